@@ -0,0 +1,213 @@
+/**
+ *  \file  0config.h
+ *  \brief Defines for generic application configuration.
+ */
+
+/*****************************************************************************
+ *                                                                           *
+ * DO NOT MODIFY IT UNLESS YOU KNOW WHAT YOU DO.                             *
+ * AUTOMATICALLY CREATED BY MAKE.                                            *
+ *                                                                           *
+ *****************************************************************************
+ */
+
+/*!
+ * \mainpage General overview
+ *
+ * \htmlonly
+ * <center>
+ *   <br>
+ *   <img src="logo.jpg" border="0" alt="BETAtech">
+ *   <br><br><br>
+ *   <table border="0" class="LAITypo" cellspacing="1">
+ *     <tr><td colspan="3">BETAtech</td></tr>
+ *     <tr>
+ *       <td>15, rue Apollo</td>
+ *       <td>31240 L'Union</td>
+ *       <td>France</td>
+ *     </tr>
+ *     <tr><td colspan="3"><br></td></tr>
+ *     <tr>
+ *       <td>Tel : +33 (0)5 34 30 40 00</td>
+ *       <td>&nbsp;</td>
+ *       <td>Fax : +33 (0)5 34 30 10 47</td>
+ *     </tr>
+ *     <tr><td colspan="3">SIRET 392315206 00046</td></tr>
+ *   </table>
+ * \endhtmlonly
+ * <br><br>
+ * \link start Quick start\endlink
+ * \htmlonly
+ * </center>
+ * \endhtmlonly
+ *
+ *
+\section intro Introduction
+  The <b>libcybercomms</b> library is a library that
+  <u>makes things (NEED DESCRIPTION HERE)</u>.
+
+ *
+ */
+
+/*!
+ * \defgroup start Quick start
+ *
+ * \section install Installation
+ * In order to install <b>libcybercomms</b>, you first need to compile it:
+ * \code
+ * $ make
+ * \endcode
+ *
+ * Then you can install it:
+ * \code
+ * $ make install-strip
+ * \endcode
+ *
+ * You can also generate the associated documentation by typing:
+ * \code
+ * $ make doc
+ * \endcode
+ *
+ * If you wand to debug the library, type the following commands:
+ * \code
+ * $ make clean
+ * $ make DEBUG_LEVEL=1
+ * \endcode
+ *
+ * For more information about the make command targets, type:
+ * \code
+ * $ make help
+ * \endcode
+ *
+ *
+ * \section usage Usage
+ * In order to use the libcybercomms library, you need to have it installed
+ * somewhere on your disk. If the library is in a standard directory (see
+ * the <tt>ldconfig</tt> command and the compiler's include path), then you
+ * don't have to do much.
+ *
+ * If the library is in a non-standard library, you need to specify its includes
+ * directory to the program you are developing, and the library path where to
+ * look for the library (-L option). Before executing your application you'll
+ * need to set the LD_LIBRARY_PATH environment variable to the directory where
+ * the library is installed.
+ *
+ */
+
+
+#ifndef GENERIC_CONFIG_H
+#define GENERIC_CONFIG_H
+
+
+/**
+ *  \defgroup buildinfo General build information constants
+ *  @{
+ */
+
+/*! Defines the package's name. */
+#define PACKAGE "cybercomms"
+
+/*! Defines the library's name. */
+#define LIBRARY "cybercomms"
+
+/*! Defines the package's version. */
+#define VERSION "1.0.0"
+
+/*! Defines the authors' names. */
+#define AUTHORS  "Thomas Nemeth"
+
+/*! Defines the OS type for which it has been compiled
+ * (Unknown for documentation).
+ */
+#if defined(WIN32)||defined(__CYGWIN32__)
+#  define OS_Win32
+#elif defined(linux)
+#  define OS_Linux
+#else
+#  define OS_Unknown
+#endif
+
+/*! Defines the architecture for which it has been compiled
+ *  (Unknown for documentation).
+ */
+#ifdef __arm__
+#  define ARCH_ARM
+#elif defined(i386)
+#  define ARCH_x86
+#else
+#  define ARCH_Unknown
+#endif
+
+/*! Defines the OS type for which it has been compiled as a string. */
+#if defined(WIN32)||defined(__CYGWIN32__)
+#  define OSTYPE     "Win32"
+#elif defined(linux)
+#  define OSTYPE     "Linux"
+#else
+#  define OSTYPE     "Unknown"
+#endif
+
+/*! Defines the architecture for which it has been compiled as a string. */
+#ifdef __arm__
+#  define ARCH     "ARM"
+#elif defined(i386)
+#  define ARCH     "x86"
+#else
+#  define ARCH     "Unknown"
+#endif
+
+/** @} */
+
+
+/**
+ *  \defgroup stddef Standard and mathematical constant defines
+ *  @{
+ */
+#ifndef TRUE
+
+/*! Defines the standard TRUE constant. */
+#   define TRUE  1
+
+/*! Defines the standard FALSE constant. */
+#   define FALSE 0
+
+#endif
+
+
+/*! Get the minimum between 2 values. */
+#define min(x, y) ({             \
+        typeof(x) _x = (x);     \
+        typeof(y) _y = (y);     \
+        (void) (&_x == &_y);    \
+        _x < _y ? _x : _y; })
+
+
+/*! Get the maximum between 2 values. */
+#define max(x, y) ({             \
+        typeof(x) _x = (x);     \
+        typeof(y) _y = (y);     \
+        (void) (&_x == &_y);    \
+        _x > _y ? _x : _y; })
+
+/*! Get the absolute value of a variable. */
+#define abs(x) (((x)>0)?(x):-(x))
+
+
+/*! Defines a way to easily debug a part of a program. */
+#define DEBUG_PART(part) (DEBUG_LEVEL>=part) || (DEBUG_LEVEL==-part)
+
+
+/*! Macro that tells if an argument is unused so that the compiled doesn't
+ *  complain.
+ */
+#if defined(__GNUC__)
+#  define UNUSED(x) UNUSED_ ## x __attribute__((unused))
+#else
+#  define UNUSED(x) /* Unused */ x
+#endif
+
+
+/** @} */
+
+
+#endif
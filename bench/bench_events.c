@@ -0,0 +1,243 @@
+/**
+ *  \file    bench_events.c
+ *  \brief   Event loop backends benchmark.
+ *
+ *           Project: cybercomms (Cyberspace communication library).
+ *
+ *           This program compares the epoll and io_uring backends of the
+ *           event loop on the same workload: a loopback server accepts
+ *           clients through the loop, reads their packets as a packet
+ *           reader and echoes each of them with event_send(). The clients
+ *           send small packets by batches and wait for the echoes.
+ *
+ *           The backend is given on the command line ("epoll" or
+ *           "io_uring"); both are run when none is given. Results are
+ *           printed as one "key=value" line per backend.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "cyberspace.h"
+
+
+/*! Number of clients. */
+#define NB_CLIENTS      4
+
+/*! Number of packets sent by each client. */
+#define NB_PACKETS      100000
+
+/*! Number of packets sent by a client before waiting for the echoes. */
+#define SEND_BATCH      32
+
+/*! Size of the data of each packet. */
+#define DATA_SIZE       32
+
+
+/*! Server state. */
+struct server {
+        struct event_loop   * loop;                     /*!< Event loop.       */
+        struct packet_decoder decoders[NB_CLIENTS];     /*!< Client decoders.  */
+        int                   nb_clients;               /*!< Accepted clients. */
+        int                   nb_closed;                /*!< Closed clients.   */
+        long                  nb_packets;               /*!< Echoed packets.   */
+};
+
+/*! Echo handler data. */
+struct client {
+        struct server * server;   /*!< Server state.    */
+        int             fd;       /*!< Client socket.   */
+};
+
+static struct client clients[NB_CLIENTS];
+
+
+/**
+ *  \brief Packet reader handler: echoes the packet.
+ */
+static void echo(const unsigned char * packet, int size, void * data)
+{
+        struct client * client = data;
+        struct xbuf   * buffer;
+
+        if (! packet)
+        {
+                event_remove(client->server->loop, client->fd);
+                close(client->fd);
+                client->server->nb_closed++;
+                return;
+        }
+        buffer = xbuf_alloc(size);
+        memcpy(buffer->data, packet, size);
+        buffer->size = size;
+        event_send(client->server->loop, client->fd, buffer);
+        xbuf_unref(buffer);
+        client->server->nb_packets++;
+}
+
+
+/**
+ *  \brief Accept handler: registers the connection as a packet reader.
+ */
+static void accepted(struct event_loop * loop, int fd, void * data)
+{
+        struct server * server = data;
+        int             i = server->nb_clients++;
+        int             on = 1;
+
+        /*
+         *      Echoes are sent one by one: without TCP_NODELAY, delayed
+         *      acknowledgements would dominate the measure.
+         */
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+        clients[i].server = server;
+        clients[i].fd = fd;
+        packet_decoder_init(&server->decoders[i]);
+        event_add_reader(loop, fd, &server->decoders[i], echo, &clients[i]);
+}
+
+
+/**
+ *  \brief Client thread: sends NB_PACKETS packets and reads the echoes.
+ */
+static void * client(void * arg)
+{
+        int                fd = *(int *) arg;
+        unsigned char      data[DATA_SIZE] = {0};
+        unsigned char      batch[SEND_BATCH * (PACKET_HEADER_SIZE + DATA_SIZE)];
+        struct packet_ring ring;
+        int                sent;
+        int                on = 1;
+        int                i;
+
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        packet_ring_init(&ring, 0);
+        for (i = 0 ; i < SEND_BATCH ; i++)
+        {
+                packet_create(CMD_SET_PARAM, data, DATA_SIZE,
+                              &batch[i * (PACKET_HEADER_SIZE + DATA_SIZE)]);
+        }
+        for (sent = 0 ; sent < NB_PACKETS ; sent += SEND_BATCH)
+        {
+                if (send(fd, batch, sizeof(batch), 0) != sizeof(batch))
+                {
+                        break;
+                }
+                for (i = 0 ; i < SEND_BATCH ; i++)
+                {
+                        unsigned char * packet;
+
+                        if (packet_ring_read(fd, &ring, &packet) <= 0)
+                        {
+                                sent = NB_PACKETS;
+                                break;
+                        }
+                }
+        }
+        packet_ring_free(&ring);
+        close(fd);
+
+        return NULL;
+}
+
+
+/**
+ *  \brief Runs one backend and prints its results.
+ */
+static void run(const char * name, int backend)
+{
+        struct sockaddr_storage address;
+        struct server      server;
+        struct timespec    begin, end;
+        pthread_t          threads[NB_CLIENTS];
+        int                fds[NB_CLIENTS];
+        int                socket_server;
+        double             elapsed;
+        int                i;
+
+        memset(&server, 0, sizeof(server));
+        server.loop = event_loop_create_backend(backend);
+        socket_server = install_server(0, "127.0.0.1", &address);
+        if (! server.loop || (socket_server < 0) ||
+            (event_add_server(server.loop, socket_server, accepted, &server) != SUCCESS))
+        {
+                fprintf(stderr, "%s: cannot start the server\n", name);
+                exit(1);
+        }
+        if (event_loop_backend(server.loop) != backend)
+        {
+                printf("bench=events backend=%s status=unavailable\n", name);
+                event_loop_destroy(server.loop);
+                close(socket_server);
+                return;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        for (i = 0 ; i < NB_CLIENTS ; i++)
+        {
+                fds[i] = connect_server("127.0.0.1", socket_local_port(socket_server));
+                if (fds[i] < 0)
+                {
+                        fprintf(stderr, "%s: cannot connect\n", name);
+                        exit(1);
+                }
+                pthread_create(&threads[i], NULL, client, &fds[i]);
+        }
+        while (server.nb_closed < NB_CLIENTS)
+        {
+                if (event_loop_wait(server.loop, 1000) < 0)
+                {
+                        break;
+                }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        for (i = 0 ; i < NB_CLIENTS ; i++)
+        {
+                pthread_join(threads[i], NULL);
+        }
+
+        elapsed = (end.tv_sec - begin.tv_sec) * 1e9
+                  + (end.tv_nsec - begin.tv_nsec);
+        printf("bench=events backend=%s clients=%d packets=%ld "
+               "ns_per_packet=%.1f packets_per_second=%.0f\n",
+               name, NB_CLIENTS, server.nb_packets,
+               server.nb_packets ? elapsed / server.nb_packets : 0.0,
+               elapsed > 0 ? server.nb_packets * 1e9 / elapsed : 0.0);
+
+        for (i = 0 ; i < NB_CLIENTS ; i++)
+        {
+                packet_decoder_free(&server.decoders[i]);
+        }
+        event_remove(server.loop, socket_server);
+        close(socket_server);
+        event_loop_destroy(server.loop);
+}
+
+
+int main(int argc, char ** argv)
+{
+        if ((argc < 2) || (strcmp(argv[1], "epoll") == 0))
+        {
+                run("epoll", EVENT_BACKEND_EPOLL);
+        }
+        if ((argc < 2) || (strcmp(argv[1], "io_uring") == 0))
+        {
+                run("io_uring", EVENT_BACKEND_IO_URING);
+        }
+
+        return 0;
+}
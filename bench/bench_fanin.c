@@ -0,0 +1,236 @@
+/**
+ *  \file    bench_fanin.c
+ *  \brief   Many connections fan-in benchmark.
+ *
+ *           Project: cybercomms (Cyberspace communication library).
+ *
+ *           This program measures how many packets a single server thread
+ *           absorbs from many clients: the server reads all its connections
+ *           as packet readers of one event loop, the clients send their
+ *           packets with cyberspace_transmit() as fast as possible. Each
+ *           client thread opens several connections and drives them in
+ *           turn, once all the connections are accepted.
+ *
+ *           Results are printed as one "key=value" line.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#include "cyberspace.h"
+
+
+/*! Number of client threads. */
+#define NB_THREADS      4
+
+/*! Number of connections of each client thread. */
+#define NB_CONNECTIONS  64
+
+/*! Number of packets sent on each connection. */
+#define NB_PACKETS      5000
+
+/*! Size of the data of each packet. */
+#define DATA_SIZE       32
+
+/*! Total number of connections. */
+#define NB_CLIENTS      (NB_THREADS * NB_CONNECTIONS)
+
+
+/*! Server connection. */
+struct connection {
+        struct server       * server;    /*!< Server state.       */
+        struct packet_decoder decoder;   /*!< Packet decoder.     */
+        int                   fd;        /*!< Service socket.     */
+};
+
+/*! Server state. */
+struct server {
+        struct event_loop * loop;                       /*!< Event loop.       */
+        struct connection   connections[NB_CLIENTS];    /*!< Connections.      */
+        int                 nb_clients;                 /*!< Accepted clients. */
+        int                 nb_closed;                  /*!< Closed clients.   */
+        long                nb_packets;                 /*!< Received packets. */
+};
+
+/*! Client thread parameters. */
+struct client {
+        int                 port;                       /*!< Server port.      */
+        int                 fds[NB_CONNECTIONS];        /*!< Connections.      */
+};
+
+/*! Start of the sending, once all the connections are accepted. */
+static int started = 0;
+
+/*! Start lock. */
+static pthread_mutex_t start_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*! Start condition. */
+static pthread_cond_t start_cond = PTHREAD_COND_INITIALIZER;
+
+
+/**
+ *  \brief Packet reader handler: counts the packets.
+ */
+static void received(const unsigned char * packet, int size, void * data)
+{
+        struct connection * connection = data;
+
+        (void) size;
+        if (! packet)
+        {
+                event_remove(connection->server->loop, connection->fd);
+                close(connection->fd);
+                connection->server->nb_closed++;
+                return;
+        }
+        connection->server->nb_packets++;
+}
+
+
+/**
+ *  \brief Accept handler: registers the connection as a packet reader.
+ */
+static void accepted(struct event_loop * loop, int fd, void * data)
+{
+        struct server     * server = data;
+        struct connection * connection;
+
+        if (server->nb_clients == NB_CLIENTS)
+        {
+                close(fd);
+                return;
+        }
+        connection = &server->connections[server->nb_clients++];
+        connection->server = server;
+        connection->fd = fd;
+        packet_decoder_init(&connection->decoder);
+        event_add_reader(loop, fd, &connection->decoder, received, connection);
+}
+
+
+/**
+ *  \brief Client thread: sends NB_PACKETS packets on each connection, one
+ *         packet per connection in turn.
+ */
+static void * client(void * arg)
+{
+        struct client * client = arg;
+        unsigned char   data[DATA_SIZE] = {0};
+        int             sent;
+        int             i;
+
+        for (i = 0 ; i < NB_CONNECTIONS ; i++)
+        {
+                client->fds[i] = connect_server("127.0.0.1", client->port);
+                if (client->fds[i] < 0)
+                {
+                        fprintf(stderr, "fanin: cannot connect\n");
+                        exit(1);
+                }
+        }
+        pthread_mutex_lock(&start_lock);
+        while (! started)
+        {
+                pthread_cond_wait(&start_cond, &start_lock);
+        }
+        pthread_mutex_unlock(&start_lock);
+
+        for (sent = 0 ; sent < NB_PACKETS ; sent++)
+        {
+                for (i = 0 ; i < NB_CONNECTIONS ; i++)
+                {
+                        cyberspace_transmit(client->fds[i], CMD_SET_PARAM,
+                                            data, DATA_SIZE);
+                }
+        }
+        for (i = 0 ; i < NB_CONNECTIONS ; i++)
+        {
+                close(client->fds[i]);
+        }
+
+        return NULL;
+}
+
+
+int main(void)
+{
+        struct sockaddr_storage address;
+        struct server         * server = calloc(1, sizeof(struct server));
+        struct client           clients[NB_THREADS];
+        struct timespec         begin, end;
+        pthread_t               threads[NB_THREADS];
+        int                     listener;
+        double                  elapsed;
+        int                     i;
+
+        server->loop = event_loop_create();
+        listener = socket_listen(0, "127.0.0.1", &address, NB_CLIENTS, 0);
+        if (! server->loop || (listener < 0) ||
+            (event_add_server(server->loop, listener, accepted, server) != SUCCESS))
+        {
+                fprintf(stderr, "fanin: cannot start the server\n");
+                return 1;
+        }
+
+        for (i = 0 ; i < NB_THREADS ; i++)
+        {
+                clients[i].port = socket_local_port(listener);
+                pthread_create(&threads[i], NULL, client, &clients[i]);
+        }
+        while (server->nb_clients < NB_CLIENTS)
+        {
+                if (event_loop_wait(server->loop, 5000) <= 0)
+                {
+                        fprintf(stderr, "fanin: connections not accepted\n");
+                        return 1;
+                }
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        pthread_mutex_lock(&start_lock);
+        started = 1;
+        pthread_cond_broadcast(&start_cond);
+        pthread_mutex_unlock(&start_lock);
+        while (server->nb_closed < NB_CLIENTS)
+        {
+                if (event_loop_wait(server->loop, 1000) < 0)
+                {
+                        break;
+                }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        for (i = 0 ; i < NB_THREADS ; i++)
+        {
+                pthread_join(threads[i], NULL);
+        }
+
+        elapsed = (end.tv_sec - begin.tv_sec) * 1e9
+                  + (end.tv_nsec - begin.tv_nsec);
+        printf("bench=fanin clients=%d packets=%ld ns_per_packet=%.1f "
+               "packets_per_second=%.0f\n",
+               NB_CLIENTS, server->nb_packets,
+               server->nb_packets ? elapsed / server->nb_packets : 0.0,
+               elapsed > 0 ? server->nb_packets * 1e9 / elapsed : 0.0);
+
+        for (i = 0 ; i < server->nb_clients ; i++)
+        {
+                packet_decoder_free(&server->connections[i].decoder);
+        }
+        event_remove(server->loop, listener);
+        close(listener);
+        event_loop_destroy(server->loop);
+        free(server);
+
+        return 0;
+}
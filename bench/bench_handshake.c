@@ -0,0 +1,127 @@
+/**
+ *  \file    bench_handshake.c
+ *  \brief   Connection handshake rate benchmark.
+ *
+ *           Project: cybercomms (Cyberspace communication library).
+ *
+ *           This program measures the rate of complete client connections
+ *           with cyberspace_connect(): TCP connection, user packet and
+ *           server answer. The server thread accepts the connections,
+ *           reads the user packet, acknowledges it and closes the service
+ *           socket. The connections are made one after the other.
+ *
+ *           Results are printed as one "key=value" line, the percentiles
+ *           being taken from a metrics histogram (see metrics.h).
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#include "cyberspace.h"
+
+
+/*! Number of measured connections (the loopback ports are reused only
+ *  after the TIME_WAIT delay: keep it well below the ephemeral range).
+ */
+#define NB_CONNECTIONS  5000
+
+
+/**
+ *  \brief Current date in nanoseconds.
+ */
+static unsigned long long now_ns(void)
+{
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (unsigned long long) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+
+/**
+ *  \brief Server thread: answers NB_CONNECTIONS handshakes.
+ */
+static void * server(void * arg)
+{
+        int           listener = *(int *) arg;
+        unsigned char packet[MAX_PACKET_SIZE];
+        int           i;
+
+        for (i = 0 ; i < NB_CONNECTIONS ; i++)
+        {
+                int fd = accept_connection(listener, 0);
+
+                if (fd < 0)
+                {
+                        break;
+                }
+                if (packet_read(fd, packet, MAX_PACKET_SIZE) > 0)
+                {
+                        message_send(fd, PACKET_MSG_ACK, 0);
+                }
+                close(fd);
+        }
+
+        return NULL;
+}
+
+
+int main(void)
+{
+        struct sockaddr_storage  address;
+        struct metrics_histogram histogram;
+        unsigned long long       begin, end;
+        pthread_t                thread;
+        int                      listener, port;
+        int                      i;
+
+        listener = install_server(0, "127.0.0.1", &address);
+        if (listener < 0)
+        {
+                fprintf(stderr, "handshake: cannot start the server\n");
+                return 1;
+        }
+        port = socket_local_port(listener);
+        pthread_create(&thread, NULL, server, &listener);
+
+        memset(&histogram, 0, sizeof(histogram));
+        begin = now_ns();
+        for (i = 0 ; i < NB_CONNECTIONS ; i++)
+        {
+                unsigned long long start = now_ns();
+                int                fd = cyberspace_connect("127.0.0.1", port,
+                                                           client_probe, "bench");
+
+                if (fd < 0)
+                {
+                        fprintf(stderr, "handshake: %s\n", get_error_info(fd));
+                        return 1;
+                }
+                metrics_histogram_add(&histogram, now_ns() - start);
+                close(fd);
+        }
+        end = now_ns();
+        pthread_join(thread, NULL);
+        close(listener);
+
+        printf("bench=handshake connections=%llu handshakes_per_second=%.0f "
+               "p50_ns=%llu p99_ns=%llu max_ns=%llu\n",
+               histogram.count,
+               histogram.count * 1e9 / (double) (end - begin),
+               metrics_percentile(&histogram, 50),
+               metrics_percentile(&histogram, 99),
+               histogram.max);
+
+        return 0;
+}
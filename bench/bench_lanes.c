@@ -0,0 +1,235 @@
+/**
+ *  \file    bench_lanes.c
+ *  \brief   Priority lanes benchmark.
+ *
+ *           Project: cybercomms (Cyberspace communication library).
+ *
+ *           This program measures the delay of ACK messages queued on a
+ *           connection while a large CMD_DUMP_STATE payload is being sent
+ *           to a slow reader. In the "fifo" mode, the payload fragments are
+ *           queued in the same lane as the messages, as a single FIFO
+ *           would; in the "lanes" mode, the payload is queued in the bulk
+ *           lane with outqueue_push_large(). In both modes, the unsent
+ *           data of the server socket is limited (socket_unsent_limit())
+ *           and the client receive buffer is RECEIVE_BUFFER bytes.
+ *
+ *           Results are printed as one "key=value" line per mode.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#include "cyberspace.h"
+
+
+/*! Size of the bulk payload. */
+#define BULK_SIZE       (16 * 1024 * 1024)
+
+/*! Delay between two ACK messages, in microseconds. */
+#define ACK_PERIOD      500
+
+/*! Pause of the reader after each bulk packet, in microseconds. */
+#define READER_PAUSE    20
+
+/*! Unsent data limit of the server socket. */
+#define UNSENT_LIMIT    (2 * OUTQUEUE_CHUNK_SIZE)
+
+/*! Receive buffer size of the client socket. */
+#define RECEIVE_BUFFER  (256 * 1024)
+
+/*! Maximum number of ACK messages measured. */
+#define MAX_ACKS        100000
+
+
+/*! ACK delays of the current mode, in nanoseconds. */
+static unsigned long long delays[MAX_ACKS];
+
+/*! Number of ACK delays. */
+static int nb_delays;
+
+
+/**
+ *  \brief Current date in nanoseconds.
+ */
+static unsigned long long now_ns(void)
+{
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (unsigned long long) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+
+/**
+ *  \brief Reader thread: a slow client recording the ACK delays.
+ */
+static void * reader(void * arg)
+{
+        int                   fd = *(int *) arg;
+        unsigned char         packet[MAX_PACKET_SIZE];
+        struct timespec       pause = {0, READER_PAUSE * 1000};
+        int                   size;
+
+        while ((size = packet_read(fd, packet, MAX_PACKET_SIZE)) > 0)
+        {
+                int type = packet_type(packet);
+
+                if (type == CMD_DISCONNECT)
+                {
+                        break;
+                }
+                if (type == PACKET_MSG_ACK)
+                {
+                        unsigned long long queued;
+
+                        memcpy(&queued, &packet[PACKET_HEADER_SIZE], sizeof(queued));
+                        if (nb_delays < MAX_ACKS)
+                        {
+                                delays[nb_delays++] = now_ns() - queued;
+                        }
+                        continue;
+                }
+                nanosleep(&pause, NULL);
+        }
+
+        return NULL;
+}
+
+
+/**
+ *  \brief Sorting function of the delays.
+ */
+static int compare(const void * a, const void * b)
+{
+        unsigned long long x = *(const unsigned long long *) a;
+        unsigned long long y = *(const unsigned long long *) b;
+
+        return (x > y) - (x < y);
+}
+
+
+/**
+ *  \brief Runs one mode and prints its results.
+ */
+static void run(const char * mode, int lanes)
+{
+        struct sockaddr_storage address;
+        struct outqueue         queue;
+        pthread_t               thread;
+        unsigned char         * payload = malloc(BULK_SIZE);
+        unsigned long long      begin, next_ack, elapsed;
+        int                     server, client, service;
+        int                     status;
+        int                     buffer = RECEIVE_BUFFER;
+
+        server = install_server(0, "127.0.0.1", &address);
+        client = connect_server("127.0.0.1", socket_local_port(server));
+        service = accept_connection(server, 0);
+        if ((server < 0) || (client < 0) || (service < 0) || ! payload)
+        {
+                fprintf(stderr, "%s: cannot open loopback connection\n", mode);
+                exit(1);
+        }
+        socket_nonblocking(service);
+        socket_unsent_limit(service, UNSENT_LIMIT);
+        setsockopt(client, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+        memset(payload, 0x5A, BULK_SIZE);
+        nb_delays = 0;
+        pthread_create(&thread, NULL, reader, &client);
+
+        outqueue_init(&queue, service, 0);
+        begin = now_ns();
+        if (lanes)
+        {
+                status = outqueue_push_large(&queue, CMD_DUMP_STATE, payload,
+                                             BULK_SIZE, 0);
+        }
+        else
+        {
+                size_t sent;
+
+                /* Une seule file : les fragments dans la voie des messages. */
+                for (sent = 0 ; sent < BULK_SIZE ; sent += OUTQUEUE_CHUNK_SIZE)
+                {
+                        unsigned char * area = outqueue_frame_begin(&queue,
+                                                   FRAGMENT_HEADER_SIZE + OUTQUEUE_CHUNK_SIZE);
+
+                        area[0] = CMD_DUMP_STATE;
+                        area[1] = ((sent == 0) ? FRAGMENT_FIRST : 0)
+                                  | ((sent + OUTQUEUE_CHUNK_SIZE == BULK_SIZE)
+                                     ? FRAGMENT_LAST : 0);
+                        memcpy(area + FRAGMENT_HEADER_SIZE, payload + sent,
+                               OUTQUEUE_CHUNK_SIZE);
+                        outqueue_frame_end(&queue, PACKET_FRAGMENT,
+                                           FRAGMENT_HEADER_SIZE + OUTQUEUE_CHUNK_SIZE,
+                                           OUTQUEUE_CONTROL);
+                }
+                status = outqueue_flush(&queue);
+        }
+
+        next_ack = now_ns();
+        while (status > 0)
+        {
+                struct pollfd watch = {service, POLLOUT, 0};
+
+                if (now_ns() >= next_ack)
+                {
+                        unsigned long long queued = now_ns();
+
+                        outqueue_push(&queue, PACKET_MSG_ACK,
+                                      (unsigned char *) &queued, sizeof(queued), 0);
+                        next_ack += ACK_PERIOD * 1000;
+                }
+                status = outqueue_flush(&queue);
+                if (status > 0)
+                {
+                        poll(&watch, 1, 1);
+                }
+        }
+        elapsed = now_ns() - begin;
+        outqueue_push(&queue, CMD_DISCONNECT, NULL, 0, 0);
+        while ((status = outqueue_flush(&queue)) > 0)
+        {
+                struct pollfd watch = {service, POLLOUT, 0};
+
+                poll(&watch, 1, 10);
+        }
+        pthread_join(thread, NULL);
+
+        qsort(delays, nb_delays, sizeof(delays[0]), compare);
+        printf("bench=lanes mode=%s bulk_bytes=%d chunk_size=%d acks=%d "
+               "ack_p50_us=%.1f ack_p99_us=%.1f ack_max_us=%.1f "
+               "bulk_mb_per_s=%.1f status=%d\n",
+               mode, BULK_SIZE, OUTQUEUE_CHUNK_SIZE, nb_delays,
+               nb_delays ? delays[nb_delays / 2] / 1e3 : 0.0,
+               nb_delays ? delays[nb_delays * 99 / 100] / 1e3 : 0.0,
+               nb_delays ? delays[nb_delays - 1] / 1e3 : 0.0,
+               BULK_SIZE / (elapsed / 1e9) / (1024 * 1024), status);
+
+        outqueue_free(&queue);
+        free(payload);
+        close(service);
+        close(client);
+        close(server);
+}
+
+
+int main(void)
+{
+        run("fifo", 0);
+        run("lanes", 1);
+
+        return 0;
+}
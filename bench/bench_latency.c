@@ -0,0 +1,161 @@
+/**
+ *  \file    bench_latency.c
+ *  \brief   Single connection latency benchmark.
+ *
+ *           Project: cybercomms (Cyberspace communication library).
+ *
+ *           This program measures the round trip of a small packet on a
+ *           loopback connection: the client sends it with
+ *           cyberspace_transmit(), the server reads it with packet_read()
+ *           and answers with message_send(PACKET_MSG_ACK). Only one packet
+ *           is in flight at a time. With the "unix" argument, the
+ *           connection is made on a local endpoint (Unix domain socket);
+ *           with the "shm" argument, it is upgraded to shared memory (see
+ *           shmem.h).
+ *
+ *           Results are printed as one "key=value" line, the percentiles
+ *           being taken from a metrics histogram (see metrics.h).
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "cyberspace.h"
+
+
+/*! Number of measured round trips. */
+#define NB_ROUNDS       100000
+
+/*! Number of round trips before the measure (connection warm-up). */
+#define NB_WARMUP       1000
+
+/*! Size of the data of each packet. */
+#define DATA_SIZE       8
+
+
+/**
+ *  \brief Current date in nanoseconds.
+ */
+static unsigned long long now_ns(void)
+{
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (unsigned long long) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+
+/**
+ *  \brief Server thread: acknowledges every packet until the connection
+ *         is closed.
+ */
+static void * server(void * arg)
+{
+        int           fd = *(int *) arg;
+        unsigned char packet[MAX_PACKET_SIZE];
+        int           size;
+
+        while ((size = packet_read(fd, packet, MAX_PACKET_SIZE)) > 0)
+        {
+                if (packet_type(packet) == PACKET_SHM)
+                {
+                        shmem_accept(fd, packet, size);
+                        continue;
+                }
+                if (message_send(fd, PACKET_MSG_ACK, 0) == 0)
+                {
+                        break;
+                }
+        }
+        shmem_close(fd);
+
+        return NULL;
+}
+
+
+int main(int argc, char ** argv)
+{
+        struct sockaddr_storage  address;
+        struct metrics_histogram histogram;
+        pthread_t                thread;
+        unsigned char            data[DATA_SIZE] = {0};
+        unsigned char            answer[MAX_PACKET_SIZE];
+        int                      listener, client, service;
+        int                      on = 1;
+        const char             * transport = (argc > 1) ? argv[1] : "tcp";
+        int                      shm = (strcmp(transport, "shm") == 0);
+        char                     endpoint[64] = "127.0.0.1";
+        int                      i;
+
+        if (strcmp(transport, "unix") == 0)
+        {
+                snprintf(endpoint, sizeof(endpoint), "%s@cybercomms-latency-%d",
+                         RESOLVER_UNIX_PREFIX, getpid());
+        }
+        else if (! shm)
+        {
+                transport = "tcp";
+        }
+        listener = install_server(0, endpoint, &address);
+        client = connect_server(endpoint, socket_local_port(listener));
+        service = accept_connection(listener, 0);
+        if ((listener < 0) || (client < 0) || (service < 0))
+        {
+                fprintf(stderr, "latency: cannot open loopback connection\n");
+                return 1;
+        }
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        setsockopt(service, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        pthread_create(&thread, NULL, server, &service);
+        if (shm && (shmem_connect(client, 0) != SUCCESS))
+        {
+                fprintf(stderr, "latency: shared memory refused\n");
+                return 1;
+        }
+
+        memset(&histogram, 0, sizeof(histogram));
+        for (i = 0 ; i < NB_WARMUP + NB_ROUNDS ; i++)
+        {
+                unsigned long long begin = now_ns();
+
+                if ((cyberspace_transmit(client, CMD_GET_PARAM, data, DATA_SIZE) == 0) ||
+                    (packet_read(client, answer, MAX_PACKET_SIZE) <= 0))
+                {
+                        fprintf(stderr, "latency: connection lost\n");
+                        return 1;
+                }
+                if (i >= NB_WARMUP)
+                {
+                        metrics_histogram_add(&histogram, now_ns() - begin);
+                }
+        }
+        shmem_close(client);
+        close(client);
+        pthread_join(thread, NULL);
+        close(service);
+        close(listener);
+
+        printf("bench=latency transport=%s rounds=%llu mean_ns=%llu p50_ns=%llu p90_ns=%llu "
+               "p99_ns=%llu p999_ns=%llu max_ns=%llu\n",
+               transport, histogram.count, histogram.sum / histogram.count,
+               metrics_percentile(&histogram, 50),
+               metrics_percentile(&histogram, 90),
+               metrics_percentile(&histogram, 99),
+               metrics_percentile(&histogram, 99.9),
+               histogram.max);
+
+        return 0;
+}
@@ -0,0 +1,155 @@
+/**
+ *  \file    bench_recv.c
+ *  \brief   Receive path benchmark.
+ *
+ *           Project: cybercomms (Cyberspace communication library).
+ *
+ *           This program measures the number of recv() system calls needed
+ *           per packet on a loopback connection, with packet_read() and with
+ *           the batched packet_ring_read(). The sender emits a stream of
+ *           small packets, as the probes do for their telemetry.
+ *
+ *           Results are printed as one "key=value" line per mode.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+
+#include "cyberspace.h"
+
+
+/*! Number of packets sent for each mode. */
+#define NB_PACKETS      200000
+
+/*! Number of packets written by the sender in one send(). */
+#define SEND_BATCH      64
+
+/*! Size of the data of each packet. */
+#define DATA_SIZE       12
+
+
+/*! Number of recv() calls since the last reset. */
+static unsigned long nb_recv = 0;
+
+
+/**
+ *  \brief recv() wrapper counting the system calls of the library.
+ */
+ssize_t recv(int fd, void * buffer, size_t size, int flags)
+{
+        nb_recv++;
+        return syscall(SYS_recvfrom, fd, buffer, size, flags, NULL, NULL);
+}
+
+
+/**
+ *  \brief Sender thread: emits NB_PACKETS small packets.
+ */
+static void * sender(void * arg)
+{
+        int           fd = *(int *) arg;
+        unsigned char data[DATA_SIZE] = {0};
+        unsigned char batch[SEND_BATCH * (PACKET_HEADER_SIZE + DATA_SIZE)];
+        int           sent;
+
+        for (sent = 0 ; sent < NB_PACKETS ; sent += SEND_BATCH)
+        {
+                int i;
+
+                for (i = 0 ; i < SEND_BATCH ; i++)
+                {
+                        packet_create(CMD_SET_PARAM, data, DATA_SIZE,
+                                      &batch[i * (PACKET_HEADER_SIZE + DATA_SIZE)]);
+                }
+                if (send(fd, batch, sizeof(batch), 0) != sizeof(batch))
+                {
+                        break;
+                }
+        }
+
+        return NULL;
+}
+
+
+/**
+ *  \brief Runs one mode and prints its results.
+ */
+static void run(const char * mode, int use_ring)
+{
+        struct sockaddr_storage address;
+        struct packet_ring ring;
+        struct timespec    begin, end;
+        pthread_t          thread;
+        unsigned char      packet[MAX_PACKET_SIZE];
+        int                server, client, service;
+        int                received = 0;
+        double             elapsed;
+
+        server = install_server(0, "127.0.0.1", &address);
+        client = connect_server("127.0.0.1", socket_local_port(server));
+        service = accept_connection(server, 0);
+        if ((server < 0) || (client < 0) || (service < 0))
+        {
+                fprintf(stderr, "%s: cannot open loopback connection\n", mode);
+                exit(1);
+        }
+        packet_ring_init(&ring, 0);
+
+        pthread_create(&thread, NULL, sender, &client);
+        nb_recv = 0;
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        while (received < NB_PACKETS)
+        {
+                int size;
+
+                if (use_ring)
+                {
+                        unsigned char * data;
+                        size = packet_ring_read(service, &ring, &data);
+                }
+                else
+                {
+                        size = packet_read(service, packet, MAX_PACKET_SIZE);
+                }
+                if (size <= 0)
+                {
+                        break;
+                }
+                received++;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        pthread_join(thread, NULL);
+
+        elapsed = (end.tv_sec - begin.tv_sec) * 1e9
+                  + (end.tv_nsec - begin.tv_nsec);
+        printf("bench=recv mode=%s packets=%d syscalls=%lu "
+               "syscalls_per_packet=%.4f ns_per_packet=%.1f\n",
+               mode, received, nb_recv,
+               received ? (double) nb_recv / received : 0.0,
+               received ? elapsed / received : 0.0);
+
+        packet_ring_free(&ring);
+        close(service);
+        close(client);
+        close(server);
+}
+
+
+int main(void)
+{
+        run("packet_read", 0);
+        run("packet_ring_read", 1);
+
+        return 0;
+}
@@ -0,0 +1,289 @@
+/**
+ *  \file    bench_schema.c
+ *  \brief   Schema payload benchmark.
+ *
+ *           Project: cybercomms (Cyberspace communication library).
+ *
+ *           This program compares the handling of CMD_ADD_OBJECT packets
+ *           hand-parsed and copied in a structure with the views generated
+ *           from schemas/cyberspace.schema, which read the fields in the
+ *           received data. It also compares the encoding of the packets in
+ *           MAX_PACKET_SIZE scratch buffers with the exact-size packer.
+ *
+ *           Results are printed as one "key=value" line per mode.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cyberspace.h"
+#include "schemas/cyberspace.h"
+
+
+/*! Number of packets handled for each mode. */
+#define NB_PACKETS      2000000
+
+/*! Number of properties of each object. */
+#define NB_PROPERTIES   24
+
+
+/*! Result of the handlers, so that they are not optimized out. */
+static volatile double sink;
+
+
+/*! Object copied by the hand-written handler. */
+struct copied_object {
+        uint32_t        id;
+        uint32_t        parent;
+        uint16_t        kind;
+        uint16_t        flags;
+        float           scale;
+        double          position[3];
+        double          orientation[4];
+        char            name[32];
+        int             nb_properties;
+        unsigned char * properties;
+};
+
+
+/**
+ *  \brief Time since the beginning of the mode, in nanoseconds.
+ */
+static double elapsed(const struct timespec * begin)
+{
+        struct timespec end;
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        return (end.tv_sec - begin->tv_sec) * 1e9 + (end.tv_nsec - begin->tv_nsec);
+}
+
+
+/**
+ *  \brief Hand-written handler: the data is parsed byte by byte and copied.
+ */
+static void handle_copy(const unsigned char * data, int size)
+{
+        struct copied_object object;
+        int                  i;
+
+        memcpy(&object.id, data, 4);
+        memcpy(&object.parent, data + 4, 4);
+        memcpy(&object.kind, data + 8, 2);
+        memcpy(&object.flags, data + 10, 2);
+        memcpy(&object.scale, data + 12, 4);
+        for (i = 0 ; i < 3 ; i++)
+        {
+                memcpy(&object.position[i], data + 16 + i * 8, 8);
+        }
+        for (i = 0 ; i < 4 ; i++)
+        {
+                memcpy(&object.orientation[i], data + 40 + i * 8, 8);
+        }
+        memcpy(object.name, data + 72, 32);
+        object.nb_properties = size - 104;
+        object.properties = malloc(object.nb_properties);
+        memcpy(object.properties, data + 104, object.nb_properties);
+
+        sink = object.id + object.kind + object.position[0] + object.properties[0];
+        free(object.properties);
+}
+
+
+/**
+ *  \brief Schema handler: the fields are read in the received data.
+ */
+static void handle_view(const unsigned char * data, int size)
+{
+        int count = add_object_check(data, size);
+
+        if (count < 1)
+        {
+                return;
+        }
+        sink = add_object_id(data) + add_object_kind(data)
+               + add_object_position(data, 0) + add_object_properties(data)[0];
+}
+
+
+/**
+ *  \brief Object of the benchmark.
+ */
+static void fill(struct add_object * object, unsigned char * properties, int n)
+{
+        int i;
+
+        memset(object, 0, sizeof(struct add_object));
+        object->id = n;
+        object->parent = 1;
+        object->kind = 7;
+        object->scale = 1.5;
+        for (i = 0 ; i < 3 ; i++)
+        {
+                object->position[i] = n * (i + 1);
+        }
+        object->orientation[0] = 1.0;
+        snprintf(object->name, sizeof(object->name), "object-%d", n);
+        for (i = 0 ; i < NB_PROPERTIES ; i++)
+        {
+                properties[i] = n + i;
+        }
+}
+
+
+/**
+ *  \brief Reading modes: the same packet handled by both handlers.
+ */
+static void run_read(const char * mode, void (* handle)(const unsigned char *, int))
+{
+        struct add_object object;
+        struct timespec   begin;
+        unsigned char     properties[NB_PROPERTIES];
+        unsigned char     packet[MAX_PACKET_SIZE];
+        int               size, n;
+        double            ns;
+
+        fill(&object, properties, 42);
+        size = add_object_pack(&object, properties, NB_PROPERTIES, packet);
+
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        for (n = 0 ; n < NB_PACKETS ; n++)
+        {
+                handle(packet + PACKET_HEADER_SIZE, size - PACKET_HEADER_SIZE);
+        }
+        ns = elapsed(&begin);
+
+        printf("bench=schema mode=%s packets=%d packet_size=%d ns_per_packet=%.1f\n",
+               mode, NB_PACKETS, size, ns / NB_PACKETS);
+}
+
+
+/**
+ *  \brief Encoding mode: data built in a scratch buffer then copied in a
+ *         shared packet.
+ */
+static void run_scratch(void)
+{
+        struct add_object object;
+        struct timespec   begin;
+        unsigned char     properties[NB_PROPERTIES];
+        unsigned char     data[MAX_DATA_SIZE];
+        int               n;
+        double            ns;
+
+        fill(&object, properties, 42);
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        for (n = 0 ; n < NB_PACKETS ; n++)
+        {
+                struct xbuf * packet;
+
+                object.id = n;
+                memset(data, 0, ADD_OBJECT_SIZE);
+                memcpy(data, &object.id, 4);
+                memcpy(data + 4, &object.parent, 4);
+                memcpy(data + 8, &object.kind, 2);
+                memcpy(data + 10, &object.flags, 2);
+                memcpy(data + 12, &object.scale, 4);
+                memcpy(data + 16, object.position, 24);
+                memcpy(data + 40, object.orientation, 32);
+                memcpy(data + 72, object.name, 32);
+                memcpy(data + 104, properties, NB_PROPERTIES);
+                packet = packet_create_shared(CMD_ADD_OBJECT, data, 104 + NB_PROPERTIES);
+                sink = packet->data[PACKET_HEADER_SIZE];
+                xbuf_unref(packet);
+        }
+        ns = elapsed(&begin);
+
+        printf("bench=schema mode=encode_scratch packets=%d buffer_size=%d "
+               "ns_per_packet=%.1f\n", NB_PACKETS, MAX_DATA_SIZE, ns / NB_PACKETS);
+}
+
+
+/**
+ *  \brief Encoding mode: packet written once, at its exact size.
+ */
+static void run_exact(void)
+{
+        struct add_object object;
+        struct timespec   begin;
+        unsigned char     properties[NB_PROPERTIES];
+        int               n;
+        double            ns;
+
+        fill(&object, properties, 42);
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        for (n = 0 ; n < NB_PACKETS ; n++)
+        {
+                struct xbuf * packet = xbuf_alloc(add_object_packet_size(NB_PROPERTIES));
+
+                object.id = n;
+                packet->size = add_object_pack(&object, properties, NB_PROPERTIES,
+                                               packet->data);
+                sink = packet->data[PACKET_HEADER_SIZE];
+                xbuf_unref(packet);
+        }
+        ns = elapsed(&begin);
+
+        printf("bench=schema mode=encode_exact packets=%d buffer_size=%d "
+               "ns_per_packet=%.1f\n", NB_PACKETS, add_object_packet_size(NB_PROPERTIES),
+               ns / NB_PACKETS);
+}
+
+
+/**
+ *  \brief Round trip check: both encodings give the same packet.
+ */
+static int check_round_trip(void)
+{
+        struct add_object object, decoded;
+        unsigned char     properties[NB_PROPERTIES];
+        unsigned char     packet[MAX_PACKET_SIZE];
+        unsigned char     data[MAX_DATA_SIZE];
+        unsigned char     expected[MAX_PACKET_SIZE];
+        int               size;
+
+        fill(&object, properties, 42);
+        size = add_object_pack(&object, properties, NB_PROPERTIES, packet);
+        add_object_encode(&object, data);
+        memcpy(data + ADD_OBJECT_SIZE, properties, NB_PROPERTIES);
+        packet_create(CMD_ADD_OBJECT, data, ADD_OBJECT_SIZE + NB_PROPERTIES, expected);
+        add_object_decode(packet + PACKET_HEADER_SIZE, &decoded);
+
+        if ((size != add_object_packet_size(NB_PROPERTIES)) ||
+            (memcmp(packet, expected, size) != 0) ||
+            (memcmp(&object, &decoded, sizeof(object)) != 0) ||
+            (add_object_check(packet + PACKET_HEADER_SIZE,
+                              size - PACKET_HEADER_SIZE) != NB_PROPERTIES) ||
+            (add_object_check(packet + PACKET_HEADER_SIZE, ADD_OBJECT_SIZE - 1)
+             != -ERR_BAD_PROTOCOL) ||
+            (add_object_name_length(packet + PACKET_HEADER_SIZE) != strlen("object-42")) ||
+            (memcmp(add_object_name(packet + PACKET_HEADER_SIZE), "object-42",
+                    strlen("object-42")) != 0))
+        {
+                fprintf(stderr, "bench=schema: round trip failed\n");
+                return 1;
+        }
+        return 0;
+}
+
+
+int main(void)
+{
+        if (check_round_trip())
+        {
+                return 1;
+        }
+        run_read("read_copy", handle_copy);
+        run_read("read_view", handle_view);
+        run_scratch();
+        run_exact();
+
+        return 0;
+}
@@ -0,0 +1,193 @@
+/**
+ *  \file    bench_slowpeer.c
+ *  \brief   Stalled peer benchmark.
+ *
+ *           Project: cybercomms (Cyberspace communication library).
+ *
+ *           This program simulates a server tick sending one real-time
+ *           update to two clients, one of which never reads. It reports the
+ *           memory held by the queue of the stalled client and the longest
+ *           tick, for an unbounded queue and for each full queue policy
+ *           (see outqueue_limits()).
+ *
+ *           Results are printed as one "key=value" line per mode.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#include "cyberspace.h"
+
+
+/*! Number of server ticks. */
+#define NB_TICKS        5000
+
+/*! Size of the update sent at each tick. */
+#define UPDATE_SIZE     1024
+
+/*! Bytes limit of the bounded queues. */
+#define QUEUE_LIMIT     (64 * 1024)
+
+
+/*! Number of watermark crossings upwards. */
+static int nb_throttles;
+
+
+/**
+ *  \brief Current date in nanoseconds.
+ */
+static unsigned long long now_ns(void)
+{
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (unsigned long long) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+
+/**
+ *  \brief Reader thread: the client that keeps up.
+ */
+static void * reader(void * arg)
+{
+        int           fd = *(int *) arg;
+        unsigned char packet[MAX_PACKET_SIZE];
+
+        while (packet_read(fd, packet, MAX_PACKET_SIZE) > 0)
+        {
+                if (packet_type(packet) == CMD_DISCONNECT)
+                {
+                        break;
+                }
+        }
+
+        return NULL;
+}
+
+
+/**
+ *  \brief Watermark function: counts the throttling requests.
+ */
+static void throttle(struct outqueue * queue, int above, void * data)
+{
+        (void) queue;
+        (void) data;
+        if (above)
+        {
+                nb_throttles++;
+        }
+}
+
+
+/**
+ *  \brief Runs one mode and prints its results.
+ */
+static void run(const char * mode, int limit, int policy)
+{
+        int                fast[2], slow[2];
+        struct outqueue    queues[2];
+        pthread_t          thread;
+        unsigned char      update[UPDATE_SIZE];
+        unsigned long long worst = 0;
+        int                peak = 0;
+        int                status = 0;
+        int                tick, i;
+
+        if ((socketpair(AF_UNIX, SOCK_STREAM, 0, fast) == -1) ||
+            (socketpair(AF_UNIX, SOCK_STREAM, 0, slow) == -1))
+        {
+                fprintf(stderr, "%s: cannot create connections\n", mode);
+                exit(1);
+        }
+        socket_nonblocking(fast[0]);
+        socket_nonblocking(slow[0]);
+        outqueue_init(&queues[0], fast[0], 0);
+        outqueue_init(&queues[1], slow[0], 0);
+        nb_throttles = 0;
+        for (i = 0 ; i < 2 ; i++)
+        {
+                if (limit)
+                {
+                        outqueue_limits(&queues[i], QUEUE_LIMIT, 0, policy);
+                        outqueue_watermarks(&queues[i], QUEUE_LIMIT / 4,
+                                            QUEUE_LIMIT / 2, throttle, NULL);
+                }
+        }
+        memset(update, 0, sizeof(update));
+        pthread_create(&thread, NULL, reader, &fast[1]);
+
+        for (tick = 0 ; tick < NB_TICKS ; tick++)
+        {
+                unsigned long long begin = now_ns();
+                unsigned long long elapsed;
+
+                memcpy(update, &tick, sizeof(tick));
+                for (i = 0 ; i < 2 ; i++)
+                {
+                        int result = outqueue_push(&queues[i], CMD_SET_PARAM, update,
+                                                   UPDATE_SIZE, OUTQUEUE_DROPPABLE);
+
+                        if (result >= 0)
+                        {
+                                result = outqueue_flush(&queues[i]);
+                        }
+                        if ((i == 1) && (result < 0))
+                        {
+                                status = result;
+                        }
+                }
+                elapsed = now_ns() - begin;
+                if (elapsed > worst)
+                {
+                        worst = elapsed;
+                }
+                if (queues[1].capacity > peak)
+                {
+                        peak = queues[1].capacity;
+                }
+        }
+
+        outqueue_push(&queues[0], CMD_DISCONNECT, NULL, 0, 0);
+        while (outqueue_flush(&queues[0]) > 0)
+        {
+                usleep(100);
+        }
+        pthread_join(thread, NULL);
+
+        printf("bench=slowpeer mode=%s ticks=%d stalled_pending=%d "
+               "stalled_buffer=%d dropped=%lu throttles=%d worst_tick_us=%.1f "
+               "status=%d\n",
+               mode, NB_TICKS, outqueue_pending(&queues[1]), peak,
+               queues[1].dropped, nb_throttles, worst / 1e3, status);
+
+        for (i = 0 ; i < 2 ; i++)
+        {
+                outqueue_free(&queues[i]);
+        }
+        close(fast[0]);
+        close(fast[1]);
+        close(slow[0]);
+        close(slow[1]);
+}
+
+
+int main(void)
+{
+        run("unbounded", 0, OUTQUEUE_REFUSE);
+        run("refuse", 1, OUTQUEUE_REFUSE);
+        run("drop_oldest", 1, OUTQUEUE_DROP_OLDEST);
+        run("disconnect", 1, OUTQUEUE_DISCONNECT);
+
+        return 0;
+}
@@ -0,0 +1,838 @@
+/**
+ *  \file    bench_swarm.c
+ *  \brief   Client swarm load generator.
+ *
+ *           Project: cybercomms (Cyberspace communication library).
+ *
+ *           This program simulates many cyberspace clients to load a
+ *           server. A few threads each run an event loop and open their
+ *           share of the sessions with connector_start(): no thread waits
+ *           for a connection, and at most SWARM_RAMP connections of a
+ *           thread are in progress at a time. Each session introduces itself like
+ *           cyberspace_connect() does (its client type as TAG, its name as
+ *           data), waits for the answer, then sends packets whose TAGs are
+ *           drawn from a weighted mix. Every packet must be answered by
+ *           exactly one packet (an ACK from a cyberspace server): the
+ *           answers are matched with the packets in order to measure the
+ *           latency.
+ *
+ *           Without a target host, the sessions connect to a bundled
+ *           stand-in server (a sharded server answering each packet with
+ *           an ACK, or echoing it with -e). The stand-in can also be run
+ *           alone with -S, to be the target of another instance.
+ *
+ *           Usage: bench_swarm [options]
+ *           -H host      target host (default: bundled stand-in)
+ *           -p port      target port (default: any free port)
+ *           -c clients   number of sessions (default: 1000)
+ *           -t threads   number of threads (default: 4)
+ *           -d seconds   duration of the run (default: 2)
+ *           -r rate      packets per second per session (default: 0, each
+ *                        session sends as soon as it is answered)
+ *           -w window    unanswered packets per session (default: 1, or
+ *                        16 with a rate, at most SWARM_WINDOW)
+ *           -s size      size of the data of the packets (default: 16)
+ *           -u mix       client types mix (default: probe:80,ship:15,god:5)
+ *           -m mix       TAGs mix (default: get:60,set:30,noop:10); TAGs
+ *                        are names (noop, get, set, add, del, load, save,
+ *                        dump, select) or numbers
+ *           -e           stand-in echoes the packets instead of an ACK
+ *           -S           run the stand-in alone
+ *
+ *           Loopback connections use one ephemeral port each: tens of
+ *           thousands of sessions may need a larger ip_local_port_range
+ *           and a higher open files limit (raised to the hard limit here).
+ *
+ *           Results are printed as "key=value" lines: one for the run and
+ *           one per TAG of the mix.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/resource.h>
+
+#include "cyberspace.h"
+
+
+/*! Maximum number of unanswered packets of a session. */
+#define SWARM_WINDOW    64
+
+/*! Maximum number of entries of a mix. */
+#define SWARM_MIX       16
+
+/*! Period of the threads timer (rate and end of the run), in ms. */
+#define SWARM_TICK      5
+
+/*! Connection timeout, in ms. */
+#define SWARM_CONNECT   5000
+
+/*! Maximum number of connections in progress per thread (a connection in
+ *  progress holds three descriptors, see connector.c).
+ */
+#define SWARM_RAMP      256
+
+/*! Session states. */
+enum { SESSION_CONNECTING, SESSION_HANDSHAKE, SESSION_ACTIVE, SESSION_CLOSED };
+
+/*! Entry of a mix. */
+struct mix {
+        int                 value;      /*!< Client type or TAG.       */
+        int                 weight;     /*!< Relative weight.          */
+};
+
+/*! Run configuration. */
+struct config {
+        char              * host;                 /*!< Target (NULL: stand-in). */
+        int                 port;                 /*!< Target port.             */
+        int                 nb_clients;           /*!< Sessions.                */
+        int                 nb_threads;           /*!< Threads.                 */
+        int                 duration;             /*!< Duration in seconds.     */
+        int                 rate;                 /*!< Packets/s per session.   */
+        int                 window;               /*!< Unanswered packets.      */
+        int                 size;                 /*!< Data size.               */
+        int                 echo;                 /*!< Stand-in echoes.         */
+        struct mix          users[SWARM_MIX];     /*!< Client types mix.        */
+        int                 nb_users;             /*!< Client types.            */
+        struct mix          tags[SWARM_MIX];      /*!< TAGs mix.                */
+        int                 nb_tags;              /*!< TAGs.                    */
+};
+
+struct worker;
+
+/*! Simulated client. */
+struct session {
+        struct worker         * worker;                 /*!< Owner thread.     */
+        struct packet_decoder   decoder;                /*!< Answers decoder.  */
+        int                     fd;                     /*!< Socket.           */
+        int                     state;                  /*!< SESSION_*.        */
+        int                     user;                   /*!< Client type.      */
+        unsigned long long      since;                  /*!< State start (ns). */
+        unsigned long long      sent;                   /*!< Sent packets.     */
+        int                     head;                   /*!< Oldest packet.    */
+        int                     outstanding;            /*!< Unanswered.       */
+        unsigned long long      times[SWARM_WINDOW];    /*!< Sending dates.    */
+        unsigned char           kinds[SWARM_WINDOW];    /*!< Mix entries.      */
+};
+
+/*! Load generator thread. */
+struct worker {
+        const struct config    * config;                 /*!< Configuration.    */
+        pthread_t                thread;                 /*!< Thread.           */
+        struct event_loop      * loop;                   /*!< Event loop.       */
+        struct session         * sessions;               /*!< Sessions.         */
+        int                      nb_sessions;            /*!< Sessions count.   */
+        struct xbuf            * hello[SWARM_MIX];       /*!< User packets.     */
+        struct xbuf            * packets[SWARM_MIX];     /*!< TAG packets.      */
+        unsigned int             seed;                   /*!< Random state.     */
+        unsigned long long       end;                    /*!< End date (ns).    */
+        unsigned long long       connected_at;           /*!< Last session up.  */
+        int                      next;                   /*!< Next to connect.  */
+        int                      nb_connecting;          /*!< In progress.      */
+        int                      nb_connected;           /*!< Sessions up.      */
+        int                      nb_failed;              /*!< Connect failures. */
+        int                      nb_closed;              /*!< Lost sessions.    */
+        unsigned long long       nb_sent;                /*!< Sent packets.     */
+        unsigned long long       nb_throttled;           /*!< Window full.      */
+        unsigned long long       tag_sent[SWARM_MIX];    /*!< Sent per TAG.     */
+        struct metrics_histogram handshake;              /*!< Handshakes.       */
+        struct metrics_histogram latency[SWARM_MIX];     /*!< Per TAG.          */
+};
+
+/*! Stand-in server connection. */
+struct standin {
+        struct event_loop     * loop;      /*!< Worker loop.   */
+        struct packet_decoder   decoder;   /*!< Decoder.       */
+        int                     fd;        /*!< Socket.        */
+        int                     echo;      /*!< Echo mode.     */
+};
+
+
+/*! Names of the client types. */
+static const char * user_names[] = {"god", "probe", "ship"};
+
+/*! Names of the TAGs, by value. */
+static const char * tag_names[] = {"noop", "get", "set", "add", "del", "load",
+                                   "save", "dump", "select"};
+
+
+/**
+ *  \brief Current date in nanoseconds.
+ */
+static unsigned long long now_ns(void)
+{
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (unsigned long long) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+
+/**
+ *  \brief Mix parsing: "name:weight,name:weight...".
+ *
+ * @param text          the mix
+ * @param names         known names (their index is their value)
+ * @param nb_names      number of names
+ * @param numbers       numeric values accepted
+ * @param mix           parsed entries
+ * @return              the number of entries, -1 on syntax error
+ */
+static int parse_mix(const char * text, const char ** names, int nb_names,
+                     int numbers, struct mix * mix)
+{
+        char * copy = strdup(text);
+        char * saved = NULL;
+        char * item;
+        int    count = 0;
+
+        for (item = strtok_r(copy, ",", &saved) ; item ;
+             item = strtok_r(NULL, ",", &saved))
+        {
+                char * weight = strchr(item, ':');
+                char * end;
+                int    i;
+
+                if (count == SWARM_MIX)
+                {
+                        break;
+                }
+                mix[count].weight = weight ? atoi(weight + 1) : 1;
+                if (weight)
+                {
+                        *weight = '\0';
+                }
+                mix[count].value = -1;
+                for (i = 0 ; i < nb_names ; i++)
+                {
+                        if (strcasecmp(item, names[i]) == 0)
+                        {
+                                mix[count].value = i;
+                        }
+                }
+                if ((mix[count].value < 0) && numbers)
+                {
+                        mix[count].value = strtol(item, &end, 0);
+                        if ((*end != '\0') || (mix[count].value > 0xFF))
+                        {
+                                mix[count].value = -1;
+                        }
+                }
+                if ((mix[count].value < 0) || (mix[count].weight <= 0))
+                {
+                        free(copy);
+                        return -1;
+                }
+                count++;
+        }
+        free(copy);
+
+        return count;
+}
+
+
+/**
+ *  \brief Weighted draw of a mix entry.
+ */
+static int draw(unsigned int * seed, const struct mix * mix, int count)
+{
+        int total = 0;
+        int pick;
+        int i;
+
+        for (i = 0 ; i < count ; i++)
+        {
+                total += mix[i].weight;
+        }
+        /* xorshift32 : suffisant pour répartir la charge. */
+        *seed ^= *seed << 13;
+        *seed ^= *seed >> 17;
+        *seed ^= *seed << 5;
+        pick = *seed % total;
+        for (i = 0 ; pick >= mix[i].weight ; i++)
+        {
+                pick -= mix[i].weight;
+        }
+
+        return i;
+}
+
+
+/**
+ *  \brief Stand-in packet handler: answers every packet.
+ */
+static void standin_received(const unsigned char * packet, int size, void * data)
+{
+        static __thread struct xbuf * ack = NULL;
+        struct standin              * connection = data;
+        struct xbuf                 * answer;
+
+        if (! packet)
+        {
+                event_remove(connection->loop, connection->fd);
+                close(connection->fd);
+                packet_decoder_free(&connection->decoder);
+                free(connection);
+                return;
+        }
+        if (connection->echo)
+        {
+                answer = xbuf_alloc(size);
+                memcpy(answer->data, packet, size);
+                answer->size = size;
+                event_send(connection->loop, connection->fd, answer);
+                xbuf_unref(answer);
+                return;
+        }
+        if (! ack)
+        {
+                ack = packet_create_shared(PACKET_MSG_ACK, NULL, 0);
+        }
+        event_send(connection->loop, connection->fd, ack);
+}
+
+
+/**
+ *  \brief Stand-in accept handler.
+ */
+static void standin_accepted(struct event_loop * loop, int fd, void * data)
+{
+        struct standin * connection = xmalloc(sizeof(struct standin));
+
+        connection->loop = loop;
+        connection->fd = fd;
+        connection->echo = *(int *) data;
+        packet_decoder_init(&connection->decoder);
+        if (event_add_reader(loop, fd, &connection->decoder, standin_received,
+                             connection) != SUCCESS)
+        {
+                close(fd);
+                free(connection);
+        }
+}
+
+
+/**
+ *  \brief Stand-in server start.
+ */
+static struct shards * standin_start(int port, int nb_workers, int * echo)
+{
+        struct shards_config config;
+        struct shards      * shards;
+
+        memset(&config, 0, sizeof(config));
+        config.port = port;
+        config.ip_address = "127.0.0.1";
+        config.nb_workers = nb_workers;
+        config.backlog = 4096;
+        config.accept = standin_accepted;
+        config.data = echo;
+        if (shards_start(&config, &shards) != SUCCESS)
+        {
+                fprintf(stderr, "swarm: cannot start the stand-in server\n");
+                exit(1);
+        }
+
+        return shards;
+}
+
+
+/**
+ *  \brief Session closing.
+ */
+static void session_close(struct session * session)
+{
+        if (session->fd >= 0)
+        {
+                event_remove(session->worker->loop, session->fd);
+                close(session->fd);
+                packet_decoder_free(&session->decoder);
+                session->fd = -1;
+        }
+        session->state = SESSION_CLOSED;
+}
+
+
+/**
+ *  \brief Sending of up to \c count packets, within the window.
+ *
+ * @return              the number of packets not sent (window full)
+ */
+static int session_send(struct session * session, int count)
+{
+        struct worker       * worker = session->worker;
+        const struct config * config = worker->config;
+
+        while ((count > 0) && (session->outstanding < config->window))
+        {
+                int kind = draw(&worker->seed, config->tags, config->nb_tags);
+                int slot = (session->head + session->outstanding) % SWARM_WINDOW;
+
+                if (event_send(worker->loop, session->fd, worker->packets[kind]) != SUCCESS)
+                {
+                        session_close(session);
+                        worker->nb_closed++;
+                        return 0;
+                }
+                session->times[slot] = now_ns();
+                session->kinds[slot] = kind;
+                session->outstanding++;
+                session->sent++;
+                worker->nb_sent++;
+                worker->tag_sent[kind]++;
+                count--;
+        }
+
+        return count;
+}
+
+
+/**
+ *  \brief Session packet handler: matches the answers with the packets.
+ */
+static void session_received(const unsigned char * packet, int size, void * data)
+{
+        struct session * session = data;
+        struct worker  * worker = session->worker;
+        unsigned long long now = now_ns();
+
+        (void) size;
+        if (! packet)
+        {
+                session_close(session);
+                worker->nb_closed++;
+                return;
+        }
+        if (session->state == SESSION_HANDSHAKE)
+        {
+                metrics_histogram_add(&worker->handshake, now - session->since);
+                session->state = SESSION_ACTIVE;
+                session->since = now;
+                session->sent = 0;
+                worker->nb_connected++;
+                worker->connected_at = now;
+        }
+        else if (session->outstanding > 0)
+        {
+                metrics_histogram_add(&worker->latency[session->kinds[session->head]],
+                                      now - session->times[session->head]);
+                session->head = (session->head + 1) % SWARM_WINDOW;
+                session->outstanding--;
+        }
+        if ((session->state == SESSION_ACTIVE) && (worker->config->rate == 0))
+        {
+                session_send(session, worker->config->window);
+        }
+}
+
+
+static void worker_connect(struct worker * worker);
+
+
+/**
+ *  \brief Connector handler: introduces the session to the server.
+ */
+static void session_connected(struct event_loop * loop, int fd, void * data)
+{
+        struct session * session = data;
+        struct worker  * worker = session->worker;
+
+        worker->nb_connecting--;
+        worker_connect(worker);
+        if (fd < 0)
+        {
+                session->state = SESSION_CLOSED;
+                worker->nb_failed++;
+                return;
+        }
+        session->fd = fd;
+        packet_decoder_init(&session->decoder);
+        if ((event_add_reader(loop, fd, &session->decoder, session_received,
+                              session) != SUCCESS) ||
+            (event_send(loop, fd, worker->hello[session->user]) != SUCCESS))
+        {
+                session_close(session);
+                worker->nb_failed++;
+                return;
+        }
+        session->state = SESSION_HANDSHAKE;
+        session->since = now_ns();
+}
+
+
+/**
+ *  \brief Connection of the next sessions, up to SWARM_RAMP in progress.
+ */
+static void worker_connect(struct worker * worker)
+{
+        const struct config * config = worker->config;
+
+        while ((worker->nb_connecting < SWARM_RAMP) &&
+               (worker->next < worker->nb_sessions))
+        {
+                struct session * session = &worker->sessions[worker->next++];
+
+                session->state = SESSION_CONNECTING;
+                worker->nb_connecting++;
+                if (connector_start(worker->loop, config->host, config->port,
+                                    SWARM_CONNECT, session_connected, session) < 0)
+                {
+                        worker->nb_connecting--;
+                        session->state = SESSION_CLOSED;
+                        worker->nb_failed++;
+                }
+        }
+}
+
+
+/**
+ *  \brief Timer handler: end of the run and sending at a given rate.
+ */
+static void worker_tick(struct event_loop * loop, int fd, int events, void * data)
+{
+        struct worker       * worker = data;
+        const struct config * config = worker->config;
+        unsigned long long    expirations;
+        unsigned long long    now = now_ns();
+        int                   i;
+
+        (void) events;
+        if (read(fd, &expirations, sizeof(expirations)) < 0)
+        {
+                return;
+        }
+        if (now >= worker->end)
+        {
+                event_loop_stop(loop);
+                return;
+        }
+        if (config->rate == 0)
+        {
+                return;
+        }
+        for (i = 0 ; i < worker->nb_sessions ; i++)
+        {
+                struct session   * session = &worker->sessions[i];
+                unsigned long long due;
+
+                if (session->state != SESSION_ACTIVE)
+                {
+                        continue;
+                }
+                due = (now - session->since) * config->rate / 1000000000ULL;
+                if (due > session->sent)
+                {
+                        int late = session_send(session, due - session->sent);
+
+                        /* Les paquets non envoyés ne sont pas rattrapés. */
+                        session->sent += late;
+                        worker->nb_throttled += late;
+                }
+        }
+}
+
+
+/**
+ *  \brief Load generator thread.
+ */
+static void * worker_run(void * arg)
+{
+        struct worker       * worker = arg;
+        const struct config * config = worker->config;
+        unsigned char       * data = calloc(1, config->size + LEN_NAME);
+        struct itimerspec     period;
+        int                   timer;
+        int                   i;
+
+        worker->loop = event_loop_create();
+        for (i = 0 ; i < config->nb_users ; i++)
+        {
+                int length = snprintf((char *) data, LEN_NAME, "swarm-%s",
+                                      user_names[config->users[i].value]);
+
+                worker->hello[i] = packet_create_shared(config->users[i].value,
+                                                        data, length);
+        }
+        memset(data, 0, LEN_NAME);
+        for (i = 0 ; i < config->nb_tags ; i++)
+        {
+                worker->packets[i] = packet_create_shared(config->tags[i].value,
+                                                          data, config->size);
+        }
+        free(data);
+
+        timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        period.it_interval.tv_sec = 0;
+        period.it_interval.tv_nsec = SWARM_TICK * 1000000;
+        period.it_value = period.it_interval;
+        timerfd_settime(timer, 0, &period, NULL);
+        event_add(worker->loop, timer, EVENT_READ, worker_tick, worker);
+
+        worker->end = now_ns() + config->duration * 1000000000ULL;
+        for (i = 0 ; i < worker->nb_sessions ; i++)
+        {
+                struct session * session = &worker->sessions[i];
+
+                session->worker = worker;
+                session->fd = -1;
+                session->state = SESSION_CLOSED;
+                session->user = draw(&worker->seed, config->users, config->nb_users);
+        }
+        worker_connect(worker);
+        event_loop_run(worker->loop);
+
+        for (i = 0 ; i < worker->nb_sessions ; i++)
+        {
+                session_close(&worker->sessions[i]);
+        }
+        event_remove(worker->loop, timer);
+        close(timer);
+        for (i = 0 ; i < config->nb_users ; i++)
+        {
+                xbuf_unref(worker->hello[i]);
+        }
+        for (i = 0 ; i < config->nb_tags ; i++)
+        {
+                xbuf_unref(worker->packets[i]);
+        }
+
+        return NULL;
+}
+
+
+/**
+ *  \brief Histogram merging.
+ */
+static void merge(struct metrics_histogram * to, const struct metrics_histogram * from)
+{
+        int i;
+
+        for (i = 0 ; i < METRICS_BUCKETS ; i++)
+        {
+                to->buckets[i] += from->buckets[i];
+        }
+        to->count += from->count;
+        to->sum += from->sum;
+        if (from->max > to->max)
+        {
+                to->max = from->max;
+        }
+}
+
+
+/**
+ *  \brief Results printing.
+ */
+static void report(const struct config * config, struct worker * workers,
+                   unsigned long long begin, unsigned long long end)
+{
+        struct metrics_histogram * all = calloc(1, sizeof(struct metrics_histogram));
+        struct metrics_histogram * tags = calloc(SWARM_MIX, sizeof(struct metrics_histogram));
+        struct metrics_histogram * handshake = calloc(1, sizeof(struct metrics_histogram));
+        unsigned long long         sent = 0, throttled = 0, last = begin;
+        unsigned long long         tag_sent[SWARM_MIX] = {0};
+        int                        connected = 0, failed = 0, closed = 0;
+        double                     seconds = (end - begin) / 1e9;
+        int                        i, j;
+
+        for (i = 0 ; i < config->nb_threads ; i++)
+        {
+                struct worker * worker = &workers[i];
+
+                connected += worker->nb_connected;
+                failed += worker->nb_failed;
+                closed += worker->nb_closed;
+                sent += worker->nb_sent;
+                throttled += worker->nb_throttled;
+                if (worker->connected_at > last)
+                {
+                        last = worker->connected_at;
+                }
+                merge(handshake, &worker->handshake);
+                for (j = 0 ; j < config->nb_tags ; j++)
+                {
+                        merge(&tags[j], &worker->latency[j]);
+                        merge(all, &worker->latency[j]);
+                        tag_sent[j] += worker->tag_sent[j];
+                }
+        }
+
+        printf("bench=swarm clients=%d threads=%d rate=%d window=%d size=%d "
+               "connected=%d failed=%d closed=%d ramp_ms=%.1f "
+               "handshake_p50_ns=%llu handshake_p99_ns=%llu "
+               "sent=%llu answered=%llu throttled=%llu seconds=%.2f "
+               "answers_per_second=%.0f p50_ns=%llu p90_ns=%llu p99_ns=%llu "
+               "p999_ns=%llu max_ns=%llu\n",
+               config->nb_clients, config->nb_threads, config->rate,
+               config->window, config->size, connected, failed, closed,
+               (last - begin) / 1e6,
+               metrics_percentile(handshake, 50),
+               metrics_percentile(handshake, 99),
+               sent, all->count, throttled, seconds,
+               seconds > 0 ? all->count / seconds : 0.0,
+               metrics_percentile(all, 50), metrics_percentile(all, 90),
+               metrics_percentile(all, 99), metrics_percentile(all, 99.9),
+               all->max);
+        for (j = 0 ; j < config->nb_tags ; j++)
+        {
+                printf("bench=swarm tag=0x%02X sent=%llu answered=%llu "
+                       "p50_ns=%llu p99_ns=%llu max_ns=%llu\n",
+                       config->tags[j].value, tag_sent[j], tags[j].count,
+                       metrics_percentile(&tags[j], 50),
+                       metrics_percentile(&tags[j], 99), tags[j].max);
+        }
+
+        free(handshake);
+        free(tags);
+        free(all);
+}
+
+
+/**
+ *  \brief Usage message.
+ */
+static void usage(const char * program)
+{
+        fprintf(stderr, "usage: %s [-H host] [-p port] [-c clients] [-t threads] "
+                "[-d seconds] [-r rate] [-w window] [-s size] [-u mix] [-m mix] "
+                "[-e] [-S]\n", program);
+        exit(1);
+}
+
+
+int main(int argc, char ** argv)
+{
+        struct config    config;
+        struct worker  * workers;
+        struct shards  * standin = NULL;
+        struct rlimit    limit;
+        unsigned long long begin;
+        int              server_only = 0;
+        int              option;
+        int              i;
+
+        memset(&config, 0, sizeof(config));
+        config.nb_clients = 1000;
+        config.nb_threads = 4;
+        config.duration = 2;
+        config.window = -1;
+        config.size = 16;
+        config.nb_users = parse_mix("probe:80,ship:15,god:5", user_names, 3, 0,
+                                    config.users);
+        config.nb_tags = parse_mix("get:60,set:30,noop:10", tag_names, 9, 1,
+                                   config.tags);
+
+        while ((option = getopt(argc, argv, "H:p:c:t:d:r:w:s:u:m:eS")) != -1)
+        {
+                switch (option)
+                {
+                        case 'H': config.host = optarg; break;
+                        case 'p': config.port = atoi(optarg); break;
+                        case 'c': config.nb_clients = atoi(optarg); break;
+                        case 't': config.nb_threads = atoi(optarg); break;
+                        case 'd': config.duration = atoi(optarg); break;
+                        case 'r': config.rate = atoi(optarg); break;
+                        case 'w': config.window = atoi(optarg); break;
+                        case 's': config.size = atoi(optarg); break;
+                        case 'u':
+                                config.nb_users = parse_mix(optarg, user_names,
+                                                            3, 0, config.users);
+                                break;
+                        case 'm':
+                                config.nb_tags = parse_mix(optarg, tag_names,
+                                                           9, 1, config.tags);
+                                break;
+                        case 'e': config.echo = 1; break;
+                        case 'S': server_only = 1; break;
+                        default: usage(argv[0]);
+                }
+        }
+        if (config.window < 0)
+        {
+                config.window = config.rate ? 16 : 1;
+        }
+        if ((config.nb_clients <= 0) || (config.nb_threads <= 0) ||
+            (config.duration <= 0) || (config.rate < 0) ||
+            (config.window <= 0) || (config.window > SWARM_WINDOW) ||
+            (config.size < 0) || (config.size > MAX_DATA_SIZE) ||
+            (config.nb_users <= 0) || (config.nb_tags <= 0))
+        {
+                usage(argv[0]);
+        }
+
+        /*
+         *      Les sessions fermées ne doivent pas tuer le serveur.
+         */
+        signal(SIGPIPE, SIG_IGN);
+
+        /*
+         *      Une socket par session (deux avec le serveur intégré).
+         */
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+        {
+                limit.rlim_cur = limit.rlim_max;
+                setrlimit(RLIMIT_NOFILE, &limit);
+        }
+
+        if (server_only)
+        {
+                standin = standin_start(config.port, config.nb_threads, &config.echo);
+                printf("bench=swarm standin_port=%d\n", shards_port(standin));
+                fflush(stdout);
+                for (;;)
+                {
+                        pause();
+                }
+        }
+        if (! config.host)
+        {
+                standin = standin_start(config.port, config.nb_threads, &config.echo);
+                config.host = "127.0.0.1";
+                config.port = shards_port(standin);
+        }
+
+        workers = calloc(config.nb_threads, sizeof(struct worker));
+        begin = now_ns();
+        for (i = 0 ; i < config.nb_threads ; i++)
+        {
+                struct worker * worker = &workers[i];
+
+                worker->config = &config;
+                worker->nb_sessions = config.nb_clients / config.nb_threads +
+                                      (i < config.nb_clients % config.nb_threads);
+                worker->sessions = calloc(worker->nb_sessions, sizeof(struct session));
+                worker->seed = 2463534242U + i;
+                pthread_create(&worker->thread, NULL, worker_run, worker);
+        }
+        for (i = 0 ; i < config.nb_threads ; i++)
+        {
+                pthread_join(workers[i].thread, NULL);
+        }
+        report(&config, workers, begin, now_ns());
+
+        for (i = 0 ; i < config.nb_threads ; i++)
+        {
+                event_loop_destroy(workers[i].loop);
+                free(workers[i].sessions);
+        }
+        free(workers);
+        if (standin)
+        {
+                shards_stop(standin);
+        }
+
+        return 0;
+}
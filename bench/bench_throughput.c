@@ -0,0 +1,143 @@
+/**
+ *  \file    bench_throughput.c
+ *  \brief   Throughput by payload size benchmark.
+ *
+ *           Project: cybercomms (Cyberspace communication library).
+ *
+ *           This program measures the one-way throughput of a loopback
+ *           connection for payloads from a 3 bytes message to the largest
+ *           packet. The sender emits a prepared packet with packet_send()
+ *           as fast as possible, the receiver reads it with packet_read().
+ *
+ *           Results are printed as one "key=value" line per payload size.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#include "cyberspace.h"
+
+
+/*! Maximum number of packets sent for a payload size. */
+#define MAX_PACKETS     200000
+
+/*! Number of bytes sent for a payload size (if less than MAX_PACKETS). */
+#define VOLUME          (128 * 1024 * 1024)
+
+/*! Sender parameters. */
+struct sender {
+        int             fd;        /*!< Sending socket.         */
+        int             size;      /*!< Size of the payload.    */
+        int             count;     /*!< Number of packets.      */
+};
+
+
+/**
+ *  \brief Sender thread: emits the packets of a run.
+ */
+static void * sender(void * arg)
+{
+        struct sender * sender = arg;
+        unsigned char * packet = malloc(PACKET_HEADER_SIZE + sender->size);
+        unsigned char * data = calloc(1, sender->size);
+        int             i;
+
+        packet_create(CMD_SET_PARAM, data, sender->size, packet);
+        for (i = 0 ; i < sender->count ; i++)
+        {
+                if (packet_send(sender->fd, packet) == 0)
+                {
+                        break;
+                }
+        }
+        free(data);
+        free(packet);
+
+        return NULL;
+}
+
+
+/**
+ *  \brief Runs one payload size and prints its results.
+ */
+static void run(int size)
+{
+        struct sockaddr_storage address;
+        struct sender           parameters;
+        struct timespec         begin, end;
+        pthread_t               thread;
+        unsigned char         * packet = malloc(MAX_PACKET_SIZE);
+        int                     listener, client, service;
+        int                     received = 0;
+        double                  elapsed, bytes;
+
+        listener = install_server(0, "127.0.0.1", &address);
+        client = connect_server("127.0.0.1", socket_local_port(listener));
+        service = accept_connection(listener, 0);
+        if ((listener < 0) || (client < 0) || (service < 0))
+        {
+                fprintf(stderr, "throughput: cannot open loopback connection\n");
+                exit(1);
+        }
+
+        parameters.fd = client;
+        parameters.size = size;
+        parameters.count = VOLUME / (PACKET_HEADER_SIZE + size);
+        if (parameters.count > MAX_PACKETS)
+        {
+                parameters.count = MAX_PACKETS;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        pthread_create(&thread, NULL, sender, &parameters);
+        while (received < parameters.count)
+        {
+                if (packet_read(service, packet, MAX_PACKET_SIZE) <= 0)
+                {
+                        break;
+                }
+                received++;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        pthread_join(thread, NULL);
+
+        elapsed = (end.tv_sec - begin.tv_sec) * 1e9
+                  + (end.tv_nsec - begin.tv_nsec);
+        bytes = (double) received * (PACKET_HEADER_SIZE + size);
+        printf("bench=throughput payload=%d packets=%d ns_per_packet=%.1f "
+               "packets_per_second=%.0f mb_per_second=%.1f\n",
+               size, received,
+               received ? elapsed / received : 0.0,
+               elapsed > 0 ? received * 1e9 / elapsed : 0.0,
+               elapsed > 0 ? bytes * 1e3 / elapsed : 0.0);
+
+        free(packet);
+        close(service);
+        close(client);
+        close(listener);
+}
+
+
+int main(void)
+{
+        static const int sizes[] = {3, 16, 64, 256, 1024, 4096, 16384, MAX_DATA_SIZE};
+        unsigned int     i;
+
+        for (i = 0 ; i < sizeof(sizes) / sizeof(sizes[0]) ; i++)
+        {
+                run(sizes[i]);
+        }
+
+        return 0;
+}
@@ -0,0 +1,573 @@
+/**
+ *  \file    compress.c
+ *  \brief   Packets compression.
+ *
+ *           Project: project independant file.
+ *
+ *           This file contains a fast LZ compressor producing the LZ4 block
+ *           format, without any external library, and the functions
+ *           compressing and expanding packets. Only the data of the
+ *           packets above a size threshold are compressed, and only when
+ *           it makes them smaller: the receiver rebuilds the original
+ *           packet before handling it.
+ *
+ *           The compressor uses a single hash table of the last positions
+ *           of 4 bytes sequences and a greedy parsing: it favours speed
+ *           over ratio.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "errors.h"
+#include "packets.h"
+#include "compress.h"
+#include "fragments.h"
+#include "tags.h"
+#include "xmem.h"
+
+
+/**
+ *  \defgroup lzinternals LZ block format internals
+ *  @{
+ */
+
+/*! Minimum length of a match. */
+#define LZ_MIN_MATCH            4
+
+/*! Number of literals that always end a block. */
+#define LZ_LAST_LITERALS        5
+
+/*! No match may start in the last LZ_MATCH_LIMIT bytes of a block. */
+#define LZ_MATCH_LIMIT          12
+
+/*! Maximum distance of a match. */
+#define LZ_MAX_OFFSET           65535
+
+/*! Size (log2) of the hash table. */
+#define LZ_HASH_LOG             12
+
+/** @} */
+
+
+/**
+ *  \brief Function returning the CPU time of the calling thread.
+ *
+ * @return              the CPU time in nanoseconds
+ */
+static unsigned long long cpu_ns(void)
+{
+        struct timespec now;
+
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+
+        return (unsigned long long) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+
+/**
+ *  \brief Function reading 4 bytes.
+ *
+ * @param data          bytes to read
+ * @return              the bytes as a number
+ */
+static unsigned int read32(const unsigned char * data)
+{
+        unsigned int value;
+
+        memcpy(&value, data, sizeof(value));
+
+        return value;
+}
+
+
+/**
+ *  \brief Function writing a length in the LZ4 extended encoding.
+ *
+ * @param destination   output
+ * @param length        length beyond the 15 of the token
+ * @return              the number of written bytes
+ */
+static int put_length(unsigned char * destination, int length)
+{
+        int written = 0;
+
+        while (length >= 255)
+        {
+                destination[written++] = 255;
+                length -= 255;
+        }
+        destination[written++] = length;
+
+        return written;
+}
+
+
+/**
+ *  \brief Function writing a sequence (literals followed by a match or
+ *         by the end of the block).
+ *
+ * @param destination   output
+ * @param capacity      remaining size of the output
+ * @param literals      literals to copy
+ * @param nb_literals   number of literals
+ * @param offset        distance of the match (0 for the last sequence)
+ * @param match         length of the match
+ * @return              the number of written bytes or 0 if the output is
+ *                      too small
+ */
+static int put_sequence(unsigned char * destination, int capacity,
+                        const unsigned char * literals, int nb_literals,
+                        int offset, int match)
+{
+        int needed = 1 + nb_literals + nb_literals / 255 + 1
+                     + (offset ? 2 + match / 255 + 1 : 0);
+        int written = 1;
+
+        if (needed > capacity)
+        {
+                return 0;
+        }
+
+        destination[0] = ((nb_literals < 15) ? nb_literals : 15) << 4;
+        if (nb_literals >= 15)
+        {
+                written += put_length(&destination[written], nb_literals - 15);
+        }
+        memcpy(&destination[written], literals, nb_literals);
+        written += nb_literals;
+
+        if (offset)
+        {
+                match -= LZ_MIN_MATCH;
+                destination[0] |= (match < 15) ? match : 15;
+                destination[written++] = (offset & 0xFF);
+                destination[written++] = ((offset >> 8) & 0xFF);
+                if (match >= 15)
+                {
+                        written += put_length(&destination[written], match - 15);
+                }
+        }
+
+        return written;
+}
+
+
+/**
+ *  \brief LZ compression function.
+ *
+ *         This function compresses a block in the LZ4 block format.
+ *
+ * @param source        data to compress
+ * @param size          size of the data
+ * @param destination   compressed data
+ * @param capacity      size of the destination (COMPRESS_BOUND(size) is
+ *                      always enough)
+ * @return              the size of the compressed data or 0 if it does not
+ *                      fit in the destination
+ */
+int lz_compress(const unsigned char * source, int size,
+                unsigned char * destination, int capacity)
+{
+        int table[1 << LZ_HASH_LOG];
+        int position = 0;
+        int anchor = 0;
+        int written = 0;
+
+        /*
+         *      Les positions sont stockées plus un : 0 signifie vide.
+         */
+        memset(table, 0, sizeof(table));
+        while (position < size - LZ_MATCH_LIMIT)
+        {
+                unsigned int sequence = read32(&source[position]);
+                unsigned int hash = (sequence * 2654435761U) >> (32 - LZ_HASH_LOG);
+                int          reference = table[hash] - 1;
+                int          match;
+                int          part;
+
+                table[hash] = position + 1;
+                if ((reference < 0) || (position - reference > LZ_MAX_OFFSET) ||
+                    (read32(&source[reference]) != sequence))
+                {
+                        position++;
+                        continue;
+                }
+
+                match = LZ_MIN_MATCH;
+                while ((position + match < size - LZ_LAST_LITERALS) &&
+                       (source[reference + match] == source[position + match]))
+                {
+                        match++;
+                }
+
+                part = put_sequence(&destination[written], capacity - written,
+                                    &source[anchor], position - anchor,
+                                    position - reference, match);
+                if (part == 0)
+                {
+                        return 0;
+                }
+                written += part;
+                position += match;
+                anchor = position;
+        }
+
+        position = put_sequence(&destination[written], capacity - written,
+                                &source[anchor], size - anchor, 0, 0);
+
+        return (position > 0) ? written + position : 0;
+}
+
+
+/**
+ *  \brief Function reading a length in the LZ4 extended encoding.
+ *
+ * @param source        input
+ * @param size          size of the input
+ * @param position      position in the input (updated)
+ * @param length        length read from the token (updated)
+ * @return              the status of the operation
+ * @retval SUCCESS              length read
+ * @retval -ERR_BAD_PROTOCOL    truncated input
+ */
+static int get_length(const unsigned char * source, int size, int * position,
+                      int * length)
+{
+        unsigned char byte;
+
+        if (*length != 15)
+        {
+                return SUCCESS;
+        }
+        do
+        {
+                if (*position >= size)
+                {
+                        return -ERR_BAD_PROTOCOL;
+                }
+                byte = source[(*position)++];
+                *length += byte;
+        } while (byte == 255);
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief LZ decompression function.
+ *
+ *         This function decompresses a block in the LZ4 block format. The
+ *         input is checked: a corrupted block cannot make it read or write
+ *         out of the buffers.
+ *
+ * @param source        compressed data
+ * @param size          size of the compressed data
+ * @param destination   decompressed data
+ * @param capacity      size of the destination
+ * @return              the size of the decompressed data or a negative
+ *                      value in case of error
+ * @retval -ERR_BAD_PROTOCOL    corrupted block or destination too small
+ */
+int lz_decompress(const unsigned char * source, int size,
+                  unsigned char * destination, int capacity)
+{
+        int position = 0;
+        int written = 0;
+
+        while (position < size)
+        {
+                int token = source[position++];
+                int length = token >> 4;
+                int offset;
+
+                check(get_length(source, size, &position, &length));
+                if ((length > size - position) || (length > capacity - written))
+                {
+                        return -ERR_BAD_PROTOCOL;
+                }
+                memcpy(&destination[written], &source[position], length);
+                position += length;
+                written += length;
+                if (position == size)
+                {
+                        break;
+                }
+
+                if (size - position < 2)
+                {
+                        return -ERR_BAD_PROTOCOL;
+                }
+                offset = source[position] | (source[position + 1] << 8);
+                position += 2;
+                length = token & 0x0F;
+                check(get_length(source, size, &position, &length));
+                length += LZ_MIN_MATCH;
+                if ((offset == 0) || (offset > written) ||
+                    (length > capacity - written))
+                {
+                        return -ERR_BAD_PROTOCOL;
+                }
+                if (offset >= length)
+                {
+                        memcpy(&destination[written], &destination[written - offset], length);
+                        written += length;
+                }
+                else
+                {
+                        /*
+                         *      Recouvrement : copie octet par octet.
+                         */
+                        while (length-- > 0)
+                        {
+                                destination[written] = destination[written - offset];
+                                written++;
+                        }
+                }
+        }
+
+        return written;
+}
+
+
+/**
+ *  \brief Compression state initialisation.
+ *
+ * @param compressor    the compression state of a connection
+ * @param threshold     minimum data size of the compressed packets (0 for
+ *                      COMPRESS_THRESHOLD)
+ */
+void compress_init(struct compressor * compressor, int threshold)
+{
+        memset(compressor, 0, sizeof(struct compressor));
+        compressor->threshold = (threshold > 0) ? threshold : COMPRESS_THRESHOLD;
+}
+
+
+/**
+ *  \brief CPU time measurement setting function.
+ *
+ *         The CPU time spent compressing and decompressing is only
+ *         measured on demand: reading the CPU time of the thread is a
+ *         system call, twice per packet. It is meant to tune the threshold,
+ *         not to stay enabled.
+ *
+ * @param compressor    the compression state of a connection
+ * @param timing        1 to measure the CPU time, 0 to stop measuring it
+ */
+void compress_timing(struct compressor * compressor, int timing)
+{
+        compressor->timing = timing;
+}
+
+
+/**
+ *  \brief Packet compression function.
+ *
+ *         This function replaces a complete packet by a PACKET_COMPRESSED
+ *         packet if its data are at least as large as the threshold and if
+ *         compression makes them smaller. The compressed packet is written
+ *         in place: it is never larger than the original one.
+ *
+ * @param compressor    the compression state of the connection
+ * @param packet        the packet (L + TAG + DATA)
+ * @return              the size of the packet, compressed or not
+ */
+int compress_packet(struct compressor * compressor, unsigned char * packet)
+{
+        unsigned char      * data = &packet[PACKET_HEADER_SIZE];
+        int                  size = packet_data_len(packet) - PACKET_TAG_SIZE;
+        struct xbuf        * buffer;
+        unsigned long long   start;
+        int                  compressed;
+
+        compressor->stats.packets++;
+        if ((size < compressor->threshold) || (size <= COMPRESS_HEADER_SIZE + 1) ||
+            (packet[PACKET_LEN_SIZE] == PACKET_COMPRESSED))
+        {
+                return PACKET_HEADER_SIZE + size;
+        }
+
+        buffer = xbuf_alloc(size);
+        start = compressor->timing ? cpu_ns() : 0;
+        /*
+         *      La place disponible impose un gain d'au moins un octet.
+         */
+        compressed = lz_compress(data, size, buffer->data,
+                                 size - COMPRESS_HEADER_SIZE - 1);
+        if (compressor->timing)
+        {
+                compressor->stats.compress_ns += cpu_ns() - start;
+        }
+        if (compressed == 0)
+        {
+                /*
+                 *      Données incompressibles : le paquet reste tel quel.
+                 */
+                xbuf_unref(buffer);
+                return PACKET_HEADER_SIZE + size;
+        }
+
+        data[0] = packet[PACKET_LEN_SIZE];
+        data[1] = (size & 0xFF);
+        data[2] = ((size >> 8) & 0xFF);
+        memcpy(&data[COMPRESS_HEADER_SIZE], buffer->data, compressed);
+        xbuf_unref(buffer);
+        packet[0] = ((COMPRESS_HEADER_SIZE + compressed + PACKET_TAG_SIZE) & 0xFF);
+        packet[1] = (((COMPRESS_HEADER_SIZE + compressed + PACKET_TAG_SIZE) >> 8) & 0xFF);
+        packet[PACKET_LEN_SIZE] = PACKET_COMPRESSED;
+
+        compressor->stats.compressed++;
+        compressor->stats.bytes_in += size;
+        compressor->stats.bytes_out += COMPRESS_HEADER_SIZE + compressed;
+
+        return PACKET_HEADER_SIZE + COMPRESS_HEADER_SIZE + compressed;
+}
+
+
+/**
+ *  \brief Payload of any size emitting function with compression.
+ *
+ *         This function is the compressed equivalent of
+ *         fragment_send_large(): a payload that fits in a packet is sent
+ *         as a normal packet, larger payloads as fragments, and each packet
+ *         is compressed by compress_packet(). Queued connections should
+ *         rather use outqueue_compress().
+ *
+ * @param socket_fd     the socket's file descriptor
+ * @param compressor    the compression state of the connection
+ * @param type          TAG of the payload
+ * @param data          payload
+ * @param size          size of the payload
+ * @return              the status of the operation
+ * @retval SUCCESS                      payload sent
+ * @retval -ERR_CONNECTION_LOST         connection lost
+ */
+int compress_send(int socket_fd, struct compressor * compressor, int type,
+                  const unsigned char * data, size_t size)
+{
+        struct xbuf * buffer = xbuf_alloc(MAX_PACKET_SIZE);
+        size_t        sent = 0;
+        int           status = SUCCESS;
+
+        do
+        {
+                unsigned char * packet = buffer->data;
+                int             header = 0;
+                int             part;
+                int             length;
+
+                if (size <= MAX_DATA_SIZE)
+                {
+                        part = (int) size;
+                        packet[PACKET_LEN_SIZE] = (type & 0xFF);
+                }
+                else
+                {
+                        part = (size - sent > FRAGMENT_DATA_SIZE)
+                               ? FRAGMENT_DATA_SIZE
+                               : (int) (size - sent);
+                        header = FRAGMENT_HEADER_SIZE;
+                        packet[PACKET_LEN_SIZE] = PACKET_FRAGMENT;
+                        packet[PACKET_HEADER_SIZE] = (type & 0xFF);
+                        packet[PACKET_HEADER_SIZE + 1] = ((sent == 0) ? FRAGMENT_FIRST : 0)
+                                                         | ((sent + part == size)
+                                                            ? FRAGMENT_LAST : 0);
+                }
+                if (part > 0)
+                {
+                        memcpy(&packet[PACKET_HEADER_SIZE + header], &data[sent], part);
+                }
+                packet[0] = ((header + part + PACKET_TAG_SIZE) & 0xFF);
+                packet[1] = (((header + part + PACKET_TAG_SIZE) >> 8) & 0xFF);
+
+                length = compress_packet(compressor, packet);
+                if (packet_send(socket_fd, packet) != length)
+                {
+                        status = -ERR_CONNECTION_LOST;
+                        break;
+                }
+                sent += part;
+        }
+        while (sent < size);
+        xbuf_unref(buffer);
+
+        return status;
+}
+
+
+/**
+ *  \brief Compressed packet expansion function.
+ *
+ *         This function rebuilds the original packet (L + TAG + DATA) of a
+ *         PACKET_COMPRESSED packet. The size of the compressed data is
+ *         given by \c size rather than by the LEN bytes of the packet.
+ *
+ * @param compressor    the compression state of the connection (NULL for
+ *                      no counters)
+ * @param packet        the received packet
+ * @param size          the size of the received packet
+ * @param result        the original packet
+ * @param capacity      size of result (MAX_PACKET_SIZE is always enough)
+ * @return              the size of the original packet, 0 if the packet is
+ *                      not compressed, or a negative value in case of error
+ * @retval -ERR_BAD_PROTOCOL    corrupted packet or result too small
+ * @retval -ERR_BAD_PACKET      compressed packet in a compressed packet
+ */
+int compress_expand(struct compressor * compressor, const unsigned char * packet,
+                    int size, unsigned char * result, int capacity)
+{
+        const unsigned char * data = &packet[PACKET_HEADER_SIZE];
+        unsigned long long    start;
+        int                   original;
+        int                   expanded;
+
+        if ((size < PACKET_HEADER_SIZE) || (packet_type(packet) != PACKET_COMPRESSED))
+        {
+                return 0;
+        }
+        size -= PACKET_HEADER_SIZE;
+        if (size < COMPRESS_HEADER_SIZE)
+        {
+                return -ERR_BAD_PROTOCOL;
+        }
+        if (data[0] == PACKET_COMPRESSED)
+        {
+                return -ERR_BAD_PACKET;
+        }
+        original = data[1] | (data[2] << 8);
+        if ((original > MAX_DATA_SIZE) || (PACKET_HEADER_SIZE + original > capacity))
+        {
+                return -ERR_BAD_PROTOCOL;
+        }
+
+        start = (compressor && compressor->timing) ? cpu_ns() : 0;
+        expanded = lz_decompress(&data[COMPRESS_HEADER_SIZE], size - COMPRESS_HEADER_SIZE,
+                                 &result[PACKET_HEADER_SIZE], original);
+        if (compressor && compressor->timing)
+        {
+                compressor->stats.expand_ns += cpu_ns() - start;
+        }
+        if (expanded != original)
+        {
+                return -ERR_BAD_PROTOCOL;
+        }
+
+        result[0] = ((original + PACKET_TAG_SIZE) & 0xFF);
+        result[1] = (((original + PACKET_TAG_SIZE) >> 8) & 0xFF);
+        result[PACKET_LEN_SIZE] = data[0];
+        if (compressor)
+        {
+                compressor->stats.expanded++;
+        }
+
+        return PACKET_HEADER_SIZE + original;
+}
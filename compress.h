@@ -0,0 +1,97 @@
+/**
+ *  \file    compress.h
+ *  \brief   Packets compression.
+ *
+ *           Project: project independant file.
+ *
+ *           This is the header file of compress.c and contains all the
+ *           constants, structures and functions declarations needed to
+ *           compress the data of large packets.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <stddef.h>
+
+/**
+ *  \defgroup compress Packets compression constants and structures
+ *
+ *  \details
+ *  A packet whose data are at least as large as the compression threshold
+ *  is sent as a PACKET_COMPRESSED packet when compression makes it
+ *  smaller. The data of a compressed packet are:
+ *  - <tt>1 byte</tt>  the TAG of the original packet
+ *  - <tt>2 bytes</tt> the size of the original data (little-endian)
+ *  - <tt>x bytes</tt> the original data compressed in the LZ4 block format
+ *
+ *  Smaller packets (ACK, NACK, errors...) are always sent as they are.
+ *  Any other packet can be compressed, fragments and identified requests
+ *  included, but not a compressed packet. Compressed packets must only be
+ *  sent to a peer that announced CAPABILITY_COMPRESSION: through
+ *  compress_send(), or through an outgoing queue given a compressor (see
+ *  outqueue_compress()).
+ *
+ *  The receive path rebuilds the original packets: packet_read(),
+ *  packet_ring_read(), packet_ring_recv(), packet_decoder_feed(),
+ *  dispatch_packet() and fragment_reassemble() expand them before
+ *  handling them, and compress_expand() does it for the other readers.
+ *  @{
+ */
+
+/*! Default size of the data from which a packet is compressed. */
+#define COMPRESS_THRESHOLD      256
+
+/*! Size of the compression information in front of the compressed data. */
+#define COMPRESS_HEADER_SIZE    3
+
+/*! Maximum compressed size of \c size bytes. */
+#define COMPRESS_BOUND(size)    ((size) + (size) / 255 + 16)
+
+/*! Compression counters, to tune the threshold. */
+struct compress_stats {
+        unsigned long        packets;      /*!< Packets given to the compressor.  */
+        unsigned long        compressed;   /*!< Packets sent compressed.          */
+        unsigned long        expanded;     /*!< Packets decompressed.             */
+        unsigned long long   bytes_in;     /*!< Data size before compression.     */
+        unsigned long long   bytes_out;    /*!< Data size after compression.      */
+        unsigned long long   compress_ns;  /*!< CPU time spent compressing
+                                                (see compress_timing()).          */
+        unsigned long long   expand_ns;    /*!< CPU time spent decompressing
+                                                (see compress_timing()).          */
+};
+
+/*! Compression state of a connection. It must be initialised with
+ *  compress_init().
+ */
+struct compressor {
+        int                   threshold;  /*!< Minimum compressed data size.  */
+        int                   timing;     /*!< Measure the CPU time spent.    */
+        struct compress_stats stats;      /*!< Counters.                      */
+};
+
+/** @} */
+
+
+/** @cond DUPLICATE_DOCUMENTATION */
+int lz_compress(const unsigned char * source, int size,
+                unsigned char * destination, int capacity);
+int lz_decompress(const unsigned char * source, int size,
+                  unsigned char * destination, int capacity);
+void compress_init(struct compressor * compressor, int threshold);
+void compress_timing(struct compressor * compressor, int timing);
+int compress_packet(struct compressor * compressor, unsigned char * packet);
+int compress_send(int socket_fd, struct compressor * compressor, int type,
+                  const unsigned char * data, size_t size);
+int compress_expand(struct compressor * compressor, const unsigned char * packet,
+                    int size, unsigned char * result, int capacity);
+/** @endcond */
+
+
+#endif /* COMPRESS_H */
@@ -0,0 +1,432 @@
+/**
+ *  \file    connector.c
+ *  \brief   Event loop connections to servers.
+ *
+ *           Project: project independant file.
+ *
+ *           This file contains the non-blocking version of
+ *           connect_server_timeout(): the name of the server is resolved
+ *           by the resolver threads, and its addresses are tried Happy
+ *           Eyeballs style by the event loop, so that a single thread can
+ *           open many connections at once. The delays are handled with a
+ *           timerfd and the end of the resolution is signaled by an
+ *           eventfd, both registered in the loop.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#include "errors.h"
+#include "resolver.h"
+#include "sockets.h"
+#include "events.h"
+#include "connector.h"
+
+
+/**
+ *  \defgroup cointernals Connector internals
+ *  @{
+ */
+
+/*! Connection in progress. */
+struct connector {
+        struct event_loop     * loop;          /*!< Event loop.                */
+        connector_handler       handler;       /*!< Result handler.            */
+        void                  * data;          /*!< Handler data.              */
+        int                     resolved;      /*!< eventfd: names resolved.   */
+        int                     timer;         /*!< timerfd: next delay.       */
+        int                     status;        /*!< Resolution status.         */
+        long long               deadline;      /*!< Deadline (0 for none).     */
+        long long               next_start;    /*!< Date of the next attempt.  */
+        int                     nb_addresses;  /*!< Number of addresses.       */
+        int                     nb_started;    /*!< Attempts started.          */
+        int                     nb_attempts;   /*!< Attempts in progress.      */
+        int                     attempts[RESOLVER_MAX_ADDRESSES]; /*!< Sockets. */
+        struct resolver_address addresses[RESOLVER_MAX_ADDRESSES]; /*!< Addresses. */
+};
+
+/** @} */
+
+
+/**
+ *  \brief Current date in milliseconds, unaffected by the clock changes.
+ */
+static long long connector_now(void)
+{
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (long long) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+
+/**
+ *  \brief End of a connection: releases everything but the kept socket
+ *         and calls the handler.
+ *
+ *         When the resolution is not over (deadline elapsed), the
+ *         connection is only released by connector_resolved(): the
+ *         resolver thread still uses it.
+ *
+ * @param connector     the connection
+ * @param fd            connected socket or error code
+ */
+static void connector_end(struct connector * connector, int fd)
+{
+        struct event_loop * loop = connector->loop;
+        connector_handler   handler = connector->handler;
+        void              * data = connector->data;
+        int                 i;
+
+        for (i = 0 ; i < connector->nb_attempts ; i++)
+        {
+                event_remove(loop, connector->attempts[i]);
+                if (connector->attempts[i] != fd)
+                {
+                        close(connector->attempts[i]);
+                }
+        }
+        event_remove(loop, connector->timer);
+        close(connector->timer);
+        if (connector->resolved >= 0)
+        {
+                connector->handler = NULL;
+        }
+        else
+        {
+                free(connector);
+        }
+
+        handler(loop, fd, data);
+}
+
+
+/**
+ *  \brief Timer setting for the next attempt or the deadline.
+ */
+static void connector_arm(struct connector * connector)
+{
+        struct itimerspec delay;
+        long long         date = 0;
+        long long         now = connector_now();
+
+        if (connector->nb_started < connector->nb_addresses)
+        {
+                date = connector->next_start;
+        }
+        if (connector->deadline && (! date || (connector->deadline < date)))
+        {
+                date = connector->deadline;
+        }
+
+        /* Une date nulle désarme le minuteur : on la décale d'1 ms. */
+        memset(&delay, 0, sizeof(delay));
+        if (date)
+        {
+                date = date > now ? date - now : 0;
+                delay.it_value.tv_sec = date / 1000;
+                delay.it_value.tv_nsec = (date % 1000) * 1000000 + 1000000;
+                if (delay.it_value.tv_nsec >= 1000000000)
+                {
+                        delay.it_value.tv_sec++;
+                        delay.it_value.tv_nsec -= 1000000000;
+                }
+        }
+        timerfd_settime(connector->timer, 0, &delay, NULL);
+}
+
+
+static void connector_ready(struct event_loop * loop, int fd, int events,
+                            void * data);
+
+
+/**
+ *  \brief Next attempts starting, when it is their turn.
+ *
+ * @param connector     the connection
+ * @return              0 if the connection goes on, 1 if it is over
+ */
+static int connector_next(struct connector * connector)
+{
+        int status = -ERR_CONNECT_SERVER;
+        int fd;
+
+        if (connector->resolved >= 0)
+        {
+                /* Résolution en cours : seule l'échéance compte. */
+                if (connector->deadline && (connector_now() >= connector->deadline))
+                {
+                        connector_end(connector, -ERR_TIMEOUT);
+                        return 1;
+                }
+                connector_arm(connector);
+                return 0;
+        }
+
+        while ((connector->nb_started < connector->nb_addresses) &&
+               ((connector_now() >= connector->next_start) ||
+                (connector->nb_attempts == 0)))
+        {
+                struct resolver_address * address;
+
+                address = &connector->addresses[connector->nb_started++];
+                fd = socket_connect_start((struct sockaddr *) &address->address,
+                                          address->length);
+                if ((fd >= 0) &&
+                    (event_add(connector->loop, fd, EVENT_WRITE,
+                               connector_ready, connector) != SUCCESS))
+                {
+                        close(fd);
+                        fd = -ERR_CONFIGURE_SOCKET;
+                }
+                if (fd < 0)
+                {
+                        status = fd;
+                        continue;
+                }
+                connector->attempts[connector->nb_attempts++] = fd;
+                connector->next_start = connector_now() + CONNECT_ATTEMPT_DELAY;
+        }
+
+        if (connector->nb_attempts == 0)
+        {
+                connector_end(connector, status);
+                return 1;
+        }
+        if (connector->deadline && (connector_now() >= connector->deadline))
+        {
+                connector_end(connector, -ERR_TIMEOUT);
+                return 1;
+        }
+        connector_arm(connector);
+        return 0;
+}
+
+
+/**
+ *  \brief Connection attempt handler: keeps the first connected socket.
+ *
+ * @param loop          event loop
+ * @param fd            socket of the attempt
+ * @param events        readiness of the socket
+ * @param data          the connection
+ */
+static void connector_ready(struct event_loop * loop, int fd, int events,
+                            void * data)
+{
+        struct connector * connector = data;
+        int                i;
+
+        (void) loop;
+        (void) events;
+        if (socket_connect_status(fd) == SUCCESS)
+        {
+                connector_end(connector, fd);
+                return;
+        }
+
+        /* Échec : la tentative suivante part tout de suite. */
+        for (i = 0 ; i < connector->nb_attempts ; i++)
+        {
+                if (connector->attempts[i] == fd)
+                {
+                        connector->attempts[i] =
+                                connector->attempts[--connector->nb_attempts];
+                        break;
+                }
+        }
+        event_remove(connector->loop, fd);
+        close(fd);
+        connector->next_start = 0;
+        connector_next(connector);
+}
+
+
+/**
+ *  \brief Timer handler: next attempt or deadline.
+ *
+ * @param loop          event loop
+ * @param fd            timerfd of the connection
+ * @param events        readiness of the timer
+ * @param data          the connection
+ */
+static void connector_timer(struct event_loop * loop, int fd, int events,
+                            void * data)
+{
+        uint64_t expirations;
+
+        (void) loop;
+        (void) events;
+        if (read(fd, &expirations, sizeof(expirations)) > 0)
+        {
+                connector_next(data);
+        }
+}
+
+
+/**
+ *  \brief Resolution handler, called in the event loop thread.
+ *
+ * @param loop          event loop
+ * @param fd            eventfd of the connection
+ * @param events        readiness of the eventfd
+ * @param data          the connection
+ */
+static void connector_resolved(struct event_loop * loop, int fd, int events,
+                               void * data)
+{
+        struct connector * connector = data;
+        uint64_t           value;
+
+        (void) events;
+        if (read(fd, &value, sizeof(value)) <= 0)
+        {
+                return;
+        }
+        event_remove(loop, fd);
+        close(fd);
+        connector->resolved = -1;
+        if (connector->handler == NULL)
+        {
+                /* Échéance passée pendant la résolution */
+                free(connector);
+                return;
+        }
+        if (connector->status <= 0)
+        {
+                connector_end(connector, -ERR_SERVER_INFO);
+                return;
+        }
+        connector->nb_addresses = connector->status;
+        resolver_interleave(connector->addresses, connector->nb_addresses);
+        connector_next(connector);
+}
+
+
+/**
+ *  \brief Resolution callback, called by a resolver thread (or by
+ *         connector_start() for a cached name): wakes the loop up.
+ *
+ * @param status        number of addresses or error code
+ * @param addresses     addresses of the server
+ * @param data          the connection
+ */
+static void connector_addresses(int status,
+                                const struct resolver_address * addresses,
+                                void * data)
+{
+        struct connector * connector = data;
+        uint64_t           one = 1;
+
+        if (status > 0)
+        {
+                memcpy(connector->addresses, addresses,
+                       status * sizeof(addresses[0]));
+        }
+        connector->status = status;
+        if (write(connector->resolved, &one, sizeof(one)) < 0)
+        {
+                perror("connector_addresses");
+        }
+}
+
+
+/**
+ *  \brief Connection to a server from an event loop.
+ *
+ *         This function starts the connection to a server like
+ *         connect_server_timeout(), without blocking: the name is resolved
+ *         by the resolver threads and the addresses are tried by the loop.
+ *         The handler is called once, from the loop thread, with the
+ *         connected socket or an error code (see connect_server_timeout()).
+ *         It must be called from the loop thread.
+ *
+ * @param loop          event loop
+ * @param machine       IP address or hostname of the server
+ * @param port          TCP port to connect to on the server
+ * @param timeout       deadline in milliseconds (0 for no deadline)
+ * @param handler       result handler
+ * @param data          handler data
+ * @return              the status of the operation
+ * @retval SUCCESS              connection started
+ * @retval -ERR_BAD_PARAMETER   missing machine or handler
+ * @retval -ERR_NO_MEMORY       could not allocate the connection
+ * @retval -ERR_SERVICE         could not create the eventfd or the timerfd
+ * @retval others               see event_add() and resolver_lookup_async()
+ */
+int connector_start(struct event_loop * loop, const char * machine, int port,
+                    int timeout, connector_handler handler, void * data)
+{
+        struct connector * connector;
+        int                status;
+
+        if (! loop || ! machine || ! handler)
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        connector = calloc(1, sizeof(struct connector));
+        if (! connector)
+        {
+                return -ERR_NO_MEMORY;
+        }
+        connector->loop = loop;
+        connector->handler = handler;
+        connector->data = data;
+        connector->deadline = timeout > 0 ? connector_now() + timeout : 0;
+        connector->resolved = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        connector->timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if ((connector->resolved < 0) || (connector->timer < 0))
+        {
+                status = -ERR_SERVICE;
+                goto error;
+        }
+
+        status = event_add(loop, connector->resolved, EVENT_READ,
+                           connector_resolved, connector);
+        if (status != SUCCESS)
+        {
+                goto error;
+        }
+        status = event_add(loop, connector->timer, EVENT_READ,
+                           connector_timer, connector);
+        if (status != SUCCESS)
+        {
+                event_remove(loop, connector->resolved);
+                goto error;
+        }
+        connector_arm(connector);
+
+        status = resolver_lookup_async(machine, port, AF_UNSPEC,
+                                       connector_addresses, connector);
+        if (status != SUCCESS)
+        {
+                event_remove(loop, connector->resolved);
+                event_remove(loop, connector->timer);
+                goto error;
+        }
+        return SUCCESS;
+
+error:
+        if (connector->resolved >= 0)
+        {
+                close(connector->resolved);
+        }
+        if (connector->timer >= 0)
+        {
+                close(connector->timer);
+        }
+        free(connector);
+        return status;
+}
@@ -0,0 +1,44 @@
+/**
+ *  \file    connector.h
+ *  \brief   Event loop connections to servers.
+ *
+ *           Project: project independant file.
+ *
+ *           This is the header file of connector.c and contains all the
+ *           types and functions declarations needed to connect servers
+ *           from an event loop.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#ifndef CONNECTOR_H
+#define CONNECTOR_H
+
+#include "events.h"
+
+/**
+ *  \defgroup connector Connector types
+ *  @{
+ */
+
+/*! Function called once a connection started by connector_start() is
+ *  over: \c fd is the connected socket (in non-blocking mode and not
+ *  registered in the loop) or a negative error code.
+ */
+typedef void (*connector_handler)(struct event_loop * loop, int fd,
+                                  void * data);
+
+/** @} */
+
+
+/** @cond DUPLICATE_DOCUMENTATION */
+int connector_start(struct event_loop * loop, const char * machine, int port,
+                    int timeout, connector_handler handler, void * data);
+/** @endcond */
+
+
+#endif /* CONNECTOR_H */
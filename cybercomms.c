@@ -67,7 +67,8 @@ int cyberspace_connect(const char * machine, int port, client_type user, const c
  *  \brief Cyberspace data transmission.
  *
  *         This function sends data between the cyberspace server and
- *         clients.
+ *         clients. The data are sent as they are, behind the packet
+ *         header, without being copied.
  *
  * @param fd            communication socket to use
  * @param tag           tag for data
@@ -77,9 +78,126 @@ int cyberspace_connect(const char * machine, int port, client_type user, const c
  */
 int cyberspace_transmit(int fd, int tag, unsigned char * data, int len)
 {
-        unsigned char packet[MAX_PACKET_SIZE] = {0};
+        struct iovec iov;
 
-        packet_create(tag, data, len, packet);
-        return packet_send(fd, packet);
+        iov.iov_base = data;
+        iov.iov_len = (len > 0) ? len : 0;
+
+        return packet_sendv(fd, tag, &iov, 1);
 }
 
+
+/**
+ *  \brief Cyberspace data broadcast.
+ *
+ *         This function sends the same data to many clients: the packet is
+ *         encoded once in a shared packet buffer and queued on the
+ *         outgoing queue of each client, without any copy. The buffer is
+ *         released when the last queue has sent it.
+ *
+ * @param queues        outgoing queues of the clients
+ * @param nb_queues     number of clients
+ * @param tag           tag for data
+ * @param data          data to transmit
+ * @param len           length of data to transmit
+ * @param flags         packet flags (OUTQUEUE_FLUSH to send at once)
+ * @return              the number of clients that did not get the packet
+ *                      (full queue) or whose connection is lost, or a
+ *                      negative value in case of error
+ * @retval -ERR_BAD_PARAMETER   invalid length
+ */
+int cyberspace_broadcast(struct outqueue ** queues, int nb_queues, int tag,
+                         const unsigned char * data, int len, int flags)
+{
+        struct xbuf * packet = packet_create_shared(tag, data, (len > 0) ? len : 0);
+        int           status;
+
+        if (! packet)
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        status = outqueue_broadcast(queues, nb_queues, packet, flags);
+        xbuf_unref(packet);
+
+        return status;
+}
+
+
+
+/**
+ *  \brief Cyberspace capabilities negotiation, client side.
+ *
+ *         This function sends the capabilities of the client in a
+ *         CMD_CAPABILITIES packet and waits for the ones of the server.
+ *         It should be called right after cyberspace_connect(). A server
+ *         that does not know the negotiation answers with a NACK or an
+ *         error: no capability is then enabled.
+ *
+ * @param fd            communication socket to use
+ * @param capabilities  capabilities of the client (CAPABILITY_*)
+ * @return              the capabilities enabled on both sides or a
+ *                      negative value in case of error
+ * @retval -ERR_CONNECTION_LOST         connection lost
+ */
+int cyberspace_negotiate(int fd, int capabilities)
+{
+        unsigned char packet[PACKET_HEADER_SIZE + PACKET_MSG_SIZE];
+        unsigned char data[PACKET_MSG_SIZE];
+        int           remote;
+
+        data[0] = (capabilities & 0xFF);
+        data[1] = ((capabilities >> 8) & 0xFF);
+        if (cyberspace_transmit(fd, CMD_CAPABILITIES, data, PACKET_MSG_SIZE) == 0)
+        {
+                return -ERR_CONNECTION_LOST;
+        }
+        if (packet_read(fd, packet, sizeof(packet)) == 0)
+        {
+                return -ERR_CONNECTION_LOST;
+        }
+        if ((packet_type(packet) != CMD_CAPABILITIES) ||
+            (packet_data_len(packet) < PACKET_TAG_SIZE + PACKET_MSG_SIZE))
+        {
+                return 0;
+        }
+        remote = packet[PACKET_HEADER_SIZE] | (packet[PACKET_HEADER_SIZE + 1] << 8);
+
+        return capabilities & remote;
+}
+
+
+/**
+ *  \brief Cyberspace capabilities negotiation, server side.
+ *
+ *         This function answers a CMD_CAPABILITIES packet received from a
+ *         client with the capabilities of the server.
+ *
+ * @param fd            communication socket to use
+ * @param packet        the received CMD_CAPABILITIES packet
+ * @param capabilities  capabilities of the server (CAPABILITY_*)
+ * @return              the capabilities enabled on both sides or a
+ *                      negative value in case of error
+ * @retval -ERR_BAD_PROTOCOL            invalid negotiation packet
+ * @retval -ERR_CONNECTION_LOST         connection lost
+ */
+int cyberspace_capabilities(int fd, const unsigned char * packet, int capabilities)
+{
+        unsigned char data[PACKET_MSG_SIZE];
+        int           remote;
+
+        if ((packet_type(packet) != CMD_CAPABILITIES) ||
+            (packet_data_len(packet) < PACKET_TAG_SIZE + PACKET_MSG_SIZE))
+        {
+                return -ERR_BAD_PROTOCOL;
+        }
+        remote = packet[PACKET_HEADER_SIZE] | (packet[PACKET_HEADER_SIZE + 1] << 8);
+
+        data[0] = (capabilities & 0xFF);
+        data[1] = ((capabilities >> 8) & 0xFF);
+        if (cyberspace_transmit(fd, CMD_CAPABILITIES, data, PACKET_MSG_SIZE) == 0)
+        {
+                return -ERR_CONNECTION_LOST;
+        }
+
+        return capabilities & remote;
+}
@@ -17,9 +17,22 @@
 #ifndef CYBERSPACE_H
 #define CYBERSPACE_H
 
+#include "compress.h"
+#include "connector.h"
 #include "errors.h"
+#include "events.h"
+#include "dispatch.h"
+#include "fragments.h"
+#include "metrics.h"
 #include "sockets.h"
 #include "packets.h"
+#include "params.h"
+#include "outqueue.h"
+#include "requests.h"
+#include "resolver.h"
+#include "shards.h"
+#include "shmem.h"
+#include "snapshots.h"
 #include "tags.h"
 #include "xmem.h"
 
@@ -31,6 +44,31 @@
 #define LEN_NAME        30      /*!< Maximum length for a name. */
 #define LEN_IPADDR      50      /*!< Maximum length for an IPv6 address + port. */
 
+/*! Capability: payloads larger than MAX_DATA_SIZE may be sent as
+ *  PACKET_FRAGMENT packets (see fragments.h).
+ */
+#define CAPABILITY_FRAGMENTS    0x0001
+
+/*! Capability: packets may be sent as PACKET_COMPRESSED packets (see
+ *  compress.h).
+ */
+#define CAPABILITY_COMPRESSION  0x0002
+
+/*! Capability: requests may be sent as PACKET_REQUEST packets and are
+ *  answered with PACKET_RESPONSE packets (see requests.h).
+ */
+#define CAPABILITY_PIPELINING   0x0004
+
+/*! Capability: CMD_GET_PARAM and CMD_SET_PARAM carry lists of parameters
+ *  (see params.h).
+ */
+#define CAPABILITY_BATCH        0x0008
+
+/*! Capability: same-host connections may be upgraded to shared memory
+ *  with a PACKET_SHM packet (see shmem.h).
+ */
+#define CAPABILITY_SHMEM        0x0010
+
 /*! Types of client that can connect to the cyberspace system server. */
 typedef enum {client_god, client_probe, client_ship} client_type;
 
@@ -40,6 +78,10 @@ typedef enum {client_god, client_probe, client_ship} client_type;
 /** @cond DUPLICATE_DOCUMENTATION */
 int cyberspace_connect(const char * machine, int port, client_type user, const char * name);
 int cyberspace_transmit(int fd, int tag, unsigned char * data, int len);
+int cyberspace_broadcast(struct outqueue ** queues, int nb_queues, int tag,
+                         const unsigned char * data, int len, int flags);
+int cyberspace_negotiate(int fd, int capabilities);
+int cyberspace_capabilities(int fd, const unsigned char * packet, int capabilities);
 /** @endcond */
 
 #endif /* CYBERSPACE_H */
@@ -0,0 +1,311 @@
+/**
+ *  \file    dispatch.c
+ *  \brief   Inbound packets dispatching.
+ *
+ *           Project: project independant file.
+ *
+ *           This file contains the dispatching of the received packets to
+ *           the handler registered for their TAG. The TAG indexes a flat
+ *           table of 256 entries, so that no switch over the TAG values is
+ *           needed in the receive path, and each entry counts its packets
+ *           so that per-TAG metrics are available in a single place.
+ *
+ *           A table is not locked: it should be owned by a single thread
+ *           (for instance one per worker of a sharded server).
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "errors.h"
+#include "packets.h"
+#include "tags.h"
+#include "dispatch.h"
+#include "requests.h"
+#include "compress.h"
+#include "xmem.h"
+
+
+/**
+ *  \brief Dispatch table initialisation.
+ *
+ *         All the TAGs get the given policy and no handler. The replies
+ *         are sent with request_message() (message_send() out of a
+ *         request).
+ *
+ * @param table         the table to initialise
+ * @param policy        default DISPATCH_* policy of the TAGs
+ */
+void dispatch_init(struct dispatch_table * table, int policy)
+{
+        int tag;
+
+        memset(table, 0, sizeof(struct dispatch_table));
+        for (tag = 0 ; tag < DISPATCH_TAGS ; tag++)
+        {
+                table->entries[tag].policy = policy;
+        }
+}
+
+
+/**
+ *  \brief TAG handler registration.
+ *
+ *         A previous registration of the TAG is replaced and its counters
+ *         are reset.
+ *
+ * @param table         dispatch table
+ * @param tag           the TAG to handle
+ * @param handler       handler of the TAG (NULL to only set the policy)
+ * @param data          user data given to the handler
+ * @param policy        DISPATCH_* reply policy of the TAG
+ * @return              the status of the registration
+ * @retval SUCCESS              handler registered
+ * @retval -ERR_OUT_OF_RANGE    invalid TAG
+ * @retval -ERR_BAD_PARAMETER   invalid policy
+ */
+int dispatch_register(struct dispatch_table * table, int tag,
+                      dispatch_handler handler, void * data, int policy)
+{
+        struct dispatch_entry * entry;
+
+        if ((tag < 0) || (tag >= DISPATCH_TAGS))
+        {
+                return -ERR_OUT_OF_RANGE;
+        }
+        if ((policy != DISPATCH_IGNORE) && (policy != DISPATCH_ACK) &&
+            (policy != DISPATCH_NACK))
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+
+        entry = &table->entries[tag];
+        memset(entry, 0, sizeof(struct dispatch_entry));
+        entry->handler = handler;
+        entry->data = data;
+        entry->policy = policy;
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Metric hook setting function.
+ *
+ * @param table         dispatch table
+ * @param metric        function called after each packet (NULL for none)
+ * @param data          user data given to the function
+ */
+void dispatch_set_metric(struct dispatch_table * table,
+                         dispatch_metric metric, void * data)
+{
+        table->metric = metric;
+        table->metric_data = data;
+}
+
+
+/**
+ *  \brief Reply function setting function.
+ *
+ *         By default, ACK and NACK messages are sent with
+ *         request_message(). A connection served by an event loop would
+ *         rather queue them; during an identified request, the function
+ *         should then wrap them in a response for request_current().
+ *
+ * @param table         dispatch table
+ * @param reply         function sending the replies (NULL: request_message())
+ * @param data          user data given to the function
+ */
+void dispatch_set_reply(struct dispatch_table * table,
+                        dispatch_reply reply, void * data)
+{
+        table->reply = reply;
+        table->reply_data = data;
+}
+
+
+/**
+ *  \brief Identified request dispatching.
+ *
+ *         The wrapped packet is rebuilt in a pool buffer and dispatched
+ *         as the request of the current thread, so that its answers are
+ *         wrapped in responses. A request wrapped in a request, directly
+ *         or in a compressed packet, is refused.
+ *
+ * @param table         dispatch table
+ * @param fd            socket on which the packet has been received
+ * @param packet        the PACKET_REQUEST packet
+ * @param size          the size of the packet
+ * @return              the status of the handling (see dispatch_packet())
+ * @retval -ERR_BAD_PACKET      nested request
+ */
+static int dispatch_request(struct dispatch_table * table, int fd,
+                            const unsigned char * packet, int size)
+{
+        int           data_size = size - PACKET_HEADER_SIZE - REQUEST_HEADER_SIZE;
+        struct xbuf * inner;
+        int           previous, status;
+
+        if (data_size < 0)
+        {
+                return -ERR_BAD_PROTOCOL;
+        }
+        packet += PACKET_HEADER_SIZE;
+        if ((packet[2] == PACKET_REQUEST) || (request_current() >= 0))
+        {
+                return -ERR_BAD_PACKET;
+        }
+
+        /*
+         *      Copie du paquet encapsulé : ses octets de longueur doivent
+         *      être les siens pour les fonctions qui les lisent.
+         */
+        inner = xbuf_alloc(data_size + PACKET_HEADER_SIZE);
+        packet_create(packet[2], (unsigned char *) packet + REQUEST_HEADER_SIZE,
+                      data_size, inner->data);
+
+        previous = request_enter(packet[0] | (packet[1] << 8));
+        status = dispatch_packet(table, fd, inner->data, data_size + PACKET_HEADER_SIZE);
+        request_leave(previous);
+        xbuf_unref(inner);
+
+        return status;
+}
+
+
+/**
+ *  \brief Compressed packet dispatching function.
+ *
+ *         The original packet is rebuilt in a pool buffer and dispatched.
+ *         A compressed packet wrapped in a compressed packet is refused.
+ *
+ * @param table         dispatch table
+ * @param fd            socket on which the packet has been received
+ * @param packet        the PACKET_COMPRESSED packet
+ * @param size          the size of the packet
+ * @return              the status of the handling (see dispatch_packet())
+ */
+static int dispatch_compressed(struct dispatch_table * table, int fd,
+                               const unsigned char * packet, int size)
+{
+        struct xbuf * original = xbuf_alloc(MAX_PACKET_SIZE);
+        int           status;
+
+        status = compress_expand(NULL, packet, size, original->data, MAX_PACKET_SIZE);
+        if (status > 0)
+        {
+                status = dispatch_packet(table, fd, original->data, status);
+        }
+        xbuf_unref(original);
+
+        return status;
+}
+
+
+/**
+ *  \brief Packet dispatching function.
+ *
+ *         This function calls the handler registered for the TAG of the
+ *         packet and answers according to the policy of the TAG. An
+ *         identified request (PACKET_REQUEST without handler) is unwrapped
+ *         and dispatched: the handlers should then answer with
+ *         request_answer(). A compressed packet (PACKET_COMPRESSED
+ *         without handler) is expanded and dispatched. A shared memory
+ *         offer (PACKET_SHM) is only accepted if the server registered
+ *         shmem_dispatch() for it: it is refused with a NACK otherwise,
+ *         whatever the policy of the TAG, since the client waits for the
+ *         answer before using the segment.
+ *
+ * @param table         dispatch table
+ * @param fd            socket on which the packet has been received
+ * @param packet        the packet (LEN + TAG + DATA)
+ * @param size          the size of the packet
+ * @return              the status of the handling
+ * @retval SUCCESS              packet handled (or dropped)
+ * @retval -ERR_BAD_PROTOCOL    truncated or corrupted packet, or refused TAG
+ * @retval -ERR_BAD_PACKET      request wrapped in a request or compressed
+ *                              packet wrapped in a compressed packet
+ * @retval -ERR_CONNECTION_LOST the reply could not be sent
+ * @retval others               error returned by the handler
+ */
+int dispatch_packet(struct dispatch_table * table, int fd,
+                    const unsigned char * packet, int size)
+{
+        struct dispatch_entry * entry;
+        int                     tag;
+        int                     status = SUCCESS;
+
+        if (size < PACKET_HEADER_SIZE)
+        {
+                return -ERR_BAD_PROTOCOL;
+        }
+        tag = packet[PACKET_LEN_SIZE];
+        entry = &table->entries[tag];
+        if ((tag == PACKET_REQUEST) && ! entry->handler &&
+            (entry->policy != DISPATCH_NACK))
+        {
+                return dispatch_request(table, fd, packet, size);
+        }
+        if ((tag == PACKET_COMPRESSED) && ! entry->handler &&
+            (entry->policy != DISPATCH_NACK))
+        {
+                return dispatch_compressed(table, fd, packet, size);
+        }
+        if ((tag == PACKET_SHM) && (! entry->handler ||
+                                    (entry->policy == DISPATCH_NACK)))
+        {
+                /*
+                 *      Mémoire partagée non demandée par le serveur : un
+                 *      acquittement ferait croire au client que le segment
+                 *      est utilisé, il faut un refus. La connexion reste
+                 *      utilisable par la socket.
+                 */
+                if (message_send(fd, PACKET_MSG_NACK, ERR_SHARED_MEMORY) == 0)
+                {
+                        return -ERR_CONNECTION_LOST;
+                }
+                return SUCCESS;
+        }
+
+        if (entry->policy == DISPATCH_NACK)
+        {
+                status = -ERR_BAD_PROTOCOL;
+        }
+        else if (entry->handler)
+        {
+                status = entry->handler(fd, packet, size, entry->data);
+        }
+
+        if (entry->policy != DISPATCH_IGNORE)
+        {
+                int type = (status == SUCCESS) ? PACKET_MSG_ACK : PACKET_MSG_NACK;
+                int sent = table->reply
+                           ? table->reply(fd, type, status, table->reply_data)
+                           : request_message(fd, type, status);
+
+                if ((sent == 0) && (status == SUCCESS))
+                {
+                        status = -ERR_CONNECTION_LOST;
+                }
+        }
+
+        entry->packets++;
+        entry->bytes += size;
+        if (status != SUCCESS)
+        {
+                entry->errors++;
+        }
+        if (table->metric)
+        {
+                table->metric(tag, size, status, table->metric_data);
+        }
+
+        return status;
+}
@@ -0,0 +1,114 @@
+/**
+ *  \file    dispatch.h
+ *  \brief   Inbound packets dispatching.
+ *
+ *           Project: project independant file.
+ *
+ *           This is the header file of dispatch.c and contains all the
+ *           constants, structures and functions declarations needed to
+ *           call a handler per TAG for the received packets.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+/**
+ *  \defgroup dispatch Dispatching constants and structures
+ *
+ *  \details
+ *  A dispatch table holds one entry for each of the 256 TAG values: the
+ *  TAG of a packet directly indexes the table. Each entry gives the
+ *  handler of the TAG and the reply policy:
+ *  - DISPATCH_IGNORE: the handler is called and nothing is answered (the
+ *    handler answers itself if needed); without handler, the packet is
+ *    dropped;
+ *  - DISPATCH_ACK: the handler is called, then PACKET_MSG_ACK is answered
+ *    if it succeeded and PACKET_MSG_NACK (with the error code) otherwise;
+ *  - DISPATCH_NACK: the TAG is refused, PACKET_MSG_NACK is answered and
+ *    the handler is not called.
+ *
+ *  A table can be filled at run time with dispatch_register(), or at
+ *  compile time with designated initialisers:
+ *  \code
+ *  static struct dispatch_table table = {
+ *          .entries = {
+ *                  [CMD_GET_PARAM] = DISPATCH_ENTRY(get_param, DISPATCH_IGNORE),
+ *                  [CMD_SET_PARAM] = DISPATCH_ENTRY(set_param, DISPATCH_ACK),
+ *          }
+ *  };
+ *  \endcode
+ *  @{
+ */
+
+/*! Number of entries of a dispatch table (one per TAG value). */
+#define DISPATCH_TAGS           256
+
+/*! Reply policy: no automatic answer. */
+#define DISPATCH_IGNORE         0
+
+/*! Reply policy: ACK on success, NACK on error. */
+#define DISPATCH_ACK            1
+
+/*! Reply policy: the TAG is refused with a NACK. */
+#define DISPATCH_NACK           2
+
+/*! Function handling a packet (LEN + TAG + DATA, of \c size bytes)
+ *  received on \c fd. It returns SUCCESS or a negative error code.
+ */
+typedef int (*dispatch_handler)(int fd, const unsigned char * packet,
+                                int size, void * data);
+
+/*! Function called after each dispatched packet, with the TAG, the packet
+ *  size and the status of its handling: the place to attach per-TAG
+ *  metrics.
+ */
+typedef void (*dispatch_metric)(int tag, int size, int status, void * data);
+
+/*! Function sending an ACK or NACK message (see request_message()). */
+typedef int (*dispatch_reply)(int fd, int type, int message, void * data);
+
+/*! Dispatch table entry. */
+struct dispatch_entry {
+        dispatch_handler    handler;  /*!< Handler of the TAG (or NULL).   */
+        void              * data;     /*!< User data of the handler.       */
+        int                 policy;   /*!< DISPATCH_* reply policy.        */
+        unsigned long       packets;  /*!< Number of dispatched packets.   */
+        unsigned long       bytes;    /*!< Size of dispatched packets.     */
+        unsigned long       errors;   /*!< Number of failed handlings.     */
+};
+
+/*! Dispatch table. */
+struct dispatch_table {
+        struct dispatch_entry entries[DISPATCH_TAGS];  /*!< Entries per TAG.  */
+        dispatch_metric       metric;       /*!< Metric hook (or NULL).       */
+        void                * metric_data;  /*!< User data of the hook.       */
+        dispatch_reply        reply;        /*!< Replies (NULL: request_message). */
+        void                * reply_data;   /*!< User data of the replies.    */
+};
+
+/*! Static initialiser of a dispatch table entry. */
+#define DISPATCH_ENTRY(handler, policy) { (handler), NULL, (policy), 0, 0, 0 }
+
+/** @} */
+
+
+/** @cond DUPLICATE_DOCUMENTATION */
+void dispatch_init(struct dispatch_table * table, int policy);
+int dispatch_register(struct dispatch_table * table, int tag,
+                      dispatch_handler handler, void * data, int policy);
+void dispatch_set_metric(struct dispatch_table * table,
+                         dispatch_metric metric, void * data);
+void dispatch_set_reply(struct dispatch_table * table,
+                        dispatch_reply reply, void * data);
+int dispatch_packet(struct dispatch_table * table, int fd,
+                    const unsigned char * packet, int size);
+/** @endcond */
+
+
+#endif /* DISPATCH_H */
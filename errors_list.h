@@ -57,4 +57,6 @@ ADD_ERR(ERR_OUT_OF_RANGE,       "Value out of range")
 ADD_ERR(ERR_MISSING_VALUE,      "Missing value")
 ADD_ERR(ERR_INVALID_VALUE,      "Invalid value")
 ADD_ERR(ERR_INVALID_EXPRESSION, "Invalid operand or value")
+ADD_ERR(ERR_SHARED_MEMORY,      "Cannot set up shared memory")
+ADD_ERR(ERR_BAD_PACKET,         "Bad packet")
 
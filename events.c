@@ -0,0 +1,1558 @@
+/**
+ *  \file    events.c
+ *  \brief   Event loop.
+ *
+ *           Project: project independant file.
+ *
+ *           This file contains an edge-triggered event loop. File
+ *           descriptors are registered with a read and/or write interest
+ *           and a handler that is called when they become ready, so that a
+ *           single thread can serve every connection of a server.
+ *           Listening sockets can be registered as well: the incomming
+ *           connections are then accepted by the loop itself. Connections
+ *           can also be registered as packet readers, the loop reading
+ *           them and handing out complete packets, and packets held in
+ *           packet buffers can be sent through the loop.
+ *
+ *           Two backends are available, selected when the loop is created:
+ *           - epoll: readiness notifications, the loop reads and writes the
+ *             sockets with recv() and writev();
+ *           - io_uring: multishot poll for plain descriptors, multishot
+ *             accept for server sockets, multishot receive in provided
+ *             buffers for packet readers and chains of linked sends for
+ *             outgoing packets. When io_uring is not available, the loop
+ *             falls back to epoll.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "errors.h"
+#include "sockets.h"
+#include "packets.h"
+#include "events.h"
+#include "metrics.h"
+#include "shmem.h"
+#include "uring.h"
+#include "xmem.h"
+
+
+/**
+ *  \defgroup evinternals Event loop internals
+ *  @{
+ */
+
+/*! Kind of operation identified by a completion (io_uring) or an event. */
+enum {
+        KIND_SEND = 0,  /*!< Linked send: the user data is a send node.    */
+        KIND_EVENT,     /*!< Readiness of a descriptor.                    */
+        KIND_ACCEPT,    /*!< Multishot accept of a server socket.          */
+        KIND_RECV,      /*!< Multishot receive of a packet reader.         */
+        KIND_CANCEL     /*!< Cancellation of a previous operation.         */
+};
+
+/*! Mode of a registered descriptor. */
+enum {
+        MODE_HANDLER,   /*!< Readiness given to the user handler.          */
+        MODE_SERVER,    /*!< Connections accepted by the loop.             */
+        MODE_READER     /*!< Packets read by the loop.                     */
+};
+
+/*! Mask of the generation number stored in events and completions. */
+#define GENERATION_MASK 0xFFFFFF
+
+/*! Buffer group of the receive buffers provided to io_uring. */
+#define RECV_GROUP      1
+
+/*! Registered file descriptor information. */
+struct event_source {
+        int                     mode;       /*!< MODE_* of the source.          */
+        int                     events;     /*!< Requested interest.            */
+        int                     armed;      /*!< Armed operation (io_uring).    */
+        int                     writing;    /*!< Waiting for EPOLLOUT (epoll).  */
+        int                     failed;     /*!< A send has failed.             */
+        unsigned int            generation; /*!< Armed operation number.       */
+        unsigned int            serial;     /*!< Registration number.          */
+        event_handler           handler;    /*!< Readiness handler.             */
+        event_accept_handler    accept;     /*!< Handler for server sockets.    */
+        struct packet_decoder * decoder;    /*!< Decoder of a packet reader.    */
+        packet_handler          packets;    /*!< Handler of a packet reader.    */
+        void                  * data;       /*!< User data for the handlers.    */
+        struct xbuf          ** out;        /*!< Packets waiting to be sent.    */
+        int                     nb_out;     /*!< Number of waiting packets.     */
+        int                     max_out;    /*!< Allocated size of out.         */
+        size_t                  out_sent;   /*!< Sent bytes of out[0] (epoll).  */
+        int                     inflight;   /*!< Sends submitted (io_uring).    */
+};
+
+/*! Packet being sent by io_uring. */
+struct event_send {
+        struct xbuf       * packet;      /*!< Packet (NULL if node is free). */
+        int                 fd;          /*!< Destination descriptor.        */
+        unsigned int        serial;      /*!< Destination registration.      */
+        struct event_send * next;        /*!< Free list link.                */
+        struct event_send * all;         /*!< List of all the nodes.         */
+};
+
+/*! Event loop structure. */
+struct event_loop {
+        int                    backend;     /*!< EVENT_BACKEND_*.                */
+        int                    epoll_fd;    /*!< epoll instance.                 */
+        struct uring           ring;        /*!< io_uring instance.              */
+        struct uring_buffers   buffers;     /*!< io_uring receive buffers.       */
+        struct event_send    * free_sends;  /*!< Free send nodes.                */
+        struct event_send    * all_sends;   /*!< All the send nodes.             */
+        int                    running;     /*!< Cleared by event_loop_stop().   */
+        int                    reserve;     /*!< Spare descriptor (EMFILE).      */
+        unsigned int           generation;  /*!< Last registration number.       */
+        int                    nb_sources;  /*!< Size of the sources table.      */
+        struct event_source ** sources;     /*!< Sources indexed by descriptor.  */
+};
+
+/** @} */
+
+
+/**
+ *  \brief Function building the identifier of an operation on a source.
+ *
+ *         The generation number is stored with the descriptor so that an
+ *         event received for a descriptor removed (and possibly reused)
+ *         in the meantime is ignored.
+ *
+ * @param kind          KIND_* of the operation
+ * @param fd            file descriptor of the source
+ * @param source        source information
+ * @return              the identifier (epoll or io_uring user data)
+ */
+static uint64_t source_id(int kind, int fd, const struct event_source * source)
+{
+        return ((uint64_t) kind << 56)
+               | ((uint64_t) source->generation << 32)
+               | (uint32_t) fd;
+}
+
+
+/**
+ *  \brief Function returning the source designated by an identifier.
+ *
+ * @param loop          event loop
+ * @param id            identifier built by source_id()
+ * @return              the source or NULL if it has been removed
+ */
+static struct event_source * source_get(struct event_loop * loop, uint64_t id)
+{
+        int                   fd = (int) (id & 0xFFFFFFFF);
+        unsigned int          generation = (id >> 32) & GENERATION_MASK;
+        struct event_source * source;
+
+        if ((fd < 0) || (fd >= loop->nb_sources))
+        {
+                return NULL;
+        }
+        source = loop->sources[fd];
+        if (! source || (source->generation != generation))
+        {
+                return NULL;
+        }
+
+        return source;
+}
+
+
+/**
+ *  \brief Function converting an interest into poll flags.
+ *
+ * @param events        EVENT_READ and/or EVENT_WRITE
+ * @return              the corresponding poll flags
+ */
+static uint32_t poll_flags(int events)
+{
+        uint32_t flags = EPOLLRDHUP;
+
+        if (events & EVENT_READ)
+        {
+                flags |= EPOLLIN;
+        }
+        if (events & EVENT_WRITE)
+        {
+                flags |= EPOLLOUT;
+        }
+
+        return flags;
+}
+
+
+/**
+ *  \brief Function converting poll flags into readiness events.
+ *
+ * @param flags         poll flags
+ * @return              the corresponding EVENT_* flags
+ */
+static int poll_events(uint32_t flags)
+{
+        int ready = 0;
+
+        if (flags & (EPOLLIN | EPOLLRDHUP))
+        {
+                ready |= EVENT_READ;
+        }
+        if (flags & EPOLLOUT)
+        {
+                ready |= EVENT_WRITE;
+        }
+        if (flags & (EPOLLERR | EPOLLHUP | EPOLLRDHUP))
+        {
+                ready |= EVENT_ERROR;
+        }
+
+        return ready;
+}
+
+
+/**
+ *  \brief Function growing the sources table.
+ *
+ * @param loop          event loop
+ * @param fd            file descriptor that must fit in the table
+ */
+static void sources_grow(struct event_loop * loop, int fd)
+{
+        int size = loop->nb_sources ? loop->nb_sources : 64;
+
+        while (size <= fd)
+        {
+                size *= 2;
+        }
+        if (size != loop->nb_sources)
+        {
+                loop->sources = realloc(loop->sources,
+                                        size * sizeof(struct event_source *));
+                if (! loop->sources)
+                {
+                        perror("realloc() ");
+                        exit(-1);
+                }
+                memset(&loop->sources[loop->nb_sources], 0,
+                       (size - loop->nb_sources) * sizeof(struct event_source *));
+                loop->nb_sources = size;
+        }
+}
+
+
+/**
+ *  \brief Function releasing a source and its waiting packets.
+ *
+ * @param source        the source to release
+ */
+static void source_free(struct event_source * source)
+{
+        int i;
+
+        for (i = 0 ; i < source->nb_out ; i++)
+        {
+                xbuf_unref(source->out[i]);
+        }
+        FREE(source->out);
+        free(source);
+}
+
+
+/**
+ *  \brief Function reporting a connection error to the owner of a source.
+ *
+ * @param loop          event loop
+ * @param fd            file descriptor of the source
+ * @param source        the source
+ * @param status        the error status
+ */
+static void source_error(struct event_loop * loop, int fd,
+                         struct event_source * source, int status)
+{
+        metrics_error(fd, status);
+        if (source->mode == MODE_READER)
+        {
+                source->packets(NULL, status, source->data);
+        }
+        else if (source->mode == MODE_HANDLER)
+        {
+                source->handler(loop, fd, EVENT_ERROR, source->data);
+        }
+}
+
+
+/**
+ *  \brief Function arming the io_uring operation of a source.
+ *
+ * @param loop          event loop
+ * @param fd            file descriptor of the source
+ * @param source        the source
+ * @return              the status of the operation
+ * @retval SUCCESS              operation armed
+ * @retval -ERR_NO_MEMORY       submission queue full
+ */
+static int uring_arm(struct event_loop * loop, int fd, struct event_source * source)
+{
+        struct io_uring_sqe * sqe = uring_get_sqe(&loop->ring);
+
+        if (! sqe)
+        {
+                return -ERR_NO_MEMORY;
+        }
+        sqe->fd = fd;
+        if ((source->mode == MODE_SERVER) && (source->armed != KIND_EVENT))
+        {
+                sqe->opcode = IORING_OP_ACCEPT;
+                sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+                sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+                source->armed = KIND_ACCEPT;
+        }
+        else if ((source->mode == MODE_READER) && (source->armed != KIND_EVENT)
+                 && loop->buffers.memory && ! shmem_active(fd))
+        {
+                sqe->opcode = IORING_OP_RECV;
+                sqe->ioprio = IORING_RECV_MULTISHOT;
+                sqe->flags = IOSQE_BUFFER_SELECT;
+                sqe->buf_group = RECV_GROUP;
+                source->armed = KIND_RECV;
+        }
+        else
+        {
+                sqe->opcode = IORING_OP_POLL_ADD;
+                /* Écritures en attente : seulement pour la mémoire partagée. */
+                sqe->poll32_events = poll_flags(source->writing
+                                                ? source->events | EVENT_WRITE
+                                                : source->events);
+                sqe->len = IORING_POLL_ADD_MULTI;
+                source->armed = KIND_EVENT;
+        }
+        sqe->user_data = source_id(source->armed, fd, source);
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Function cancelling the io_uring operation of a source.
+ *
+ * @param loop          event loop
+ * @param fd            file descriptor of the source
+ * @param source        the source
+ */
+static void uring_disarm(struct event_loop * loop, int fd,
+                         struct event_source * source)
+{
+        struct io_uring_sqe * sqe = uring_get_sqe(&loop->ring);
+
+        if (! sqe)
+        {
+                return;
+        }
+        sqe->opcode = (source->armed == KIND_EVENT)
+                      ? IORING_OP_POLL_REMOVE
+                      : IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = source_id(source->armed, fd, source);
+        sqe->user_data = (uint64_t) KIND_CANCEL << 56;
+}
+
+
+/**
+ *  \brief Function cancelling the sends in flight on a descriptor.
+ *
+ *         The linked sends still submitted for a removed descriptor hold
+ *         their packets until they complete: they are cancelled, and
+ *         their completions are ignored (they do not match the serial
+ *         number of a new registration of the descriptor).
+ *
+ * @param loop          event loop
+ * @param fd            file descriptor of the removed source
+ */
+static void uring_cancel_sends(struct event_loop * loop, int fd)
+{
+        struct io_uring_sqe * sqe = uring_get_sqe(&loop->ring);
+
+        if (! sqe)
+        {
+                return;
+        }
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = fd;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+        sqe->user_data = (uint64_t) KIND_CANCEL << 56;
+}
+
+
+/**
+ *  \brief Function registering a source in the backend.
+ *
+ * @param loop          event loop
+ * @param fd            file descriptor of the source
+ * @param source        the source
+ * @return              the status of the registration
+ * @retval SUCCESS                      source registered
+ * @retval -ERR_CONFIGURE_SOCKET        the system refused the descriptor
+ */
+static int backend_add(struct event_loop * loop, int fd, struct event_source * source)
+{
+        struct epoll_event event;
+
+        if (loop->backend == EVENT_BACKEND_IO_URING)
+        {
+                return (uring_arm(loop, fd, source) == SUCCESS)
+                       ? SUCCESS
+                       : -ERR_CONFIGURE_SOCKET;
+        }
+
+        event.events = poll_flags(source->events) | EPOLLET;
+        event.data.u64 = source_id(KIND_EVENT, fd, source);
+        if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1)
+        {
+                return -ERR_CONFIGURE_SOCKET;
+        }
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Function updating the interest of a source in the backend.
+ *
+ *         The generation of the source is changed, so that the events of
+ *         the previous registration are ignored.
+ *
+ * @param loop          event loop
+ * @param fd            file descriptor of the source
+ * @param source        the source
+ * @param events        new interest
+ * @return              the status of the modification
+ * @retval SUCCESS                      interest modified
+ * @retval -ERR_CONFIGURE_SOCKET        the system refused the modification
+ */
+static int backend_modify(struct event_loop * loop, int fd,
+                          struct event_source * source, int events)
+{
+        struct epoll_event event;
+
+        if (loop->backend == EVENT_BACKEND_IO_URING)
+        {
+                source->events = events;
+                if (source->armed != KIND_EVENT)
+                {
+                        return SUCCESS;
+                }
+                uring_disarm(loop, fd, source);
+                source->generation = ++loop->generation & GENERATION_MASK;
+                return (uring_arm(loop, fd, source) == SUCCESS)
+                       ? SUCCESS
+                       : -ERR_CONFIGURE_SOCKET;
+        }
+
+        if (source->writing)
+        {
+                events |= EVENT_WRITE;
+        }
+        event.events = poll_flags(events) | EPOLLET;
+        event.data.u64 = source_id(KIND_EVENT, fd, source);
+        if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, fd, &event) == -1)
+        {
+                return -ERR_CONFIGURE_SOCKET;
+        }
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Function registering a new source.
+ *
+ * @param loop          event loop
+ * @param fd            file descriptor
+ * @param mode          MODE_* of the source
+ * @param events        interest
+ * @param result        returned source
+ * @return              the status of the registration
+ * @retval SUCCESS                      descriptor registered
+ * @retval -ERR_BAD_PARAMETER           invalid descriptor
+ * @retval -ERR_SERVICE_RUNNING         descriptor already registered
+ * @retval -ERR_CONFIGURE_SOCKET        the system refused the descriptor
+ */
+static int source_add(struct event_loop * loop, int fd, int mode, int events,
+                      struct event_source ** result)
+{
+        struct event_source * source;
+        int                   status;
+
+        if (fd < 0)
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        sources_grow(loop, fd);
+        if (loop->sources[fd])
+        {
+                return -ERR_SERVICE_RUNNING;
+        }
+
+        source = xmalloc(sizeof(struct event_source));
+        memset(source, 0, sizeof(struct event_source));
+        source->mode = mode;
+        source->events = events;
+        source->generation = ++loop->generation & GENERATION_MASK;
+        source->serial = source->generation;
+        *result = source;
+
+        status = backend_add(loop, fd, source);
+        if (status != SUCCESS)
+        {
+                free(source);
+                return status;
+        }
+        loop->sources[fd] = source;
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Function telling if an accept() error only concerns the
+ *         connection being accepted.
+ *
+ *         Besides EINTR, these are the errors of a connection aborted
+ *         before being accepted and the network errors that Linux reports
+ *         through accept() (see accept(2)): the next pending connections
+ *         can still be accepted.
+ *
+ * @param error         errno value of the failed accept()
+ * @return              1 for a transient error, 0 otherwise
+ */
+static int accept_transient(int error)
+{
+        switch (error)
+        {
+                case EINTR:
+                case ECONNABORTED:
+                case EPROTO:
+                case ENETDOWN:
+                case ENOPROTOOPT:
+                case EHOSTDOWN:
+                case ENONET:
+                case EHOSTUNREACH:
+                case EOPNOTSUPP:
+                case ENETUNREACH:
+                        return 1;
+                default:
+                        return 0;
+        }
+}
+
+
+/**
+ *  \brief Function rejecting the pending connections of a server socket
+ *         when no descriptor is left.
+ *
+ *         On EMFILE or ENFILE, the connections stay in the backlog and the
+ *         server socket stays readable: an io_uring accept would fail again
+ *         at once, forever, and an edge-triggered epoll would never notify
+ *         the socket again. The spare descriptor of the loop is released so
+ *         that the pending connections can be accepted and closed, then it
+ *         is taken back.
+ *
+ * @param loop          event loop
+ * @param fd            server socket (non-blocking)
+ */
+static void accept_reject(struct event_loop * loop, int fd)
+{
+        int client;
+
+        if (loop->reserve >= 0)
+        {
+                close(loop->reserve);
+        }
+        while (((client = accept(fd, NULL, NULL)) >= 0) || accept_transient(errno))
+        {
+                if (client >= 0)
+                {
+                        close(client);
+                }
+        }
+        loop->reserve = open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
+
+
+/**
+ *  \brief Function accepting all pending connections of a server socket.
+ *
+ *         As notifications are edge-triggered, connections are accepted
+ *         until none is left: only EAGAIN or a persistent error stop the
+ *         loop, a transient error (see accept_transient()) skips the
+ *         failed connection. When no descriptor is left, the pending
+ *         connections are rejected (see accept_reject()).
+ *
+ * @param loop          event loop
+ * @param fd            server socket
+ * @param source        server socket information
+ */
+static void accept_all(struct event_loop * loop, int fd, struct event_source * source)
+{
+        /*
+         *      Le gestionnaire peut retirer la socket serveur de la boucle.
+         */
+        while (loop->sources[fd] == source)
+        {
+                int client = accept_connection(fd, 0);
+
+                if (client < 0)
+                {
+                        /*
+                         *      Une connexion abandonnée ne doit pas laisser
+                         *      les suivantes dans la file : la notification
+                         *      ne sera pas répétée.
+                         */
+                        if (accept_transient(errno))
+                        {
+                                continue;
+                        }
+                        if ((errno == EMFILE) || (errno == ENFILE))
+                        {
+                                accept_reject(loop, fd);
+                        }
+                        break;
+                }
+                if (socket_nonblocking(client) != SUCCESS)
+                {
+                        close(client);
+                        continue;
+                }
+                source->accept(loop, client, source->data);
+        }
+}
+
+
+/**
+ *  \brief Function reading all available packets of a packet reader.
+ *
+ * @param fd            socket of the reader
+ * @param source        reader information
+ */
+static void read_all(int fd, struct event_source * source)
+{
+        int status = packet_decoder_read(fd, source->decoder,
+                                         source->packets, source->data);
+
+        if (status < 0)
+        {
+                metrics_error(fd, status);
+                source->packets(NULL, status, source->data);
+        }
+}
+
+
+/**
+ *  \brief Function sending the waiting packets of a source with writev().
+ *
+ * @param loop          event loop
+ * @param fd            file descriptor of the source
+ * @param source        the source
+ * @return              the status of the operation
+ * @retval SUCCESS                      packets sent or waiting for EPOLLOUT
+ * @retval -ERR_CONNECTION_LOST         connection lost
+ */
+static int epoll_flush(struct event_loop * loop, int fd, struct event_source * source)
+{
+        while (source->nb_out > 0)
+        {
+                struct iovec iov[EVENT_SEND_CHAIN];
+                int          nb_iov = 0;
+                ssize_t      nb_write;
+                int          requested = 0;
+                int          done = 0;
+
+                while ((nb_iov < source->nb_out) && (nb_iov < EVENT_SEND_CHAIN))
+                {
+                        iov[nb_iov].iov_base = source->out[nb_iov]->data;
+                        iov[nb_iov].iov_len = source->out[nb_iov]->size;
+                        requested += source->out[nb_iov]->size;
+                        nb_iov++;
+                }
+                iov[0].iov_base = (unsigned char *) iov[0].iov_base + source->out_sent;
+                iov[0].iov_len -= source->out_sent;
+                requested -= source->out_sent;
+
+                nb_write = shmem_writev(fd, iov, nb_iov);
+                metrics_write(fd, nb_write, requested);
+                if (nb_write < 0)
+                {
+                        if (errno == EINTR)
+                        {
+                                continue;
+                        }
+                        if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+                        {
+                                /*
+                                 *      Anneau de mémoire partagée plein : la
+                                 *      socket reste disponible, on relance
+                                 *      l'attente pour réessayer.
+                                 */
+                                if (! source->writing || shmem_active(fd))
+                                {
+                                        source->writing = 1;
+                                        backend_modify(loop, fd, source, source->events);
+                                }
+                                return SUCCESS;
+                        }
+                        source->failed = 1;
+                        return -ERR_CONNECTION_LOST;
+                }
+
+                nb_write += source->out_sent;
+                while ((done < source->nb_out) &&
+                       ((size_t) nb_write >= source->out[done]->size))
+                {
+                        nb_write -= source->out[done]->size;
+                        metrics_frame_out(fd, source->out[done]->data[PACKET_LEN_SIZE],
+                                          source->out[done]->size);
+                        xbuf_unref(source->out[done]);
+                        done++;
+                }
+                source->out_sent = nb_write;
+                source->nb_out -= done;
+                memmove(source->out, &source->out[done],
+                        source->nb_out * sizeof(struct xbuf *));
+        }
+
+        if (source->writing)
+        {
+                source->writing = 0;
+                backend_modify(loop, fd, source, source->events);
+        }
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Function submitting the waiting packets of a source as a chain
+ *         of linked sends.
+ *
+ *         Only one chain is in flight for a given descriptor, so that the
+ *         packets are sent in order.
+ *
+ * @param loop          event loop
+ * @param fd            file descriptor of the source
+ * @param source        the source
+ */
+static void uring_flush(struct event_loop * loop, int fd, struct event_source * source)
+{
+        int count = source->nb_out;
+        int i;
+
+        if ((source->inflight > 0) || (count == 0))
+        {
+                return;
+        }
+        if (count > EVENT_SEND_CHAIN)
+        {
+                count = EVENT_SEND_CHAIN;
+        }
+        if (uring_space(&loop->ring) < count)
+        {
+                uring_submit(&loop->ring);
+                if (uring_space(&loop->ring) < count)
+                {
+                        return;
+                }
+        }
+
+        for (i = 0 ; i < count ; i++)
+        {
+                struct io_uring_sqe * sqe = uring_get_sqe(&loop->ring);
+                struct event_send   * node = loop->free_sends;
+
+                if (node)
+                {
+                        loop->free_sends = node->next;
+                }
+                else
+                {
+                        node = xmalloc(sizeof(struct event_send));
+                        node->all = loop->all_sends;
+                        loop->all_sends = node;
+                }
+                node->packet = source->out[i];
+                node->fd = fd;
+                node->serial = source->serial;
+                node->next = NULL;
+
+                sqe->opcode = IORING_OP_SEND;
+                sqe->fd = fd;
+                sqe->addr = (unsigned long) node->packet->data;
+                sqe->len = node->packet->size;
+                sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+                sqe->flags = (i < count - 1) ? IOSQE_IO_LINK : 0;
+                sqe->user_data = (uint64_t) (uintptr_t) node;
+        }
+        source->inflight = count;
+        source->nb_out -= count;
+        memmove(source->out, &source->out[count],
+                source->nb_out * sizeof(struct xbuf *));
+}
+
+
+/**
+ *  \brief Function handling the readiness of a source.
+ *
+ * @param loop          event loop
+ * @param fd            file descriptor of the source
+ * @param source        the source
+ * @param ready         EVENT_* readiness flags
+ */
+static void source_ready(struct event_loop * loop, int fd,
+                         struct event_source * source, int ready)
+{
+        if ((ready & EVENT_WRITE) && source->writing)
+        {
+                if (epoll_flush(loop, fd, source) != SUCCESS)
+                {
+                        source_error(loop, fd, source, -ERR_CONNECTION_LOST);
+                        return;
+                }
+                if ((loop->sources[fd] != source) || ! (source->events & EVENT_WRITE))
+                {
+                        ready &= ~EVENT_WRITE;
+                }
+        }
+
+        switch (source->mode)
+        {
+                case MODE_SERVER:
+                        accept_all(loop, fd, source);
+                        break;
+                case MODE_READER:
+                        if (ready & (EVENT_READ | EVENT_ERROR))
+                        {
+                                read_all(fd, source);
+                        }
+                        break;
+                default:
+                        if (ready)
+                        {
+                                source->handler(loop, fd, ready, source->data);
+                        }
+        }
+}
+
+
+/**
+ *  \brief Function handling a completion of the io_uring backend.
+ *
+ * @param loop          event loop
+ * @param id            user data of the completion
+ * @param result        result of the operation
+ * @param flags         completion flags
+ */
+static void uring_complete(struct event_loop * loop, uint64_t id, int result,
+                           unsigned int flags)
+{
+        int                   kind = id >> 56;
+        int                   fd = (int) (id & 0xFFFFFFFF);
+        struct event_source * source;
+
+        if (kind == KIND_SEND)
+        {
+                struct event_send * node = (struct event_send *) (uintptr_t) id;
+                size_t              size = node->packet->size;
+
+                fd = node->fd;
+                source = loop->sources && (fd < loop->nb_sources)
+                         ? loop->sources[fd] : NULL;
+                if (result >= 0)
+                {
+                        metrics_write(fd, result, size);
+                }
+                if (result == (int) size)
+                {
+                        metrics_frame_out(fd, node->packet->data[PACKET_LEN_SIZE],
+                                          result);
+                }
+                xbuf_unref(node->packet);
+                node->packet = NULL;
+                node->next = loop->free_sends;
+                loop->free_sends = node;
+                /*
+                 *      Le numéro d'enregistrement, contrairement à la
+                 *      génération, ne change pas quand l'opération armée
+                 *      est relancée : chaque envoi de la chaîne est décompté,
+                 *      sinon le descripteur n'enverrait plus rien.
+                 */
+                if (! source || (source->serial != node->serial))
+                {
+                        return;
+                }
+                source->inflight--;
+                /*
+                 *      Un envoi incomplet laisse une trame tronquée dans le
+                 *      flux et les envois chaînés qui le suivent sont
+                 *      annulés : relancer la fin désordonnerait les trames,
+                 *      la connexion est donc perdue.
+                 */
+                if ((result < (int) size) && ! source->failed)
+                {
+                        source->failed = 1;
+                        source_error(loop, fd, source, -ERR_CONNECTION_LOST);
+                        return;
+                }
+                if (source->inflight == 0)
+                {
+                        uring_flush(loop, fd, source);
+                }
+                return;
+        }
+
+        source = source_get(loop, id);
+        if (kind == KIND_RECV)
+        {
+                int             buffer_id = flags >> IORING_CQE_BUFFER_SHIFT;
+                unsigned char * data = (flags & IORING_CQE_F_BUFFER)
+                                       ? uring_buffer(&loop->buffers, buffer_id)
+                                       : NULL;
+
+                if (result >= 0)
+                {
+                        metrics_read(fd, result);
+                }
+                if (source && (result > 0) && data && ! shmem_active(fd))
+                {
+                        int status;
+
+                        source->decoder->fd = fd;
+                        status = packet_decoder_feed(source->decoder, data, result,
+                                                     source->packets, source->data);
+                        if (status < 0)
+                        {
+                                source_error(loop, fd, source, status);
+                        }
+                }
+                if (data)
+                {
+                        uring_buffer_recycle(&loop->buffers, buffer_id);
+                }
+                if (! source || (source != source_get(loop, id)))
+                {
+                        return;
+                }
+                if (result == 0)
+                {
+                        source_error(loop, fd, source, -ERR_CONNECTION_LOST);
+                        return;
+                }
+                if (shmem_active(fd))
+                {
+                        /*
+                         *      Connexion passée en mémoire partagée : la
+                         *      socket ne reçoit plus que les coups de
+                         *      sonnette, on attend sa disponibilité.
+                         */
+                        uring_disarm(loop, fd, source);
+                        source->generation = ++loop->generation & GENERATION_MASK;
+                        source->armed = KIND_EVENT;
+                        uring_arm(loop, fd, source);
+                        read_all(fd, source);
+                        return;
+                }
+                if ((result < 0) && (result != -ENOBUFS))
+                {
+                        if (result == -EINVAL)
+                        {
+                                /*
+                                 *      Réception multiple non supportée :
+                                 *      on se replie sur l'attente de
+                                 *      disponibilité.
+                                 */
+                                source->armed = KIND_EVENT;
+                                uring_arm(loop, fd, source);
+                                return;
+                        }
+                        source_error(loop, fd, source, -ERR_CONNECTION);
+                        return;
+                }
+        }
+        else if (kind == KIND_ACCEPT)
+        {
+                if (! source)
+                {
+                        if (result >= 0)
+                        {
+                                close(result);
+                        }
+                        return;
+                }
+                if (result >= 0)
+                {
+                        source->accept(loop, result, source->data);
+                }
+                else if ((result == -EMFILE) || (result == -ENFILE))
+                {
+                        /*
+                         *      Le descripteur est réservé avant l'attente :
+                         *      relancée, l'acceptation multiple échouerait
+                         *      aussitôt, sans fin. On se replie sur
+                         *      l'attente de disponibilité, et les
+                         *      connexions en attente sont refusées.
+                         */
+                        accept_reject(loop, fd);
+                        if (flags & IORING_CQE_F_MORE)
+                        {
+                                uring_disarm(loop, fd, source);
+                                source->generation = ++loop->generation & GENERATION_MASK;
+                        }
+                        source->armed = KIND_EVENT;
+                        uring_arm(loop, fd, source);
+                        return;
+                }
+                else if (result == -EINVAL)
+                {
+                        source->armed = KIND_EVENT;
+                        uring_arm(loop, fd, source);
+                        return;
+                }
+        }
+        else if (kind == KIND_EVENT)
+        {
+                if (! source)
+                {
+                        return;
+                }
+                if (result > 0)
+                {
+                        source_ready(loop, fd, source, poll_events(result));
+                }
+        }
+        else
+        {
+                return;
+        }
+
+        /*
+         *      Opération multiple terminée : on la relance.
+         */
+        if (! (flags & IORING_CQE_F_MORE) && (source == source_get(loop, id)))
+        {
+                uring_arm(loop, fd, source);
+        }
+}
+
+
+/**
+ *  \brief Event loop creation with a given backend.
+ *
+ *         If the io_uring backend is requested but not available, the
+ *         loop uses epoll: event_loop_backend() tells which one is used.
+ *
+ * @param backend       EVENT_BACKEND_EPOLL or EVENT_BACKEND_IO_URING
+ * @return              a new event loop or NULL if the system cannot
+ *                      provide one
+ */
+struct event_loop * event_loop_create_backend(int backend)
+{
+        struct event_loop * loop = xmalloc(sizeof(struct event_loop));
+
+        memset(loop, 0, sizeof(struct event_loop));
+        loop->epoll_fd = -1;
+        loop->reserve = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        if ((backend == EVENT_BACKEND_IO_URING) &&
+            (uring_init(&loop->ring, EVENT_BATCH) == SUCCESS))
+        {
+                loop->backend = EVENT_BACKEND_IO_URING;
+                /*
+                 *      Sans tampons fournis, les lecteurs de paquets
+                 *      utilisent l'attente de disponibilité.
+                 */
+                uring_buffers_init(&loop->ring, &loop->buffers, RECV_GROUP,
+                                   EVENT_RECV_BUFFERS, EVENT_RECV_SIZE);
+                return loop;
+        }
+
+        loop->backend = EVENT_BACKEND_EPOLL;
+        loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (loop->epoll_fd == -1)
+        {
+                if (loop->reserve >= 0)
+                {
+                        close(loop->reserve);
+                }
+                free(loop);
+                return NULL;
+        }
+
+        return loop;
+}
+
+
+/**
+ *  \brief Event loop creation.
+ *
+ * @return              a new event loop using epoll or NULL if the system
+ *                      cannot provide one
+ */
+struct event_loop * event_loop_create(void)
+{
+        return event_loop_create_backend(EVENT_BACKEND_EPOLL);
+}
+
+
+/**
+ *  \brief Event loop backend information function.
+ *
+ * @param loop          event loop
+ * @return              the backend used by the loop (EVENT_BACKEND_*)
+ */
+int event_loop_backend(const struct event_loop * loop)
+{
+        return loop->backend;
+}
+
+
+/**
+ *  \brief Event loop destruction.
+ *
+ *         The registered file descriptors are not closed. The packets
+ *         waiting to be sent are dropped.
+ *
+ * @param loop          event loop to destroy
+ */
+void event_loop_destroy(struct event_loop * loop)
+{
+        int i;
+
+        if (! loop)
+        {
+                return;
+        }
+        for (i = 0 ; i < loop->nb_sources ; i++)
+        {
+                if (loop->sources[i])
+                {
+                        source_free(loop->sources[i]);
+                }
+        }
+        FREE(loop->sources);
+        if (loop->backend == EVENT_BACKEND_IO_URING)
+        {
+                uring_buffers_free(&loop->ring, &loop->buffers);
+                uring_exit(&loop->ring);
+                while (loop->all_sends)
+                {
+                        struct event_send * node = loop->all_sends;
+
+                        loop->all_sends = node->all;
+                        xbuf_unref(node->packet);
+                        free(node);
+                }
+        }
+        else
+        {
+                close(loop->epoll_fd);
+        }
+        if (loop->reserve >= 0)
+        {
+                close(loop->reserve);
+        }
+        free(loop);
+}
+
+
+/**
+ *  \brief File descriptor registration.
+ *
+ *         This function adds a file descriptor to the loop. The handler is
+ *         called each time the descriptor becomes ready for one of the
+ *         requested operations, or when an error occurs on it.
+ *
+ * @param loop          event loop
+ * @param fd            file descriptor (should be in non-blocking mode)
+ * @param events        interest: EVENT_READ and/or EVENT_WRITE
+ * @param handler       function called when the descriptor is ready
+ * @param data          user data given to the handler
+ * @return              the status of the registration
+ * @retval SUCCESS                      descriptor registered
+ * @retval -ERR_BAD_PARAMETER           invalid descriptor or no handler
+ * @retval -ERR_SERVICE_RUNNING         descriptor already registered
+ * @retval -ERR_CONFIGURE_SOCKET        the system refused the descriptor
+ */
+int event_add(struct event_loop * loop, int fd, int events,
+              event_handler handler, void * data)
+{
+        struct event_source * source;
+
+        if (! handler)
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        check(source_add(loop, fd, MODE_HANDLER, events, &source));
+        source->handler = handler;
+        source->data = data;
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Registered file descriptor interest modification.
+ *
+ *         Typically used to add EVENT_WRITE while outgoing data are
+ *         pending and to remove it once everything has been sent.
+ *
+ * @param loop          event loop
+ * @param fd            registered file descriptor
+ * @param events        new interest: EVENT_READ and/or EVENT_WRITE
+ * @return              the status of the modification
+ * @retval SUCCESS                      interest modified
+ * @retval -ERR_NOT_FOUND               descriptor not registered
+ * @retval -ERR_CONFIGURE_SOCKET        the system refused the modification
+ */
+int event_modify(struct event_loop * loop, int fd, int events)
+{
+        struct event_source * source;
+
+        if ((fd < 0) || (fd >= loop->nb_sources) || (! loop->sources[fd]))
+        {
+                return -ERR_NOT_FOUND;
+        }
+        source = loop->sources[fd];
+        if (source->events == events)
+        {
+                return SUCCESS;
+        }
+
+        check(backend_modify(loop, fd, source, events));
+        source->events = events;
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief File descriptor unregistration.
+ *
+ *         It is safe to call this function from a handler, even for
+ *         another descriptor that has a pending event in the current wait.
+ *         The descriptor is not closed. The packets waiting to be sent on
+ *         it are dropped, and the sends in flight are cancelled (io_uring).
+ *         The shared memory of an upgraded packet reader is released (see
+ *         shmem_close()).
+ *
+ * @param loop          event loop
+ * @param fd            registered file descriptor
+ * @return              the status of the operation
+ * @retval SUCCESS              descriptor removed
+ * @retval -ERR_NOT_FOUND       descriptor not registered
+ */
+int event_remove(struct event_loop * loop, int fd)
+{
+        struct event_source * source;
+
+        if ((fd < 0) || (fd >= loop->nb_sources) || (! loop->sources[fd]))
+        {
+                return -ERR_NOT_FOUND;
+        }
+        source = loop->sources[fd];
+
+        if (loop->backend == EVENT_BACKEND_IO_URING)
+        {
+                /*
+                 *      L'annulation est soumise tout de suite : le
+                 *      descripteur peut être fermé au retour.
+                 */
+                uring_disarm(loop, fd, source);
+                if (source->inflight > 0)
+                {
+                        uring_cancel_sends(loop, fd);
+                }
+                uring_submit(&loop->ring);
+        }
+        else
+        {
+                epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+        }
+        if (source->mode == MODE_READER)
+        {
+                metrics_close(fd);
+                shmem_close(fd);
+        }
+        source_free(source);
+        loop->sources[fd] = NULL;
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Server socket registration.
+ *
+ *         This function registers a listening socket created with
+ *         install_server(). The socket is put in non-blocking mode and
+ *         every incomming connection is accepted by the loop and given to
+ *         the handler, in non-blocking mode too. With io_uring, the
+ *         connections are accepted by a multishot accept operation. When
+ *         the process runs out of descriptors, the pending connections are
+ *         closed instead of being left in the backlog (with io_uring, the
+ *         server socket then waits for readiness instead).
+ *
+ * @param loop          event loop
+ * @param socket_server listening socket
+ * @param handler       function called for each accepted connection
+ * @param data          user data given to the handler
+ * @return              the status of the registration
+ * @retval SUCCESS                      server socket registered
+ * @retval -ERR_BAD_PARAMETER           invalid descriptor or no handler
+ * @retval -ERR_SERVICE_RUNNING         descriptor already registered
+ * @retval -ERR_CONFIGURE_SOCKET        the socket cannot be configured
+ */
+int event_add_server(struct event_loop * loop, int socket_server,
+                     event_accept_handler handler, void * data)
+{
+        struct event_source * source;
+
+        if (! handler)
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        check(socket_nonblocking(socket_server));
+        check(source_add(loop, socket_server, MODE_SERVER, EVENT_READ, &source));
+        source->accept = handler;
+        source->data = data;
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Packet reader registration.
+ *
+ *         This function registers a connection whose packets are read by
+ *         the loop: the handler is called for each complete packet, as
+ *         with packet_decoder_read(). When the connection is lost or on
+ *         error, the handler is called once with a NULL packet and the
+ *         negative error status as size; it should then remove and close
+ *         the connection. With io_uring, the data are received by a
+ *         multishot receive operation in buffers provided by the loop.
+ *
+ * @param loop          event loop
+ * @param fd            connection socket (non-blocking)
+ * @param decoder       initialised decoder of the connection
+ * @param handler       function called for each packet or error
+ * @param data          user data given to the handler
+ * @return              the status of the registration
+ * @retval SUCCESS                      connection registered
+ * @retval -ERR_BAD_PARAMETER           invalid descriptor, decoder or
+ *                                      handler
+ * @retval -ERR_SERVICE_RUNNING         descriptor already registered
+ * @retval -ERR_CONFIGURE_SOCKET        the system refused the descriptor
+ */
+int event_add_reader(struct event_loop * loop, int fd,
+                     struct packet_decoder * decoder,
+                     packet_handler handler, void * data)
+{
+        struct event_source * source;
+
+        if (! handler || ! decoder)
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        check(source_add(loop, fd, MODE_READER, EVENT_READ, &source));
+        source->decoder = decoder;
+        source->packets = handler;
+        source->data = data;
+        metrics_open(fd);
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Packet sending through the loop.
+ *
+ *         This function queues a complete packet (L + TAG + DATA, of
+ *         \c size bytes) held in a packet buffer, and takes a reference on
+ *         it: the same buffer can be sent to many connections. The packets
+ *         of a descriptor are sent in order. With epoll, they are written
+ *         at once when possible, and when the descriptor becomes writable
+ *         otherwise. With io_uring, they are sent by chains of linked send
+ *         operations. A send error is reported to the handler of the
+ *         descriptor (EVENT_ERROR, or a NULL packet for packet readers).
+ *
+ * @param loop          event loop
+ * @param fd            registered file descriptor
+ * @param packet        the packet to send
+ * @return              the status of the operation
+ * @retval SUCCESS                      packet sent or queued
+ * @retval -ERR_NOT_FOUND               descriptor not registered
+ * @retval -ERR_CONNECTION_LOST         connection lost
+ */
+int event_send(struct event_loop * loop, int fd, struct xbuf * packet)
+{
+        struct event_source * source;
+
+        if ((fd < 0) || (fd >= loop->nb_sources) || (! loop->sources[fd]))
+        {
+                return -ERR_NOT_FOUND;
+        }
+        source = loop->sources[fd];
+        if (source->failed)
+        {
+                return -ERR_CONNECTION_LOST;
+        }
+
+        if (source->nb_out == source->max_out)
+        {
+                source->max_out = source->max_out ? source->max_out * 2 : 16;
+                source->out = realloc(source->out,
+                                      source->max_out * sizeof(struct xbuf *));
+                if (! source->out)
+                {
+                        perror("realloc() ");
+                        exit(-1);
+                }
+        }
+        source->out[source->nb_out++] = xbuf_ref(packet);
+
+        if ((loop->backend == EVENT_BACKEND_IO_URING) && ! shmem_active(fd))
+        {
+                uring_flush(loop, fd, source);
+                return SUCCESS;
+        }
+        if (source->writing)
+        {
+                return SUCCESS;
+        }
+
+        return epoll_flush(loop, fd, source);
+}
+
+
+/**
+ *  \brief Event waiting and dispatching function.
+ *
+ *         This function waits until at least one registered descriptor is
+ *         ready or the timeout elapses, then calls the handlers of all the
+ *         ready descriptors.
+ *
+ * @param loop          event loop
+ * @param timeout       timeout in milliseconds (-1 means no timeout)
+ * @return              the number of dispatched events or a negative value
+ *                      in case of error
+ * @retval -ERR_CONNECTION      the wait failed
+ */
+int event_loop_wait(struct event_loop * loop, int timeout)
+{
+        struct epoll_event events[EVENT_BATCH];
+        int                nb_events;
+        int                i;
+
+        if (loop->backend == EVENT_BACKEND_IO_URING)
+        {
+                struct io_uring_cqe * cqe;
+                int                   status = uring_wait(&loop->ring, timeout);
+
+                if (status == -ERR_TIMEOUT)
+                {
+                        return 0;
+                }
+                if (status < 0)
+                {
+                        return status;
+                }
+
+                nb_events = 0;
+                while ((nb_events < EVENT_BATCH) && (cqe = uring_peek(&loop->ring)))
+                {
+                        uint64_t     id = cqe->user_data;
+                        int          result = cqe->res;
+                        unsigned int flags = cqe->flags;
+
+                        uring_advance(&loop->ring);
+                        uring_complete(loop, id, result, flags);
+                        nb_events++;
+                }
+                uring_submit(&loop->ring);
+
+                return nb_events;
+        }
+
+        nb_events = epoll_wait(loop->epoll_fd, events, EVENT_BATCH, timeout);
+        if (nb_events < 0)
+        {
+                return (errno == EINTR) ? 0 : -ERR_CONNECTION;
+        }
+
+        for (i = 0 ; i < nb_events ; i++)
+        {
+                struct event_source * source = source_get(loop, events[i].data.u64);
+
+                /*
+                 *      La source a pu être retirée par un gestionnaire
+                 *      précédent de la même attente.
+                 */
+                if (source)
+                {
+                        source_ready(loop, (int) (events[i].data.u64 & 0xFFFFFFFF),
+                                     source, poll_events(events[i].events));
+                }
+        }
+
+        return nb_events;
+}
+
+
+/**
+ *  \brief Event loop main function.
+ *
+ *         This function dispatches events until event_loop_stop() is
+ *         called from a handler.
+ *
+ * @param loop          event loop
+ * @return              the status of the loop
+ * @retval SUCCESS              loop stopped by event_loop_stop()
+ * @retval -ERR_CONNECTION      the wait failed
+ */
+int event_loop_run(struct event_loop * loop)
+{
+        loop->running = 1;
+        while (loop->running)
+        {
+                int status = event_loop_wait(loop, -1);
+                if (status < 0)
+                {
+                        return status;
+                }
+        }
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Event loop stopping function.
+ *
+ *         The loop returns once the handlers of the current wait have been
+ *         called.
+ *
+ * @param loop          event loop
+ */
+void event_loop_stop(struct event_loop * loop)
+{
+        loop->running = 0;
+}
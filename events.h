@@ -0,0 +1,96 @@
+/**
+ *  \file    events.h
+ *  \brief   Event loop.
+ *
+ *           Project: project independant file.
+ *
+ *           This is the header file of events.c and contains all the
+ *           constants and functions declarations needed to multiplex many
+ *           file descriptors in a single thread.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include "packets.h"
+#include "xmem.h"
+
+/**
+ *  \defgroup events Event loop constants and types
+ *  @{
+ */
+
+/*! Interest / readiness: data can be read from the file descriptor. */
+#define EVENT_READ      0x01
+
+/*! Interest / readiness: data can be written to the file descriptor. */
+#define EVENT_WRITE     0x02
+
+/*! Readiness only: the peer hung up or an error is pending. */
+#define EVENT_ERROR     0x04
+
+/*! Maximum number of events handled by a single wait. */
+#define EVENT_BATCH     256
+
+/*! Backend: epoll readiness notifications. */
+#define EVENT_BACKEND_EPOLL     0
+
+/*! Backend: io_uring (multishot poll, accept and receive, linked sends). */
+#define EVENT_BACKEND_IO_URING  1
+
+/*! Number of receive buffers provided to io_uring (a power of 2). */
+#define EVENT_RECV_BUFFERS      256
+
+/*! Size of the receive buffers provided to io_uring. */
+#define EVENT_RECV_SIZE         PACKET_READ_CHUNK
+
+/*! Maximum number of packets sent by a single chain of linked sends. */
+#define EVENT_SEND_CHAIN        32
+
+/*! Opaque event loop structure. */
+struct event_loop;
+
+/*! Function called when a registered file descriptor becomes ready. The
+ *  notification is edge-triggered: the handler must read (or write) until
+ *  the operation would block, or it will not be called again.
+ */
+typedef void (*event_handler)(struct event_loop * loop, int fd, int events,
+                              void * data);
+
+/*! Function called for each connection accepted on a server socket. The
+ *  given socket is already in non-blocking mode.
+ */
+typedef void (*event_accept_handler)(struct event_loop * loop, int fd,
+                                     void * data);
+
+/** @} */
+
+
+/** @cond DUPLICATE_DOCUMENTATION */
+struct event_loop * event_loop_create(void);
+struct event_loop * event_loop_create_backend(int backend);
+int event_loop_backend(const struct event_loop * loop);
+void event_loop_destroy(struct event_loop * loop);
+int event_add(struct event_loop * loop, int fd, int events,
+              event_handler handler, void * data);
+int event_modify(struct event_loop * loop, int fd, int events);
+int event_remove(struct event_loop * loop, int fd);
+int event_add_server(struct event_loop * loop, int socket_server,
+                     event_accept_handler handler, void * data);
+int event_add_reader(struct event_loop * loop, int fd,
+                     struct packet_decoder * decoder,
+                     packet_handler handler, void * data);
+int event_send(struct event_loop * loop, int fd, struct xbuf * packet);
+int event_loop_wait(struct event_loop * loop, int timeout);
+int event_loop_run(struct event_loop * loop);
+void event_loop_stop(struct event_loop * loop);
+/** @endcond */
+
+
+#endif /* EVENTS_H */
@@ -0,0 +1,324 @@
+/**
+ *  \file    fragments.c
+ *  \brief   Large payloads handling.
+ *
+ *           Project: project independant file.
+ *
+ *           This file contains the functions needed to transmit payloads
+ *           larger than MAX_DATA_SIZE, such as state dumps and saved
+ *           configurations. The payload is split into PACKET_FRAGMENT
+ *           packets that are sent without copying the payload. The
+ *           receiver can either handle each fragment as it arrives
+ *           (streaming) or let fragment_reassemble() rebuild the payload in
+ *           a buffer that grows with the received fragments.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+#include "errors.h"
+#include "packets.h"
+#include "tags.h"
+#include "fragments.h"
+#include "compress.h"
+#include "xmem.h"
+
+
+/**
+ *  \brief Fragment emitting function.
+ *
+ *         This function sends one fragment of a payload. It allows a
+ *         payload to be streamed without having it in memory as a whole.
+ *
+ * @param socket_fd     the socket's file descriptor
+ * @param type          TAG of the payload
+ * @param data          part of the payload
+ * @param size          size of the part (at most FRAGMENT_DATA_SIZE)
+ * @param flags         FRAGMENT_FIRST and/or FRAGMENT_LAST
+ * @return              the status of the operation
+ * @retval SUCCESS                      fragment sent
+ * @retval -ERR_BAD_PARAMETER           invalid size
+ * @retval -ERR_CONNECTION_LOST         connection lost
+ */
+int fragment_send(int socket_fd, int type, const unsigned char * data,
+                  int size, int flags)
+{
+        unsigned char header[FRAGMENT_HEADER_SIZE];
+        struct iovec  iov[2];
+
+        if ((size < 0) || (size > FRAGMENT_DATA_SIZE))
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+
+        header[0] = (type & 0xFF);
+        header[1] = (flags & 0xFF);
+        iov[0].iov_base = header;
+        iov[0].iov_len = FRAGMENT_HEADER_SIZE;
+        iov[1].iov_base = (void *) data;
+        iov[1].iov_len = size;
+
+        if (packet_sendv(socket_fd, PACKET_FRAGMENT, iov, 2)
+            != PACKET_HEADER_SIZE + FRAGMENT_HEADER_SIZE + size)
+        {
+                return -ERR_CONNECTION_LOST;
+        }
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Payload of any size emitting function.
+ *
+ *         A payload that fits in a packet is sent as a normal packet.
+ *         Larger payloads are sent as fragments, which requires the peer
+ *         to have announced CAPABILITY_FRAGMENTS.
+ *
+ * @param socket_fd     the socket's file descriptor
+ * @param type          TAG of the payload
+ * @param data          payload
+ * @param size          size of the payload
+ * @return              the status of the operation
+ * @retval SUCCESS                      payload sent
+ * @retval -ERR_CONNECTION_LOST         connection lost
+ */
+int fragment_send_large(int socket_fd, int type, const unsigned char * data,
+                        size_t size)
+{
+        size_t sent = 0;
+        int    flags = FRAGMENT_FIRST;
+
+        if (size <= MAX_DATA_SIZE)
+        {
+                struct iovec iov;
+
+                iov.iov_base = (void *) data;
+                iov.iov_len = size;
+                if (packet_sendv(socket_fd, type, &iov, 1)
+                    != (int) (PACKET_HEADER_SIZE + size))
+                {
+                        return -ERR_CONNECTION_LOST;
+                }
+                return SUCCESS;
+        }
+
+        while (sent < size)
+        {
+                int part = (size - sent > FRAGMENT_DATA_SIZE)
+                           ? FRAGMENT_DATA_SIZE
+                           : (int) (size - sent);
+
+                if (sent + part == size)
+                {
+                        flags |= FRAGMENT_LAST;
+                }
+                check(fragment_send(socket_fd, type, &data[sent], part, flags));
+                sent += part;
+                flags = 0;
+        }
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Fragment payload TAG information function.
+ *
+ * @param packet        the fragment's full data to examine
+ * @return              the TAG of the payload the fragment belongs to
+ */
+int fragment_type(const unsigned char * packet)
+{
+        return packet[PACKET_HEADER_SIZE];
+}
+
+
+/**
+ *  \brief Fragment flags information function.
+ *
+ * @param packet        the fragment's full data to examine
+ * @return              the fragment flags
+ */
+int fragment_flags(const unsigned char * packet)
+{
+        return packet[PACKET_HEADER_SIZE + 1];
+}
+
+
+/**
+ *  \brief Fragment payload part size information function.
+ *
+ * @param packet        the fragment's full data to examine
+ * @return              the size of the payload part of the fragment, or a
+ *                      negative value if the packet is too short
+ */
+int fragment_data_len(const unsigned char * packet)
+{
+        return packet_data_len(packet) - PACKET_TAG_SIZE - FRAGMENT_HEADER_SIZE;
+}
+
+
+/**
+ *  \brief Fragment payload part function.
+ *
+ * @param packet        the fragment's full data to examine
+ * @return              a pointer to the payload part of the fragment
+ */
+const unsigned char * fragment_data(const unsigned char * packet)
+{
+        return &packet[PACKET_HEADER_SIZE + FRAGMENT_HEADER_SIZE];
+}
+
+
+/**
+ *  \brief Reassembly state initialisation function.
+ *
+ * @param reassembly    the reassembly state to initialise
+ * @param max_size      maximum accepted payload size (0 for no limit)
+ */
+void fragment_init(struct fragment_reassembly * reassembly, size_t max_size)
+{
+        memset(reassembly, 0, sizeof(struct fragment_reassembly));
+        reassembly->max_size = max_size;
+}
+
+
+/**
+ *  \brief Reassembly state release function.
+ *
+ * @param reassembly    the reassembly state to release
+ */
+void fragment_free(struct fragment_reassembly * reassembly)
+{
+        free(reassembly->data);
+        fragment_init(reassembly, reassembly->max_size);
+}
+
+
+/**
+ *  \brief Function appending a fragment to the payload being reassembled.
+ *
+ * @param reassembly    the reassembly state of the connection
+ * @param packet        the fragment (L + TAG + DATA)
+ * @return              the reassembly status (see fragment_reassemble())
+ */
+static int fragment_append(struct fragment_reassembly * reassembly,
+                           const unsigned char * packet)
+{
+        int    flags;
+        int    size;
+        size_t needed;
+
+        size = fragment_data_len(packet);
+        if ((packet_type(packet) != PACKET_FRAGMENT) || (size < 0))
+        {
+                reassembly->active = 0;
+                return -ERR_BAD_PROTOCOL;
+        }
+        flags = fragment_flags(packet);
+
+        if (flags & FRAGMENT_FIRST)
+        {
+                reassembly->type = fragment_type(packet);
+                reassembly->size = 0;
+                reassembly->active = 1;
+        }
+        else if ((! reassembly->active) ||
+                 (fragment_type(packet) != reassembly->type))
+        {
+                reassembly->active = 0;
+                return -ERR_BAD_PROTOCOL;
+        }
+
+        needed = reassembly->size + size;
+        if (reassembly->max_size && (needed > reassembly->max_size))
+        {
+                reassembly->active = 0;
+                return -ERR_OUT_OF_RANGE;
+        }
+        if (needed > reassembly->capacity)
+        {
+                size_t capacity = reassembly->capacity
+                                  ? reassembly->capacity
+                                  : FRAGMENT_DATA_SIZE;
+
+                while (capacity < needed)
+                {
+                        capacity *= 2;
+                }
+                reassembly->data = realloc(reassembly->data, capacity);
+                if (! reassembly->data)
+                {
+                        perror("realloc() ");
+                        exit(-1);
+                }
+                reassembly->capacity = capacity;
+        }
+        memcpy(&reassembly->data[reassembly->size], fragment_data(packet), size);
+        reassembly->size = needed;
+
+        if (flags & FRAGMENT_LAST)
+        {
+                reassembly->active = 0;
+                return 1;
+        }
+
+        return 0;
+}
+
+
+/**
+ *  \brief Fragment reassembly function.
+ *
+ *         This function appends a received fragment to the payload being
+ *         reassembled. When the last fragment is received, the payload is
+ *         available in the \c data and \c size fields of the reassembly
+ *         state, with its TAG in \c type, until the next call. A
+ *         compressed fragment (PACKET_COMPRESSED) is expanded first.
+ *
+ * @param reassembly    the reassembly state of the connection
+ * @param packet        the received fragment (L + TAG + DATA)
+ * @return              the reassembly status
+ * @retval 1                    the payload is complete
+ * @retval 0                    more fragments are expected
+ * @retval -ERR_BAD_PROTOCOL    invalid fragment or fragments sequence (the
+ *                              partial payload is dropped)
+ * @retval -ERR_OUT_OF_RANGE    the payload exceeds the maximum size (the
+ *                              partial payload is dropped)
+ */
+int fragment_reassemble(struct fragment_reassembly * reassembly,
+                        const unsigned char * packet)
+{
+        struct xbuf * original;
+        int           status;
+
+        if (packet_type(packet) != PACKET_COMPRESSED)
+        {
+                return fragment_append(reassembly, packet);
+        }
+
+        original = xbuf_alloc(MAX_PACKET_SIZE);
+        status = compress_expand(NULL, packet, packet_data_len(packet) + PACKET_LEN_SIZE,
+                                 original->data, MAX_PACKET_SIZE);
+        if (status > 0)
+        {
+                status = fragment_append(reassembly, original->data);
+        }
+        else
+        {
+                reassembly->active = 0;
+                status = -ERR_BAD_PROTOCOL;
+        }
+        xbuf_unref(original);
+
+        return status;
+}
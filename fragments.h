@@ -0,0 +1,86 @@
+/**
+ *  \file    fragments.h
+ *  \brief   Large payloads handling.
+ *
+ *           Project: project independant file.
+ *
+ *           This is the header file of fragments.c and contains all the
+ *           constants, structures and functions declarations needed to
+ *           transmit payloads larger than MAX_DATA_SIZE.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#ifndef FRAGMENTS_H
+#define FRAGMENTS_H
+
+#include <stddef.h>
+
+#include "packets.h"
+
+/**
+ *  \defgroup fragments Large payloads constants and structures
+ *
+ *  \details
+ *  A payload larger than MAX_DATA_SIZE is sent as a sequence of
+ *  PACKET_FRAGMENT packets. The data of each fragment is:
+ *  - <tt>1 byte</tt>  the TAG of the payload
+ *  - <tt>1 byte</tt>  the fragment flags (FRAGMENT_FIRST, FRAGMENT_LAST)
+ *  - <tt>x bytes</tt> the next part of the payload
+ *
+ *  Fragments of a payload are sent in order and are not interleaved with
+ *  the fragments of another payload. Other packets may be sent between
+ *  two fragments. Each fragment may be compressed (see compress.h).
+ *  Fragments must only be sent to a peer that announced
+ *  CAPABILITY_FRAGMENTS.
+ *  @{
+ */
+
+/*! Fragment flag: first fragment of a payload. */
+#define FRAGMENT_FIRST          0x01
+
+/*! Fragment flag: last fragment of a payload. */
+#define FRAGMENT_LAST           0x02
+
+/*! Size of the fragment information in front of the payload part. */
+#define FRAGMENT_HEADER_SIZE    2
+
+/*! Maximum size of the payload part of a fragment. */
+#define FRAGMENT_DATA_SIZE      (MAX_DATA_SIZE - FRAGMENT_HEADER_SIZE)
+
+/*! Reassembly state of the fragmented payloads of a connection. It must
+ *  be initialised with fragment_init().
+ */
+struct fragment_reassembly {
+        int             type;      /*!< TAG of the payload.                  */
+        int             active;    /*!< A payload is being reassembled.      */
+        size_t          size;      /*!< Received size of the payload.        */
+        size_t          capacity;  /*!< Allocated size of the buffer.        */
+        size_t          max_size;  /*!< Maximum accepted payload size.       */
+        unsigned char * data;      /*!< Payload.                             */
+};
+
+/** @} */
+
+
+/** @cond DUPLICATE_DOCUMENTATION */
+int fragment_send(int socket_fd, int type, const unsigned char * data,
+                  int size, int flags);
+int fragment_send_large(int socket_fd, int type, const unsigned char * data,
+                        size_t size);
+int fragment_type(const unsigned char * packet);
+int fragment_flags(const unsigned char * packet);
+int fragment_data_len(const unsigned char * packet);
+const unsigned char * fragment_data(const unsigned char * packet);
+void fragment_init(struct fragment_reassembly * reassembly, size_t max_size);
+void fragment_free(struct fragment_reassembly * reassembly);
+int fragment_reassemble(struct fragment_reassembly * reassembly,
+                        const unsigned char * packet);
+/** @endcond */
+
+
+#endif /* FRAGMENTS_H */
@@ -0,0 +1,611 @@
+/**
+ *  \file    metrics.c
+ *  \brief   Communication metrics.
+ *
+ *           Project: project independant file.
+ *
+ *           This file contains the counters of the communications. Each
+ *           thread owns a block of counters, created on its first update
+ *           and chained in a global list: the hot paths only store to
+ *           their own block (relaxed atomic stores, no locked instruction)
+ *           and the readers add all the blocks. The blocks are never
+ *           released, so that the counts of the finished threads remain.
+ *
+ *           The counters of a connection are shared by the threads that
+ *           use it: they are updated with relaxed atomic additions. They
+ *           are found by file descriptor and reset by metrics_open().
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "errors.h"
+#include "metrics.h"
+#include "xmem.h"
+
+
+/**
+ *  \defgroup mtinternals Metrics internals
+ *  @{
+ */
+
+/*! Counters of a thread. */
+struct metrics_block {
+        struct metrics_tag       tags[256];               /*!< Per TAG.         */
+        struct metrics_counters  total;                   /*!< All traffic.     */
+        unsigned long long       errors[METRICS_ERRORS];  /*!< Per error.       */
+        struct metrics_histogram latency;                 /*!< Requests.        */
+        struct metrics_block   * next;                    /*!< Next thread.     */
+};
+
+/*! Counters of a connection. */
+struct metrics_connection {
+        int                     active;    /*!< Followed connection.  */
+        struct metrics_counters counters;  /*!< Counters.             */
+};
+
+/*! Single-writer counter update (the block of the current thread). */
+#define COUNT(counter, value) \
+        __atomic_store_n(&(counter), (counter) + (value), __ATOMIC_RELAXED)
+
+/*! Shared counter update (the counters of a connection). */
+#define SHARED_COUNT(counter, value) \
+        __atomic_fetch_add(&(counter), (value), __ATOMIC_RELAXED)
+
+/*! Counter reading. */
+#define READ(counter) __atomic_load_n(&(counter), __ATOMIC_RELAXED)
+
+/** @} */
+
+
+/*! Blocks of all the threads. */
+static struct metrics_block * blocks = NULL;
+
+/*! Blocks list lock (registration only). */
+static pthread_mutex_t blocks_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*! Block of the current thread. */
+static __thread struct metrics_block * current_block = NULL;
+
+/*! Counters of the followed connections, by file descriptor. */
+static struct metrics_connection * connections[METRICS_MAX_CONNECTIONS];
+
+
+/**
+ *  \brief Block of the current thread, created on the first call.
+ */
+static struct metrics_block * metrics_block(void)
+{
+        struct metrics_block * block = current_block;
+
+        if (block)
+        {
+                return block;
+        }
+        block = xmalloc(sizeof(struct metrics_block));
+        memset(block, 0, sizeof(struct metrics_block));
+
+        pthread_mutex_lock(&blocks_lock);
+        block->next = blocks;
+        __atomic_store_n(&blocks, block, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&blocks_lock);
+
+        current_block = block;
+        return block;
+}
+
+
+/**
+ *  \brief Counters of a followed connection.
+ *
+ * @param fd            file descriptor of the connection
+ * @return              the counters, NULL if the connection is not followed
+ */
+static struct metrics_counters * metrics_counters(int fd)
+{
+        struct metrics_connection * connection;
+
+        if ((fd < 0) || (fd >= METRICS_MAX_CONNECTIONS))
+        {
+                return NULL;
+        }
+        connection = __atomic_load_n(&connections[fd], __ATOMIC_ACQUIRE);
+        if (! connection || ! READ(connection->active))
+        {
+                return NULL;
+        }
+        return &connection->counters;
+}
+
+
+/**
+ *  \brief Connection following start.
+ *
+ *         The counters of the connection are reset. The counters of a
+ *         file descriptor are allocated once, and reused by the following
+ *         connections with the same descriptor.
+ *
+ * @param fd            file descriptor of the connection
+ */
+void metrics_open(int fd)
+{
+        struct metrics_connection * connection;
+
+        if ((fd < 0) || (fd >= METRICS_MAX_CONNECTIONS))
+        {
+                return;
+        }
+        connection = __atomic_load_n(&connections[fd], __ATOMIC_ACQUIRE);
+        if (! connection)
+        {
+                struct metrics_connection * expected = NULL;
+
+                connection = xmalloc(sizeof(struct metrics_connection));
+                memset(connection, 0, sizeof(struct metrics_connection));
+                if (! __atomic_compare_exchange_n(&connections[fd], &expected,
+                                                  connection, 0,
+                                                  __ATOMIC_ACQ_REL,
+                                                  __ATOMIC_ACQUIRE))
+                {
+                        /* Un autre thread l'a créé entre-temps. */
+                        free(connection);
+                        connection = expected;
+                }
+        }
+        memset(&connection->counters, 0, sizeof(struct metrics_counters));
+        __atomic_store_n(&connection->active, 1, __ATOMIC_RELEASE);
+}
+
+
+/**
+ *  \brief Connection following end.
+ *
+ * @param fd            file descriptor of the connection
+ */
+void metrics_close(int fd)
+{
+        if ((fd >= 0) && (fd < METRICS_MAX_CONNECTIONS) && connections[fd])
+        {
+                __atomic_store_n(&connections[fd]->active, 0, __ATOMIC_RELEASE);
+        }
+}
+
+
+/**
+ *  \brief Received frame counting.
+ *
+ * @param fd            connection (-1 if unknown)
+ * @param tag           TAG of the frame
+ * @param size          size of the frame
+ */
+void metrics_frame_in(int fd, int tag, int size)
+{
+        struct metrics_block    * block = metrics_block();
+        struct metrics_counters * counters = metrics_counters(fd);
+
+        COUNT(block->tags[tag & 0xFF].frames_in, 1);
+        COUNT(block->tags[tag & 0xFF].bytes_in, size);
+        COUNT(block->total.frames_in, 1);
+        if (counters)
+        {
+                SHARED_COUNT(counters->frames_in, 1);
+        }
+}
+
+
+/**
+ *  \brief Sent frame counting.
+ *
+ * @param fd            connection (-1 if unknown)
+ * @param tag           TAG of the frame
+ * @param size          size of the frame
+ */
+void metrics_frame_out(int fd, int tag, int size)
+{
+        struct metrics_block    * block = metrics_block();
+        struct metrics_counters * counters = metrics_counters(fd);
+
+        COUNT(block->tags[tag & 0xFF].frames_out, 1);
+        COUNT(block->tags[tag & 0xFF].bytes_out, size);
+        COUNT(block->total.frames_out, 1);
+        if (counters)
+        {
+                SHARED_COUNT(counters->frames_out, 1);
+        }
+}
+
+
+/**
+ *  \brief Receive system call counting.
+ *
+ *         This function must be called right after the call, errno is
+ *         examined for a failed call.
+ *
+ * @param fd            connection
+ * @param result        result of the call (received bytes or -1)
+ */
+void metrics_read(int fd, int result)
+{
+        struct metrics_block    * block = metrics_block();
+        struct metrics_counters * counters = metrics_counters(fd);
+        int                       again = (result < 0) &&
+                                          ((errno == EAGAIN) || (errno == EWOULDBLOCK));
+
+        COUNT(block->total.syscalls_in, 1);
+        if (result > 0)
+        {
+                COUNT(block->total.bytes_in, result);
+        }
+        if (again)
+        {
+                COUNT(block->total.eagains, 1);
+        }
+        if (counters)
+        {
+                SHARED_COUNT(counters->syscalls_in, 1);
+                if (result > 0)
+                {
+                        SHARED_COUNT(counters->bytes_in, result);
+                }
+                if (again)
+                {
+                        SHARED_COUNT(counters->eagains, 1);
+                }
+        }
+}
+
+
+/**
+ *  \brief Send system call counting.
+ *
+ *         This function must be called right after the call, errno is
+ *         examined for a failed call.
+ *
+ * @param fd            connection
+ * @param result        result of the call (sent bytes or -1)
+ * @param requested     number of bytes given to the call
+ */
+void metrics_write(int fd, int result, int requested)
+{
+        struct metrics_block    * block = metrics_block();
+        struct metrics_counters * counters = metrics_counters(fd);
+        int                       again = (result < 0) &&
+                                          ((errno == EAGAIN) || (errno == EWOULDBLOCK));
+        int                       partial = (result >= 0) && (result < requested);
+
+        COUNT(block->total.syscalls_out, 1);
+        if (result > 0)
+        {
+                COUNT(block->total.bytes_out, result);
+        }
+        if (again)
+        {
+                COUNT(block->total.eagains, 1);
+        }
+        if (partial)
+        {
+                COUNT(block->total.partial_writes, 1);
+        }
+        if (counters)
+        {
+                SHARED_COUNT(counters->syscalls_out, 1);
+                if (result > 0)
+                {
+                        SHARED_COUNT(counters->bytes_out, result);
+                }
+                if (again)
+                {
+                        SHARED_COUNT(counters->eagains, 1);
+                }
+                if (partial)
+                {
+                        SHARED_COUNT(counters->partial_writes, 1);
+                }
+        }
+}
+
+
+/**
+ *  \brief Connection error counting.
+ *
+ * @param fd            connection (-1 if unknown)
+ * @param error         error code (ERR_* value, negative or not)
+ */
+void metrics_error(int fd, int error)
+{
+        struct metrics_block    * block = metrics_block();
+        struct metrics_counters * counters = metrics_counters(fd);
+
+        if (error < 0)
+        {
+                error = -error;
+        }
+        if (error >= METRICS_ERRORS)
+        {
+                error = 0;
+        }
+        COUNT(block->errors[error], 1);
+        COUNT(block->total.errors, 1);
+        if (counters)
+        {
+                SHARED_COUNT(counters->errors, 1);
+        }
+}
+
+
+/**
+ *  \brief Outgoing queue depth setting.
+ *
+ * @param fd            connection
+ * @param depth         bytes waiting to be sent
+ */
+void metrics_queue(int fd, int depth)
+{
+        struct metrics_counters * counters = metrics_counters(fd);
+
+        if (counters)
+        {
+                __atomic_store_n(&counters->queue_depth, depth, __ATOMIC_RELAXED);
+                if ((unsigned long long) depth > READ(counters->queue_peak))
+                {
+                        __atomic_store_n(&counters->queue_peak, depth,
+                                         __ATOMIC_RELAXED);
+                }
+        }
+}
+
+
+/**
+ *  \brief Bucket of a value in a histogram.
+ */
+static int metrics_bucket(unsigned long long value)
+{
+        int exponent, shift;
+
+        if (value < METRICS_SUB_BUCKETS)
+        {
+                return (int) value;
+        }
+        exponent = 63 - __builtin_clzll(value);
+        shift = exponent - METRICS_SUB_BITS;
+
+        return (shift + 1) * METRICS_SUB_BUCKETS +
+               (int) ((value >> shift) & (METRICS_SUB_BUCKETS - 1));
+}
+
+
+/**
+ *  \brief Smallest value of a bucket of a histogram.
+ */
+static unsigned long long metrics_bucket_value(int bucket)
+{
+        int shift;
+
+        if (bucket < METRICS_SUB_BUCKETS)
+        {
+                return bucket;
+        }
+        shift = bucket / METRICS_SUB_BUCKETS - 1;
+
+        return (unsigned long long) (METRICS_SUB_BUCKETS +
+                                     bucket % METRICS_SUB_BUCKETS) << shift;
+}
+
+
+/**
+ *  \brief Value recording in a histogram owned by the current thread.
+ *
+ * @param histogram     the histogram
+ * @param value         the value
+ */
+void metrics_histogram_add(struct metrics_histogram * histogram,
+                           unsigned long long value)
+{
+        COUNT(histogram->buckets[metrics_bucket(value)], 1);
+        COUNT(histogram->count, 1);
+        COUNT(histogram->sum, value);
+        if (value > histogram->max)
+        {
+                __atomic_store_n(&histogram->max, value, __ATOMIC_RELAXED);
+        }
+}
+
+
+/**
+ *  \brief Request latency recording.
+ *
+ * @param ns            round trip of a request, in nanoseconds
+ */
+void metrics_latency(unsigned long long ns)
+{
+        metrics_histogram_add(&metrics_block()->latency, ns);
+}
+
+
+/**
+ *  \brief Percentile of a histogram.
+ *
+ * @param histogram     the histogram
+ * @param percentile    the percentile (0 to 100)
+ * @return              the value under which the given percentage of the
+ *                      values are (middle of its bucket), 0 if empty
+ */
+unsigned long long metrics_percentile(const struct metrics_histogram * histogram,
+                                      double percentile)
+{
+        unsigned long long wanted, seen = 0;
+        int                i;
+
+        if (histogram->count == 0)
+        {
+                return 0;
+        }
+        wanted = (unsigned long long) (histogram->count * percentile / 100.0 + 0.5);
+        if (wanted == 0)
+        {
+                wanted = 1;
+        }
+        for (i = 0 ; i < METRICS_BUCKETS ; i++)
+        {
+                seen += histogram->buckets[i];
+                if (seen >= wanted)
+                {
+                        unsigned long long low = metrics_bucket_value(i);
+                        unsigned long long high = metrics_bucket_value(i + 1);
+                        unsigned long long middle = low + (high - low) / 2;
+
+                        return (middle < histogram->max) ? middle : histogram->max;
+                }
+        }
+        return histogram->max;
+}
+
+
+/**
+ *  \brief Metrics snapshot.
+ *
+ *         This function adds the counters of all the threads. It takes no
+ *         lock: the counts of a snapshot taken during the traffic may be
+ *         off by the updates made while it is taken.
+ *
+ * @param snapshot      the returned metrics
+ */
+void metrics_snapshot(struct metrics_snapshot * snapshot)
+{
+        struct metrics_block * block;
+        int                    i;
+
+        memset(snapshot, 0, sizeof(struct metrics_snapshot));
+        for (block = __atomic_load_n(&blocks, __ATOMIC_ACQUIRE) ;
+             block ; block = block->next)
+        {
+                unsigned long long * from = (unsigned long long *) &block->total;
+                unsigned long long * to = (unsigned long long *) &snapshot->total;
+                unsigned long long   max;
+
+                for (i = 0 ; i < 256 ; i++)
+                {
+                        snapshot->tags[i].frames_in += READ(block->tags[i].frames_in);
+                        snapshot->tags[i].frames_out += READ(block->tags[i].frames_out);
+                        snapshot->tags[i].bytes_in += READ(block->tags[i].bytes_in);
+                        snapshot->tags[i].bytes_out += READ(block->tags[i].bytes_out);
+                }
+                for (i = 0 ; i < (int) (sizeof(struct metrics_counters) /
+                                        sizeof(unsigned long long)) ; i++)
+                {
+                        to[i] += READ(from[i]);
+                }
+                for (i = 0 ; i < METRICS_ERRORS ; i++)
+                {
+                        snapshot->errors[i] += READ(block->errors[i]);
+                }
+                for (i = 0 ; i < METRICS_BUCKETS ; i++)
+                {
+                        snapshot->latency.buckets[i] += READ(block->latency.buckets[i]);
+                }
+                snapshot->latency.count += READ(block->latency.count);
+                snapshot->latency.sum += READ(block->latency.sum);
+                max = READ(block->latency.max);
+                if (max > snapshot->latency.max)
+                {
+                        snapshot->latency.max = max;
+                }
+        }
+}
+
+
+/**
+ *  \brief Connection metrics snapshot.
+ *
+ * @param fd            file descriptor of the connection
+ * @param counters      the returned counters
+ * @return              the status of the operation
+ * @retval SUCCESS              counters returned
+ * @retval -ERR_NOT_FOUND       the connection is not followed
+ */
+int metrics_connection(int fd, struct metrics_counters * counters)
+{
+        struct metrics_counters * current = metrics_counters(fd);
+        unsigned long long      * from = (unsigned long long *) current;
+        unsigned long long      * to = (unsigned long long *) counters;
+        int                       i;
+
+        if (! current)
+        {
+                return -ERR_NOT_FOUND;
+        }
+        for (i = 0 ; i < (int) (sizeof(struct metrics_counters) /
+                                sizeof(unsigned long long)) ; i++)
+        {
+                to[i] = READ(from[i]);
+        }
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Metrics text dump.
+ *
+ *         This function writes the process counters, the TAGs that have
+ *         some traffic, the errors that occured and the latency
+ *         percentiles, one item per line.
+ *
+ * @param out           output stream
+ */
+void metrics_dump(FILE * out)
+{
+        struct metrics_snapshot * snapshot = xmalloc(sizeof(struct metrics_snapshot));
+        struct metrics_counters * total = &snapshot->total;
+        int                       i;
+
+        metrics_snapshot(snapshot);
+        fprintf(out, "frames in=%llu out=%llu bytes in=%llu out=%llu\n",
+                total->frames_in, total->frames_out,
+                total->bytes_in, total->bytes_out);
+        fprintf(out, "syscalls in=%llu out=%llu partial_writes=%llu "
+                "eagains=%llu errors=%llu\n",
+                total->syscalls_in, total->syscalls_out,
+                total->partial_writes, total->eagains, total->errors);
+        for (i = 0 ; i < 256 ; i++)
+        {
+                struct metrics_tag * tag = &snapshot->tags[i];
+
+                if (tag->frames_in || tag->frames_out)
+                {
+                        fprintf(out, "tag 0x%02X frames in=%llu out=%llu "
+                                "bytes in=%llu out=%llu\n", i,
+                                tag->frames_in, tag->frames_out,
+                                tag->bytes_in, tag->bytes_out);
+                }
+        }
+        for (i = 0 ; i < METRICS_ERRORS ; i++)
+        {
+                if (snapshot->errors[i])
+                {
+                        fprintf(out, "error %d (%s) count=%llu\n", i,
+                                get_error_name(-i), snapshot->errors[i]);
+                }
+        }
+        if (snapshot->latency.count)
+        {
+                fprintf(out, "latency_ns count=%llu mean=%llu p50=%llu p90=%llu "
+                        "p99=%llu p999=%llu max=%llu\n",
+                        snapshot->latency.count,
+                        snapshot->latency.sum / snapshot->latency.count,
+                        metrics_percentile(&snapshot->latency, 50),
+                        metrics_percentile(&snapshot->latency, 90),
+                        metrics_percentile(&snapshot->latency, 99),
+                        metrics_percentile(&snapshot->latency, 99.9),
+                        snapshot->latency.max);
+        }
+        free(snapshot);
+}
@@ -0,0 +1,121 @@
+/**
+ *  \file    metrics.h
+ *  \brief   Communication metrics.
+ *
+ *           Project: project independant file.
+ *
+ *           This is the header file of metrics.c and contains all the
+ *           constants, structures and functions declarations needed to
+ *           count the traffic per TAG and per connection and to measure
+ *           the requests latency.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+
+/**
+ *  \defgroup metrics Metrics constants and structures
+ *
+ *  \details
+ *  The library counts, for the whole process, the frames and bytes
+ *  received and sent per TAG, the system calls, partial writes, EAGAIN,
+ *  connection errors per error code (see errors_list.h) and the latency
+ *  of the requests (see requests.h). The same counters, but the per-TAG
+ *  ones, are kept for each connection registered with metrics_open()
+ *  (event_add_reader() registers its connections).
+ *
+ *  The counters are updated without lock: each thread updates its own
+ *  block, and metrics_snapshot() adds the blocks of all the threads.
+ *
+ *  The latencies are kept in HDR-style histograms: each power of two is
+ *  divided in METRICS_SUB_BUCKETS buckets, so that a percentile is known
+ *  within 1 / METRICS_SUB_BUCKETS of its value, from 1 ns to hours.
+ *  @{
+ */
+
+/*! Number of file descriptors whose connection can be followed. */
+#define METRICS_MAX_CONNECTIONS 4096
+
+/*! Number of error codes counted. */
+#define METRICS_ERRORS          128
+
+/*! log2 of the number of buckets per power of two of a histogram. */
+#define METRICS_SUB_BITS        4
+
+/*! Number of buckets per power of two of a histogram. */
+#define METRICS_SUB_BUCKETS     (1 << METRICS_SUB_BITS)
+
+/*! Number of buckets of a histogram (64 bits values). */
+#define METRICS_BUCKETS         ((64 - METRICS_SUB_BITS + 1) * METRICS_SUB_BUCKETS)
+
+/*! Traffic of a TAG. */
+struct metrics_tag {
+        unsigned long long frames_in;   /*!< Received frames.        */
+        unsigned long long frames_out;  /*!< Sent frames.            */
+        unsigned long long bytes_in;    /*!< Received bytes.         */
+        unsigned long long bytes_out;   /*!< Sent bytes.             */
+};
+
+/*! Counters of a connection (or of the whole process). */
+struct metrics_counters {
+        unsigned long long frames_in;       /*!< Received frames.           */
+        unsigned long long frames_out;      /*!< Sent frames.               */
+        unsigned long long bytes_in;        /*!< Received bytes.            */
+        unsigned long long bytes_out;       /*!< Sent bytes.                */
+        unsigned long long syscalls_in;     /*!< Receive system calls.      */
+        unsigned long long syscalls_out;    /*!< Send system calls.         */
+        unsigned long long partial_writes;  /*!< Incomplete sends.          */
+        unsigned long long eagains;         /*!< Calls that would block.    */
+        unsigned long long errors;          /*!< Connection errors.         */
+        unsigned long long queue_depth;     /*!< Bytes waiting to be sent.  */
+        unsigned long long queue_peak;      /*!< Maximum queue depth.       */
+};
+
+/*! Latency histogram, in nanoseconds. */
+struct metrics_histogram {
+        unsigned long long count;                     /*!< Number of values.  */
+        unsigned long long sum;                       /*!< Sum of the values. */
+        unsigned long long max;                       /*!< Maximum value.     */
+        unsigned long long buckets[METRICS_BUCKETS];  /*!< Values per bucket. */
+};
+
+/*! Metrics of the whole process. */
+struct metrics_snapshot {
+        struct metrics_tag       tags[256];               /*!< Per TAG.      */
+        struct metrics_counters  total;                   /*!< All traffic.  */
+        unsigned long long       errors[METRICS_ERRORS];  /*!< Per error.    */
+        struct metrics_histogram latency;                 /*!< Requests.     */
+};
+
+/** @} */
+
+
+/** @cond DUPLICATE_DOCUMENTATION */
+void metrics_open(int fd);
+void metrics_close(int fd);
+void metrics_frame_in(int fd, int tag, int size);
+void metrics_frame_out(int fd, int tag, int size);
+void metrics_read(int fd, int result);
+void metrics_write(int fd, int result, int requested);
+void metrics_error(int fd, int error);
+void metrics_queue(int fd, int depth);
+void metrics_latency(unsigned long long ns);
+void metrics_histogram_add(struct metrics_histogram * histogram,
+                           unsigned long long value);
+unsigned long long metrics_percentile(const struct metrics_histogram * histogram,
+                                      double percentile);
+void metrics_snapshot(struct metrics_snapshot * snapshot);
+int metrics_connection(int fd, struct metrics_counters * counters);
+void metrics_dump(FILE * out);
+/** @endcond */
+
+
+#endif /* METRICS_H */
@@ -0,0 +1,1219 @@
+/**
+ *  \file    outqueue.c
+ *  \brief   Outgoing packets queue.
+ *
+ *           Project: project independant file.
+ *
+ *           This file contains the functions coalescing the outgoing
+ *           packets of a connection. Packets are built in place in a
+ *           per-connection buffer and sent together, in a single system
+ *           call, when the queue is flushed: explicitly (typically at the
+ *           end of a server tick), when the pending size or the age of the
+ *           oldest pending packet reaches a threshold, or immediately for
+ *           latency-critical packets.
+ *
+ *           A packet sent to many connections can be encoded once in a
+ *           shared packet buffer and queued on all their queues: the
+ *           queues then hold a reference on the buffer instead of a copy,
+ *           and the buffer is released when the last queue has sent it.
+ *
+ *           The packets are sent by priority lanes: control messages first,
+ *           then real-time packets, then the bulk payloads, which are split
+ *           into fragments built one at a time, when nothing else is
+ *           pending. A large transfer thus delays the other packets by one
+ *           fragment at most.
+ *
+ *           A queue can be bounded: when a packet does not fit, it is
+ *           refused, older droppable packets are dropped for it, or the
+ *           connection is shut down, so that a peer that stops reading
+ *           cannot make the server memory grow. Watermarks let the server
+ *           slow its producers down before.
+ *
+ *           The queue works with blocking and non-blocking sockets. With a
+ *           non-blocking socket, a flush sends what the socket accepts and
+ *           keeps the rest: the socket should then be watched for
+ *           EVENT_WRITE and flushed again when it is writable.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "errors.h"
+#include "packets.h"
+#include "tags.h"
+#include "fragments.h"
+#include "metrics.h"
+#include "outqueue.h"
+#include "shmem.h"
+#include "xmem.h"
+
+
+/**
+ *  \brief Function returning the current monotonic date.
+ *
+ * @return              the date in milliseconds
+ */
+static long long now_ms(void)
+{
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        return (long long) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+
+/**
+ *  \brief Function making room for a packet in the queue buffer.
+ *
+ *         The packets already sent are removed from the beginning of the
+ *         buffer, then the buffer is enlarged if it is still too small.
+ *
+ * @param queue         the queue
+ * @param size          size needed at the end of the buffer
+ */
+static void queue_reserve(struct outqueue * queue, int size)
+{
+        if (queue->capacity - queue->used >= size)
+        {
+                return;
+        }
+
+        if (queue->used > 0)
+        {
+                int start = queue->used;
+                int i;
+
+                /*
+                 *      Les paquets ne sont pas forcément dans l'ordre du
+                 *      tampon : le plus ancien encore en attente est celui
+                 *      dont la position est la plus petite.
+                 */
+                for (i = 0 ; i < queue->nb_frames ; i++)
+                {
+                        if (! queue->frames[i].shared && (queue->frames[i].offset < start))
+                        {
+                                start = queue->frames[i].offset;
+                        }
+                }
+                if (start > 0)
+                {
+                        memmove(queue->buffer, &queue->buffer[start],
+                                queue->used - start);
+                        queue->used -= start;
+                        for (i = 0 ; i < queue->nb_frames ; i++)
+                        {
+                                queue->frames[i].offset -= start;
+                        }
+                }
+        }
+
+        if (queue->capacity - queue->used < size)
+        {
+                int capacity = queue->capacity ? queue->capacity : OUTQUEUE_SIZE;
+
+                while (capacity - queue->used < size)
+                {
+                        capacity *= 2;
+                }
+                queue->buffer = realloc(queue->buffer, capacity);
+                if (! queue->buffer)
+                {
+                        perror("realloc() ");
+                        exit(-1);
+                }
+                queue->capacity = capacity;
+        }
+}
+
+
+/**
+ *  \brief Function removing sent bytes from the queue.
+ *
+ * @param queue         the queue
+ * @param size          number of bytes sent
+ */
+static void queue_consume(struct outqueue * queue, int size)
+{
+        int done = 0;
+
+        queue->pending -= size;
+        size += queue->sent;
+        while ((done < queue->nb_frames) && (size >= queue->frames[done].size))
+        {
+                struct outqueue_frame * frame = &queue->frames[done];
+                unsigned char         * packet = frame->shared
+                                                 ? frame->shared->data
+                                                 : &queue->buffer[frame->offset];
+
+                metrics_frame_out(queue->socket_fd, packet[PACKET_LEN_SIZE],
+                                  frame->size);
+                size -= frame->size;
+                if (frame->shared)
+                {
+                        xbuf_unref(frame->shared);
+                }
+                done++;
+        }
+        queue->sent = size;
+
+        if (done == queue->nb_frames)
+        {
+                queue->nb_frames = 0;
+                queue->used = 0;
+                queue->sent = 0;
+        }
+        else if (done > 0)
+        {
+                memmove(queue->frames, &queue->frames[done],
+                        (queue->nb_frames - done) * sizeof(struct outqueue_frame));
+                queue->nb_frames -= done;
+        }
+}
+
+
+/**
+ *  \brief Function giving the lane of a packet.
+ *
+ * @param type          packet type (TAG)
+ * @param flags         packet flags (OUTQUEUE_CONTROL)
+ * @return              the lane of the packet
+ */
+static int queue_lane(int type, int flags)
+{
+        if ((flags & OUTQUEUE_CONTROL) || ((type & 0xFF) >= PACKET_MSG_ACK))
+        {
+                return OUTQUEUE_LANE_CONTROL;
+        }
+
+        return OUTQUEUE_LANE_REALTIME;
+}
+
+
+/**
+ *  \brief Function adding a packet to the pending packets.
+ *
+ *         The packet is placed after the pending packets of its lane and
+ *         of the higher lanes, but never before the packet being sent.
+ *
+ * @param queue         the queue
+ * @param size          full size of the packet
+ * @param flags         packet flags
+ * @param lane          priority lane of the packet
+ * @return              the new frame (at the current end of the buffer)
+ */
+static struct outqueue_frame * queue_add(struct outqueue * queue, int size,
+                                         int flags, int lane)
+{
+        struct outqueue_frame * frame;
+        int                     position = queue->nb_frames;
+        int                     first = (queue->sent > 0) ? 1 : 0;
+
+        if (queue->nb_frames == queue->max_frames)
+        {
+                queue->max_frames = queue->max_frames ? queue->max_frames * 2 : 64;
+                queue->frames = realloc(queue->frames, queue->max_frames
+                                        * sizeof(struct outqueue_frame));
+                if (! queue->frames)
+                {
+                        perror("realloc() ");
+                        exit(-1);
+                }
+        }
+        if (queue->nb_frames == 0)
+        {
+                queue->oldest = now_ms();
+        }
+        while ((position > first) && (queue->frames[position - 1].lane > lane))
+        {
+                position--;
+        }
+        if (position < queue->nb_frames)
+        {
+                memmove(&queue->frames[position + 1], &queue->frames[position],
+                        (queue->nb_frames - position) * sizeof(struct outqueue_frame));
+        }
+        queue->nb_frames++;
+        frame = &queue->frames[position];
+        frame->offset = queue->used;
+        frame->size = size;
+        frame->flags = flags;
+        frame->lane = lane;
+        queue->pending += size;
+        metrics_queue(queue->socket_fd, queue->pending);
+
+        return frame;
+}
+
+
+/**
+ *  \brief Function giving the number of bytes still to send.
+ *
+ * @param queue         the queue
+ * @return              the pending bytes and the bulk bytes not fragmented
+ *                      yet (at most INT_MAX)
+ */
+static int queue_remaining(const struct outqueue * queue)
+{
+        if (queue->bulk > (size_t) (INT_MAX - queue->pending))
+        {
+                return INT_MAX;
+        }
+
+        return queue->pending + (int) queue->bulk;
+}
+
+
+/**
+ *  \brief Function calling the watermark function when a watermark is
+ *         crossed.
+ *
+ * @param queue         the queue
+ */
+static void queue_watermark(struct outqueue * queue)
+{
+        int remaining;
+
+        if (! queue->watermark)
+        {
+                return;
+        }
+
+        remaining = queue_remaining(queue);
+        if (! queue->above && (remaining >= queue->high_mark))
+        {
+                queue->above = 1;
+                queue->watermark(queue, 1, queue->watermark_data);
+        }
+        else if (queue->above && (remaining <= queue->low_mark))
+        {
+                queue->above = 0;
+                queue->watermark(queue, 0, queue->watermark_data);
+        }
+}
+
+
+/**
+ *  \brief Function checking the limits of the queue.
+ *
+ * @param queue         the queue
+ * @param size          size of the new packet or payload
+ * @param freed         bytes that would be dropped before
+ * @param nb_freed      packets that would be dropped before
+ * @return              1 if the new packet fits in the queue, 0 otherwise
+ */
+static int queue_fits(const struct outqueue * queue, size_t size,
+                      size_t freed, int nb_freed)
+{
+        size_t bytes = queue->pending + queue->bulk + size - freed;
+        int    count = queue->nb_frames + queue->nb_transfers - nb_freed;
+
+        /*
+         *      Le fragment en attente d'un transfert commencé est déjà
+         *      compté avec les paquets : le transfert ne compte pas deux fois.
+         */
+        if ((queue->nb_transfers > 0) && (queue->transfers[0].offset > 0))
+        {
+                count--;
+        }
+
+        return ((queue->max_bytes == 0) || (bytes <= (size_t) queue->max_bytes)) &&
+               ((queue->max_count == 0) || (count < queue->max_count));
+}
+
+
+/**
+ *  \brief Function dropping all the pending packets and bulk payloads.
+ *
+ * @param queue         the queue
+ */
+static void queue_clear(struct outqueue * queue)
+{
+        int i;
+
+        for (i = 0 ; i < queue->nb_frames ; i++)
+        {
+                if (queue->frames[i].shared)
+                {
+                        xbuf_unref(queue->frames[i].shared);
+                }
+        }
+        for (i = 0 ; i < queue->nb_transfers ; i++)
+        {
+                xbuf_unref(queue->transfers[i].payload);
+        }
+        queue->used = 0;
+        queue->nb_frames = 0;
+        queue->sent = 0;
+        queue->pending = 0;
+        queue->nb_transfers = 0;
+        queue->bulk = 0;
+}
+
+
+/**
+ *  \brief Function making room for a new packet, as the policy of the
+ *         queue says.
+ *
+ *         With OUTQUEUE_DROP_OLDEST, the droppable packets are dropped in
+ *         sending order (the oldest of each lane first), then the droppable
+ *         bulk payloads, and only if this makes enough room. The packet
+ *         being sent is never dropped, and neither are the fragments of a
+ *         bulk payload nor a payload whose sending has started: the peer
+ *         could not reassemble it.
+ *
+ * @param queue         the queue
+ * @param size          size of the new packet or payload
+ * @return              the status of the operation
+ * @retval SUCCESS              the new packet fits
+ * @retval -ERR_FIFO_FULL       the new packet must be refused
+ * @retval -ERR_CONNECTION_LOST the connection is shut down
+ */
+static int queue_admit(struct outqueue * queue, size_t size)
+{
+        int first = (queue->sent > 0) ? 1 : 0;
+        int i;
+
+        if (queue->closed)
+        {
+                return -ERR_CONNECTION_LOST;
+        }
+        if (queue_fits(queue, size, 0, 0))
+        {
+                return SUCCESS;
+        }
+
+        if (queue->policy == OUTQUEUE_DROP_OLDEST)
+        {
+                size_t freed = 0;
+                int    nb_freed = 0;
+
+                for (i = first ; i < queue->nb_frames ; i++)
+                {
+                        if (queue->frames[i].flags & OUTQUEUE_DROPPABLE)
+                        {
+                                freed += queue->frames[i].size;
+                                nb_freed++;
+                        }
+                }
+                for (i = 0 ; i < queue->nb_transfers ; i++)
+                {
+                        if ((queue->transfers[i].flags & OUTQUEUE_DROPPABLE) &&
+                            (queue->transfers[i].offset == 0))
+                        {
+                                freed += queue->transfers[i].payload->size;
+                                nb_freed++;
+                        }
+                }
+                if (queue_fits(queue, size, freed, nb_freed))
+                {
+                        i = first;
+                        while (! queue_fits(queue, size, 0, 0) &&
+                               (i < queue->nb_frames))
+                        {
+                                struct outqueue_frame * frame = &queue->frames[i];
+
+                                if (! (frame->flags & OUTQUEUE_DROPPABLE))
+                                {
+                                        i++;
+                                        continue;
+                                }
+                                queue->pending -= frame->size;
+                                if (frame->shared)
+                                {
+                                        xbuf_unref(frame->shared);
+                                }
+                                queue->nb_frames--;
+                                memmove(frame, frame + 1, (queue->nb_frames - i)
+                                        * sizeof(struct outqueue_frame));
+                                queue->dropped++;
+                                metrics_error(queue->socket_fd, ERR_FIFO_FULL);
+                        }
+                        i = 0;
+                        while (! queue_fits(queue, size, 0, 0))
+                        {
+                                struct outqueue_transfer * transfer = &queue->transfers[i];
+
+                                if (! (transfer->flags & OUTQUEUE_DROPPABLE) ||
+                                    (transfer->offset > 0))
+                                {
+                                        i++;
+                                        continue;
+                                }
+                                queue->bulk -= transfer->payload->size;
+                                xbuf_unref(transfer->payload);
+                                queue->nb_transfers--;
+                                memmove(transfer, transfer + 1, (queue->nb_transfers - i)
+                                        * sizeof(struct outqueue_transfer));
+                                queue->dropped++;
+                                metrics_error(queue->socket_fd, ERR_FIFO_FULL);
+                        }
+                        queue_watermark(queue);
+                        return SUCCESS;
+                }
+        }
+
+        metrics_error(queue->socket_fd, ERR_FIFO_FULL);
+        if (queue->policy == OUTQUEUE_DISCONNECT)
+        {
+                /* Le pair ne lit plus : la boucle d'événements le verra. */
+                queue_clear(queue);
+                queue->closed = 1;
+                shutdown(queue->socket_fd, SHUT_RDWR);
+                metrics_queue(queue->socket_fd, 0);
+                queue_watermark(queue);
+                return -ERR_CONNECTION_LOST;
+        }
+
+        return -ERR_FIFO_FULL;
+}
+
+
+/**
+ *  \brief Function building the next fragment of the bulk payloads.
+ *
+ *         A payload that fits in a fragment is sent as a normal packet,
+ *         with the flags of the payload. The fragments are never
+ *         droppable. Each packet is compressed if the queue has a
+ *         compressor.
+ *
+ * @param queue         the queue
+ */
+static void queue_chunk(struct outqueue * queue)
+{
+        struct outqueue_transfer * transfer = &queue->transfers[0];
+        struct outqueue_frame    * frame;
+        size_t                     left = transfer->payload->size - transfer->offset;
+        int                        part = (left > (size_t) queue->chunk_size)
+                                          ? queue->chunk_size
+                                          : (int) left;
+        int                        type = transfer->type;
+        int                        size = part;
+        unsigned char            * packet;
+        unsigned char            * data;
+
+        if ((transfer->offset > 0) || (part < (int) transfer->payload->size))
+        {
+                size += FRAGMENT_HEADER_SIZE;
+        }
+        queue_reserve(queue, PACKET_HEADER_SIZE + size);
+        packet = &queue->buffer[queue->used];
+        data = &packet[PACKET_HEADER_SIZE];
+
+        if (size > part)
+        {
+                int flags = 0;
+
+                if (transfer->offset == 0)
+                {
+                        flags |= FRAGMENT_FIRST;
+                }
+                if ((size_t) part == left)
+                {
+                        flags |= FRAGMENT_LAST;
+                }
+                data[0] = (transfer->type & 0xFF);
+                data[1] = flags;
+                data += FRAGMENT_HEADER_SIZE;
+                type = PACKET_FRAGMENT;
+        }
+        memcpy(data, &transfer->payload->data[transfer->offset], part);
+        packet[0] = ((size + PACKET_TAG_SIZE) & 0xFF);
+        packet[1] = (((size + PACKET_TAG_SIZE) >> 8) & 0xFF);
+        packet[PACKET_LEN_SIZE] = (type & 0xFF);
+        if (queue->compressor)
+        {
+                size = compress_packet(queue->compressor, packet) - PACKET_HEADER_SIZE;
+        }
+
+        frame = queue_add(queue, PACKET_HEADER_SIZE + size,
+                          (type == PACKET_FRAGMENT) ? 0 : transfer->flags,
+                          OUTQUEUE_LANE_BULK);
+        frame->shared = NULL;
+        queue->used += frame->size;
+
+        transfer->offset += part;
+        queue->bulk -= part;
+        if (transfer->offset == transfer->payload->size)
+        {
+                xbuf_unref(transfer->payload);
+                queue->nb_transfers--;
+                memmove(&queue->transfers[0], &queue->transfers[1],
+                        queue->nb_transfers * sizeof(struct outqueue_transfer));
+        }
+}
+
+
+/**
+ *  \brief Queue initialisation function.
+ *
+ *         The buffer is allocated when the first packet is queued, and it
+ *         grows when packets cannot be sent fast enough.
+ *
+ * @param queue         the queue to initialise
+ * @param socket_fd     socket on which the packets are sent
+ * @param capacity      initial size of the buffer (0 for OUTQUEUE_SIZE)
+ */
+void outqueue_init(struct outqueue * queue, int socket_fd, int capacity)
+{
+        memset(queue, 0, sizeof(struct outqueue));
+        queue->socket_fd = socket_fd;
+        queue->flush_size = OUTQUEUE_FLUSH_SIZE;
+        queue->flush_delay = OUTQUEUE_FLUSH_DELAY;
+        queue->chunk_size = OUTQUEUE_CHUNK_SIZE;
+        if (capacity > 0)
+        {
+                queue_reserve(queue, capacity);
+        }
+}
+
+
+/**
+ *  \brief Queue release function.
+ *
+ *         The pending packets and bulk payloads are dropped:
+ *         outqueue_flush() should be called before if they must be sent.
+ *
+ * @param queue         the queue to release
+ */
+void outqueue_free(struct outqueue * queue)
+{
+        queue_clear(queue);
+        FREE(queue->buffer);
+        FREE(queue->frames);
+        FREE(queue->transfers);
+        queue->capacity = 0;
+        queue->max_frames = 0;
+        queue->max_transfers = 0;
+}
+
+
+/**
+ *  \brief Queue flush thresholds setting function.
+ *
+ * @param queue         the queue
+ * @param flush_size    number of pending bytes that triggers a flush (0 to
+ *                      flush each packet as soon as it is queued)
+ * @param flush_delay   age in milliseconds of the oldest pending packet
+ *                      that makes outqueue_check() flush the queue
+ */
+void outqueue_thresholds(struct outqueue * queue, int flush_size, int flush_delay)
+{
+        queue->flush_size = flush_size;
+        queue->flush_delay = flush_delay;
+}
+
+
+/**
+ *  \brief Bulk fragments size setting function.
+ *
+ *         The smaller the fragments, the shorter the delay of the control
+ *         and real-time packets queued during a bulk transfer, and the more
+ *         system calls for the transfer.
+ *
+ * @param queue         the queue
+ * @param chunk_size    maximum size of the payload part of the fragments
+ *                      (from 1 to FRAGMENT_DATA_SIZE)
+ * @return              the status of the operation
+ * @retval SUCCESS              size set
+ * @retval -ERR_BAD_PARAMETER   invalid size
+ */
+int outqueue_chunk_size(struct outqueue * queue, int chunk_size)
+{
+        if ((chunk_size < 1) || (chunk_size > FRAGMENT_DATA_SIZE))
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        queue->chunk_size = chunk_size;
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Queue limits setting function.
+ *
+ *         The limits apply to the packets and bulk payloads queued
+ *         afterwards: the bytes waiting to be sent (bulk payloads
+ *         included) and the number of packets and bulk payloads. The
+ *         control messages are bounded as well, but never dropped unless
+ *         queued with OUTQUEUE_DROPPABLE.
+ *
+ * @param queue         the queue
+ * @param max_bytes     maximum bytes waiting to be sent (0: no limit)
+ * @param max_count     maximum number of packets and bulk payloads (0: no
+ *                      limit)
+ * @param policy        what to do with a packet that does not fit
+ *                      (OUTQUEUE_REFUSE, OUTQUEUE_DROP_OLDEST or
+ *                      OUTQUEUE_DISCONNECT)
+ */
+void outqueue_limits(struct outqueue * queue, int max_bytes, int max_count,
+                     int policy)
+{
+        queue->max_bytes = max_bytes;
+        queue->max_count = max_count;
+        queue->policy = policy;
+}
+
+
+/**
+ *  \brief Queue watermarks setting function.
+ *
+ *         The watermark function is called when the bytes waiting to be
+ *         sent reach the high watermark, then when they go back to the low
+ *         watermark: a server typically stops producing packets for this
+ *         connection in between (lower update rate, no new bulk payload).
+ *
+ * @param queue         the queue
+ * @param low_mark      bytes under which the producers can resume
+ * @param high_mark     bytes from which the producers should slow down
+ *                      (greater than low_mark)
+ * @param watermark     watermark function (NULL for none)
+ * @param data          data given to the watermark function
+ */
+void outqueue_watermarks(struct outqueue * queue, int low_mark, int high_mark,
+                         outqueue_watermark watermark, void * data)
+{
+        queue->low_mark = low_mark;
+        queue->high_mark = high_mark;
+        queue->above = 0;
+        queue->watermark = watermark;
+        queue->watermark_data = data;
+        queue_watermark(queue);
+}
+
+
+/**
+ *  \brief Queue compression setting function.
+ *
+ *         The packets built in the queue afterwards, bulk fragments
+ *         included, are compressed by compress_packet(): only the data at
+ *         least as large as the threshold of the compressor, and only when
+ *         it makes them smaller. The shared packets are sent as they are.
+ *         The peer must have announced CAPABILITY_COMPRESSION.
+ *
+ * @param queue         the queue
+ * @param compressor    compression state of the connection (NULL to stop
+ *                      compressing)
+ */
+void outqueue_compress(struct outqueue * queue, struct compressor * compressor)
+{
+        queue->compressor = compressor;
+}
+
+
+/**
+ *  \brief Function starting the building of a packet in the queue.
+ *
+ *         This function reserves room for a packet and returns the area
+ *         where its data must be written. The packet is queued by
+ *         outqueue_frame_end(). No other queue function may be called in
+ *         between.
+ *
+ * @param queue         the queue
+ * @param size          maximum size of the data of the packet
+ * @return              the area where to write the data, or NULL if the
+ *                      size is invalid
+ */
+unsigned char * outqueue_frame_begin(struct outqueue * queue, int size)
+{
+        if ((size < 0) || (size > MAX_DATA_SIZE))
+        {
+                return NULL;
+        }
+
+        queue_reserve(queue, PACKET_HEADER_SIZE + size);
+        queue->reserved = size;
+
+        return &queue->buffer[queue->used + PACKET_HEADER_SIZE];
+}
+
+
+/**
+ *  \brief Function queuing the packet started by outqueue_frame_begin().
+ *
+ *         The packet header is written in front of the data, the packet
+ *         is compressed if the queue has a compressor, and it is queued.
+ *         The queue is flushed if the packet has the OUTQUEUE_FLUSH flag
+ *         or if the pending size reaches the flush threshold.
+ *
+ * @param queue         the queue
+ * @param type          packet type (TAG)
+ * @param size          real size of the data written
+ * @param flags         packet flags (OUTQUEUE_FLUSH)
+ * @return              the number of bytes still pending or a negative
+ *                      value in case of error
+ * @retval -ERR_BAD_PARAMETER   size larger than the reserved one
+ * @retval -ERR_FIFO_FULL       the queue is full (see outqueue_limits())
+ * @retval -ERR_CONNECTION_LOST the queue was flushed and the connection is
+ *                              lost, or the queue was full and shut the
+ *                              connection down
+ */
+int outqueue_frame_end(struct outqueue * queue, int type, int size, int flags)
+{
+        unsigned char         * packet = &queue->buffer[queue->used];
+        struct outqueue_frame * frame;
+
+        int                     status;
+
+        if ((size < 0) || (size > queue->reserved))
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        queue->reserved = 0;
+
+        packet[0] = ((size + PACKET_TAG_SIZE) & 0xFF);
+        packet[1] = (((size + PACKET_TAG_SIZE) >> 8) & 0xFF);
+        packet[PACKET_LEN_SIZE] = (type & 0xFF);
+        if (queue->compressor)
+        {
+                size = compress_packet(queue->compressor, packet) - PACKET_HEADER_SIZE;
+        }
+
+        status = queue_admit(queue, size + PACKET_HEADER_SIZE);
+        if (status != SUCCESS)
+        {
+                return status;
+        }
+        frame = queue_add(queue, size + PACKET_HEADER_SIZE, flags,
+                          queue_lane(type, flags));
+        frame->shared = NULL;
+        queue->used += frame->size;
+        queue_watermark(queue);
+
+        if ((flags & OUTQUEUE_FLUSH) || (queue->pending >= queue->flush_size))
+        {
+                return outqueue_flush(queue);
+        }
+
+        return queue_remaining(queue);
+}
+
+
+/**
+ *  \brief Function queuing a packet.
+ *
+ *         This function is the queued equivalent of packet_create() and
+ *         packet_send(): the data are copied in the queue buffer.
+ *
+ * @param queue         the queue
+ * @param type          packet type (TAG)
+ * @param data          data of the packet
+ * @param size          size of the data
+ * @param flags         packet flags (OUTQUEUE_FLUSH)
+ * @return              the number of bytes still pending or a negative
+ *                      value in case of error
+ * @retval -ERR_BAD_PARAMETER   invalid size
+ * @retval -ERR_FIFO_FULL       the queue is full (see outqueue_limits())
+ * @retval -ERR_CONNECTION_LOST the queue was flushed and the connection is
+ *                              lost, or the queue was full and shut the
+ *                              connection down
+ */
+int outqueue_push(struct outqueue * queue, int type,
+                  const unsigned char * data, int size, int flags)
+{
+        unsigned char * area = outqueue_frame_begin(queue, size);
+
+        if (! area)
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        if (size > 0)
+        {
+                memcpy(area, data, size);
+        }
+
+        return outqueue_frame_end(queue, type, size, flags);
+}
+
+
+/**
+ *  \brief Function queuing a message.
+ *
+ *         This function is the queued equivalent of message_send(), used
+ *         for ACK, NACK and error messages.
+ *
+ * @param queue         the queue
+ * @param type          type (TAG) of the message
+ * @param message       optional additionnal information
+ * @param flags         packet flags (OUTQUEUE_FLUSH)
+ * @return              the number of bytes still pending or a negative
+ *                      value in case of error
+ * @retval -ERR_FIFO_FULL       the queue is full (see outqueue_limits())
+ * @retval -ERR_CONNECTION_LOST the queue was flushed and the connection is
+ *                              lost, or the queue was full and shut the
+ *                              connection down
+ */
+int outqueue_message(struct outqueue * queue, int type, int message, int flags)
+{
+        int             size = (message != 0) ? PACKET_MSG_SIZE : 0;
+        unsigned char * area = outqueue_frame_begin(queue, size);
+
+        if (message < 0)
+        {
+                message = -message;
+        }
+        if (message != 0)
+        {
+                area[0] = (message & 0xFF);
+                area[1] = ((message >> 8) & 0xFF);
+        }
+
+        return outqueue_frame_end(queue, type, size, flags);
+}
+
+
+/**
+ *  \brief Function queuing a shared packet.
+ *
+ *         The packet is not copied: the queue takes a reference on the
+ *         packet buffer, which must not be modified anymore, and releases
+ *         it once the packet is sent.
+ *
+ * @param queue         the queue
+ * @param packet        complete packet (see packet_create_shared())
+ * @param flags         packet flags (OUTQUEUE_FLUSH)
+ * @return              the number of bytes still pending or a negative
+ *                      value in case of error
+ * @retval -ERR_BAD_PARAMETER   invalid packet
+ * @retval -ERR_FIFO_FULL       the queue is full (see outqueue_limits())
+ * @retval -ERR_CONNECTION_LOST the queue was flushed and the connection is
+ *                              lost, or the queue was full and shut the
+ *                              connection down
+ */
+int outqueue_push_shared(struct outqueue * queue, struct xbuf * packet, int flags)
+{
+        struct outqueue_frame * frame;
+        int                     status;
+
+        if (! packet || (packet->size < PACKET_HEADER_SIZE) ||
+            (packet->size > MAX_PACKET_SIZE))
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+
+        status = queue_admit(queue, packet->size);
+        if (status != SUCCESS)
+        {
+                return status;
+        }
+        frame = queue_add(queue, packet->size, flags,
+                          queue_lane(packet->data[PACKET_LEN_SIZE], flags));
+        frame->shared = xbuf_ref(packet);
+        queue_watermark(queue);
+
+        if ((flags & OUTQUEUE_FLUSH) || (queue->pending >= queue->flush_size))
+        {
+                return outqueue_flush(queue);
+        }
+
+        return queue_remaining(queue);
+}
+
+
+/**
+ *  \brief Function queuing a payload of any size in the bulk lane.
+ *
+ *         This function is the queued equivalent of fragment_send_large():
+ *         the payload is copied, then sent as fragments (see
+ *         outqueue_push_bulk()).
+ *
+ * @param queue         the queue
+ * @param type          TAG of the payload
+ * @param data          payload
+ * @param size          size of the payload
+ * @param flags         packet flags (OUTQUEUE_FLUSH, OUTQUEUE_DROPPABLE)
+ * @return              the number of bytes still pending or a negative
+ *                      value in case of error
+ * @retval -ERR_FIFO_FULL       the queue is full (see outqueue_limits())
+ * @retval -ERR_CONNECTION_LOST the queue was flushed and the connection is
+ *                              lost, or the queue was full and shut the
+ *                              connection down
+ */
+int outqueue_push_large(struct outqueue * queue, int type,
+                        const unsigned char * data, size_t size, int flags)
+{
+        struct xbuf * payload = xbuf_alloc(size);
+        int           status;
+
+        if (size > 0)
+        {
+                memcpy(payload->data, data, size);
+        }
+        payload->size = size;
+        status = outqueue_push_bulk(queue, type, payload, flags);
+        xbuf_unref(payload);
+
+        return status;
+}
+
+
+/**
+ *  \brief Function queuing a shared payload in the bulk lane.
+ *
+ *         The payload is not copied: the queue takes a reference on the
+ *         buffer, which must not be modified anymore. It is sent as
+ *         PACKET_FRAGMENT packets of at most chunk_size bytes (see
+ *         outqueue_chunk_size()), built when no control or real-time
+ *         packet is pending, which requires the peer to have announced
+ *         CAPABILITY_FRAGMENTS. A payload that fits in a fragment is sent
+ *         as a normal packet. The bulk payloads are sent in order. A
+ *         droppable payload is only dropped as a whole, before its first
+ *         fragment is sent (see outqueue_limits()).
+ *
+ * @param queue         the queue
+ * @param type          TAG of the payload
+ * @param payload       payload buffer (its size is payload->size)
+ * @param flags         packet flags (OUTQUEUE_FLUSH, OUTQUEUE_DROPPABLE)
+ * @return              the number of bytes still pending or a negative
+ *                      value in case of error
+ * @retval -ERR_BAD_PARAMETER   invalid payload
+ * @retval -ERR_FIFO_FULL       the queue is full (see outqueue_limits())
+ * @retval -ERR_CONNECTION_LOST the queue was flushed and the connection is
+ *                              lost, or the queue was full and shut the
+ *                              connection down
+ */
+int outqueue_push_bulk(struct outqueue * queue, int type,
+                       struct xbuf * payload, int flags)
+{
+        struct outqueue_transfer * transfer;
+        int                        status;
+
+        if (! payload)
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        if (payload->size == 0)
+        {
+                /* Rien à fragmenter : un paquet vide suffit. */
+                return outqueue_push(queue, type, NULL, 0, flags);
+        }
+        status = queue_admit(queue, payload->size);
+        if (status != SUCCESS)
+        {
+                return status;
+        }
+
+        if (queue->nb_transfers == queue->max_transfers)
+        {
+                queue->max_transfers = queue->max_transfers ? queue->max_transfers * 2 : 8;
+                queue->transfers = realloc(queue->transfers, queue->max_transfers
+                                           * sizeof(struct outqueue_transfer));
+                if (! queue->transfers)
+                {
+                        perror("realloc() ");
+                        exit(-1);
+                }
+        }
+        if ((queue->nb_frames == 0) && (queue->nb_transfers == 0))
+        {
+                queue->oldest = now_ms();
+        }
+        transfer = &queue->transfers[queue->nb_transfers++];
+        transfer->type = type;
+        transfer->offset = 0;
+        transfer->flags = flags;
+        transfer->payload = xbuf_ref(payload);
+        queue->bulk += payload->size;
+        queue_watermark(queue);
+
+        if ((flags & OUTQUEUE_FLUSH) || (queue_remaining(queue) >= queue->flush_size))
+        {
+                return outqueue_flush(queue);
+        }
+
+        return queue_remaining(queue);
+}
+
+
+/**
+ *  \brief Function queuing a shared packet on many queues.
+ *
+ *         This function is the fan-out of a packet encoded once: each
+ *         queue takes a reference on the same packet buffer. The packet is
+ *         queued even on the queues whose flush fails.
+ *
+ * @param queues        the queues
+ * @param nb_queues     number of queues
+ * @param packet        complete packet (see packet_create_shared())
+ * @param flags         packet flags (OUTQUEUE_FLUSH)
+ * @return              the number of queues on which the packet could not
+ *                      be queued (full queue) or whose connection is lost,
+ *                      or a negative value in case of error
+ * @retval -ERR_BAD_PARAMETER   invalid packet
+ */
+int outqueue_broadcast(struct outqueue ** queues, int nb_queues,
+                       struct xbuf * packet, int flags)
+{
+        int nb_lost = 0;
+        int i;
+
+        for (i = 0 ; i < nb_queues ; i++)
+        {
+                int status = outqueue_push_shared(queues[i], packet, flags);
+
+                if (status == -ERR_BAD_PARAMETER)
+                {
+                        return status;
+                }
+                if (status < 0)
+                {
+                        nb_lost++;
+                }
+        }
+
+        return nb_lost;
+}
+
+
+/**
+ *  \brief Queue flush function.
+ *
+ *         This function sends all the pending packets in a single system
+ *         call (more if the socket accepts them partially), then the bulk
+ *         payloads, one fragment at a time. With a non-blocking socket, the
+ *         packets that cannot be sent are kept for the next flush.
+ *
+ * @param queue         the queue
+ * @return              the number of bytes still pending or a negative
+ *                      value in case of error
+ * @retval -ERR_CONNECTION_LOST the connection is lost
+ */
+int outqueue_flush(struct outqueue * queue)
+{
+        if (queue->closed)
+        {
+                return -ERR_CONNECTION_LOST;
+        }
+
+        for (;;)
+        {
+                struct iovec iov[OUTQUEUE_MAX_IOV];
+                int          nb_iov = 0;
+                int          requested = 0;
+                int          i;
+                ssize_t      nb_write;
+
+                if ((queue->nb_frames == 0) && (queue->nb_transfers > 0))
+                {
+                        queue_chunk(queue);
+                }
+                if (queue->pending == 0)
+                {
+                        break;
+                }
+
+                /*
+                 *      Les paquets copiés dans le tampon sont contigus,
+                 *      sauf ceux qui en ont doublé d'autres : seuls ces
+                 *      derniers et les paquets partagés ajoutent des morceaux.
+                 */
+                for (i = 0 ; (i < queue->nb_frames) && (nb_iov < OUTQUEUE_MAX_IOV) ; i++)
+                {
+                        struct outqueue_frame * frame = &queue->frames[i];
+                        unsigned char         * base = frame->shared
+                                                       ? frame->shared->data
+                                                       : &queue->buffer[frame->offset];
+                        size_t                  len = frame->size;
+
+                        if (i == 0)
+                        {
+                                base += queue->sent;
+                                len -= queue->sent;
+                        }
+                        requested += len;
+                        if ((nb_iov > 0) && ! frame->shared && ! frame[-1].shared &&
+                            (frame[-1].offset + frame[-1].size == frame->offset))
+                        {
+                                iov[nb_iov - 1].iov_len += len;
+                                continue;
+                        }
+                        iov[nb_iov].iov_base = base;
+                        iov[nb_iov].iov_len = len;
+                        nb_iov++;
+                }
+
+                nb_write = shmem_writev(queue->socket_fd, iov, nb_iov);
+                metrics_write(queue->socket_fd, nb_write, requested);
+                if (nb_write < 0)
+                {
+                        if (errno == EINTR)
+                        {
+                                continue;
+                        }
+                        if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+                        {
+                                break;
+                        }
+                }
+                if (nb_write <= 0)
+                {
+                        metrics_error(queue->socket_fd, ERR_CONNECTION_LOST);
+                        return -ERR_CONNECTION_LOST;
+                }
+                queue_consume(queue, nb_write);
+        }
+        metrics_queue(queue->socket_fd, queue->pending);
+        queue_watermark(queue);
+
+        return queue_remaining(queue);
+}
+
+
+/**
+ *  \brief Queue thresholds checking function.
+ *
+ *         This function flushes the queue if the pending size or the age
+ *         of the oldest pending packet has reached its threshold. It should
+ *         be called regularly, for instance after each event loop wait.
+ *
+ * @param queue         the queue
+ * @return              the number of bytes still pending or a negative
+ *                      value in case of error
+ * @retval -ERR_CONNECTION_LOST the queue was flushed and the connection is
+ *                              lost
+ */
+int outqueue_check(struct outqueue * queue)
+{
+        int remaining = queue_remaining(queue);
+
+        if (queue->closed)
+        {
+                return -ERR_CONNECTION_LOST;
+        }
+        if ((remaining > 0) &&
+            ((remaining >= queue->flush_size) ||
+             (now_ms() - queue->oldest >= queue->flush_delay)))
+        {
+                return outqueue_flush(queue);
+        }
+
+        return remaining;
+}
+
+
+/**
+ *  \brief Queue pending size information function.
+ *
+ * @param queue         the queue
+ * @return              the number of bytes waiting to be sent, bulk
+ *                      payloads included (at most INT_MAX)
+ */
+int outqueue_pending(const struct outqueue * queue)
+{
+        return queue_remaining(queue);
+}
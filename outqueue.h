@@ -0,0 +1,198 @@
+/**
+ *  \file    outqueue.h
+ *  \brief   Outgoing packets queue.
+ *
+ *           Project: project independant file.
+ *
+ *           This is the header file of outqueue.c and contains all the
+ *           constants, structures and functions declarations needed to
+ *           coalesce the outgoing packets of a connection.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#ifndef OUTQUEUE_H
+#define OUTQUEUE_H
+
+#include "xmem.h"
+#include "compress.h"
+
+/**
+ *  \defgroup outqueue Outgoing packets queue constants and structures
+ *
+ *  \details
+ *  The packets of a queue are sent by priority lanes:
+ *  - OUTQUEUE_LANE_CONTROL: ACK, NACK and error messages (TAGs from
+ *    PACKET_MSG_ACK) and the packets queued with OUTQUEUE_CONTROL;
+ *  - OUTQUEUE_LANE_REALTIME: the other packets;
+ *  - OUTQUEUE_LANE_BULK: the payloads queued by outqueue_push_large() and
+ *    outqueue_push_bulk(), sent as fragments of at most chunk_size bytes.
+ *
+ *  A packet overtakes the pending packets of the lower lanes, except the
+ *  packet being sent. The next bulk fragment is only built when nothing
+ *  else is pending: a control packet thus waits for one fragment at most,
+ *  whatever the size of the bulk payloads. The order of the packets of a
+ *  lane is kept. The data already in the socket buffers are sent first:
+ *  socket_unsent_limit() bounds them on the sending side.
+ *
+ *  A queue can be bounded in bytes and in packets (outqueue_limits()), so
+ *  that a peer that stops reading does not make it grow without limit.
+ *  When a packet does not fit, the policy of the queue applies: the packet
+ *  is refused (-ERR_FIFO_FULL), the oldest OUTQUEUE_DROPPABLE packets are
+ *  dropped to make room, or the connection is shut down. Watermarks
+ *  (outqueue_watermarks()) tell the producers when to slow down and when
+ *  to resume, before the limits are reached.
+ *  @{
+ */
+
+/*! Packet flag: flush the queue as soon as the packet is queued. */
+#define OUTQUEUE_FLUSH          0x01
+
+/*! Packet flag: send the packet in the control lane. */
+#define OUTQUEUE_CONTROL        0x02
+
+/*! Packet flag: the packet can be dropped when the queue is full (a
+ *  real-time update superseded by the next one, for instance).
+ */
+#define OUTQUEUE_DROPPABLE      0x04
+
+/*! Full queue policy: refuse the new packet. */
+#define OUTQUEUE_REFUSE         0
+
+/*! Full queue policy: drop the oldest droppable packets, then refuse the
+ *  new packet if it still does not fit.
+ */
+#define OUTQUEUE_DROP_OLDEST    1
+
+/*! Full queue policy: shut the connection down. */
+#define OUTQUEUE_DISCONNECT     2
+
+/*! Lane of the control packets. */
+#define OUTQUEUE_LANE_CONTROL   0
+
+/*! Lane of the real-time packets. */
+#define OUTQUEUE_LANE_REALTIME  1
+
+/*! Lane of the bulk payloads. */
+#define OUTQUEUE_LANE_BULK      2
+
+/*! Default initial size of the queue buffer. */
+#define OUTQUEUE_SIZE           16384
+
+/*! Default number of pending bytes that triggers a flush. */
+#define OUTQUEUE_FLUSH_SIZE     8192
+
+/*! Default age in milliseconds of the oldest pending packet that triggers
+ *  a flush (checked by outqueue_check()).
+ */
+#define OUTQUEUE_FLUSH_DELAY    5
+
+/*! Maximum number of buffer parts sent by a single system call. */
+#define OUTQUEUE_MAX_IOV        64
+
+/*! Default maximum size of the payload part of the bulk fragments. */
+#define OUTQUEUE_CHUNK_SIZE     16384
+
+/*! Queued packet. A shared packet is not copied in the queue buffer: the
+ *  queue holds a reference on its packet buffer.
+ */
+struct outqueue_frame {
+        int             offset;  /*!< Offset of the packet in the queue
+                                      buffer (where it would be, if shared). */
+        int             size;    /*!< Full size of the packet.               */
+        int             flags;   /*!< Packet flags.                          */
+        int             lane;    /*!< Priority lane.                         */
+        struct xbuf   * shared;  /*!< Shared packet buffer (or NULL).        */
+};
+
+/*! Bulk payload waiting to be fragmented. */
+struct outqueue_transfer {
+        int             type;     /*!< TAG of the payload.                   */
+        size_t          offset;   /*!< Size already fragmented.              */
+        int             flags;    /*!< Packet flags of the payload.          */
+        struct xbuf   * payload;  /*!< Payload (its size is payload->size).  */
+};
+
+struct outqueue;
+
+/*! Watermark function of a queue, called when the bytes waiting to be
+ *  sent reach the high watermark (\c above set) and when they are back to
+ *  the low watermark (\c above cleared).
+ */
+typedef void (*outqueue_watermark)(struct outqueue * queue, int above,
+                                   void * data);
+
+/*! Outgoing packets queue of a connection: the packets are built in place
+ *  in the queue buffer and sent together by a single system call. It must
+ *  be initialised with outqueue_init().
+ */
+struct outqueue {
+        int                     socket_fd;   /*!< Connection socket.               */
+        int                     flush_size;  /*!< Pending bytes flush threshold.   */
+        int                     flush_delay; /*!< Pending age flush threshold.     */
+        long long               oldest;      /*!< Queuing date of the oldest
+                                                  pending packet (ms).             */
+        unsigned char         * buffer;      /*!< Packets storage.                 */
+        int                     capacity;    /*!< Allocated size of the buffer.    */
+        int                     used;        /*!< Used size of the buffer.         */
+        struct outqueue_frame * frames;      /*!< Pending packets.                 */
+        int                     nb_frames;   /*!< Number of pending packets.       */
+        int                     max_frames;  /*!< Allocated size of frames.        */
+        int                     sent;        /*!< Sent bytes of the first packet.  */
+        int                     pending;     /*!< Bytes waiting to be sent.        */
+        int                     reserved;    /*!< Data size of the packet being
+                                                  built (outqueue_frame_begin()).  */
+        int                     chunk_size;  /*!< Bulk fragments payload size.     */
+        struct outqueue_transfer * transfers; /*!< Pending bulk payloads.          */
+        int                     nb_transfers; /*!< Number of bulk payloads.        */
+        int                     max_transfers; /*!< Allocated size of transfers.   */
+        size_t                  bulk;        /*!< Bulk bytes not fragmented yet.   */
+        int                     max_bytes;   /*!< Bytes limit (0: none).           */
+        int                     max_count;   /*!< Packets limit (0: none).         */
+        int                     policy;      /*!< Full queue policy.               */
+        int                     closed;      /*!< Shut down by the policy.         */
+        unsigned long           dropped;     /*!< Number of dropped packets.       */
+        int                     low_mark;    /*!< Low watermark (bytes).           */
+        int                     high_mark;   /*!< High watermark (bytes).          */
+        int                     above;       /*!< High watermark reached.          */
+        outqueue_watermark      watermark;   /*!< Watermark function (or NULL).    */
+        void                  * watermark_data; /*!< Watermark function data.      */
+        struct compressor     * compressor;  /*!< Packets compression (or NULL).   */
+};
+
+/** @} */
+
+
+/** @cond DUPLICATE_DOCUMENTATION */
+void outqueue_init(struct outqueue * queue, int socket_fd, int capacity);
+void outqueue_free(struct outqueue * queue);
+void outqueue_thresholds(struct outqueue * queue, int flush_size, int flush_delay);
+int outqueue_chunk_size(struct outqueue * queue, int chunk_size);
+void outqueue_limits(struct outqueue * queue, int max_bytes, int max_count,
+                     int policy);
+void outqueue_watermarks(struct outqueue * queue, int low_mark, int high_mark,
+                         outqueue_watermark watermark, void * data);
+void outqueue_compress(struct outqueue * queue, struct compressor * compressor);
+unsigned char * outqueue_frame_begin(struct outqueue * queue, int size);
+int outqueue_frame_end(struct outqueue * queue, int type, int size, int flags);
+int outqueue_push(struct outqueue * queue, int type,
+                  const unsigned char * data, int size, int flags);
+int outqueue_message(struct outqueue * queue, int type, int message, int flags);
+int outqueue_push_shared(struct outqueue * queue, struct xbuf * packet, int flags);
+int outqueue_push_large(struct outqueue * queue, int type,
+                        const unsigned char * data, size_t size, int flags);
+int outqueue_push_bulk(struct outqueue * queue, int type,
+                       struct xbuf * payload, int flags);
+int outqueue_broadcast(struct outqueue ** queues, int nb_queues,
+                       struct xbuf * packet, int flags);
+int outqueue_flush(struct outqueue * queue);
+int outqueue_check(struct outqueue * queue);
+int outqueue_pending(const struct outqueue * queue);
+/** @endcond */
+
+
+#endif /* OUTQUEUE_H */
@@ -22,6 +22,8 @@
 #include <unistd.h>
 #include <stdint.h>
 #include <string.h>
+#include <errno.h>
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #ifdef __CYGWIN32__
@@ -30,6 +32,11 @@
 
 #include "packets.h"
 #include "errors.h"
+#include "metrics.h"
+#include "compress.h"
+#include "tags.h"
+#include "shmem.h"
+#include "xmem.h"
 
 
 /**
@@ -52,8 +59,9 @@ static int read_bytes(int socket_fd, unsigned char * data, int size)
                 /*
                 int nb_read = read(socket_fd, &data[total], size - total);
                 */
-                int nb_read = recv(socket_fd, &data[total], size - total,
-                                MSG_WAITALL);
+                int nb_read = shmem_recv(socket_fd, &data[total],
+                                         size - total, MSG_WAITALL);
+                metrics_read(socket_fd, nb_read);
                 if (nb_read <= 0)
                 {
                         total = -1; /* Fin de fichier : socket fermée */
@@ -66,6 +74,38 @@ static int read_bytes(int socket_fd, unsigned char * data, int size)
 }
 
 
+/**
+ *  \brief Function expanding a compressed packet in its buffer.
+ *
+ *         As for a packet larger than the buffer, the end of an original
+ *         packet larger than the buffer is lost.
+ *
+ * @param compressor    the compression state of the connection (NULL for
+ *                      no counters)
+ * @param packet        the compressed packet, replaced by the original one
+ * @param size          the size of the compressed packet
+ * @param capacity      size of the buffer of the packet
+ * @return              the size of the original packet or 0 for a corrupted
+ *                      packet
+ */
+static int packet_expand(struct compressor * compressor, unsigned char * packet,
+                         int size, int capacity)
+{
+        struct xbuf * original = xbuf_alloc(MAX_PACKET_SIZE);
+
+        size = compress_expand(compressor, packet, size, original->data,
+                               MAX_PACKET_SIZE);
+        if (size > 0)
+        {
+                size = (size > capacity) ? capacity : size;
+                memcpy(packet, original->data, size);
+        }
+        xbuf_unref(original);
+
+        return (size > 0) ? size : 0;
+}
+
+
 /**
  *  \brief Function reading a full packet on a socket.
  *
@@ -73,7 +113,8 @@ static int read_bytes(int socket_fd, unsigned char * data, int size)
  *         real number of bytes received. It returns 0 in case of closed
  *         connection or read error. Data are stored in a sufficiently-sized
  *         pre-allocated buffer.
- *         The returned packet is a full packet (L + TAG + DATA)
+ *         The returned packet is a full packet (L + TAG + DATA), a
+ *         compressed packet being returned expanded.
  *
  * @param socket_fd     the socket's file descriptor
  * @param data          the array where to store the received data
@@ -108,25 +149,47 @@ int packet_read(int socket_fd, unsigned char * data, int size)
          *      Lecture des données du paquet.
          */
         received = read_bytes(socket_fd, &data[PACKET_LEN_SIZE], read_size);
-        if (packet_size > size)
+        if ((received > 0) && (packet_size > read_size))
         {
                 /*
                  *      Prendre en compte le cas où les données reçues sont
                  *      plus grandes que la taille du buffer passé en
-                 *      paramètre : elles sont lues et non prises en compte
-                 *      afin de ne pas gêner les communications protocolaires :
-                 *      ne devrait jamais arriver car la taille des buffer est
-                 *      maximisée.
+                 *      paramètre : elles sont lues par blocs et non prises
+                 *      en compte afin de ne pas gêner les communications
+                 *      protocolaires. Les charges plus grandes qu'un paquet
+                 *      doivent être fragmentées (voir fragments.h).
                  */
-                int           i;
-                unsigned char trash;
-                for (i = size ; i < packet_size ; i++)
+                unsigned char trash[PACKET_READ_CHUNK];
+                int           remaining = packet_size - read_size;
+
+                while (remaining > 0)
                 {
-                        read(socket_fd, &trash, 1);
+                        int chunk = (remaining > PACKET_READ_CHUNK)
+                                    ? PACKET_READ_CHUNK
+                                    : remaining;
+                        if (read_bytes(socket_fd, trash, chunk) < chunk)
+                        {
+                                return 0;
+                        }
+                        remaining -= chunk;
                 }
         }
+        if (received <= 0)
+        {
+                return 0;
+        }
+        metrics_frame_in(socket_fd, data[PACKET_LEN_SIZE],
+                         packet_size + PACKET_LEN_SIZE);
+        if (data[PACKET_LEN_SIZE] == PACKET_COMPRESSED)
+        {
+                /*
+                 *      Un paquet compressé tronqué ne peut pas être
+                 *      décompressé, c'est une erreur de lecture.
+                 */
+                return packet_expand(NULL, data, received + PACKET_LEN_SIZE, size);
+        }
 
-        return (received > 0) ? received + PACKET_LEN_SIZE: 0;
+        return received + PACKET_LEN_SIZE;
 }
 
 
@@ -168,6 +231,37 @@ void packet_create(int type, unsigned char * data, int size, unsigned char * pac
 }
 
 
+/**
+ *  \brief Function creating a shared packet.
+ *
+ *         This function creates a packet like packet_create() in a packet
+ *         buffer, so that it can be encoded once and queued on many
+ *         connections (see outqueue_broadcast() and event_send()). The
+ *         size of the buffer is the full size of the packet.
+ *
+ * @param type          packet type (TAG)
+ * @param data          data to include in the packet
+ * @param size          size of the data to include
+ * @return              the packet buffer (with one reference) or NULL if
+ *                      the size is invalid
+ */
+struct xbuf * packet_create_shared(int type, const unsigned char * data, int size)
+{
+        struct xbuf * packet;
+
+        if ((size < 0) || (size > MAX_DATA_SIZE))
+        {
+                return NULL;
+        }
+
+        packet = xbuf_alloc(PACKET_HEADER_SIZE + size);
+        packet_create(type, (unsigned char *) data, size, packet->data);
+        packet->size = PACKET_HEADER_SIZE + size;
+
+        return packet;
+}
+
+
 /**
  *  \brief Packet emitting function.
  *
@@ -193,19 +287,137 @@ int packet_send(int socket_fd, unsigned char * data)
                                      &data[written],
                                      packet_size - written);
                 */
-                int nb_write = send(socket_fd,
-                                    &data[written],
-                                    packet_size - written, 0);
+                int nb_write = shmem_send(socket_fd,
+                                          &data[written],
+                                          packet_size - written, 0);
+                metrics_write(socket_fd, nb_write, packet_size - written);
                 if (nb_write <= 0)
                 {
                         connected = 0;
-                        //perror("Packet sending error");
+                        metrics_error(socket_fd, ERR_CONNECTION_LOST);
                 }
                 else
                 {
                         written += nb_write;
                 }
         }
+        if (written == packet_size)
+        {
+                metrics_frame_out(socket_fd, data[PACKET_LEN_SIZE], packet_size);
+        }
+
+        return written;
+}
+
+
+/**
+ *  \brief Scatter-gather packet emitting function.
+ *
+ *         This function emits a packet whose data are given in several
+ *         parts. The header is built on the stack and sent with the data
+ *         in a single sendmsg() call: the data are neither copied nor
+ *         gathered in an intermediate buffer. Short writes are completed
+ *         until the whole packet is sent or the connection is lost: on a
+ *         non-blocking socket, the function waits for the socket to be
+ *         writable rather than leave a partial packet in the stream.
+ *
+ * @param socket_fd     the socket's file descriptor
+ * @param type          packet type (TAG)
+ * @param iov           parts of the data of the packet
+ * @param iovcnt        number of parts (at most PACKET_MAX_IOV)
+ * @return              the emitted size (header included) or 0 in case of
+ *                      error (the packet may then be partially sent: the
+ *                      connection is no longer usable)
+ */
+int packet_sendv(int socket_fd, int type, const struct iovec * iov, int iovcnt)
+{
+        unsigned char header[PACKET_HEADER_SIZE];
+        struct iovec  parts[PACKET_MAX_IOV + 1];
+        struct msghdr message;
+        size_t        size = 0;
+        int           packet_size;
+        int           written = 0;
+        int           i;
+
+        if ((iovcnt < 0) || (iovcnt > PACKET_MAX_IOV))
+        {
+                return 0;
+        }
+        for (i = 0 ; i < iovcnt ; i++)
+        {
+                parts[i + 1] = iov[i];
+                size += iov[i].iov_len;
+        }
+        if (size > MAX_DATA_SIZE)
+        {
+                return 0;
+        }
+
+        header[0] = ((size + PACKET_TAG_SIZE) & 0xFF);
+        header[1] = (((size + PACKET_TAG_SIZE) >> 8) & 0xFF);
+        header[PACKET_LEN_SIZE] = (type & 0xFF);
+        parts[0].iov_base = header;
+        parts[0].iov_len = PACKET_HEADER_SIZE;
+        packet_size = size + PACKET_HEADER_SIZE;
+
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = parts;
+        message.msg_iovlen = iovcnt + 1;
+
+        while (written < packet_size)
+        {
+                ssize_t nb_write = shmem_sendmsg(socket_fd, &message, 0);
+
+                metrics_write(socket_fd, nb_write, packet_size - written);
+                if ((nb_write < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+                {
+                        struct pollfd writable;
+
+                        /*
+                         *      Un paquet entamé doit être terminé : on attend
+                         *      de pouvoir écrire la suite.
+                         */
+                        writable.fd = socket_fd;
+                        writable.events = POLLOUT;
+                        writable.revents = 0;
+                        if ((poll(&writable, 1, -1) >= 0) || (errno == EINTR))
+                        {
+                                continue;
+                        }
+                }
+                if (nb_write <= 0)
+                {
+                        if ((nb_write < 0) && (errno == EINTR))
+                        {
+                                continue;
+                        }
+                        metrics_error(socket_fd, ERR_CONNECTION_LOST);
+                        break;
+                }
+                written += nb_write;
+
+                /*
+                 *      Écriture partielle : on saute les parties envoyées.
+                 */
+                while ((message.msg_iovlen > 0) &&
+                       ((size_t) nb_write >= message.msg_iov->iov_len))
+                {
+                        nb_write -= message.msg_iov->iov_len;
+                        message.msg_iov++;
+                        message.msg_iovlen--;
+                }
+                if (message.msg_iovlen > 0)
+                {
+                        message.msg_iov->iov_base =
+                                (unsigned char *) message.msg_iov->iov_base + nb_write;
+                        message.msg_iov->iov_len -= nb_write;
+                }
+        }
+        if (written < packet_size)
+        {
+                return 0;
+        }
+        metrics_frame_out(socket_fd, type, packet_size);
 
         return written;
 }
@@ -315,3 +527,530 @@ char * packet_error_message(const unsigned char * packet)
         return get_error_name(- error);
 }
 
+
+
+/**
+ *  \brief Packet decoder initialisation function.
+ *
+ *         The decoder buffer is allocated on demand and grows up to the
+ *         size of the largest packet received.
+ *
+ * @param decoder       the decoder to initialise
+ */
+void packet_decoder_init(struct packet_decoder * decoder)
+{
+        memset(decoder, 0, sizeof(struct packet_decoder));
+        decoder->fd = -1;
+}
+
+
+/**
+ *  \brief Packet decoder release function.
+ *
+ *         This function frees the decoder buffer and drops any partial
+ *         packet.
+ *
+ * @param decoder       the decoder to release
+ */
+void packet_decoder_free(struct packet_decoder * decoder)
+{
+        free(decoder->buffer);
+        packet_decoder_init(decoder);
+}
+
+
+/**
+ *  \brief Function storing bytes of the current packet in the decoder.
+ *
+ * @param decoder       the decoder
+ * @param bytes         received bytes
+ * @param size          number of bytes to store
+ */
+static void decoder_store(struct packet_decoder * decoder,
+                          const unsigned char * bytes, int size)
+{
+        int needed = decoder->received + size;
+
+        if (needed > decoder->capacity)
+        {
+                int capacity = decoder->capacity ? decoder->capacity : 256;
+
+                while (capacity < needed)
+                {
+                        capacity *= 2;
+                }
+                if (capacity > MAX_PACKET_SIZE)
+                {
+                        capacity = MAX_PACKET_SIZE;
+                }
+                decoder->buffer = realloc(decoder->buffer, capacity);
+                if (! decoder->buffer)
+                {
+                        perror("realloc() ");
+                        exit(-1);
+                }
+                decoder->capacity = capacity;
+        }
+        memcpy(&decoder->buffer[decoder->received], bytes, size);
+        decoder->received += size;
+}
+
+
+/**
+ *  \brief Function giving a complete packet to a handler.
+ *
+ *         A compressed packet is given expanded.
+ *
+ * @param socket_fd     the connection of the packet (metrics)
+ * @param compressor    the compression state of the connection (NULL for
+ *                      no counters)
+ * @param packet        the packet (LEN + TAG + DATA)
+ * @param size          the size of the packet
+ * @param handler       function called for the packet
+ * @param data          user data given to the handler
+ * @return              the status of the operation
+ * @retval SUCCESS              packet handled
+ * @retval -ERR_BAD_PROTOCOL    corrupted compressed packet
+ */
+static int packet_deliver(int socket_fd, struct compressor * compressor,
+                          const unsigned char * packet, int size,
+                          packet_handler handler, void * data)
+{
+        struct xbuf * original;
+        int           status;
+
+        metrics_frame_in(socket_fd, packet[PACKET_LEN_SIZE], size);
+        if (packet[PACKET_LEN_SIZE] != PACKET_COMPRESSED)
+        {
+                handler(packet, size, data);
+                return SUCCESS;
+        }
+
+        original = xbuf_alloc(MAX_PACKET_SIZE);
+        status = compress_expand(compressor, packet, size,
+                                 original->data, MAX_PACKET_SIZE);
+        if (status > 0)
+        {
+                handler(original->data, status, data);
+        }
+        xbuf_unref(original);
+
+        return (status > 0) ? SUCCESS : -ERR_BAD_PROTOCOL;
+}
+
+
+/**
+ *  \brief Function giving bytes to a packet decoder.
+ *
+ *         This function accepts any number of bytes of a stream, as returned
+ *         by recv(), and calls the handler for each complete packet found.
+ *         Incomplete headers and data are kept in the decoder until the
+ *         next call. The packets given to the handler have the same format
+ *         as the ones built by packet_create() and returned by packet_read().
+ *         Complete packets are given without copy when no partial packet is
+ *         pending. Compressed packets (PACKET_COMPRESSED) are given expanded,
+ *         counted by the compressor of the decoder if it has one.
+ *
+ * @param decoder       the decoder of the stream
+ * @param bytes         received bytes
+ * @param size          number of received bytes
+ * @param handler       function called for each complete packet
+ * @param data          user data given to the handler
+ * @return              the number of complete packets or a negative value
+ *                      in case of error
+ * @retval -ERR_BAD_PROTOCOL    a packet has a null size (no TAG) or a
+ *                              compressed packet is corrupted
+ */
+int packet_decoder_feed(struct packet_decoder * decoder,
+                        const unsigned char * bytes, int size,
+                        packet_handler handler, void * data)
+{
+        int done = 0;
+        int nb_packets = 0;
+
+        while (done < size)
+        {
+                int remaining = size - done;
+                int wanted;
+
+                /*
+                 *      Pas de paquet partiel : les paquets complets sont
+                 *      transmis directement depuis les données reçues.
+                 */
+                if ((decoder->received == 0) && (remaining >= PACKET_LEN_SIZE))
+                {
+                        int packet_size = packet_data_len(&bytes[done]);
+
+                        if (packet_size == 0)
+                        {
+                                return -ERR_BAD_PROTOCOL;
+                        }
+                        if (remaining >= packet_size + PACKET_LEN_SIZE)
+                        {
+                                check(packet_deliver(decoder->fd, decoder->compressor,
+                                                     &bytes[done],
+                                                     packet_size + PACKET_LEN_SIZE,
+                                                     handler, data));
+                                done += packet_size + PACKET_LEN_SIZE;
+                                nb_packets++;
+                                continue;
+                        }
+                }
+
+                /*
+                 *      Récupération de la taille, puis des données.
+                 */
+                if (decoder->received < PACKET_LEN_SIZE)
+                {
+                        wanted = PACKET_LEN_SIZE - decoder->received;
+                }
+                else
+                {
+                        wanted = decoder->expected - decoder->received;
+                }
+                if (wanted > remaining)
+                {
+                        wanted = remaining;
+                }
+                decoder_store(decoder, &bytes[done], wanted);
+                done += wanted;
+
+                if (decoder->received == PACKET_LEN_SIZE)
+                {
+                        int packet_size = packet_data_len(decoder->buffer);
+
+                        if (packet_size == 0)
+                        {
+                                decoder->received = 0;
+                                return -ERR_BAD_PROTOCOL;
+                        }
+                        decoder->expected = packet_size + PACKET_LEN_SIZE;
+                }
+                if ((decoder->received > PACKET_LEN_SIZE) &&
+                    (decoder->received == decoder->expected))
+                {
+                        int status = packet_deliver(decoder->fd, decoder->compressor,
+                                                    decoder->buffer,
+                                                    decoder->received,
+                                                    handler, data);
+
+                        decoder->received = 0;
+                        decoder->expected = 0;
+                        if (status != SUCCESS)
+                        {
+                                return status;
+                        }
+                        nb_packets++;
+                }
+        }
+
+        return nb_packets;
+}
+
+
+/**
+ *  \brief Function reading all available packets on a socket.
+ *
+ *         This function is the packet read path for non-blocking sockets
+ *         registered in an event loop: it reads everything available on
+ *         the socket, until it would block, and gives the bytes to the
+ *         decoder of the connection.
+ *
+ * @param socket_fd     the socket's file descriptor (non-blocking)
+ * @param decoder       the decoder of the connection
+ * @param handler       function called for each complete packet
+ * @param data          user data given to the handler
+ * @return              the number of complete packets or a negative value
+ *                      in case of error (after the complete packets have
+ *                      been handled)
+ * @retval -ERR_CONNECTION_LOST the connection has been closed by the peer
+ * @retval -ERR_CONNECTION      read error
+ * @retval -ERR_BAD_PROTOCOL    the stream is not made of packets
+ */
+int packet_decoder_read(int socket_fd, struct packet_decoder * decoder,
+                        packet_handler handler, void * data)
+{
+        unsigned char chunk[PACKET_READ_CHUNK];
+        int           nb_packets = 0;
+
+        for (;;)
+        {
+                int nb_read = shmem_recv(socket_fd, chunk, sizeof(chunk), 0);
+                int status;
+
+                metrics_read(socket_fd, nb_read);
+                if (nb_read == 0)
+                {
+                        return -ERR_CONNECTION_LOST;
+                }
+                if (nb_read < 0)
+                {
+                        if (errno == EINTR)
+                        {
+                                continue;
+                        }
+                        if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+                        {
+                                break;
+                        }
+                        return -ERR_CONNECTION;
+                }
+
+                decoder->fd = socket_fd;
+                status = packet_decoder_feed(decoder, chunk, nb_read,
+                                             handler, data);
+                if (status < 0)
+                {
+                        return status;
+                }
+                nb_packets += status;
+        }
+
+        return nb_packets;
+}
+
+
+/**
+ *  \brief Packet ring initialisation function.
+ *
+ *         The buffer is allocated on the first read. It grows if a packet
+ *         does not fit in it.
+ *
+ * @param ring          the ring to initialise
+ * @param capacity      size of the receive buffer (0 for PACKET_RING_SIZE)
+ */
+void packet_ring_init(struct packet_ring * ring, int capacity)
+{
+        memset(ring, 0, sizeof(struct packet_ring));
+        ring->capacity = (capacity > 0) ? capacity : PACKET_RING_SIZE;
+}
+
+
+/**
+ *  \brief Packet ring release function.
+ *
+ *         This function frees the receive buffer and drops the unread
+ *         bytes.
+ *
+ * @param ring          the ring to release
+ */
+void packet_ring_free(struct packet_ring * ring)
+{
+        int capacity = ring->capacity;
+
+        free(ring->buffer);
+        xbuf_unref(ring->expanded);
+        packet_ring_init(ring, capacity);
+}
+
+
+/**
+ *  \brief Function returning the size of the first complete packet of a
+ *         ring.
+ *
+ * @param ring          the ring to examine
+ * @return              the full size of the first packet, 0 if it is not
+ *                      complete or -ERR_BAD_PROTOCOL for a null size
+ */
+static int ring_packet(const struct packet_ring * ring)
+{
+        int available = ring->end - ring->start;
+        int packet_size;
+
+        if (available < PACKET_LEN_SIZE)
+        {
+                return 0;
+        }
+        packet_size = packet_data_len(&ring->buffer[ring->start]);
+        if (packet_size == 0)
+        {
+                return -ERR_BAD_PROTOCOL;
+        }
+        packet_size += PACKET_LEN_SIZE;
+
+        return (available >= packet_size) ? packet_size : 0;
+}
+
+
+/**
+ *  \brief Function receiving as many bytes as possible in a ring.
+ *
+ *         The unread bytes are first moved to the beginning of the buffer,
+ *         and the buffer is enlarged if the pending packet cannot fit.
+ *
+ * @param socket_fd     the socket's file descriptor
+ * @param ring          the ring of the socket
+ * @return              the number of received bytes, 0 if the connection
+ *                      is closed or -1 in case of error (errno is set)
+ */
+static int ring_fill(int socket_fd, struct packet_ring * ring)
+{
+        int available = ring->end - ring->start;
+        int needed = ring->capacity;
+        int nb_read;
+
+        if (available >= PACKET_LEN_SIZE)
+        {
+                int packet_size = packet_data_len(&ring->buffer[ring->start])
+                                  + PACKET_LEN_SIZE;
+                if (packet_size > needed)
+                {
+                        needed = packet_size;
+                }
+        }
+        if (! ring->buffer || (needed > ring->capacity))
+        {
+                unsigned char * buffer = xmalloc(needed);
+
+                if (available > 0)
+                {
+                        memcpy(buffer, &ring->buffer[ring->start], available);
+                }
+                free(ring->buffer);
+                ring->buffer = buffer;
+                ring->capacity = needed;
+                ring->start = 0;
+                ring->end = available;
+        }
+        else if (ring->start > 0)
+        {
+                /*
+                 *      Seul le paquet incomplet est déplacé.
+                 */
+                memmove(ring->buffer, &ring->buffer[ring->start], available);
+                ring->start = 0;
+                ring->end = available;
+        }
+
+        nb_read = shmem_recv(socket_fd, &ring->buffer[ring->end],
+                             ring->capacity - ring->end, 0);
+        metrics_read(socket_fd, nb_read);
+        if (nb_read > 0)
+        {
+                ring->end += nb_read;
+        }
+
+        return nb_read;
+}
+
+
+/**
+ *  \brief Function reading a full packet through a ring.
+ *
+ *         This function is the batched equivalent of packet_read(): it
+ *         returns the next complete packet of the ring and only reads the
+ *         socket, in large chunks, when no complete packet is buffered. A
+ *         stream of small packets thus costs far less than one recv() per
+ *         packet. The packet is returned without copy: it stays valid
+ *         until the next call on the same ring. A compressed packet is
+ *         returned expanded, in a buffer of the ring.
+ *
+ * @param socket_fd     the socket's file descriptor
+ * @param ring          the ring of the socket
+ * @param packet        returned pointer to the packet (L + TAG + DATA)
+ * @return              the size of the packet or 0 in case of closed
+ *                      connection or read error
+ */
+int packet_ring_read(int socket_fd, struct packet_ring * ring,
+                     unsigned char ** packet)
+{
+        int packet_size;
+
+        while ((packet_size = ring_packet(ring)) == 0)
+        {
+                int nb_read = ring_fill(socket_fd, ring);
+
+                if ((nb_read == 0) || ((nb_read < 0) && (errno != EINTR)))
+                {
+                        return 0;
+                }
+        }
+        if (packet_size < 0)
+        {
+                return 0;
+        }
+
+        *packet = &ring->buffer[ring->start];
+        ring->start += packet_size;
+        metrics_frame_in(socket_fd, (*packet)[PACKET_LEN_SIZE], packet_size);
+        if ((*packet)[PACKET_LEN_SIZE] == PACKET_COMPRESSED)
+        {
+                if (! ring->expanded)
+                {
+                        ring->expanded = xbuf_alloc(MAX_PACKET_SIZE);
+                }
+                packet_size = compress_expand(ring->compressor, *packet, packet_size,
+                                              ring->expanded->data, MAX_PACKET_SIZE);
+                *packet = ring->expanded->data;
+        }
+
+        return (packet_size > 0) ? packet_size : 0;
+}
+
+
+/**
+ *  \brief Function handling all available packets on a socket through a
+ *         ring.
+ *
+ *         This function is the batched read path for non-blocking sockets
+ *         registered in an event loop: it reads the socket in large chunks
+ *         until it would block and calls the handler for each complete
+ *         packet, directly from the receive buffer (a compressed packet is
+ *         given expanded).
+ *
+ * @param socket_fd     the socket's file descriptor (non-blocking)
+ * @param ring          the ring of the connection
+ * @param handler       function called for each complete packet
+ * @param data          user data given to the handler
+ * @return              the number of complete packets or a negative value
+ *                      in case of error (after the complete packets have
+ *                      been handled)
+ * @retval -ERR_CONNECTION_LOST the connection has been closed by the peer
+ * @retval -ERR_CONNECTION      read error
+ * @retval -ERR_BAD_PROTOCOL    the stream is not made of packets
+ */
+int packet_ring_recv(int socket_fd, struct packet_ring * ring,
+                     packet_handler handler, void * data)
+{
+        int nb_packets = 0;
+
+        for (;;)
+        {
+                int nb_read;
+                int packet_size;
+
+                while ((packet_size = ring_packet(ring)) > 0)
+                {
+                        unsigned char * packet = &ring->buffer[ring->start];
+
+                        ring->start += packet_size;
+                        check(packet_deliver(socket_fd, ring->compressor, packet,
+                                             packet_size, handler, data));
+                        nb_packets++;
+                }
+                if (packet_size < 0)
+                {
+                        return packet_size;
+                }
+
+                nb_read = ring_fill(socket_fd, ring);
+                if (nb_read == 0)
+                {
+                        return -ERR_CONNECTION_LOST;
+                }
+                if (nb_read < 0)
+                {
+                        if (errno == EINTR)
+                        {
+                                continue;
+                        }
+                        if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+                        {
+                                break;
+                        }
+                        return -ERR_CONNECTION;
+                }
+        }
+
+        return nb_packets;
+}
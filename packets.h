@@ -17,6 +17,10 @@
 #ifndef PACKETS_H
 #define PACKETS_H
 
+#include <sys/uio.h>
+
+#include "xmem.h"
+
 /**
  *  \defgroup packets Packets information constants
  *  @{
@@ -38,6 +42,48 @@
 
 /*! Maximum full size of a packet */
 #define MAX_PACKET_SIZE   (PACKET_HEADER_SIZE + MAX_DATA_SIZE)
+
+/*! Maximum number of data parts given to packet_sendv() */
+#define PACKET_MAX_IOV    16
+
+/*! Size of the chunks read by packet_decoder_read() */
+#define PACKET_READ_CHUNK 4096
+
+/*! Function called for each complete packet (LEN + TAG + DATA) found in
+ *  a stream. The packet is only valid during the call.
+ */
+typedef void (*packet_handler)(const unsigned char * packet, int size,
+                               void * data);
+
+/*! Incremental packet decoder: keeps the partial packet of a connection
+ *  between two reads. It must be initialised with packet_decoder_init().
+ */
+struct packet_decoder {
+        int             received;  /*!< Bytes of the current packet received. */
+        int             expected;  /*!< Full size of the current packet.      */
+        int             capacity;  /*!< Allocated size of the buffer.         */
+        unsigned char * buffer;    /*!< Current (partial) packet.             */
+        int             fd;        /*!< Connection of the stream (metrics).   */
+        struct compressor * compressor; /*!< Expansion counters (or NULL).    */
+};
+
+/*! Default size of the receive buffer of a packet ring */
+#define PACKET_RING_SIZE  16384
+
+/*! Receive buffer of a connection: the socket is read in large chunks and
+ *  the complete packets are handed out from the buffer, so that a single
+ *  recv() can provide many packets. It must be initialised with
+ *  packet_ring_init().
+ */
+struct packet_ring {
+        int             start;     /*!< Offset of the first unread byte.      */
+        int             end;       /*!< Offset after the last received byte.  */
+        int             capacity;  /*!< Allocated size of the buffer.         */
+        unsigned char * buffer;    /*!< Received bytes.                       */
+        struct compressor * compressor; /*!< Expansion counters (or NULL).    */
+        struct xbuf   * expanded;  /*!< Last packet expanded by
+                                        packet_ring_read().                   */
+};
 /** @} */
 
 
@@ -45,9 +91,12 @@
 int packet_read(int socket_fd, unsigned char * data, int size);
 
 void packet_create(int type, unsigned char * data, int size, unsigned char * packet);
+struct xbuf * packet_create_shared(int type, const unsigned char * data, int size);
 
 int packet_send(int socket_fd, unsigned char * data);
 
+int packet_sendv(int socket_fd, int type, const struct iovec * iov, int iovcnt);
+
 void message_create(int type, int message, unsigned char * packet);
 
 int message_send(int socket_fd, int type, int message);
@@ -57,6 +106,27 @@ int packet_data_len(const unsigned char * packet);
 int packet_type(const unsigned char * packet);
 
 char * packet_error_message(const unsigned char * packet);
+
+void packet_decoder_init(struct packet_decoder * decoder);
+
+void packet_decoder_free(struct packet_decoder * decoder);
+
+int packet_decoder_feed(struct packet_decoder * decoder,
+                        const unsigned char * bytes, int size,
+                        packet_handler handler, void * data);
+
+int packet_decoder_read(int socket_fd, struct packet_decoder * decoder,
+                        packet_handler handler, void * data);
+
+void packet_ring_init(struct packet_ring * ring, int capacity);
+
+void packet_ring_free(struct packet_ring * ring);
+
+int packet_ring_read(int socket_fd, struct packet_ring * ring,
+                     unsigned char ** packet);
+
+int packet_ring_recv(int socket_fd, struct packet_ring * ring,
+                     packet_handler handler, void * data);
 /** @endcond */
 
 #endif /* PACKETS_H */
@@ -0,0 +1,297 @@
+/**
+ *  \file    params.c
+ *  \brief   Batched parameters.
+ *
+ *           Project: project independant file.
+ *
+ *           This file contains the encoding and decoding of the batched
+ *           CMD_GET_PARAM and CMD_SET_PARAM lists: a console refreshing
+ *           hundreds of parameters sends a handful of packets instead of
+ *           one packet (and one answer) per parameter. The decoded values
+ *           point into the received data, nothing is copied.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "errors.h"
+#include "packets.h"
+#include "requests.h"
+#include "params.h"
+
+
+/**
+ *  \brief Size of the encoded record of a parameter.
+ *
+ * @param kind          kind of list (PARAMS_*)
+ * @param param         the parameter
+ * @return              the size of the record
+ */
+static int param_size(int kind, const struct param * param)
+{
+        switch (kind)
+        {
+                case PARAMS_KEYS:
+                        return 2;
+                case PARAMS_VALUES:
+                        return 4 + param->size;
+                case PARAMS_RESULTS:
+                        return 5 + ((param->status == SUCCESS) ? param->size : 0);
+                default:
+                        return 1;
+        }
+}
+
+
+/**
+ *  \brief Encoding of a status on a byte.
+ */
+static unsigned char param_status(int status)
+{
+        if (status < 0)
+        {
+                status = -status;
+        }
+        return (status > 0xFF) ? 0xFF : status;
+}
+
+
+/**
+ *  \brief Parameters list encoding.
+ *
+ *         This function encodes as many parameters as fit in the buffer:
+ *         the remaining ones should be encoded in another packet.
+ *
+ * @param kind          kind of list (PARAMS_*)
+ * @param params        parameters to encode
+ * @param count         number of parameters
+ * @param buffer        resulting data
+ * @param capacity      size of the buffer (MAX_DATA_SIZE for a packet)
+ * @param size          returned size of the encoded data
+ * @return              the number of encoded parameters or a negative
+ *                      value in case of error
+ * @retval -ERR_BAD_PARAMETER   unknown kind or invalid value size
+ * @retval -ERR_OUT_OF_RANGE    the first parameter does not fit
+ */
+int params_encode(int kind, const struct param * params, int count,
+                  unsigned char * buffer, int capacity, int * size)
+{
+        int used = PARAMS_COUNT_SIZE;
+        int i;
+
+        if ((kind < PARAMS_KEYS) || (kind > PARAMS_STATUS) || (count < 0))
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        if (count > PARAMS_MAX_COUNT)
+        {
+                count = PARAMS_MAX_COUNT;
+        }
+
+        for (i = 0 ; i < count ; i++)
+        {
+                const struct param * param = &params[i];
+                unsigned char      * record = buffer + used;
+                int                  value_size = 0;
+
+                if ((kind == PARAMS_VALUES) ||
+                    ((kind == PARAMS_RESULTS) && (param->status == SUCCESS)))
+                {
+                        value_size = param->size;
+                        if ((value_size < 0) || (value_size > PARAMS_MAX_VALUE) ||
+                            (value_size && ! param->value))
+                        {
+                                return -ERR_BAD_PARAMETER;
+                        }
+                }
+                if (used + param_size(kind, param) > capacity)
+                {
+                        break;
+                }
+
+                if (kind != PARAMS_STATUS)
+                {
+                        *record++ = (param->key & 0xFF);
+                        *record++ = ((param->key >> 8) & 0xFF);
+                }
+                if ((kind == PARAMS_RESULTS) || (kind == PARAMS_STATUS))
+                {
+                        *record++ = param_status(param->status);
+                }
+                if ((kind == PARAMS_VALUES) || (kind == PARAMS_RESULTS))
+                {
+                        *record++ = (value_size & 0xFF);
+                        *record++ = ((value_size >> 8) & 0xFF);
+                        if (value_size > 0)
+                        {
+                                memcpy(record, param->value, value_size);
+                        }
+                        record += value_size;
+                }
+                used = record - buffer;
+        }
+        if ((i == 0) && (count > 0))
+        {
+                return -ERR_OUT_OF_RANGE;
+        }
+
+        buffer[0] = (i & 0xFF);
+        buffer[1] = ((i >> 8) & 0xFF);
+        *size = used;
+
+        return i;
+}
+
+
+/**
+ *  \brief Number of records of a parameters list.
+ *
+ * @param data          encoded list
+ * @param size          size of the list
+ * @return              the number of records or -ERR_BAD_PROTOCOL
+ */
+int params_count(const unsigned char * data, int size)
+{
+        if (size < PARAMS_COUNT_SIZE)
+        {
+                return -ERR_BAD_PROTOCOL;
+        }
+        return data[0] | (data[1] << 8);
+}
+
+
+/**
+ *  \brief Parameters list decoding.
+ *
+ *         The values of the decoded parameters point into the data. A
+ *         PARAMS_STATUS list only fills the status of the parameters, in
+ *         order: the keys should be the ones of the request.
+ *
+ * @param kind          kind of list (PARAMS_*)
+ * @param data          encoded list (data of a packet)
+ * @param size          size of the list
+ * @param params        decoded parameters
+ * @param max           maximum number of decoded parameters
+ * @return              the number of decoded parameters or a negative
+ *                      value in case of error
+ * @retval -ERR_BAD_PARAMETER   unknown kind
+ * @retval -ERR_BAD_PROTOCOL    truncated or invalid list
+ */
+int params_decode(int kind, const unsigned char * data, int size,
+                  struct param * params, int max)
+{
+        const unsigned char * end = data + size;
+        int                   count = params_count(data, size);
+        int                   i;
+
+        if ((kind < PARAMS_KEYS) || (kind > PARAMS_STATUS))
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        if (count < 0)
+        {
+                return count;
+        }
+        if (count > max)
+        {
+                count = max;
+        }
+
+        data += PARAMS_COUNT_SIZE;
+        for (i = 0 ; i < count ; i++)
+        {
+                struct param * param = &params[i];
+                int            header;
+
+                /* Taille fixe de l'enregistrement, sans la valeur */
+                header = (kind == PARAMS_KEYS) ? 2 :
+                         (kind == PARAMS_VALUES) ? 4 :
+                         (kind == PARAMS_RESULTS) ? 5 : 1;
+                if (end - data < header)
+                {
+                        return -ERR_BAD_PROTOCOL;
+                }
+
+                if (kind != PARAMS_STATUS)
+                {
+                        param->key = data[0] | (data[1] << 8);
+                        data += 2;
+                        param->status = SUCCESS;
+                }
+                if ((kind == PARAMS_RESULTS) || (kind == PARAMS_STATUS))
+                {
+                        param->status = -(int) data[0];
+                        data++;
+                }
+                param->size = 0;
+                param->value = NULL;
+                if ((kind == PARAMS_VALUES) || (kind == PARAMS_RESULTS))
+                {
+                        param->size = data[0] | (data[1] << 8);
+                        data += 2;
+                        if (end - data < param->size)
+                        {
+                                return -ERR_BAD_PROTOCOL;
+                        }
+                        param->value = data;
+                        data += param->size;
+                }
+        }
+
+        return count;
+}
+
+
+/**
+ *  \brief Parameters list sending.
+ *
+ *         This function sends a parameters list in as many packets as
+ *         needed (each one small enough to be wrapped in a response or a
+ *         request). The packets are sent with request_answer(): they are
+ *         wrapped in a response when the current thread handles an
+ *         identified request.
+ *
+ * @param fd            communication socket to use
+ * @param tag           TAG of the packets (CMD_GET_PARAM, CMD_SET_PARAM)
+ * @param kind          kind of list (PARAMS_*)
+ * @param params        parameters to send
+ * @param count         number of parameters
+ * @return              the number of sent packets or a negative value in
+ *                      case of error
+ * @retval -ERR_CONNECTION_LOST a packet could not be sent
+ * @retval others               see params_encode()
+ */
+int params_send(int fd, int tag, int kind, const struct param * params,
+                int count)
+{
+        unsigned char data[MAX_DATA_SIZE];
+        int           nb_packets = 0;
+        int           size, encoded;
+
+        do
+        {
+                encoded = params_encode(kind, params, count, data,
+                                        REQUEST_MAX_DATA, &size);
+                if (encoded < 0)
+                {
+                        return encoded;
+                }
+                if (request_answer(fd, tag, data, size) == 0)
+                {
+                        return -ERR_CONNECTION_LOST;
+                }
+                params += encoded;
+                count -= encoded;
+                nb_packets++;
+        }
+        while (count > 0);
+
+        return nb_packets;
+}
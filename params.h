@@ -0,0 +1,88 @@
+/**
+ *  \file    params.h
+ *  \brief   Batched parameters.
+ *
+ *           Project: project independant file.
+ *
+ *           This is the header file of params.c and contains all the
+ *           constants, structures and functions declarations needed to
+ *           get or set many parameters with a single packet.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#ifndef PARAMS_H
+#define PARAMS_H
+
+/**
+ *  \defgroup params Batched parameters constants and structures
+ *
+ *  \details
+ *  Once CAPABILITY_BATCH is negotiated, the data of the CMD_GET_PARAM and
+ *  CMD_SET_PARAM packets are a list of records preceded by their number
+ *  (<tt>2 bytes</tt>). The records depend on the kind of list:
+ *  - PARAMS_KEYS (CMD_GET_PARAM request):
+ *    <tt>2 bytes</tt> key;
+ *  - PARAMS_VALUES (CMD_SET_PARAM request):
+ *    <tt>2 bytes</tt> key, <tt>2 bytes</tt> size, value;
+ *  - PARAMS_RESULTS (CMD_GET_PARAM answer):
+ *    <tt>2 bytes</tt> key, <tt>1 byte</tt> status, <tt>2 bytes</tt> size,
+ *    value;
+ *  - PARAMS_STATUS (CMD_SET_PARAM answer):
+ *    <tt>1 byte</tt> status for each record of the request, in order.
+ *
+ *  All numbers are little-endian. A status is 0 for success or the
+ *  absolute value of the error code. A list that does not fit in a packet
+ *  is sent as many packets (see params_send()), each one answered on its
+ *  own.
+ *  @{
+ */
+
+/*! List of keys (CMD_GET_PARAM request). */
+#define PARAMS_KEYS             0
+
+/*! List of keys and values (CMD_SET_PARAM request). */
+#define PARAMS_VALUES           1
+
+/*! List of keys, status and values (CMD_GET_PARAM answer). */
+#define PARAMS_RESULTS          2
+
+/*! List of status (CMD_SET_PARAM answer). */
+#define PARAMS_STATUS           3
+
+/*! Size of the number of records. */
+#define PARAMS_COUNT_SIZE       2
+
+/*! Maximum number of records in a list. */
+#define PARAMS_MAX_COUNT        0xFFFF
+
+/*! Maximum size of a value. */
+#define PARAMS_MAX_VALUE        0xFFFF
+
+/*! Parameter record. */
+struct param {
+        unsigned int            key;     /*!< Parameter key (16 bits).      */
+        int                     status;  /*!< SUCCESS or error code.        */
+        int                     size;    /*!< Size of the value.            */
+        const unsigned char   * value;   /*!< Value (not copied).           */
+};
+
+/** @} */
+
+
+/** @cond DUPLICATE_DOCUMENTATION */
+int params_encode(int kind, const struct param * params, int count,
+                  unsigned char * buffer, int capacity, int * size);
+int params_decode(int kind, const unsigned char * data, int size,
+                  struct param * params, int max);
+int params_count(const unsigned char * data, int size);
+int params_send(int fd, int tag, int kind, const struct param * params,
+                int count);
+/** @endcond */
+
+
+#endif /* PARAMS_H */
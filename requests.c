@@ -0,0 +1,598 @@
+/**
+ *  \file    requests.c
+ *  \brief   Pipelined requests.
+ *
+ *           Project: project independant file.
+ *
+ *           This file contains the management of the requests identifiers:
+ *           on the client side, many requests are sent without waiting
+ *           for their answers, which are matched back to their request by
+ *           identifier and given to a callback or kept for request_wait()
+ *           (future); each request may have its own timeout. N requests
+ *           thus cost one round trip instead of N. On the server side, the
+ *           identifier of the request being handled is kept per thread so
+ *           that the answers are wrapped in responses.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/uio.h>
+
+#include "errors.h"
+#include "metrics.h"
+#include "packets.h"
+#include "tags.h"
+#include "requests.h"
+#include "xmem.h"
+
+
+/*! Identifier of the request handled by the current thread (server). */
+static __thread int current_request = -1;
+
+
+/**
+ *  \brief Current date in nanoseconds, unaffected by the clock changes.
+ */
+static long long requests_now_ns(void)
+{
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+
+/**
+ *  \brief Current date in milliseconds, unaffected by the clock changes.
+ */
+static long long requests_now(void)
+{
+        return requests_now_ns() / 1000000;
+}
+
+
+/**
+ *  \brief Request completion: calls its handler or completes its future.
+ *
+ * @param requests      requests of the connection
+ * @param request       the completed request
+ * @param status        SUCCESS, -ERR_TIMEOUT or -ERR_CONNECTION_LOST
+ * @param tag           TAG of the answer
+ * @param data          data of the answer
+ * @param size          size of the data
+ */
+static void request_complete(struct requests * requests, struct request * request,
+                             int status, int tag, const unsigned char * data,
+                             int size)
+{
+        request_callback   callback = request->callback;
+        void             * user = request->user;
+
+        requests->nb_pending--;
+        if (status == SUCCESS)
+        {
+                metrics_latency(requests_now_ns() - request->sent);
+        }
+        else
+        {
+                metrics_error(requests->fd, status);
+        }
+        if (callback)
+        {
+                /* Libéré avant l'appel : le gestionnaire peut relancer. */
+                request->id = -1;
+                callback(status, tag, data, size, user);
+                return;
+        }
+
+        request->done = 1;
+        request->status = status;
+        request->tag = tag;
+        request->size = 0;
+        if ((status == SUCCESS) && (size > 0))
+        {
+                request->answer = xmalloc(size);
+                memcpy(request->answer, data, size);
+                request->size = size;
+        }
+}
+
+
+/**
+ *  \brief Failure of all the requests in flight.
+ */
+static void requests_fail(struct requests * requests, int status)
+{
+        int i;
+
+        for (i = 0 ; i < requests->capacity ; i++)
+        {
+                struct request * request = &requests->slots[i];
+
+                if ((request->id >= 0) && ! request->done)
+                {
+                        request_complete(requests, request, status, 0, NULL, 0);
+                }
+        }
+}
+
+
+/**
+ *  \brief Requests initialisation.
+ *
+ * @param requests      requests to initialise
+ * @param fd            connection to the server
+ * @param capacity      maximum number of requests in flight (0 for
+ *                      REQUESTS_IN_FLIGHT)
+ * @return              the status of the initialisation
+ * @retval SUCCESS              requests ready
+ * @retval -ERR_BAD_PARAMETER   invalid capacity
+ */
+int requests_init(struct requests * requests, int fd, int capacity)
+{
+        int i;
+
+        if (capacity <= 0)
+        {
+                capacity = REQUESTS_IN_FLIGHT;
+        }
+        if (capacity > 0x10000)
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        memset(requests, 0, sizeof(struct requests));
+        requests->slots = xmalloc(capacity * sizeof(struct request));
+        memset(requests->slots, 0, capacity * sizeof(struct request));
+        for (i = 0 ; i < capacity ; i++)
+        {
+                requests->slots[i].id = -1;
+        }
+        requests->fd = fd;
+        requests->capacity = capacity;
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Requests release.
+ *
+ *         The requests still in flight are completed with
+ *         -ERR_CONNECTION_LOST. The connection is not closed.
+ *
+ * @param requests      requests to release
+ */
+void requests_free(struct requests * requests)
+{
+        int i;
+
+        if (! requests->slots)
+        {
+                return;
+        }
+        requests_fail(requests, -ERR_CONNECTION_LOST);
+        for (i = 0 ; i < requests->capacity ; i++)
+        {
+                FREE(requests->slots[i].answer);
+        }
+        FREE(requests->slots);
+        requests->capacity = 0;
+}
+
+
+/**
+ *  \brief Other packets handler setting.
+ *
+ *         The packets received by request_wait() that are not responses
+ *         (notifications, broadcasts...) are given to this handler.
+ *
+ * @param requests      requests of the connection
+ * @param handler       packets handler (NULL to drop them)
+ * @param data          user data of the handler
+ */
+void requests_set_handler(struct requests * requests,
+                          packet_handler handler, void * data)
+{
+        requests->handler = handler;
+        requests->data = data;
+}
+
+
+/**
+ *  \brief Request sending.
+ *
+ *         This function sends a packet as a request without waiting for
+ *         its answer. The answer is given to the callback (from
+ *         requests_handle(), request_wait() or requests_expire()), or is
+ *         kept until request_wait() is called with the returned
+ *         identifier when there is no callback.
+ *
+ * @param requests      requests of the connection
+ * @param tag           TAG of the request packet
+ * @param data          data of the request packet
+ * @param size          size of the data (at most REQUEST_MAX_DATA)
+ * @param timeout       timeout of the request in ms (0 for none)
+ * @param callback      answer handler (NULL for a future)
+ * @param user          user data of the handler
+ * @return              the identifier of the request or a negative value
+ *                      in case of error
+ * @retval -ERR_BAD_PARAMETER   invalid size
+ * @retval -ERR_FIFO_FULL       too many requests in flight
+ * @retval -ERR_CONNECTION_LOST could not send the request
+ */
+int request_send(struct requests * requests, int tag,
+                 const unsigned char * data, int size, int timeout,
+                 request_callback callback, void * user)
+{
+        unsigned char    header[REQUEST_HEADER_SIZE];
+        struct iovec     iov[2];
+        struct request * request = NULL;
+        long long        sent;
+        int              id = 0;
+        int              i;
+
+        if ((size < 0) || (size > REQUEST_MAX_DATA) || (size && ! data))
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        for (i = 0 ; (i < requests->capacity) && ! request ; i++)
+        {
+                id = requests->next_id;
+                requests->next_id = (requests->next_id + 1) & 0xFFFF;
+                if (requests->slots[id % requests->capacity].id < 0)
+                {
+                        request = &requests->slots[id % requests->capacity];
+                }
+        }
+        if (! request)
+        {
+                return -ERR_FIFO_FULL;
+        }
+
+        header[0] = (id & 0xFF);
+        header[1] = ((id >> 8) & 0xFF);
+        header[2] = (tag & 0xFF);
+        iov[0].iov_base = header;
+        iov[0].iov_len = REQUEST_HEADER_SIZE;
+        iov[1].iov_base = (void *) data;
+        iov[1].iov_len = size;
+        sent = requests_now_ns();
+        if (packet_sendv(requests->fd, PACKET_REQUEST, iov, 2) == 0)
+        {
+                return -ERR_CONNECTION_LOST;
+        }
+
+        request->id = id;
+        request->sent = sent;
+        request->deadline = timeout > 0 ? requests_now() + timeout : 0;
+        request->callback = callback;
+        request->user = user;
+        request->done = 0;
+        request->answer = NULL;
+        requests->nb_pending++;
+
+        return id;
+}
+
+
+/**
+ *  \brief Received packet handling.
+ *
+ *         This function matches a PACKET_RESPONSE packet with its request.
+ *         It can be called from any reader (event loop, packet decoder...)
+ *         with every received packet. A response to an unknown request (a
+ *         request that timed out for instance) is dropped.
+ *
+ * @param requests      requests of the connection
+ * @param packet        received packet (LEN + TAG + DATA)
+ * @return              1 if the packet is a response, 0 otherwise, or a
+ *                      negative value in case of error
+ * @retval -ERR_BAD_PROTOCOL    invalid response
+ */
+int requests_handle(struct requests * requests, const unsigned char * packet)
+{
+        struct request * request;
+        int              size, id;
+
+        if (packet_type(packet) != PACKET_RESPONSE)
+        {
+                return 0;
+        }
+        size = packet_data_len(packet) - PACKET_TAG_SIZE;
+        if (size < REQUEST_HEADER_SIZE)
+        {
+                return -ERR_BAD_PROTOCOL;
+        }
+        packet += PACKET_HEADER_SIZE;
+        id = packet[0] | (packet[1] << 8);
+
+        request = &requests->slots[id % requests->capacity];
+        if ((request->id == id) && ! request->done)
+        {
+                request_complete(requests, request, SUCCESS, packet[2],
+                                 packet + REQUEST_HEADER_SIZE,
+                                 size - REQUEST_HEADER_SIZE);
+        }
+
+        return 1;
+}
+
+
+/**
+ *  \brief Requests timeouts.
+ *
+ *         This function completes the requests whose timeout elapsed with
+ *         -ERR_TIMEOUT. An event loop should call it when the delay given
+ *         by requests_timeout() elapses.
+ *
+ * @param requests      requests of the connection
+ * @return              the number of requests that timed out
+ */
+int requests_expire(struct requests * requests)
+{
+        long long now = requests_now();
+        int       nb_expired = 0;
+        int       i;
+
+        for (i = 0 ; i < requests->capacity ; i++)
+        {
+                struct request * request = &requests->slots[i];
+
+                if ((request->id >= 0) && ! request->done &&
+                    request->deadline && (request->deadline <= now))
+                {
+                        request_complete(requests, request, -ERR_TIMEOUT,
+                                         0, NULL, 0);
+                        nb_expired++;
+                }
+        }
+
+        return nb_expired;
+}
+
+
+/**
+ *  \brief Delay until the next request timeout.
+ *
+ * @param requests      requests of the connection
+ * @return              the delay in ms, -1 if no request has a timeout
+ */
+int requests_timeout(const struct requests * requests)
+{
+        long long next = 0;
+        long long now;
+        int       i;
+
+        for (i = 0 ; i < requests->capacity ; i++)
+        {
+                const struct request * request = &requests->slots[i];
+
+                if ((request->id >= 0) && ! request->done && request->deadline &&
+                    (! next || (request->deadline < next)))
+                {
+                        next = request->deadline;
+                }
+        }
+        if (! next)
+        {
+                return -1;
+        }
+        now = requests_now();
+
+        return next > now ? (int) (next - now) : 0;
+}
+
+
+/**
+ *  \brief Request waiting.
+ *
+ *         This function reads the packets of the connection until the
+ *         given request is completed (or all the requests for a negative
+ *         identifier), handling the responses, the timeouts and the other
+ *         packets (see requests_set_handler()). For a request sent without
+ *         callback (future), the answer is then copied and the request
+ *         released.
+ *
+ * @param requests      requests of the connection
+ * @param id            identifier of the request, -1 for all
+ * @param tag           returned TAG of the answer (may be NULL)
+ * @param answer        returned data of the answer (may be NULL)
+ * @param capacity      size of the answer buffer
+ * @return              the size of the answer data (SUCCESS for a request
+ *                      with callback or for all the requests) or a
+ *                      negative value in case of error
+ * @retval -ERR_NOT_FOUND       unknown request
+ * @retval -ERR_TIMEOUT         the request timed out
+ * @retval -ERR_CONNECTION_LOST connection lost
+ */
+int request_wait(struct requests * requests, int id, int * tag,
+                 unsigned char * answer, int capacity)
+{
+        unsigned char    packet[MAX_PACKET_SIZE];
+        struct request * request = NULL;
+        int              status;
+
+        if (id >= 0)
+        {
+                request = &requests->slots[id % requests->capacity];
+                if (request->id != id)
+                {
+                        return -ERR_NOT_FOUND;
+                }
+        }
+
+        for (;;)
+        {
+                struct pollfd pfd;
+                int           size;
+
+                if (request ? (request->id != id) || request->done
+                            : (requests->nb_pending == 0))
+                {
+                        break;
+                }
+
+                pfd.fd = requests->fd;
+                pfd.events = POLLIN;
+                pfd.revents = 0;
+                status = poll(&pfd, 1, requests_timeout(requests));
+                if ((status < 0) && (errno != EINTR))
+                {
+                        requests_fail(requests, -ERR_CONNECTION_LOST);
+                        break;
+                }
+                if (status <= 0)
+                {
+                        requests_expire(requests);
+                        continue;
+                }
+
+                size = packet_read(requests->fd, packet, sizeof(packet));
+                if (size <= 0)
+                {
+                        requests_fail(requests, -ERR_CONNECTION_LOST);
+                        break;
+                }
+                if ((requests_handle(requests, packet) == 0) && requests->handler)
+                {
+                        requests->handler(packet, size, requests->data);
+                }
+                requests_expire(requests);
+        }
+
+        if (! request)
+        {
+                return (requests->nb_pending == 0) ? SUCCESS : -ERR_CONNECTION_LOST;
+        }
+        if (request->id != id)
+        {
+                /* Requête à gestionnaire : déjà traitée. */
+                return SUCCESS;
+        }
+
+        status = request->status;
+        if (status == SUCCESS)
+        {
+                status = (request->size < capacity) ? request->size : capacity;
+                if (answer && (status > 0))
+                {
+                        memcpy(answer, request->answer, status);
+                }
+                if (tag)
+                {
+                        *tag = request->tag;
+                }
+        }
+        FREE(request->answer);
+        request->id = -1;
+
+        return status;
+}
+
+
+/**
+ *  \brief Identifier of the request being handled by the current thread.
+ *
+ * @return              the identifier, -1 outside of a request
+ */
+int request_current(void)
+{
+        return current_request;
+}
+
+
+/**
+ *  \brief Request handling start (server side).
+ *
+ *         The answers sent by the current thread are wrapped in responses
+ *         to the given request until request_leave().
+ *
+ * @param id            identifier of the request
+ * @return              the identifier of the previous request, to give to
+ *                      request_leave()
+ */
+int request_enter(int id)
+{
+        int previous = current_request;
+
+        current_request = id;
+        return previous;
+}
+
+
+/**
+ *  \brief Request handling end (server side).
+ *
+ * @param previous      value returned by request_enter()
+ */
+void request_leave(int previous)
+{
+        current_request = previous;
+}
+
+
+/**
+ *  \brief Answer sending (server side).
+ *
+ *         This function sends a packet, wrapped in a response when the
+ *         current thread handles a request.
+ *
+ * @param fd            communication socket to use
+ * @param tag           TAG of the answer
+ * @param data          data of the answer
+ * @param size          size of the data
+ * @return              the emitted size or 0 in case of error
+ */
+int request_answer(int fd, int tag, const unsigned char * data, int size)
+{
+        unsigned char header[REQUEST_HEADER_SIZE];
+        struct iovec  iov[2];
+
+        iov[1].iov_base = (void *) data;
+        iov[1].iov_len = (size > 0) ? size : 0;
+        if (current_request < 0)
+        {
+                return packet_sendv(fd, tag, &iov[1], 1);
+        }
+
+        header[0] = (current_request & 0xFF);
+        header[1] = ((current_request >> 8) & 0xFF);
+        header[2] = (tag & 0xFF);
+        iov[0].iov_base = header;
+        iov[0].iov_len = REQUEST_HEADER_SIZE;
+
+        return packet_sendv(fd, PACKET_RESPONSE, iov, 2);
+}
+
+
+/**
+ *  \brief Message sending (server side).
+ *
+ *         This function sends a message like message_send(), wrapped in a
+ *         response when the current thread handles a request.
+ *
+ * @param fd            communication socket to use
+ * @param type          type (TAG) of the message
+ * @param message       optional additionnal information
+ * @return              the emitted size or 0 in case of error
+ */
+int request_message(int fd, int type, int message)
+{
+        unsigned char packet[PACKET_HEADER_SIZE + PACKET_MSG_SIZE];
+
+        message_create(type, message, packet);
+
+        return request_answer(fd, type, packet + PACKET_HEADER_SIZE,
+                              packet_data_len(packet) - PACKET_TAG_SIZE);
+}
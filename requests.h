@@ -0,0 +1,109 @@
+/**
+ *  \file    requests.h
+ *  \brief   Pipelined requests.
+ *
+ *           Project: project independant file.
+ *
+ *           This is the header file of requests.c and contains all the
+ *           constants, structures and functions declarations needed to
+ *           keep many requests in flight on a connection.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#ifndef REQUESTS_H
+#define REQUESTS_H
+
+#include "packets.h"
+
+/**
+ *  \defgroup requests Pipelined requests constants and structures
+ *
+ *  \details
+ *  A request is a packet wrapped in a PACKET_REQUEST packet with an
+ *  identifier chosen by the client; the server answers each request with
+ *  a PACKET_RESPONSE packet carrying the same identifier, in any order.
+ *  The data of both packets are:
+ *  - <tt>2 bytes</tt> the request identifier (little-endian)
+ *  - <tt>1 byte</tt>  the TAG of the wrapped packet
+ *  - <tt>x bytes</tt> the data of the wrapped packet
+ *
+ *  Requests must only be sent to a server that announced
+ *  CAPABILITY_PIPELINING. On the server side, dispatch_packet() unwraps
+ *  the requests: the ACK and NACK of the dispatch policies and the
+ *  answers sent with request_answer() are then wrapped in responses.
+ *  @{
+ */
+
+/*! Size of the request information in front of the wrapped packet. */
+#define REQUEST_HEADER_SIZE     3
+
+/*! Maximum size of the data of a wrapped packet. */
+#define REQUEST_MAX_DATA        (MAX_DATA_SIZE - REQUEST_HEADER_SIZE)
+
+/*! Default maximum number of requests in flight on a connection. */
+#define REQUESTS_IN_FLIGHT      64
+
+/*! Function called with the response of a request: the status is SUCCESS,
+ *  -ERR_TIMEOUT or -ERR_CONNECTION_LOST, the TAG and data are the ones of
+ *  the wrapped answer (on success only).
+ */
+typedef void (*request_callback)(int status, int tag, const unsigned char * data,
+                                 int size, void * user);
+
+/*! Request in flight. */
+struct request {
+        int                id;        /*!< Identifier, -1 if free.          */
+        long long          deadline;  /*!< Deadline in ms (0 for none).     */
+        long long          sent;      /*!< Sending date in ns (latency).    */
+        request_callback   callback;  /*!< Handler (NULL for a future).     */
+        void             * user;      /*!< Handler data.                    */
+        int                done;      /*!< Future completed.                */
+        int                status;    /*!< Future status.                   */
+        int                tag;       /*!< Future answer TAG.               */
+        int                size;      /*!< Future answer size.              */
+        unsigned char    * answer;    /*!< Future answer data.              */
+};
+
+/*! Requests of a connection, client side. It must be initialised with
+ *  requests_init().
+ */
+struct requests {
+        int                fd;          /*!< Connection.                     */
+        int                next_id;     /*!< Next identifier.                */
+        int                capacity;    /*!< Maximum requests in flight.     */
+        int                nb_pending;  /*!< Requests in flight.             */
+        struct request   * slots;       /*!< Requests by identifier.         */
+        packet_handler     handler;     /*!< Other packets (or NULL).        */
+        void             * data;        /*!< User data of the handler.       */
+};
+
+/** @} */
+
+
+/** @cond DUPLICATE_DOCUMENTATION */
+int requests_init(struct requests * requests, int fd, int capacity);
+void requests_free(struct requests * requests);
+int request_send(struct requests * requests, int tag,
+                 const unsigned char * data, int size, int timeout,
+                 request_callback callback, void * user);
+int requests_handle(struct requests * requests, const unsigned char * packet);
+int requests_expire(struct requests * requests);
+int requests_timeout(const struct requests * requests);
+int request_wait(struct requests * requests, int id, int * tag,
+                 unsigned char * answer, int capacity);
+void requests_set_handler(struct requests * requests,
+                          packet_handler handler, void * data);
+int request_current(void);
+int request_enter(int id);
+void request_leave(int previous);
+int request_answer(int fd, int tag, const unsigned char * data, int size);
+int request_message(int fd, int type, int message);
+/** @endcond */
+
+
+#endif /* REQUESTS_H */
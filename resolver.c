@@ -0,0 +1,864 @@
+/**
+ *  \file    resolver.c
+ *  \brief   Caching names resolver.
+ *
+ *           Project: project independant file.
+ *
+ *           This file contains a thread-safe names resolver built on
+ *           getaddrinfo() and getnameinfo(), for IPv4 as well as IPv6.
+ *           The results of the lookups are kept in a cache: getaddrinfo()
+ *           does not give the TTL of the DNS records, so every entry lives
+ *           for the configured TTL (see resolver_set_ttl()). The
+ *           asynchronous lookups are made by a few resolver threads, so
+ *           that the event loops never wait for the DNS.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <sys/un.h>
+#include <stddef.h>
+
+#include "errors.h"
+#include "resolver.h"
+
+
+/**
+ *  \defgroup reinternals Resolver internals
+ *  @{
+ */
+
+/*! Maximum length of a host name. */
+#define RESOLVER_NAME_SIZE      256
+
+/*! Cache entry kinds. */
+enum {
+        ENTRY_EMPTY = 0,  /*!< Unused entry.                 */
+        ENTRY_FORWARD,    /*!< Name to addresses lookup.     */
+        ENTRY_REVERSE     /*!< Address to name lookup.       */
+};
+
+/*! Cache entry states. */
+enum {
+        STATE_READY = 0,  /*!< Successful lookup.            */
+        STATE_FAILED,     /*!< Failed lookup.                */
+        STATE_PENDING     /*!< Lookup queued for a thread.   */
+};
+
+/*! Cache entry. */
+struct resolver_entry {
+        int                     kind;          /*!< Kind of lookup.            */
+        int                     state;         /*!< State of the lookup.       */
+        int                     family;        /*!< Asked address family.      */
+        time_t                  expires;       /*!< Expiration date.           */
+        char                    name[RESOLVER_NAME_SIZE]; /*!< Host name.      */
+        struct resolver_address key;           /*!< Reverse lookup address.    */
+        int                     nb_addresses;  /*!< Number of addresses.       */
+        struct resolver_address addresses[RESOLVER_MAX_ADDRESSES]; /*!< Addresses. */
+};
+
+/*! Asynchronous lookup. */
+struct resolver_job {
+        int                     kind;       /*!< Kind of lookup.          */
+        char                    name[RESOLVER_NAME_SIZE]; /*!< Host name. */
+        int                     port;       /*!< Port of the addresses.   */
+        int                     family;     /*!< Asked address family.    */
+        struct resolver_address key;        /*!< Address to resolve.      */
+        resolver_callback       callback;   /*!< Result handler.          */
+        void                  * data;       /*!< Handler data.            */
+        struct resolver_job   * next;       /*!< Next lookup.             */
+};
+
+/** @} */
+
+
+/*! Resolver lock: protects the cache and the lookups queue. */
+static pthread_mutex_t resolver_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*! New lookups condition. */
+static pthread_cond_t resolver_jobs = PTHREAD_COND_INITIALIZER;
+
+/*! Lookups cache. */
+static struct resolver_entry resolver_cache[RESOLVER_CACHE_SIZE];
+
+/*! Time to live of the cache entries. */
+static int resolver_ttl = RESOLVER_TTL;
+
+/*! Lookups queue. */
+static struct resolver_job * queue_head = NULL;
+
+/*! Last lookup of the queue. */
+static struct resolver_job * queue_tail = NULL;
+
+/*! Number of queued lookups. */
+static int queue_length = 0;
+
+/*! Number of running resolver threads. */
+static int nb_threads = 0;
+
+
+/**
+ *  \brief Current date, in seconds, unaffected by the clock changes.
+ */
+static time_t resolver_now(void)
+{
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return now.tv_sec;
+}
+
+
+/**
+ *  \brief FNV-1a hash of a buffer.
+ */
+static unsigned int resolver_hash(const void * buffer, size_t size,
+                                  unsigned int hash)
+{
+        const unsigned char * bytes = buffer;
+        size_t                i;
+
+        for (i = 0 ; i < size ; i++)
+        {
+                hash = (hash ^ bytes[i]) * 16777619U;
+        }
+        return hash;
+}
+
+
+/**
+ *  \brief Address part of a socket address (without the port).
+ *
+ * @param address       socket address
+ * @param size          returned size of the address part
+ * @return              the address part, NULL for an unknown family
+ */
+static const void * resolver_raw(const struct sockaddr * address, size_t * size)
+{
+        if (address->sa_family == AF_INET)
+        {
+                *size = sizeof(struct in_addr);
+                return &((const struct sockaddr_in *) address)->sin_addr;
+        }
+        if (address->sa_family == AF_INET6)
+        {
+                *size = sizeof(struct in6_addr);
+                return &((const struct sockaddr_in6 *) address)->sin6_addr;
+        }
+        return NULL;
+}
+
+
+/**
+ *  \brief Port setting of a socket address.
+ */
+static void resolver_set_port(struct resolver_address * address, int port)
+{
+        if (address->address.ss_family == AF_INET)
+        {
+                ((struct sockaddr_in *) &address->address)->sin_port = htons(port);
+        }
+        else if (address->address.ss_family == AF_INET6)
+        {
+                ((struct sockaddr_in6 *) &address->address)->sin6_port = htons(port);
+        }
+}
+
+
+/**
+ *  \brief Forward lookup cache entry.
+ *
+ *         The resolver lock must be held.
+ *
+ * @param host          host name
+ * @param family        asked address family
+ * @param found         returned flag: the entry is the one of the name
+ * @return              the entry of the name, or the one to replace
+ */
+static struct resolver_entry * cache_forward(const char * host, int family,
+                                             int * found)
+{
+        unsigned int            hash;
+        struct resolver_entry * entry;
+
+        hash = resolver_hash(host, strlen(host), 2166136261U);
+        hash = resolver_hash(&family, sizeof(family), hash);
+        entry = &resolver_cache[hash % RESOLVER_CACHE_SIZE];
+        *found = (entry->kind == ENTRY_FORWARD) &&
+                 (entry->family == family) &&
+                 (strcmp(entry->name, host) == 0) &&
+                 (entry->expires > resolver_now());
+        return entry;
+}
+
+
+/**
+ *  \brief Reverse lookup cache entry.
+ *
+ *         The resolver lock must be held.
+ *
+ * @param key           address to resolve (port ignored)
+ * @param found         returned flag: the entry is the one of the address
+ * @return              the entry of the address, or the one to replace,
+ *                      NULL for an unknown address family
+ */
+static struct resolver_entry * cache_reverse(const struct sockaddr * key,
+                                             int * found)
+{
+        const void            * raw;
+        const void            * cached;
+        size_t                  size, cached_size;
+        unsigned int            hash;
+        struct resolver_entry * entry;
+
+        *found = 0;
+        raw = resolver_raw(key, &size);
+        if (raw == NULL)
+        {
+                return NULL;
+        }
+        hash = resolver_hash(raw, size, 2166136261U ^ ENTRY_REVERSE);
+        entry = &resolver_cache[hash % RESOLVER_CACHE_SIZE];
+        if ((entry->kind == ENTRY_REVERSE) &&
+            (entry->expires > resolver_now()))
+        {
+                cached = resolver_raw((struct sockaddr *) &entry->key.address,
+                                      &cached_size);
+                *found = (cached != NULL) && (cached_size == size) &&
+                         (memcmp(cached, raw, size) == 0);
+        }
+        return entry;
+}
+
+
+/**
+ *  \brief Expiration date of a new cache entry.
+ */
+static time_t cache_expires(int state)
+{
+        int ttl = resolver_ttl;
+
+        if ((state != STATE_READY) && (ttl > RESOLVER_NEGATIVE_TTL))
+        {
+                ttl = RESOLVER_NEGATIVE_TTL;
+        }
+        return resolver_now() + ttl;
+}
+
+
+/**
+ *  \brief Local endpoint conversion.
+ *
+ * @param host          RESOLVER_UNIX_PREFIX followed by a path (or by '@'
+ *                      and a name in the abstract namespace)
+ * @param family        asked address family (AF_UNSPEC or AF_UNIX)
+ * @param address       returned address
+ * @return              1 if the host is a local endpoint, 0 if it is not,
+ *                      -ERR_UNKNOWN_ADDRESS if it cannot be used
+ */
+static int resolver_local(const char * host, int family,
+                          struct resolver_address * address)
+{
+        struct sockaddr_un * local = (struct sockaddr_un *) &address->address;
+        size_t               length;
+
+        if (strncmp(host, RESOLVER_UNIX_PREFIX, strlen(RESOLVER_UNIX_PREFIX)) != 0)
+        {
+                return 0;
+        }
+        host += strlen(RESOLVER_UNIX_PREFIX);
+        length = strlen(host);
+        if ((length == 0) || (length >= sizeof(local->sun_path)) ||
+            ((family != AF_UNSPEC) && (family != AF_UNIX)))
+        {
+                return -ERR_UNKNOWN_ADDRESS;
+        }
+
+        memset(address, 0, sizeof(struct resolver_address));
+        local->sun_family = AF_UNIX;
+        memcpy(local->sun_path, host, length);
+        if (host[0] == '@')
+        {
+                /* Espace abstrait : ni '\0' final, ni fichier. */
+                local->sun_path[0] = '\0';
+                address->length = offsetof(struct sockaddr_un, sun_path) + length;
+        }
+        else
+        {
+                address->length = offsetof(struct sockaddr_un, sun_path) + length + 1;
+        }
+        return 1;
+}
+
+
+/**
+ *  \brief Numeric address conversion.
+ *
+ * @param host          numeric IPv4 or IPv6 address
+ * @param port          port of the address
+ * @param family        asked address family (AF_UNSPEC for any)
+ * @param address       returned address
+ * @return              1 if the host is a numeric address, 0 otherwise
+ */
+static int resolver_numeric(const char * host, int port, int family,
+                            struct resolver_address * address)
+{
+        struct addrinfo   hints, * result;
+
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = family;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_NUMERICHOST;
+        if ((getaddrinfo(host, NULL, &hints, &result) != 0) || (result == NULL))
+        {
+                return 0;
+        }
+        memcpy(&address->address, result->ai_addr, result->ai_addrlen);
+        address->length = result->ai_addrlen;
+        resolver_set_port(address, port);
+        freeaddrinfo(result);
+        return 1;
+}
+
+
+/**
+ *  \brief Cache time to live setting.
+ *
+ *         This function sets the time to live of the new cache entries.
+ *         A null TTL disables the cache.
+ *
+ * @param ttl           time to live, in seconds
+ */
+void resolver_set_ttl(int ttl)
+{
+        pthread_mutex_lock(&resolver_lock);
+        resolver_ttl = ttl > 0 ? ttl : 0;
+        pthread_mutex_unlock(&resolver_lock);
+}
+
+
+/**
+ *  \brief Cache flush.
+ *
+ *         This function forgets all the cached lookups.
+ */
+void resolver_flush(void)
+{
+        int i;
+
+        pthread_mutex_lock(&resolver_lock);
+        for (i = 0 ; i < RESOLVER_CACHE_SIZE ; i++)
+        {
+                resolver_cache[i].kind = ENTRY_EMPTY;
+        }
+        pthread_mutex_unlock(&resolver_lock);
+}
+
+
+/**
+ *  \brief Host name resolution.
+ *
+ *         This function gets the addresses of a host, from the cache or
+ *         with getaddrinfo(). A numeric address or a local endpoint (see
+ *         RESOLVER_UNIX_PREFIX) is converted without any lookup. The
+ *         addresses are given in the order of getaddrinfo() (RFC 6724
+ *         preferences). This function blocks during the lookup:
+ *         an event loop should use resolver_lookup_async() instead.
+ *
+ * @param host          host name, numeric address or local endpoint
+ * @param port          port of the returned addresses
+ * @param family        AF_INET, AF_INET6, AF_UNIX or AF_UNSPEC for any
+ * @param addresses     returned addresses
+ * @param max           maximum number of returned addresses
+ * @return              the number of addresses or a negative error code
+ * @retval -ERR_BAD_PARAMETER           missing host or addresses
+ * @retval -ERR_UNKNOWN_ADDRESS         unknown host
+ */
+int resolver_lookup(const char * host, int port, int family,
+                    struct resolver_address * addresses, int max)
+{
+        struct resolver_address   found[RESOLVER_MAX_ADDRESSES];
+        struct resolver_entry   * entry;
+        struct addrinfo           hints, * result, * info;
+        int                       nb_found = 0;
+        int                       i, hit, cached = 0;
+
+        if ((host == NULL) || (addresses == NULL) || (max <= 0) ||
+            (strlen(host) >= RESOLVER_NAME_SIZE))
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        nb_found = resolver_local(host, family, addresses);
+        if (nb_found != 0)
+        {
+                return nb_found;
+        }
+        if (resolver_numeric(host, port, family, addresses))
+        {
+                return 1;
+        }
+
+        /* Recherche dans le cache */
+        pthread_mutex_lock(&resolver_lock);
+        entry = cache_forward(host, family, &hit);
+        if (hit && (entry->state != STATE_PENDING))
+        {
+                cached = 1;
+                nb_found = entry->state == STATE_READY ? entry->nb_addresses : 0;
+                memcpy(found, entry->addresses, nb_found * sizeof(found[0]));
+        }
+        pthread_mutex_unlock(&resolver_lock);
+
+        if (! cached)
+        {
+                /* Résolution hors verrou : elle peut durer. */
+                memset(&hints, 0, sizeof(hints));
+                hints.ai_family = family;
+                hints.ai_socktype = SOCK_STREAM;
+                hints.ai_flags = AI_ADDRCONFIG;
+                if (getaddrinfo(host, NULL, &hints, &result) == 0)
+                {
+                        for (info = result ;
+                             info && (nb_found < RESOLVER_MAX_ADDRESSES) ;
+                             info = info->ai_next)
+                        {
+                                if ((info->ai_family != AF_INET) &&
+                                    (info->ai_family != AF_INET6))
+                                {
+                                        continue;
+                                }
+                                memcpy(&found[nb_found].address, info->ai_addr,
+                                       info->ai_addrlen);
+                                found[nb_found].length = info->ai_addrlen;
+                                nb_found++;
+                        }
+                        freeaddrinfo(result);
+                }
+
+                pthread_mutex_lock(&resolver_lock);
+                if (resolver_ttl > 0)
+                {
+                        entry = cache_forward(host, family, &hit);
+                        entry->kind = ENTRY_FORWARD;
+                        entry->state = nb_found ? STATE_READY : STATE_FAILED;
+                        entry->family = family;
+                        entry->expires = cache_expires(entry->state);
+                        strcpy(entry->name, host);
+                        entry->nb_addresses = nb_found;
+                        memcpy(entry->addresses, found, nb_found * sizeof(found[0]));
+                }
+                pthread_mutex_unlock(&resolver_lock);
+        }
+
+        if (nb_found == 0)
+        {
+                return -ERR_UNKNOWN_ADDRESS;
+        }
+        if (nb_found > max)
+        {
+                nb_found = max;
+        }
+        for (i = 0 ; i < nb_found ; i++)
+        {
+                addresses[i] = found[i];
+                resolver_set_port(&addresses[i], port);
+        }
+        return nb_found;
+}
+
+
+/**
+ *  \brief Address to name resolution.
+ *
+ *         This function gets the name of a host from its address, from
+ *         the cache or with getnameinfo(). It blocks during the lookup.
+ *
+ * @param address       address of the host (the port is ignored)
+ * @param length        length of the address
+ * @param name          returned host name
+ * @param len           maximum length of the name
+ * @return              the status of the lookup
+ * @retval SUCCESS              name found
+ * @retval -ERR_NOT_FOUND       no name for this address
+ * @retval -ERR_BAD_PARAMETER   unknown address family
+ */
+int resolver_reverse(const struct sockaddr * address, socklen_t length,
+                     char * name, int len)
+{
+        struct resolver_entry * entry;
+        char                    host[RESOLVER_NAME_SIZE];
+        int                     status = -ERR_NOT_FOUND;
+        int                     hit, cached = 0;
+
+        if ((address == NULL) || (length > sizeof(struct sockaddr_storage)) ||
+            (name == NULL) || (len <= 0))
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+
+        pthread_mutex_lock(&resolver_lock);
+        entry = cache_reverse(address, &hit);
+        if (hit && (entry->state != STATE_PENDING))
+        {
+                cached = 1;
+                status = entry->state == STATE_READY ? SUCCESS : -ERR_NOT_FOUND;
+                if (status == SUCCESS)
+                {
+                        snprintf(name, len, "%s", entry->name);
+                }
+        }
+        pthread_mutex_unlock(&resolver_lock);
+        if (entry == NULL)
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        if (cached)
+        {
+                return status;
+        }
+
+        /* Résolution hors verrou */
+        if (getnameinfo(address, length, host, sizeof(host),
+                        NULL, 0, NI_NAMEREQD) == 0)
+        {
+                status = SUCCESS;
+                snprintf(name, len, "%s", host);
+        }
+
+        pthread_mutex_lock(&resolver_lock);
+        if (resolver_ttl > 0)
+        {
+                entry = cache_reverse(address, &hit);
+                entry->kind = ENTRY_REVERSE;
+                entry->state = status == SUCCESS ? STATE_READY : STATE_FAILED;
+                entry->expires = cache_expires(entry->state);
+                memcpy(&entry->key.address, address, length);
+                entry->key.length = length;
+                if (status == SUCCESS)
+                {
+                        strcpy(entry->name, host);
+                }
+        }
+        pthread_mutex_unlock(&resolver_lock);
+
+        return status;
+}
+
+
+/**
+ *  \brief Resolver thread: runs the queued lookups.
+ *
+ * @param arg           unused
+ * @return              never returns
+ */
+static void * resolver_thread(void * arg)
+{
+        struct resolver_address   addresses[RESOLVER_MAX_ADDRESSES];
+        struct resolver_job     * job;
+        char                      name[RESOLVER_NAME_SIZE];
+        int                       status;
+
+        (void) arg;
+        for (;;)
+        {
+                pthread_mutex_lock(&resolver_lock);
+                while (queue_head == NULL)
+                {
+                        pthread_cond_wait(&resolver_jobs, &resolver_lock);
+                }
+                job = queue_head;
+                queue_head = job->next;
+                if (queue_head == NULL)
+                {
+                        queue_tail = NULL;
+                }
+                queue_length--;
+                pthread_mutex_unlock(&resolver_lock);
+
+                if (job->kind == ENTRY_FORWARD)
+                {
+                        status = resolver_lookup(job->name, job->port, job->family,
+                                                 addresses, RESOLVER_MAX_ADDRESSES);
+                        job->callback(status, addresses, job->data);
+                }
+                else
+                {
+                        /* Le résultat ne sert qu'à remplir le cache. */
+                        resolver_reverse((struct sockaddr *) &job->key.address,
+                                         job->key.length, name, sizeof(name));
+                }
+                free(job);
+        }
+        return NULL;
+}
+
+
+/**
+ *  \brief Lookup queuing.
+ *
+ *         This function gives a lookup to the resolver threads, starting
+ *         them if needed. The resolver lock must be held.
+ *
+ * @param job           lookup to queue
+ * @return              the status of the operation
+ * @retval SUCCESS              lookup queued
+ * @retval -ERR_FIFO_FULL       too many waiting lookups
+ * @retval -ERR_SERVICE         could not start a resolver thread
+ */
+static int resolver_queue(struct resolver_job * job)
+{
+        pthread_attr_t attributes;
+        pthread_t      thread;
+
+        if (queue_length >= RESOLVER_MAX_PENDING)
+        {
+                return -ERR_FIFO_FULL;
+        }
+        if (nb_threads < RESOLVER_THREADS)
+        {
+                pthread_attr_init(&attributes);
+                pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+                while (nb_threads < RESOLVER_THREADS &&
+                       pthread_create(&thread, &attributes, resolver_thread, NULL) == 0)
+                {
+                        nb_threads++;
+                }
+                pthread_attr_destroy(&attributes);
+                if (nb_threads == 0)
+                {
+                        return -ERR_SERVICE;
+                }
+        }
+
+        job->next = NULL;
+        if (queue_tail)
+        {
+                queue_tail->next = job;
+        }
+        else
+        {
+                queue_head = job;
+        }
+        queue_tail = job;
+        queue_length++;
+        pthread_cond_signal(&resolver_jobs);
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Asynchronous host name resolution.
+ *
+ *         This function resolves a host like resolver_lookup() without
+ *         blocking. The callback gets the number of addresses (or a
+ *         negative error code, see resolver_lookup()) and the addresses.
+ *         It is called before this function returns for a numeric or
+ *         cached host or a local endpoint, and by a resolver thread
+ *         otherwise: a callback used with an event loop should hand the
+ *         result to the loop thread (with an eventfd for instance).
+ *
+ * @param host          host name, numeric address or local endpoint
+ * @param port          port of the returned addresses
+ * @param family        AF_INET, AF_INET6, AF_UNIX or AF_UNSPEC for any
+ * @param callback      result handler
+ * @param data          handler data
+ * @return              the status of the operation
+ * @retval SUCCESS              lookup done or queued
+ * @retval -ERR_BAD_PARAMETER   missing host or callback
+ * @retval -ERR_NO_MEMORY       could not allocate the lookup
+ * @retval -ERR_FIFO_FULL       too many waiting lookups
+ * @retval -ERR_SERVICE         could not start a resolver thread
+ */
+int resolver_lookup_async(const char * host, int port, int family,
+                          resolver_callback callback, void * data)
+{
+        struct resolver_address   addresses[RESOLVER_MAX_ADDRESSES];
+        struct resolver_entry   * entry;
+        struct resolver_job     * job;
+        int                       nb_found = 0;
+        int                       i, hit, status;
+
+        if ((host == NULL) || (callback == NULL) ||
+            (strlen(host) >= RESOLVER_NAME_SIZE))
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        nb_found = resolver_local(host, family, addresses);
+        if (nb_found != 0)
+        {
+                callback(nb_found, addresses, data);
+                return SUCCESS;
+        }
+        if (resolver_numeric(host, port, family, addresses))
+        {
+                callback(1, addresses, data);
+                return SUCCESS;
+        }
+
+        pthread_mutex_lock(&resolver_lock);
+        entry = cache_forward(host, family, &hit);
+        if (hit && (entry->state != STATE_PENDING))
+        {
+                nb_found = entry->state == STATE_READY ? entry->nb_addresses : 0;
+                memcpy(addresses, entry->addresses, nb_found * sizeof(addresses[0]));
+                pthread_mutex_unlock(&resolver_lock);
+
+                for (i = 0 ; i < nb_found ; i++)
+                {
+                        resolver_set_port(&addresses[i], port);
+                }
+                callback(nb_found ? nb_found : -ERR_UNKNOWN_ADDRESS,
+                         addresses, data);
+                return SUCCESS;
+        }
+
+        job = malloc(sizeof(struct resolver_job));
+        if (job == NULL)
+        {
+                pthread_mutex_unlock(&resolver_lock);
+                return -ERR_NO_MEMORY;
+        }
+        job->kind = ENTRY_FORWARD;
+        strcpy(job->name, host);
+        job->port = port;
+        job->family = family;
+        job->callback = callback;
+        job->data = data;
+        status = resolver_queue(job);
+        pthread_mutex_unlock(&resolver_lock);
+        if (status != SUCCESS)
+        {
+                free(job);
+        }
+        return status;
+}
+
+
+/**
+ *  \brief Non-blocking address to name resolution.
+ *
+ *         This function gets the name of a host from the cache only. When
+ *         the address is not in the cache, its lookup is queued for the
+ *         resolver threads and the name will be found by a later call.
+ *
+ * @param address       address of the host (the port is ignored)
+ * @param length        length of the address
+ * @param name          returned host name
+ * @param len           maximum length of the name
+ * @return              the status of the lookup
+ * @retval SUCCESS              name found
+ * @retval -ERR_NOT_FOUND       no name known (yet) for this address
+ * @retval -ERR_BAD_PARAMETER   unknown address family
+ */
+int resolver_reverse_cached(const struct sockaddr * address, socklen_t length,
+                            char * name, int len)
+{
+        struct resolver_entry * entry;
+        struct resolver_job   * job;
+        int                     status = -ERR_NOT_FOUND;
+        int                     hit;
+
+        if ((address == NULL) || (length > sizeof(struct sockaddr_storage)) ||
+            (name == NULL) || (len <= 0))
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+
+        pthread_mutex_lock(&resolver_lock);
+        entry = cache_reverse(address, &hit);
+        if (entry == NULL)
+        {
+                status = -ERR_BAD_PARAMETER;
+        }
+        else if (hit)
+        {
+                if (entry->state == STATE_READY)
+                {
+                        status = SUCCESS;
+                        snprintf(name, len, "%s", entry->name);
+                }
+        }
+        else if ((resolver_ttl > 0) &&
+                 ((job = malloc(sizeof(struct resolver_job))) != NULL))
+        {
+                /* Entrée en attente : une seule résolution par adresse. */
+                job->kind = ENTRY_REVERSE;
+                memcpy(&job->key.address, address, length);
+                job->key.length = length;
+                if (resolver_queue(job) == SUCCESS)
+                {
+                        entry->kind = ENTRY_REVERSE;
+                        entry->state = STATE_PENDING;
+                        entry->expires = cache_expires(STATE_PENDING);
+                        entry->key = job->key;
+                }
+                else
+                {
+                        free(job);
+                }
+        }
+        pthread_mutex_unlock(&resolver_lock);
+
+        return status;
+}
+
+
+/**
+ *  \brief Address families interleaving.
+ *
+ *         This function reorders the addresses so that the families
+ *         alternate, starting with the family of the first address and
+ *         keeping the order of each family (RFC 8305): a connection
+ *         attempt to a broken family does not delay the other one.
+ *
+ * @param addresses     addresses to reorder
+ * @param nb_addresses  number of addresses
+ */
+void resolver_interleave(struct resolver_address * addresses, int nb_addresses)
+{
+        struct resolver_address sorted[RESOLVER_MAX_ADDRESSES];
+        int                     first[RESOLVER_MAX_ADDRESSES];
+        int                     other[RESOLVER_MAX_ADDRESSES];
+        int                     nb_first = 0, nb_other = 0;
+        int                     i, n = 0;
+
+        if (nb_addresses > RESOLVER_MAX_ADDRESSES)
+        {
+                nb_addresses = RESOLVER_MAX_ADDRESSES;
+        }
+        for (i = 0 ; i < nb_addresses ; i++)
+        {
+                if (addresses[i].address.ss_family == addresses[0].address.ss_family)
+                {
+                        first[nb_first++] = i;
+                }
+                else
+                {
+                        other[nb_other++] = i;
+                }
+        }
+        for (i = 0 ; (i < nb_first) || (i < nb_other) ; i++)
+        {
+                if (i < nb_first)
+                {
+                        sorted[n++] = addresses[first[i]];
+                }
+                if (i < nb_other)
+                {
+                        sorted[n++] = addresses[other[i]];
+                }
+        }
+        memcpy(addresses, sorted, n * sizeof(sorted[0]));
+}
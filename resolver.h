@@ -0,0 +1,90 @@
+/**
+ *  \file    resolver.h
+ *  \brief   Caching names resolver.
+ *
+ *           Project: project independant file.
+ *
+ *           This is the header file of resolver.c and contains all the
+ *           constants, structures and functions declarations needed to
+ *           resolve host names and addresses (IPv4 and IPv6) with a cache.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include <sys/socket.h>
+
+/**
+ *  \defgroup resolver Resolver constants and structures
+ *
+ *  \details
+ *  Forward (name to addresses) and reverse (address to name) lookups are
+ *  kept in a cache for RESOLVER_TTL seconds, failures for
+ *  RESOLVER_NEGATIVE_TTL seconds. All the functions are thread-safe.
+ *  Asynchronous lookups are made by resolver threads, started on the first
+ *  asynchronous request, so that an event loop never waits for the DNS.
+ *  @{
+ */
+
+/*! Default time to live of the cached lookups, in seconds. */
+#define RESOLVER_TTL            300
+
+/*! Time to live of the cached failed lookups, in seconds. */
+#define RESOLVER_NEGATIVE_TTL   30
+
+/*! Maximum number of addresses kept for a name. */
+#define RESOLVER_MAX_ADDRESSES  8
+
+/*! Number of entries of the cache. */
+#define RESOLVER_CACHE_SIZE     256
+
+/*! Number of resolver threads. */
+#define RESOLVER_THREADS        2
+
+/*! Maximum number of asynchronous lookups waiting for a thread. */
+#define RESOLVER_MAX_PENDING    1024
+
+/*! Prefix of the local endpoints (Unix domain sockets): "unix:/path", or
+ *  "unix:@name" in the abstract namespace of Linux. They are converted
+ *  without any lookup and their port is ignored.
+ */
+#define RESOLVER_UNIX_PREFIX    "unix:"
+
+/*! Resolved address. */
+struct resolver_address {
+        struct sockaddr_storage address;  /*!< Address (port included).  */
+        socklen_t               length;   /*!< Length of the address.    */
+};
+
+/*! Asynchronous lookup callback. The status is the number of addresses or
+ *  a negative error code.
+ */
+typedef void (*resolver_callback)(int status,
+                                  const struct resolver_address * addresses,
+                                  void * data);
+
+/** @} */
+
+
+/** @cond DUPLICATE_DOCUMENTATION */
+void resolver_set_ttl(int ttl);
+void resolver_flush(void);
+int resolver_lookup(const char * host, int port, int family,
+                    struct resolver_address * addresses, int max);
+int resolver_lookup_async(const char * host, int port, int family,
+                          resolver_callback callback, void * data);
+int resolver_reverse(const struct sockaddr * address, socklen_t length,
+                     char * name, int len);
+int resolver_reverse_cached(const struct sockaddr * address, socklen_t length,
+                            char * name, int len);
+void resolver_interleave(struct resolver_address * addresses, int nb_addresses);
+/** @endcond */
+
+
+#endif /* RESOLVER_H */
@@ -0,0 +1,206 @@
+/**
+ *  \file    schema.h
+ *  \brief   Schema payload views.
+ *
+ *           Project: project independant file.
+ *
+ *           This file contains the inline functions used by the headers
+ *           generated from the payload schemas (see tools/cyberschema.c):
+ *           reading and writing little-endian numbers at any address of a
+ *           received packet, without copying the payload.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ *  \defgroup schema Schema payload views
+ *
+ *  \details
+ *  A schema describes the data of a packet as a fixed list of fields
+ *  (numbers, arrays of numbers, strings), optionally followed by an array
+ *  of any length. The cyberschema tool turns a schema into a header
+ *  giving, for each message:
+ *  - the offsets and sizes of its fields, and its exact size;
+ *  - a C structure with the same layout (for the encoders and decoders);
+ *  - accessors reading each field directly from the received data (an
+ *    index out of a fixed array reads 0 and writes nothing, and the length
+ *    of a string is given apart: it has no '\0' when it fills its field);
+ *  - an encoder writing the message in a buffer of its exact size, and a
+ *    packer adding the packet header when the message has a TAG;
+ *  - in C++, a view class with constexpr offsets and sizes.
+ *
+ *  The headers of the schemas/ directory are generated by the build
+ *  ("make schemas"): schemas/cyberspace.schema describes the packets of
+ *  the library.
+ *
+ *  The fields are aligned on their size, unless the message is declared
+ *  packed (the layout of the existing packets), so that the loads are
+ *  aligned when the data is. All numbers are little-endian, the accessors
+ *  work at any address: the data of a packet follows a header of
+ *  PACKET_HEADER_SIZE bytes.
+ *  @{
+ */
+
+/** @} */
+
+
+/**
+ *  \brief Unsigned 8 bits number reading.
+ */
+static inline uint8_t schema_get_u8(const unsigned char * data)
+{
+        return data[0];
+}
+
+
+/**
+ *  \brief Unsigned 16 bits little-endian number reading.
+ */
+static inline uint16_t schema_get_u16(const unsigned char * data)
+{
+        uint16_t value;
+
+        memcpy(&value, data, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        value = __builtin_bswap16(value);
+#endif
+        return value;
+}
+
+
+/**
+ *  \brief Unsigned 32 bits little-endian number reading.
+ */
+static inline uint32_t schema_get_u32(const unsigned char * data)
+{
+        uint32_t value;
+
+        memcpy(&value, data, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        value = __builtin_bswap32(value);
+#endif
+        return value;
+}
+
+
+/**
+ *  \brief Unsigned 64 bits little-endian number reading.
+ */
+static inline uint64_t schema_get_u64(const unsigned char * data)
+{
+        uint64_t value;
+
+        memcpy(&value, data, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        value = __builtin_bswap64(value);
+#endif
+        return value;
+}
+
+
+/**
+ *  \brief Single precision floating point number reading.
+ */
+static inline float schema_get_f32(const unsigned char * data)
+{
+        uint32_t bits = schema_get_u32(data);
+        float    value;
+
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+}
+
+
+/**
+ *  \brief Double precision floating point number reading.
+ */
+static inline double schema_get_f64(const unsigned char * data)
+{
+        uint64_t bits = schema_get_u64(data);
+        double   value;
+
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+}
+
+
+/**
+ *  \brief Unsigned 8 bits number writing.
+ */
+static inline void schema_put_u8(unsigned char * data, uint8_t value)
+{
+        data[0] = value;
+}
+
+
+/**
+ *  \brief Unsigned 16 bits little-endian number writing.
+ */
+static inline void schema_put_u16(unsigned char * data, uint16_t value)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        value = __builtin_bswap16(value);
+#endif
+        memcpy(data, &value, sizeof(value));
+}
+
+
+/**
+ *  \brief Unsigned 32 bits little-endian number writing.
+ */
+static inline void schema_put_u32(unsigned char * data, uint32_t value)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        value = __builtin_bswap32(value);
+#endif
+        memcpy(data, &value, sizeof(value));
+}
+
+
+/**
+ *  \brief Unsigned 64 bits little-endian number writing.
+ */
+static inline void schema_put_u64(unsigned char * data, uint64_t value)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        value = __builtin_bswap64(value);
+#endif
+        memcpy(data, &value, sizeof(value));
+}
+
+
+/**
+ *  \brief Single precision floating point number writing.
+ */
+static inline void schema_put_f32(unsigned char * data, float value)
+{
+        uint32_t bits;
+
+        memcpy(&bits, &value, sizeof(bits));
+        schema_put_u32(data, bits);
+}
+
+
+/**
+ *  \brief Double precision floating point number writing.
+ */
+static inline void schema_put_f64(unsigned char * data, double value)
+{
+        uint64_t bits;
+
+        memcpy(&bits, &value, sizeof(bits));
+        schema_put_u64(data, bits);
+}
+
+
+#endif /* SCHEMA_H */
@@ -0,0 +1,1068 @@
+/*
+ *  Generated by cyberschema from cyberspace.schema: do not edit.
+ */
+
+#ifndef CYBERSPACE_SCHEMA_H
+#define CYBERSPACE_SCHEMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "errors.h"
+#include "packets.h"
+#include "schema.h"
+#include "tags.h"
+
+#ifndef SCHEMA_ASSERT
+#ifdef __cplusplus
+#define SCHEMA_ASSERT static_assert
+#else
+#define SCHEMA_ASSERT _Static_assert
+#endif
+#endif
+
+/**
+ *  \defgroup schema_dump_state dump_state message
+ *
+ *  \details
+ *  CMD_DUMP_STATE request: version known by the client (0 for a full state).
+ *  @{
+ */
+
+/*! TAG of the dump_state packets. */
+#define DUMP_STATE_TAG CMD_DUMP_STATE
+
+/*! Offset of the version field. */
+#define DUMP_STATE_VERSION_OFFSET 0
+
+/*! Size of the dump_state data. */
+#define DUMP_STATE_SIZE 4
+
+/*! Alignment of the dump_state data. */
+#define DUMP_STATE_ALIGN 4
+
+/*! Size of a dump_state packet, header included. */
+#define DUMP_STATE_PACKET_SIZE (PACKET_HEADER_SIZE + DUMP_STATE_SIZE)
+
+/*! dump_state data (host copy). */
+struct dump_state {
+        uint32_t version; /*!< version held by the client */
+} __attribute__((packed, aligned(4)));
+
+/** @} */
+
+/** @cond DUPLICATE_DOCUMENTATION */
+SCHEMA_ASSERT(sizeof(struct dump_state) == DUMP_STATE_SIZE, "dump_state size");
+SCHEMA_ASSERT(offsetof(struct dump_state, version) == DUMP_STATE_VERSION_OFFSET, "dump_state.version offset");
+
+static inline int dump_state_check(const unsigned char * data, int size)
+{
+        (void) data;
+        return (size < DUMP_STATE_SIZE) ? -ERR_BAD_PROTOCOL : SUCCESS;
+}
+
+static inline uint32_t dump_state_version(const unsigned char * data)
+{
+        return (uint32_t) schema_get_u32(data + DUMP_STATE_VERSION_OFFSET);
+}
+
+static inline void dump_state_set_version(unsigned char * data, uint32_t value)
+{
+        schema_put_u32(data + DUMP_STATE_VERSION_OFFSET, value);
+}
+
+static inline void dump_state_encode(const struct dump_state * value, unsigned char * data)
+{
+        memset(data, 0, DUMP_STATE_SIZE);
+        dump_state_set_version(data, value->version);
+}
+
+static inline void dump_state_decode(const unsigned char * data, struct dump_state * value)
+{
+        memset(value, 0, sizeof(struct dump_state));
+        value->version = dump_state_version(data);
+}
+
+static inline int dump_state_pack(const struct dump_state * value, unsigned char * packet)
+{
+        schema_put_u16(packet, DUMP_STATE_SIZE + PACKET_TAG_SIZE);
+        packet[PACKET_LEN_SIZE] = DUMP_STATE_TAG;
+        dump_state_encode(value, packet + PACKET_HEADER_SIZE);
+        return DUMP_STATE_PACKET_SIZE;
+}
+
+/** @endcond */
+
+
+/**
+ *  \defgroup schema_snapshot_header snapshot_header message
+ *
+ *  \details
+ *  CMD_DUMP_STATE answer header, followed by the snapshot_entry records.
+ *  @{
+ */
+
+/*! TAG of the snapshot_header packets. */
+#define SNAPSHOT_HEADER_TAG CMD_DUMP_STATE
+
+/*! Offset of the flags field. */
+#define SNAPSHOT_HEADER_FLAGS_OFFSET 0
+/*! Offset of the base field. */
+#define SNAPSHOT_HEADER_BASE_OFFSET 1
+/*! Offset of the version field. */
+#define SNAPSHOT_HEADER_VERSION_OFFSET 5
+/*! Offset of the records field. */
+#define SNAPSHOT_HEADER_RECORDS_OFFSET 9
+
+/*! Size of the snapshot_header data (without its last field). */
+#define SNAPSHOT_HEADER_SIZE 9
+
+/*! Alignment of the snapshot_header data. */
+#define SNAPSHOT_HEADER_ALIGN 1
+
+/*! Size of an element of the records field. */
+#define SNAPSHOT_HEADER_RECORDS_ELEMENT 1
+
+/*! Maximum number of elements of the records field. */
+#define SNAPSHOT_HEADER_MAX_COUNT (MAX_DATA_SIZE - SNAPSHOT_HEADER_SIZE)
+
+/*! snapshot_header data (host copy, without its last field). */
+struct snapshot_header {
+        uint8_t flags; /*!< SNAPSHOT_FULL for a full state */
+        uint32_t base; /*!< version on which the delta is based */
+        uint32_t version; /*!< version of the state after the delta */
+} __attribute__((packed, aligned(1)));
+
+/** @} */
+
+/** @cond DUPLICATE_DOCUMENTATION */
+SCHEMA_ASSERT(sizeof(struct snapshot_header) == SNAPSHOT_HEADER_SIZE, "snapshot_header size");
+SCHEMA_ASSERT(offsetof(struct snapshot_header, flags) == SNAPSHOT_HEADER_FLAGS_OFFSET, "snapshot_header.flags offset");
+SCHEMA_ASSERT(offsetof(struct snapshot_header, base) == SNAPSHOT_HEADER_BASE_OFFSET, "snapshot_header.base offset");
+SCHEMA_ASSERT(offsetof(struct snapshot_header, version) == SNAPSHOT_HEADER_VERSION_OFFSET, "snapshot_header.version offset");
+
+static inline int snapshot_header_check(const unsigned char * data, int size)
+{
+        (void) data;
+        return (size < SNAPSHOT_HEADER_SIZE) ? -ERR_BAD_PROTOCOL : size - SNAPSHOT_HEADER_SIZE;
+}
+
+static inline uint8_t snapshot_header_flags(const unsigned char * data)
+{
+        return (uint8_t) schema_get_u8(data + SNAPSHOT_HEADER_FLAGS_OFFSET);
+}
+
+static inline void snapshot_header_set_flags(unsigned char * data, uint8_t value)
+{
+        schema_put_u8(data + SNAPSHOT_HEADER_FLAGS_OFFSET, value);
+}
+
+static inline uint32_t snapshot_header_base(const unsigned char * data)
+{
+        return (uint32_t) schema_get_u32(data + SNAPSHOT_HEADER_BASE_OFFSET);
+}
+
+static inline void snapshot_header_set_base(unsigned char * data, uint32_t value)
+{
+        schema_put_u32(data + SNAPSHOT_HEADER_BASE_OFFSET, value);
+}
+
+static inline uint32_t snapshot_header_version(const unsigned char * data)
+{
+        return (uint32_t) schema_get_u32(data + SNAPSHOT_HEADER_VERSION_OFFSET);
+}
+
+static inline void snapshot_header_set_version(unsigned char * data, uint32_t value)
+{
+        schema_put_u32(data + SNAPSHOT_HEADER_VERSION_OFFSET, value);
+}
+
+static inline const uint8_t * snapshot_header_records(const unsigned char * data)
+{
+        return (const uint8_t *) (data + SNAPSHOT_HEADER_RECORDS_OFFSET);
+}
+
+static inline void snapshot_header_encode(const struct snapshot_header * value, unsigned char * data)
+{
+        memset(data, 0, SNAPSHOT_HEADER_SIZE);
+        snapshot_header_set_flags(data, value->flags);
+        snapshot_header_set_base(data, value->base);
+        snapshot_header_set_version(data, value->version);
+}
+
+static inline void snapshot_header_decode(const unsigned char * data, struct snapshot_header * value)
+{
+        memset(value, 0, sizeof(struct snapshot_header));
+        value->flags = snapshot_header_flags(data);
+        value->base = snapshot_header_base(data);
+        value->version = snapshot_header_version(data);
+}
+
+static inline int snapshot_header_packet_size(int count)
+{
+        return PACKET_HEADER_SIZE + SNAPSHOT_HEADER_SIZE + count;
+}
+
+static inline int snapshot_header_pack(const struct snapshot_header * value, const uint8_t * records, int count, unsigned char * packet)
+{
+        unsigned char * data = packet + PACKET_HEADER_SIZE;
+
+        if ((count < 0) || (count > SNAPSHOT_HEADER_MAX_COUNT))
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        schema_put_u16(packet, SNAPSHOT_HEADER_SIZE + count + PACKET_TAG_SIZE);
+        packet[PACKET_LEN_SIZE] = SNAPSHOT_HEADER_TAG;
+        snapshot_header_encode(value, data);
+        memcpy(data + SNAPSHOT_HEADER_SIZE, records, count);
+        return snapshot_header_packet_size(count);
+}
+
+/** @endcond */
+
+
+/**
+ *  \defgroup schema_snapshot_entry snapshot_entry message
+ *
+ *  \details
+ *  Record of a snapshot: header of a key value.
+ *  @{
+ */
+
+/*! Offset of the key field. */
+#define SNAPSHOT_ENTRY_KEY_OFFSET 0
+/*! Offset of the size field. */
+#define SNAPSHOT_ENTRY_SIZE_OFFSET 4
+/*! Offset of the value field. */
+#define SNAPSHOT_ENTRY_VALUE_OFFSET 6
+
+/*! Size of the snapshot_entry data (without its last field). */
+#define SNAPSHOT_ENTRY_SIZE 6
+
+/*! Alignment of the snapshot_entry data. */
+#define SNAPSHOT_ENTRY_ALIGN 1
+
+/*! Size of an element of the value field. */
+#define SNAPSHOT_ENTRY_VALUE_ELEMENT 1
+
+/*! Maximum number of elements of the value field. */
+#define SNAPSHOT_ENTRY_MAX_COUNT (MAX_DATA_SIZE - SNAPSHOT_ENTRY_SIZE)
+
+/*! snapshot_entry data (host copy, without its last field). */
+struct snapshot_entry {
+        uint32_t key; /*!< key of the value */
+        uint16_t size; /*!< size of the value (SNAPSHOT_DELETED: key removed) */
+} __attribute__((packed, aligned(1)));
+
+/** @} */
+
+/** @cond DUPLICATE_DOCUMENTATION */
+SCHEMA_ASSERT(sizeof(struct snapshot_entry) == SNAPSHOT_ENTRY_SIZE, "snapshot_entry size");
+SCHEMA_ASSERT(offsetof(struct snapshot_entry, key) == SNAPSHOT_ENTRY_KEY_OFFSET, "snapshot_entry.key offset");
+SCHEMA_ASSERT(offsetof(struct snapshot_entry, size) == SNAPSHOT_ENTRY_SIZE_OFFSET, "snapshot_entry.size offset");
+
+static inline int snapshot_entry_check(const unsigned char * data, int size)
+{
+        (void) data;
+        return (size < SNAPSHOT_ENTRY_SIZE) ? -ERR_BAD_PROTOCOL : size - SNAPSHOT_ENTRY_SIZE;
+}
+
+static inline uint32_t snapshot_entry_key(const unsigned char * data)
+{
+        return (uint32_t) schema_get_u32(data + SNAPSHOT_ENTRY_KEY_OFFSET);
+}
+
+static inline void snapshot_entry_set_key(unsigned char * data, uint32_t value)
+{
+        schema_put_u32(data + SNAPSHOT_ENTRY_KEY_OFFSET, value);
+}
+
+static inline uint16_t snapshot_entry_size(const unsigned char * data)
+{
+        return (uint16_t) schema_get_u16(data + SNAPSHOT_ENTRY_SIZE_OFFSET);
+}
+
+static inline void snapshot_entry_set_size(unsigned char * data, uint16_t value)
+{
+        schema_put_u16(data + SNAPSHOT_ENTRY_SIZE_OFFSET, value);
+}
+
+static inline const uint8_t * snapshot_entry_value(const unsigned char * data)
+{
+        return (const uint8_t *) (data + SNAPSHOT_ENTRY_VALUE_OFFSET);
+}
+
+static inline void snapshot_entry_encode(const struct snapshot_entry * value, unsigned char * data)
+{
+        memset(data, 0, SNAPSHOT_ENTRY_SIZE);
+        snapshot_entry_set_key(data, value->key);
+        snapshot_entry_set_size(data, value->size);
+}
+
+static inline void snapshot_entry_decode(const unsigned char * data, struct snapshot_entry * value)
+{
+        memset(value, 0, sizeof(struct snapshot_entry));
+        value->key = snapshot_entry_key(data);
+        value->size = snapshot_entry_size(data);
+}
+
+/** @endcond */
+
+
+/**
+ *  \defgroup schema_param_list param_list message
+ *
+ *  \details
+ *  CMD_GET_PARAM and CMD_SET_PARAM lists (CAPABILITY_BATCH).
+ *  @{
+ */
+
+/*! Offset of the count field. */
+#define PARAM_LIST_COUNT_OFFSET 0
+/*! Offset of the records field. */
+#define PARAM_LIST_RECORDS_OFFSET 2
+
+/*! Size of the param_list data (without its last field). */
+#define PARAM_LIST_SIZE 2
+
+/*! Alignment of the param_list data. */
+#define PARAM_LIST_ALIGN 1
+
+/*! Size of an element of the records field. */
+#define PARAM_LIST_RECORDS_ELEMENT 1
+
+/*! Maximum number of elements of the records field. */
+#define PARAM_LIST_MAX_COUNT (MAX_DATA_SIZE - PARAM_LIST_SIZE)
+
+/*! param_list data (host copy, without its last field). */
+struct param_list {
+        uint16_t count; /*!< number of records */
+} __attribute__((packed, aligned(1)));
+
+/** @} */
+
+/** @cond DUPLICATE_DOCUMENTATION */
+SCHEMA_ASSERT(sizeof(struct param_list) == PARAM_LIST_SIZE, "param_list size");
+SCHEMA_ASSERT(offsetof(struct param_list, count) == PARAM_LIST_COUNT_OFFSET, "param_list.count offset");
+
+static inline int param_list_check(const unsigned char * data, int size)
+{
+        (void) data;
+        return (size < PARAM_LIST_SIZE) ? -ERR_BAD_PROTOCOL : size - PARAM_LIST_SIZE;
+}
+
+static inline uint16_t param_list_count(const unsigned char * data)
+{
+        return (uint16_t) schema_get_u16(data + PARAM_LIST_COUNT_OFFSET);
+}
+
+static inline void param_list_set_count(unsigned char * data, uint16_t value)
+{
+        schema_put_u16(data + PARAM_LIST_COUNT_OFFSET, value);
+}
+
+static inline const uint8_t * param_list_records(const unsigned char * data)
+{
+        return (const uint8_t *) (data + PARAM_LIST_RECORDS_OFFSET);
+}
+
+static inline void param_list_encode(const struct param_list * value, unsigned char * data)
+{
+        memset(data, 0, PARAM_LIST_SIZE);
+        param_list_set_count(data, value->count);
+}
+
+static inline void param_list_decode(const unsigned char * data, struct param_list * value)
+{
+        memset(value, 0, sizeof(struct param_list));
+        value->count = param_list_count(data);
+}
+
+/** @endcond */
+
+
+/**
+ *  \defgroup schema_param_value param_value message
+ *
+ *  \details
+ *  Record of a CMD_SET_PARAM request.
+ *  @{
+ */
+
+/*! Offset of the key field. */
+#define PARAM_VALUE_KEY_OFFSET 0
+/*! Offset of the size field. */
+#define PARAM_VALUE_SIZE_OFFSET 2
+/*! Offset of the value field. */
+#define PARAM_VALUE_VALUE_OFFSET 4
+
+/*! Size of the param_value data (without its last field). */
+#define PARAM_VALUE_SIZE 4
+
+/*! Alignment of the param_value data. */
+#define PARAM_VALUE_ALIGN 1
+
+/*! Size of an element of the value field. */
+#define PARAM_VALUE_VALUE_ELEMENT 1
+
+/*! Maximum number of elements of the value field. */
+#define PARAM_VALUE_MAX_COUNT (MAX_DATA_SIZE - PARAM_VALUE_SIZE)
+
+/*! param_value data (host copy, without its last field). */
+struct param_value {
+        uint16_t key; /*!< parameter key */
+        uint16_t size; /*!< size of the value */
+} __attribute__((packed, aligned(1)));
+
+/** @} */
+
+/** @cond DUPLICATE_DOCUMENTATION */
+SCHEMA_ASSERT(sizeof(struct param_value) == PARAM_VALUE_SIZE, "param_value size");
+SCHEMA_ASSERT(offsetof(struct param_value, key) == PARAM_VALUE_KEY_OFFSET, "param_value.key offset");
+SCHEMA_ASSERT(offsetof(struct param_value, size) == PARAM_VALUE_SIZE_OFFSET, "param_value.size offset");
+
+static inline int param_value_check(const unsigned char * data, int size)
+{
+        (void) data;
+        return (size < PARAM_VALUE_SIZE) ? -ERR_BAD_PROTOCOL : size - PARAM_VALUE_SIZE;
+}
+
+static inline uint16_t param_value_key(const unsigned char * data)
+{
+        return (uint16_t) schema_get_u16(data + PARAM_VALUE_KEY_OFFSET);
+}
+
+static inline void param_value_set_key(unsigned char * data, uint16_t value)
+{
+        schema_put_u16(data + PARAM_VALUE_KEY_OFFSET, value);
+}
+
+static inline uint16_t param_value_size(const unsigned char * data)
+{
+        return (uint16_t) schema_get_u16(data + PARAM_VALUE_SIZE_OFFSET);
+}
+
+static inline void param_value_set_size(unsigned char * data, uint16_t value)
+{
+        schema_put_u16(data + PARAM_VALUE_SIZE_OFFSET, value);
+}
+
+static inline const uint8_t * param_value_value(const unsigned char * data)
+{
+        return (const uint8_t *) (data + PARAM_VALUE_VALUE_OFFSET);
+}
+
+static inline void param_value_encode(const struct param_value * value, unsigned char * data)
+{
+        memset(data, 0, PARAM_VALUE_SIZE);
+        param_value_set_key(data, value->key);
+        param_value_set_size(data, value->size);
+}
+
+static inline void param_value_decode(const unsigned char * data, struct param_value * value)
+{
+        memset(value, 0, sizeof(struct param_value));
+        value->key = param_value_key(data);
+        value->size = param_value_size(data);
+}
+
+/** @endcond */
+
+
+/**
+ *  \defgroup schema_param_result param_result message
+ *
+ *  \details
+ *  Record of a CMD_GET_PARAM answer.
+ *  @{
+ */
+
+/*! Offset of the key field. */
+#define PARAM_RESULT_KEY_OFFSET 0
+/*! Offset of the status field. */
+#define PARAM_RESULT_STATUS_OFFSET 2
+/*! Offset of the size field. */
+#define PARAM_RESULT_SIZE_OFFSET 3
+/*! Offset of the value field. */
+#define PARAM_RESULT_VALUE_OFFSET 5
+
+/*! Size of the param_result data (without its last field). */
+#define PARAM_RESULT_SIZE 5
+
+/*! Alignment of the param_result data. */
+#define PARAM_RESULT_ALIGN 1
+
+/*! Size of an element of the value field. */
+#define PARAM_RESULT_VALUE_ELEMENT 1
+
+/*! Maximum number of elements of the value field. */
+#define PARAM_RESULT_MAX_COUNT (MAX_DATA_SIZE - PARAM_RESULT_SIZE)
+
+/*! param_result data (host copy, without its last field). */
+struct param_result {
+        uint16_t key; /*!< parameter key */
+        uint8_t status; /*!< 0 or the absolute value of the error code */
+        uint16_t size; /*!< size of the value */
+} __attribute__((packed, aligned(1)));
+
+/** @} */
+
+/** @cond DUPLICATE_DOCUMENTATION */
+SCHEMA_ASSERT(sizeof(struct param_result) == PARAM_RESULT_SIZE, "param_result size");
+SCHEMA_ASSERT(offsetof(struct param_result, key) == PARAM_RESULT_KEY_OFFSET, "param_result.key offset");
+SCHEMA_ASSERT(offsetof(struct param_result, status) == PARAM_RESULT_STATUS_OFFSET, "param_result.status offset");
+SCHEMA_ASSERT(offsetof(struct param_result, size) == PARAM_RESULT_SIZE_OFFSET, "param_result.size offset");
+
+static inline int param_result_check(const unsigned char * data, int size)
+{
+        (void) data;
+        return (size < PARAM_RESULT_SIZE) ? -ERR_BAD_PROTOCOL : size - PARAM_RESULT_SIZE;
+}
+
+static inline uint16_t param_result_key(const unsigned char * data)
+{
+        return (uint16_t) schema_get_u16(data + PARAM_RESULT_KEY_OFFSET);
+}
+
+static inline void param_result_set_key(unsigned char * data, uint16_t value)
+{
+        schema_put_u16(data + PARAM_RESULT_KEY_OFFSET, value);
+}
+
+static inline uint8_t param_result_status(const unsigned char * data)
+{
+        return (uint8_t) schema_get_u8(data + PARAM_RESULT_STATUS_OFFSET);
+}
+
+static inline void param_result_set_status(unsigned char * data, uint8_t value)
+{
+        schema_put_u8(data + PARAM_RESULT_STATUS_OFFSET, value);
+}
+
+static inline uint16_t param_result_size(const unsigned char * data)
+{
+        return (uint16_t) schema_get_u16(data + PARAM_RESULT_SIZE_OFFSET);
+}
+
+static inline void param_result_set_size(unsigned char * data, uint16_t value)
+{
+        schema_put_u16(data + PARAM_RESULT_SIZE_OFFSET, value);
+}
+
+static inline const uint8_t * param_result_value(const unsigned char * data)
+{
+        return (const uint8_t *) (data + PARAM_RESULT_VALUE_OFFSET);
+}
+
+static inline void param_result_encode(const struct param_result * value, unsigned char * data)
+{
+        memset(data, 0, PARAM_RESULT_SIZE);
+        param_result_set_key(data, value->key);
+        param_result_set_status(data, value->status);
+        param_result_set_size(data, value->size);
+}
+
+static inline void param_result_decode(const unsigned char * data, struct param_result * value)
+{
+        memset(value, 0, sizeof(struct param_result));
+        value->key = param_result_key(data);
+        value->status = param_result_status(data);
+        value->size = param_result_size(data);
+}
+
+/** @endcond */
+
+
+/**
+ *  \defgroup schema_add_object add_object message
+ *
+ *  \details
+ *  CMD_ADD_OBJECT request: object of the cyberspace, with its properties.
+ *  @{
+ */
+
+/*! TAG of the add_object packets. */
+#define ADD_OBJECT_TAG CMD_ADD_OBJECT
+
+/*! Offset of the id field. */
+#define ADD_OBJECT_ID_OFFSET 0
+/*! Offset of the parent field. */
+#define ADD_OBJECT_PARENT_OFFSET 4
+/*! Offset of the kind field. */
+#define ADD_OBJECT_KIND_OFFSET 8
+/*! Offset of the flags field. */
+#define ADD_OBJECT_FLAGS_OFFSET 10
+/*! Offset of the scale field. */
+#define ADD_OBJECT_SCALE_OFFSET 12
+/*! Offset of the position field. */
+#define ADD_OBJECT_POSITION_OFFSET 16
+/*! Number of elements of the position field. */
+#define ADD_OBJECT_POSITION_COUNT 3
+/*! Offset of the orientation field. */
+#define ADD_OBJECT_ORIENTATION_OFFSET 40
+/*! Number of elements of the orientation field. */
+#define ADD_OBJECT_ORIENTATION_COUNT 4
+/*! Offset of the name field. */
+#define ADD_OBJECT_NAME_OFFSET 72
+/*! Number of elements of the name field. */
+#define ADD_OBJECT_NAME_COUNT 32
+/*! Offset of the properties field. */
+#define ADD_OBJECT_PROPERTIES_OFFSET 104
+
+/*! Size of the add_object data (without its last field). */
+#define ADD_OBJECT_SIZE 104
+
+/*! Alignment of the add_object data. */
+#define ADD_OBJECT_ALIGN 8
+
+/*! Size of an element of the properties field. */
+#define ADD_OBJECT_PROPERTIES_ELEMENT 1
+
+/*! Maximum number of elements of the properties field. */
+#define ADD_OBJECT_MAX_COUNT (MAX_DATA_SIZE - ADD_OBJECT_SIZE)
+
+/*! add_object data (host copy, without its last field). */
+struct add_object {
+        uint32_t id; /*!< object identifier */
+        uint32_t parent; /*!< parent identifier (0 for the root) */
+        uint16_t kind; /*!< kind of object */
+        uint16_t flags; /*!< object flags */
+        float scale; /*!< scale factor */
+        double position[3]; /*!< position (x, y, z) */
+        double orientation[4]; /*!< orientation quaternion (w, x, y, z) */
+        char name[32]; /*!< name, padded with '\0' (none if 32 long) */
+} __attribute__((packed, aligned(8)));
+
+/** @} */
+
+/** @cond DUPLICATE_DOCUMENTATION */
+SCHEMA_ASSERT(sizeof(struct add_object) == ADD_OBJECT_SIZE, "add_object size");
+SCHEMA_ASSERT(offsetof(struct add_object, id) == ADD_OBJECT_ID_OFFSET, "add_object.id offset");
+SCHEMA_ASSERT(offsetof(struct add_object, parent) == ADD_OBJECT_PARENT_OFFSET, "add_object.parent offset");
+SCHEMA_ASSERT(offsetof(struct add_object, kind) == ADD_OBJECT_KIND_OFFSET, "add_object.kind offset");
+SCHEMA_ASSERT(offsetof(struct add_object, flags) == ADD_OBJECT_FLAGS_OFFSET, "add_object.flags offset");
+SCHEMA_ASSERT(offsetof(struct add_object, scale) == ADD_OBJECT_SCALE_OFFSET, "add_object.scale offset");
+SCHEMA_ASSERT(offsetof(struct add_object, position) == ADD_OBJECT_POSITION_OFFSET, "add_object.position offset");
+SCHEMA_ASSERT(offsetof(struct add_object, orientation) == ADD_OBJECT_ORIENTATION_OFFSET, "add_object.orientation offset");
+SCHEMA_ASSERT(offsetof(struct add_object, name) == ADD_OBJECT_NAME_OFFSET, "add_object.name offset");
+
+static inline int add_object_check(const unsigned char * data, int size)
+{
+        (void) data;
+        return (size < ADD_OBJECT_SIZE) ? -ERR_BAD_PROTOCOL : size - ADD_OBJECT_SIZE;
+}
+
+static inline uint32_t add_object_id(const unsigned char * data)
+{
+        return (uint32_t) schema_get_u32(data + ADD_OBJECT_ID_OFFSET);
+}
+
+static inline void add_object_set_id(unsigned char * data, uint32_t value)
+{
+        schema_put_u32(data + ADD_OBJECT_ID_OFFSET, value);
+}
+
+static inline uint32_t add_object_parent(const unsigned char * data)
+{
+        return (uint32_t) schema_get_u32(data + ADD_OBJECT_PARENT_OFFSET);
+}
+
+static inline void add_object_set_parent(unsigned char * data, uint32_t value)
+{
+        schema_put_u32(data + ADD_OBJECT_PARENT_OFFSET, value);
+}
+
+static inline uint16_t add_object_kind(const unsigned char * data)
+{
+        return (uint16_t) schema_get_u16(data + ADD_OBJECT_KIND_OFFSET);
+}
+
+static inline void add_object_set_kind(unsigned char * data, uint16_t value)
+{
+        schema_put_u16(data + ADD_OBJECT_KIND_OFFSET, value);
+}
+
+static inline uint16_t add_object_flags(const unsigned char * data)
+{
+        return (uint16_t) schema_get_u16(data + ADD_OBJECT_FLAGS_OFFSET);
+}
+
+static inline void add_object_set_flags(unsigned char * data, uint16_t value)
+{
+        schema_put_u16(data + ADD_OBJECT_FLAGS_OFFSET, value);
+}
+
+static inline float add_object_scale(const unsigned char * data)
+{
+        return (float) schema_get_f32(data + ADD_OBJECT_SCALE_OFFSET);
+}
+
+static inline void add_object_set_scale(unsigned char * data, float value)
+{
+        schema_put_f32(data + ADD_OBJECT_SCALE_OFFSET, value);
+}
+
+static inline double add_object_position(const unsigned char * data, int i)
+{
+        if ((i < 0) || (i >= 3))
+        {
+                return 0;
+        }
+        return (double) schema_get_f64(data + ADD_OBJECT_POSITION_OFFSET + i * 8);
+}
+
+static inline void add_object_set_position(unsigned char * data, int i, double value)
+{
+        if ((i < 0) || (i >= 3))
+        {
+                return;
+        }
+        schema_put_f64(data + ADD_OBJECT_POSITION_OFFSET + i * 8, value);
+}
+
+static inline double add_object_orientation(const unsigned char * data, int i)
+{
+        if ((i < 0) || (i >= 4))
+        {
+                return 0;
+        }
+        return (double) schema_get_f64(data + ADD_OBJECT_ORIENTATION_OFFSET + i * 8);
+}
+
+static inline void add_object_set_orientation(unsigned char * data, int i, double value)
+{
+        if ((i < 0) || (i >= 4))
+        {
+                return;
+        }
+        schema_put_f64(data + ADD_OBJECT_ORIENTATION_OFFSET + i * 8, value);
+}
+
+static inline const char * add_object_name(const unsigned char * data)
+{
+        return (const char *) (data + ADD_OBJECT_NAME_OFFSET);
+}
+
+static inline size_t add_object_name_length(const unsigned char * data)
+{
+        const char * name = (const char *) (data + ADD_OBJECT_NAME_OFFSET);
+        const char * end = (const char *) memchr(name, '\0', 32);
+
+        return end ? (size_t) (end - name) : 32;
+}
+
+static inline void add_object_set_name(unsigned char * data, const char * value)
+{
+        strncpy((char *) (data + ADD_OBJECT_NAME_OFFSET), value, 32);
+}
+
+static inline const uint8_t * add_object_properties(const unsigned char * data)
+{
+        return (const uint8_t *) (data + ADD_OBJECT_PROPERTIES_OFFSET);
+}
+
+static inline void add_object_encode(const struct add_object * value, unsigned char * data)
+{
+        memset(data, 0, ADD_OBJECT_SIZE);
+        add_object_set_id(data, value->id);
+        add_object_set_parent(data, value->parent);
+        add_object_set_kind(data, value->kind);
+        add_object_set_flags(data, value->flags);
+        add_object_set_scale(data, value->scale);
+        {
+                int i;
+
+                for (i = 0 ; i < 3 ; i++)
+                {
+                        add_object_set_position(data, i, value->position[i]);
+                }
+        }
+        {
+                int i;
+
+                for (i = 0 ; i < 4 ; i++)
+                {
+                        add_object_set_orientation(data, i, value->orientation[i]);
+                }
+        }
+        memcpy(data + ADD_OBJECT_NAME_OFFSET, value->name, 32);
+}
+
+static inline void add_object_decode(const unsigned char * data, struct add_object * value)
+{
+        memset(value, 0, sizeof(struct add_object));
+        value->id = add_object_id(data);
+        value->parent = add_object_parent(data);
+        value->kind = add_object_kind(data);
+        value->flags = add_object_flags(data);
+        value->scale = add_object_scale(data);
+        {
+                int i;
+
+                for (i = 0 ; i < 3 ; i++)
+                {
+                        value->position[i] = add_object_position(data, i);
+                }
+        }
+        {
+                int i;
+
+                for (i = 0 ; i < 4 ; i++)
+                {
+                        value->orientation[i] = add_object_orientation(data, i);
+                }
+        }
+        memcpy(value->name, data + ADD_OBJECT_NAME_OFFSET, 32);
+}
+
+static inline int add_object_packet_size(int count)
+{
+        return PACKET_HEADER_SIZE + ADD_OBJECT_SIZE + count;
+}
+
+static inline int add_object_pack(const struct add_object * value, const uint8_t * properties, int count, unsigned char * packet)
+{
+        unsigned char * data = packet + PACKET_HEADER_SIZE;
+
+        if ((count < 0) || (count > ADD_OBJECT_MAX_COUNT))
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        schema_put_u16(packet, ADD_OBJECT_SIZE + count + PACKET_TAG_SIZE);
+        packet[PACKET_LEN_SIZE] = ADD_OBJECT_TAG;
+        add_object_encode(value, data);
+        memcpy(data + ADD_OBJECT_SIZE, properties, count);
+        return add_object_packet_size(count);
+}
+
+/** @endcond */
+
+
+/**
+ *  \defgroup schema_del_object del_object message
+ *
+ *  \details
+ *  CMD_DEL_OBJECT request.
+ *  @{
+ */
+
+/*! TAG of the del_object packets. */
+#define DEL_OBJECT_TAG CMD_DEL_OBJECT
+
+/*! Offset of the id field. */
+#define DEL_OBJECT_ID_OFFSET 0
+
+/*! Size of the del_object data. */
+#define DEL_OBJECT_SIZE 4
+
+/*! Alignment of the del_object data. */
+#define DEL_OBJECT_ALIGN 4
+
+/*! Size of a del_object packet, header included. */
+#define DEL_OBJECT_PACKET_SIZE (PACKET_HEADER_SIZE + DEL_OBJECT_SIZE)
+
+/*! del_object data (host copy). */
+struct del_object {
+        uint32_t id; /*!< object identifier */
+} __attribute__((packed, aligned(4)));
+
+/** @} */
+
+/** @cond DUPLICATE_DOCUMENTATION */
+SCHEMA_ASSERT(sizeof(struct del_object) == DEL_OBJECT_SIZE, "del_object size");
+SCHEMA_ASSERT(offsetof(struct del_object, id) == DEL_OBJECT_ID_OFFSET, "del_object.id offset");
+
+static inline int del_object_check(const unsigned char * data, int size)
+{
+        (void) data;
+        return (size < DEL_OBJECT_SIZE) ? -ERR_BAD_PROTOCOL : SUCCESS;
+}
+
+static inline uint32_t del_object_id(const unsigned char * data)
+{
+        return (uint32_t) schema_get_u32(data + DEL_OBJECT_ID_OFFSET);
+}
+
+static inline void del_object_set_id(unsigned char * data, uint32_t value)
+{
+        schema_put_u32(data + DEL_OBJECT_ID_OFFSET, value);
+}
+
+static inline void del_object_encode(const struct del_object * value, unsigned char * data)
+{
+        memset(data, 0, DEL_OBJECT_SIZE);
+        del_object_set_id(data, value->id);
+}
+
+static inline void del_object_decode(const unsigned char * data, struct del_object * value)
+{
+        memset(value, 0, sizeof(struct del_object));
+        value->id = del_object_id(data);
+}
+
+static inline int del_object_pack(const struct del_object * value, unsigned char * packet)
+{
+        schema_put_u16(packet, DEL_OBJECT_SIZE + PACKET_TAG_SIZE);
+        packet[PACKET_LEN_SIZE] = DEL_OBJECT_TAG;
+        del_object_encode(value, packet + PACKET_HEADER_SIZE);
+        return DEL_OBJECT_PACKET_SIZE;
+}
+
+/** @endcond */
+
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+
+/** @cond DUPLICATE_DOCUMENTATION */
+namespace cyberschema {
+
+struct dump_state_view {
+        static constexpr std::size_t byte_size = DUMP_STATE_SIZE;
+        static constexpr std::size_t alignment = DUMP_STATE_ALIGN;
+        static constexpr int tag_value = DUMP_STATE_TAG;
+        static constexpr std::size_t version_offset = DUMP_STATE_VERSION_OFFSET;
+
+        const unsigned char * data;
+
+        constexpr explicit dump_state_view(const unsigned char * data) : data(data) {}
+        int validate(int size) const { return dump_state_check(data, size); }
+        uint32_t version() const { return dump_state_version(data); }
+};
+
+struct snapshot_header_view {
+        static constexpr std::size_t byte_size = SNAPSHOT_HEADER_SIZE;
+        static constexpr std::size_t alignment = SNAPSHOT_HEADER_ALIGN;
+        static constexpr int tag_value = SNAPSHOT_HEADER_TAG;
+        static constexpr std::size_t flags_offset = SNAPSHOT_HEADER_FLAGS_OFFSET;
+        static constexpr std::size_t base_offset = SNAPSHOT_HEADER_BASE_OFFSET;
+        static constexpr std::size_t version_offset = SNAPSHOT_HEADER_VERSION_OFFSET;
+        static constexpr std::size_t records_offset = SNAPSHOT_HEADER_RECORDS_OFFSET;
+
+        const unsigned char * data;
+
+        constexpr explicit snapshot_header_view(const unsigned char * data) : data(data) {}
+        int validate(int size) const { return snapshot_header_check(data, size); }
+        uint8_t flags() const { return snapshot_header_flags(data); }
+        uint32_t base() const { return snapshot_header_base(data); }
+        uint32_t version() const { return snapshot_header_version(data); }
+        const uint8_t * records() const { return snapshot_header_records(data); }
+};
+
+struct snapshot_entry_view {
+        static constexpr std::size_t byte_size = SNAPSHOT_ENTRY_SIZE;
+        static constexpr std::size_t alignment = SNAPSHOT_ENTRY_ALIGN;
+        static constexpr std::size_t key_offset = SNAPSHOT_ENTRY_KEY_OFFSET;
+        static constexpr std::size_t size_offset = SNAPSHOT_ENTRY_SIZE_OFFSET;
+        static constexpr std::size_t value_offset = SNAPSHOT_ENTRY_VALUE_OFFSET;
+
+        const unsigned char * data;
+
+        constexpr explicit snapshot_entry_view(const unsigned char * data) : data(data) {}
+        int validate(int size) const { return snapshot_entry_check(data, size); }
+        uint32_t key() const { return snapshot_entry_key(data); }
+        uint16_t size() const { return snapshot_entry_size(data); }
+        const uint8_t * value() const { return snapshot_entry_value(data); }
+};
+
+struct param_list_view {
+        static constexpr std::size_t byte_size = PARAM_LIST_SIZE;
+        static constexpr std::size_t alignment = PARAM_LIST_ALIGN;
+        static constexpr std::size_t count_offset = PARAM_LIST_COUNT_OFFSET;
+        static constexpr std::size_t records_offset = PARAM_LIST_RECORDS_OFFSET;
+
+        const unsigned char * data;
+
+        constexpr explicit param_list_view(const unsigned char * data) : data(data) {}
+        int validate(int size) const { return param_list_check(data, size); }
+        uint16_t count() const { return param_list_count(data); }
+        const uint8_t * records() const { return param_list_records(data); }
+};
+
+struct param_value_view {
+        static constexpr std::size_t byte_size = PARAM_VALUE_SIZE;
+        static constexpr std::size_t alignment = PARAM_VALUE_ALIGN;
+        static constexpr std::size_t key_offset = PARAM_VALUE_KEY_OFFSET;
+        static constexpr std::size_t size_offset = PARAM_VALUE_SIZE_OFFSET;
+        static constexpr std::size_t value_offset = PARAM_VALUE_VALUE_OFFSET;
+
+        const unsigned char * data;
+
+        constexpr explicit param_value_view(const unsigned char * data) : data(data) {}
+        int validate(int size) const { return param_value_check(data, size); }
+        uint16_t key() const { return param_value_key(data); }
+        uint16_t size() const { return param_value_size(data); }
+        const uint8_t * value() const { return param_value_value(data); }
+};
+
+struct param_result_view {
+        static constexpr std::size_t byte_size = PARAM_RESULT_SIZE;
+        static constexpr std::size_t alignment = PARAM_RESULT_ALIGN;
+        static constexpr std::size_t key_offset = PARAM_RESULT_KEY_OFFSET;
+        static constexpr std::size_t status_offset = PARAM_RESULT_STATUS_OFFSET;
+        static constexpr std::size_t size_offset = PARAM_RESULT_SIZE_OFFSET;
+        static constexpr std::size_t value_offset = PARAM_RESULT_VALUE_OFFSET;
+
+        const unsigned char * data;
+
+        constexpr explicit param_result_view(const unsigned char * data) : data(data) {}
+        int validate(int size) const { return param_result_check(data, size); }
+        uint16_t key() const { return param_result_key(data); }
+        uint8_t status() const { return param_result_status(data); }
+        uint16_t size() const { return param_result_size(data); }
+        const uint8_t * value() const { return param_result_value(data); }
+};
+
+struct add_object_view {
+        static constexpr std::size_t byte_size = ADD_OBJECT_SIZE;
+        static constexpr std::size_t alignment = ADD_OBJECT_ALIGN;
+        static constexpr int tag_value = ADD_OBJECT_TAG;
+        static constexpr std::size_t id_offset = ADD_OBJECT_ID_OFFSET;
+        static constexpr std::size_t parent_offset = ADD_OBJECT_PARENT_OFFSET;
+        static constexpr std::size_t kind_offset = ADD_OBJECT_KIND_OFFSET;
+        static constexpr std::size_t flags_offset = ADD_OBJECT_FLAGS_OFFSET;
+        static constexpr std::size_t scale_offset = ADD_OBJECT_SCALE_OFFSET;
+        static constexpr std::size_t position_offset = ADD_OBJECT_POSITION_OFFSET;
+        static constexpr std::size_t position_count = 3;
+        static constexpr std::size_t orientation_offset = ADD_OBJECT_ORIENTATION_OFFSET;
+        static constexpr std::size_t orientation_count = 4;
+        static constexpr std::size_t name_offset = ADD_OBJECT_NAME_OFFSET;
+        static constexpr std::size_t name_count = 32;
+        static constexpr std::size_t properties_offset = ADD_OBJECT_PROPERTIES_OFFSET;
+
+        const unsigned char * data;
+
+        constexpr explicit add_object_view(const unsigned char * data) : data(data) {}
+        int validate(int size) const { return add_object_check(data, size); }
+        uint32_t id() const { return add_object_id(data); }
+        uint32_t parent() const { return add_object_parent(data); }
+        uint16_t kind() const { return add_object_kind(data); }
+        uint16_t flags() const { return add_object_flags(data); }
+        float scale() const { return add_object_scale(data); }
+        double position(int i) const { return add_object_position(data, i); }
+        double orientation(int i) const { return add_object_orientation(data, i); }
+        const char * name() const { return add_object_name(data); }
+        std::size_t name_length() const { return add_object_name_length(data); }
+        const uint8_t * properties() const { return add_object_properties(data); }
+};
+
+struct del_object_view {
+        static constexpr std::size_t byte_size = DEL_OBJECT_SIZE;
+        static constexpr std::size_t alignment = DEL_OBJECT_ALIGN;
+        static constexpr int tag_value = DEL_OBJECT_TAG;
+        static constexpr std::size_t id_offset = DEL_OBJECT_ID_OFFSET;
+
+        const unsigned char * data;
+
+        constexpr explicit del_object_view(const unsigned char * data) : data(data) {}
+        int validate(int size) const { return del_object_check(data, size); }
+        uint32_t id() const { return del_object_id(data); }
+};
+
+} /* namespace cyberschema */
+/** @endcond */
+#endif
+
+#endif /* CYBERSPACE_SCHEMA_H */
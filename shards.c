@@ -0,0 +1,388 @@
+/**
+ *  \file    shards.c
+ *  \brief   Sharded multi-threaded server.
+ *
+ *           Project: project independant file.
+ *
+ *           This file contains a server made of N worker threads. Each
+ *           worker owns a listening socket bound with SO_REUSEPORT to the
+ *           server port and an event loop in which this socket is
+ *           registered: the kernel balances the incomming connections
+ *           among the listening sockets, so that the workers never share
+ *           an accept lock nor any connection. The workers can be pinned
+ *           on CPUs.
+ *
+ *           The accept handler of the configuration is called in the
+ *           worker thread that accepted the connection, with the loop of
+ *           this worker: the connection should be registered in this loop
+ *           and handled by this thread only.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+
+#include "errors.h"
+#include "resolver.h"
+#include "sockets.h"
+#include "events.h"
+#include "shards.h"
+#include "xmem.h"
+
+
+/**
+ *  \defgroup shinternals Sharded server internals
+ *  @{
+ */
+
+/*! Worker thread information. */
+struct shard {
+        struct event_loop * loop;      /*!< Event loop of the worker.        */
+        int                 listener;  /*!< Listening socket of the worker.  */
+        int                 wakeup;    /*!< eventfd used to stop the worker. */
+        int                 index;     /*!< Index of the worker.             */
+        int                 started;   /*!< The thread is running.           */
+        pthread_t           thread;    /*!< Worker thread.                   */
+};
+
+/*! Sharded server structure. */
+struct shards {
+        int            port;        /*!< Listening port.      */
+        int            nb_workers;  /*!< Number of workers.   */
+        struct shard * workers;     /*!< Workers.             */
+};
+
+/** @} */
+
+
+/*! Index of the worker running in the current thread. */
+static __thread int current_worker = -1;
+
+
+/**
+ *  \brief Stop request handler: stops the loop of the worker.
+ *
+ * @param loop          event loop of the worker
+ * @param fd            eventfd of the worker
+ * @param events        readiness events
+ * @param data          unused
+ */
+static void shard_wakeup(struct event_loop * loop, int fd, int events, void * data)
+{
+        /*
+         *      Le compteur n'est pas lu : la boucle est détruite ensuite.
+         */
+        event_loop_stop(loop);
+}
+
+
+/**
+ *  \brief Worker thread main function.
+ *
+ * @param arg           worker information
+ * @return              NULL
+ */
+static void * shard_run(void * arg)
+{
+        struct shard * worker = arg;
+
+        current_worker = worker->index;
+        event_loop_run(worker->loop);
+
+        /*
+         *      Les tampons libres sont propres au thread : sans cela, ils
+         *      seraient perdus à sa fin.
+         */
+        xbuf_trim();
+
+        return NULL;
+}
+
+
+/**
+ *  \brief Function releasing the resources of a worker that is not
+ *         running.
+ *
+ * @param worker        worker information
+ */
+static void shard_free(struct shard * worker)
+{
+        if (worker->loop)
+        {
+                event_loop_destroy(worker->loop);
+                worker->loop = NULL;
+        }
+        if (worker->listener >= 0)
+        {
+                close(worker->listener);
+                worker->listener = -1;
+        }
+        if (worker->wakeup >= 0)
+        {
+                close(worker->wakeup);
+                worker->wakeup = -1;
+        }
+}
+
+
+/**
+ *  \brief Function preparing a worker: listening socket, event loop and
+ *         stop notification.
+ *
+ * @param shards        sharded server (the port is set by the first worker)
+ * @param worker        worker information
+ * @param config        server configuration
+ * @return              the status of the preparation
+ * @retval SUCCESS              worker ready to be started
+ * @retval -ERR_SERVICE         cannot create the loop or the eventfd
+ * @retval others               see socket_listen() and event_add()
+ */
+static int shard_prepare(struct shards * shards, struct shard * worker,
+                         const struct shards_config * config)
+{
+        int status;
+
+        if ((worker->index > 0) && config->ip_address &&
+            (strncmp(config->ip_address, RESOLVER_UNIX_PREFIX,
+                     strlen(RESOLVER_UNIX_PREFIX)) == 0))
+        {
+                /*
+                 *      Pas de SO_REUSEPORT pour les sockets locales : les
+                 *      travailleurs partagent celle du premier.
+                 */
+                worker->listener = dup(shards->workers[0].listener);
+                if (worker->listener < 0)
+                {
+                        return -ERR_SERVICE;
+                }
+        }
+        else
+        {
+                worker->listener = socket_listen(shards->port, config->ip_address,
+                                                 NULL, config->backlog,
+                                                 SOCKET_REUSE_PORT);
+        }
+        if (worker->listener < 0)
+        {
+                return worker->listener;
+        }
+        if (shards->port == 0)
+        {
+                /*
+                 *      Les autres travailleurs écoutent sur le port
+                 *      choisi par le système pour le premier.
+                 */
+                shards->port = socket_local_port(worker->listener);
+        }
+
+        worker->loop = event_loop_create_backend(config->backend);
+        worker->wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (! worker->loop || (worker->wakeup < 0))
+        {
+                return -ERR_SERVICE;
+        }
+        check(event_add_server(worker->loop, worker->listener,
+                               config->accept, config->data));
+        status = event_add(worker->loop, worker->wakeup, EVENT_READ,
+                           shard_wakeup, NULL);
+
+        return status;
+}
+
+
+/**
+ *  \brief Function starting a worker thread.
+ *
+ * @param worker        worker information
+ * @param options       SHARDS_* options
+ * @param nb_cpus       number of available CPUs
+ * @return              the status of the operation
+ * @retval SUCCESS                      worker started
+ * @retval -ERR_CANNOT_CONFIGURE        cannot pin the worker on its CPU
+ * @retval -ERR_SERVICE                 cannot create the thread
+ */
+static int shard_start(struct shard * worker, int options, int nb_cpus)
+{
+        pthread_attr_t attributes;
+        int            status = SUCCESS;
+
+        pthread_attr_init(&attributes);
+        if (options & SHARDS_PIN_CPU)
+        {
+                cpu_set_t cpus;
+
+                CPU_ZERO(&cpus);
+                CPU_SET(worker->index % nb_cpus, &cpus);
+                if (pthread_attr_setaffinity_np(&attributes, sizeof(cpus), &cpus) != 0)
+                {
+                        status = -ERR_CANNOT_CONFIGURE;
+                }
+        }
+        if ((status == SUCCESS) &&
+            (pthread_create(&worker->thread, &attributes, shard_run, worker) != 0))
+        {
+                status = -ERR_SERVICE;
+        }
+        pthread_attr_destroy(&attributes);
+        worker->started = (status == SUCCESS);
+
+        return status;
+}
+
+
+/**
+ *  \brief Sharded server start function.
+ *
+ *         This function creates the listening socket and the event loop of
+ *         every worker, then starts the worker threads. Each worker
+ *         accepts connections on its own socket and calls the accept
+ *         handler of the configuration in its own thread.
+ *
+ * @param config        server configuration
+ * @param result        returned server
+ * @return              the status of the operation
+ * @retval SUCCESS                      server started
+ * @retval -ERR_BAD_PARAMETER           no accept handler
+ * @retval -ERR_SERVICE                 cannot create a worker
+ * @retval -ERR_CANNOT_CONFIGURE        cannot pin a worker on its CPU
+ * @retval others                       see socket_listen()
+ */
+int shards_start(const struct shards_config * config, struct shards ** result)
+{
+        struct shards * shards;
+        int             nb_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        int             status = SUCCESS;
+        int             i;
+
+        if (! config->accept)
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        if (nb_cpus < 1)
+        {
+                nb_cpus = 1;
+        }
+
+        shards = xmalloc(sizeof(struct shards));
+        shards->port = config->port;
+        shards->nb_workers = config->nb_workers > 0 ? config->nb_workers : nb_cpus;
+        shards->workers = xmalloc(shards->nb_workers * sizeof(struct shard));
+        for (i = 0 ; i < shards->nb_workers ; i++)
+        {
+                memset(&shards->workers[i], 0, sizeof(struct shard));
+                shards->workers[i].index = i;
+                shards->workers[i].listener = -1;
+                shards->workers[i].wakeup = -1;
+        }
+
+        for (i = 0 ; (i < shards->nb_workers) && (status == SUCCESS) ; i++)
+        {
+                status = shard_prepare(shards, &shards->workers[i], config);
+        }
+        for (i = 0 ; (i < shards->nb_workers) && (status == SUCCESS) ; i++)
+        {
+                status = shard_start(&shards->workers[i], config->options, nb_cpus);
+        }
+        if (status != SUCCESS)
+        {
+                shards_stop(shards);
+                return status;
+        }
+
+        *result = shards;
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Sharded server stop function.
+ *
+ *         This function stops the workers, waits for their threads and
+ *         releases their sockets and loops. The connections accepted by
+ *         the handler are not closed.
+ *
+ * @param shards        the server to stop
+ */
+void shards_stop(struct shards * shards)
+{
+        uint64_t one = 1;
+        int      i;
+
+        if (! shards)
+        {
+                return;
+        }
+        for (i = 0 ; i < shards->nb_workers ; i++)
+        {
+                if (shards->workers[i].started &&
+                    (write(shards->workers[i].wakeup, &one, sizeof(one)) < 0))
+                {
+                        perror("write() ");
+                }
+        }
+        for (i = 0 ; i < shards->nb_workers ; i++)
+        {
+                if (shards->workers[i].started)
+                {
+                        pthread_join(shards->workers[i].thread, NULL);
+                }
+                shard_free(&shards->workers[i]);
+        }
+        free(shards->workers);
+        free(shards);
+}
+
+
+/**
+ *  \brief Sharded server port information function.
+ *
+ * @param shards        the server
+ * @return              the TCP port on which the workers listen
+ */
+int shards_port(const struct shards * shards)
+{
+        return shards->port;
+}
+
+
+/**
+ *  \brief Sharded server size information function.
+ *
+ * @param shards        the server
+ * @return              the number of workers
+ */
+int shards_count(const struct shards * shards)
+{
+        return shards->nb_workers;
+}
+
+
+/**
+ *  \brief Current worker information function.
+ *
+ *         This function is meant to be called from the handlers run by the
+ *         workers, to select per-worker state without locking.
+ *
+ * @return              the index of the worker running the calling thread,
+ *                      or -1 if the thread is not a worker
+ */
+int shards_worker(void)
+{
+        return current_worker;
+}
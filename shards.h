@@ -0,0 +1,66 @@
+/**
+ *  \file    shards.h
+ *  \brief   Sharded multi-threaded server.
+ *
+ *           Project: project independant file.
+ *
+ *           This is the header file of shards.c and contains all the
+ *           constants, structures and functions declarations needed to
+ *           serve connections with many worker threads.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#ifndef SHARDS_H
+#define SHARDS_H
+
+#include "events.h"
+
+/**
+ *  \defgroup shards Sharded server constants and structures
+ *
+ *  \details
+ *  Each worker thread owns its own listening socket (bound to the same
+ *  port with SO_REUSEPORT) and its own event loop: the kernel spreads the
+ *  incomming connections among the workers, which share nothing. On a
+ *  local endpoint ("unix:/path"), the workers accept the connections of
+ *  the same socket.
+ *  @{
+ */
+
+/*! Shard option: pin worker i on CPU i (modulo the number of CPUs). */
+#define SHARDS_PIN_CPU          0x01
+
+/*! Sharded server configuration. */
+struct shards_config {
+        int                  port;        /*!< TCP port (0: any free port).   */
+        char               * ip_address;  /*!< IP address or local endpoint
+                                               (NULL: any).                   */
+        int                  nb_workers;  /*!< Workers (0: one per CPU).      */
+        int                  backlog;     /*!< Backlog (0: SOCKET_BACKLOG).   */
+        int                  backend;     /*!< EVENT_BACKEND_* of the loops.  */
+        int                  options;     /*!< SHARDS_* options.              */
+        event_accept_handler accept;      /*!< Called in the worker thread.   */
+        void               * data;        /*!< User data given to accept.     */
+};
+
+/*! Opaque sharded server structure. */
+struct shards;
+
+/** @} */
+
+
+/** @cond DUPLICATE_DOCUMENTATION */
+int shards_start(const struct shards_config * config, struct shards ** result);
+void shards_stop(struct shards * shards);
+int shards_port(const struct shards * shards);
+int shards_count(const struct shards * shards);
+int shards_worker(void);
+/** @endcond */
+
+
+#endif /* SHARDS_H */
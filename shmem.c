@@ -0,0 +1,899 @@
+/**
+ *  \file    shmem.c
+ *  \brief   Shared memory transport.
+ *
+ *           Project: project independant file.
+ *
+ *           This file contains the shared memory transport of the
+ *           connections between processes of the same host. A segment
+ *           holds two single-producer single-consumer byte rings, one per
+ *           direction: each side only writes the head of the ring it fills
+ *           and the tail of the ring it empties, so that no lock is needed.
+ *           The rings carry the byte stream the socket would carry, the
+ *           packets are thus framed as usual.
+ *
+ *           The segment is a memfd of the client, sealed to its size so that
+ *           the client cannot truncate it under the mapping of the server.
+ *           A file descriptor cannot be given through a TCP connection: the
+ *           server opens it by its /proc path, named in the PACKET_SHM offer
+ *           with a random token also written in the segment, so that a
+ *           client cannot offer the segment of another one. The wakeups use
+ *           the socket itself, which only carries doorbell bytes once the
+ *           connection is upgraded.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/random.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "errors.h"
+#include "packets.h"
+#include "tags.h"
+#include "sockets.h"
+#include "shmem.h"
+#include "xmem.h"
+
+
+/**
+ *  \defgroup shinternals Shared memory transport internals
+ *  @{
+ */
+
+/*! Segment identification. */
+#define SHMEM_MAGIC             0x43595348
+
+/*! Smallest size of a ring. */
+#define SHMEM_MIN_RING          4096
+
+/*! Maximum length of a segment name. */
+#define SHMEM_NAME_SIZE         64
+
+/*! Size of the token of a segment. */
+#define SHMEM_TOKEN_SIZE        16
+
+/*! Seals required on a segment: its size can no longer change. */
+#define SHMEM_SEALS             (F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL)
+
+/*! Pause of a writer waiting for space in a ring, in ns. */
+#define SHMEM_WRITER_PAUSE      50000
+
+/*! Ring of one direction. The positions only grow: the bytes are at their
+ *  position modulo the capacity. Each side keeps its own position in its
+ *  channel and only publishes it here: the position written by the peer is
+ *  checked before use, the peer may be hostile.
+ */
+struct shmem_ring {
+        unsigned long long head __attribute__((aligned(64)));    /*!< Writer. */
+        unsigned long long tail __attribute__((aligned(64)));    /*!< Reader. */
+        int                waiting __attribute__((aligned(64))); /*!< Reader
+                                                                      asleep. */
+        int                closed;                               /*!< Writer
+                                                                      gone.   */
+};
+
+/*! Segment header, followed by the data of the two rings. */
+struct shmem_segment {
+        unsigned int      magic;      /*!< SHMEM_MAGIC.                    */
+        unsigned int      capacity;   /*!< Size of each ring.              */
+        unsigned char     token[SHMEM_TOKEN_SIZE]; /*!< Token of the offer. */
+        struct shmem_ring rings[2];   /*!< Client to server, server to
+                                           client.                         */
+};
+
+/*! Offset of the data of the first ring. */
+#define SHMEM_DATA              ((sizeof(struct shmem_segment) + 63) & ~63UL)
+
+/*! Upgraded connection. */
+struct shmem_channel {
+        struct shmem_segment * segment;   /*!< Mapped segment.          */
+        size_t                 size;      /*!< Size of the mapping.     */
+        struct shmem_ring    * in;        /*!< Ring read.               */
+        struct shmem_ring    * out;       /*!< Ring written.            */
+        unsigned char        * in_data;   /*!< Data of the ring read.   */
+        unsigned char        * out_data;  /*!< Data of the ring written.*/
+        unsigned long long     capacity;  /*!< Size of each ring.       */
+        unsigned long long     tail;      /*!< Position read.           */
+        unsigned long long     head;      /*!< Position written.        */
+        int                    broken;    /*!< Inconsistent peer.       */
+};
+
+/** @} */
+
+
+/*! Upgraded connections, by file descriptor. */
+static struct shmem_channel * channels[SHMEM_MAX_CONNECTIONS];
+
+
+/**
+ *  \brief Channel of an upgraded connection (NULL if not upgraded).
+ */
+static struct shmem_channel * shmem_channel(int fd)
+{
+        if ((fd < 0) || (fd >= SHMEM_MAX_CONNECTIONS))
+        {
+                return NULL;
+        }
+        return __atomic_load_n(&channels[fd], __ATOMIC_ACQUIRE);
+}
+
+
+/**
+ *  \brief Connection upgrade.
+ *
+ * @param fd            connection socket
+ * @param segment       mapped segment
+ * @param size          size of the mapping
+ * @param capacity      size of each ring, checked against the mapping
+ * @param side          0 for the client, 1 for the server
+ */
+static void shmem_register(int fd, struct shmem_segment * segment, size_t size,
+                           unsigned long long capacity, int side)
+{
+        struct shmem_channel * channel = xmalloc(sizeof(struct shmem_channel));
+        unsigned char        * data = (unsigned char *) segment + SHMEM_DATA;
+        int                    immediate = 1;
+
+        /* Les coups de sonnette ne doivent pas attendre l'algorithme de Nagle. */
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &immediate, sizeof(immediate));
+
+        channel->segment = segment;
+        channel->size = size;
+        channel->capacity = capacity;
+        channel->out = &segment->rings[side];
+        channel->in = &segment->rings[1 - side];
+        channel->tail = __atomic_load_n(&channel->in->tail, __ATOMIC_ACQUIRE);
+        channel->head = __atomic_load_n(&channel->out->head, __ATOMIC_ACQUIRE);
+        channel->broken = 0;
+        channel->out_data = data + side * channel->capacity;
+        channel->in_data = data + (1 - side) * channel->capacity;
+        __atomic_store_n(&channels[fd], channel, __ATOMIC_RELEASE);
+}
+
+
+/**
+ *  \brief Doorbell: wakes the reader of a ring up if it sleeps.
+ */
+static void shmem_bell(int fd, struct shmem_ring * ring)
+{
+        if (__atomic_exchange_n(&ring->waiting, 0, __ATOMIC_SEQ_CST))
+        {
+                unsigned char bell = 0;
+
+                if (send(fd, &bell, 1, MSG_DONTWAIT | MSG_NOSIGNAL) < 0)
+                {
+                        /* Socket pleine : le lecteur a déjà de quoi se réveiller. */
+                }
+        }
+}
+
+
+/**
+ *  \brief Doorbell bytes reading.
+ *
+ * @return              1, 0 if the socket is closed by the peer, -1 on error
+ */
+static int shmem_drain(int fd)
+{
+        unsigned char bells[64];
+
+        for (;;)
+        {
+                ssize_t nb_read = recv(fd, bells, sizeof(bells), MSG_DONTWAIT);
+
+                if (nb_read == 0)
+                {
+                        return 0;
+                }
+                if (nb_read < 0)
+                {
+                        if (errno == EINTR)
+                        {
+                                continue;
+                        }
+                        return ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? 1 : -1;
+                }
+        }
+}
+
+
+/**
+ *  \brief Non-blocking mode of a call.
+ */
+static int shmem_nonblocking(int fd, int flags)
+{
+        int mode;
+
+        if (flags & MSG_DONTWAIT)
+        {
+                return 1;
+        }
+        mode = fcntl(fd, F_GETFL, 0);
+
+        return (mode != -1) && (mode & O_NONBLOCK);
+}
+
+
+/**
+ *  \brief Bytes available in the ring read.
+ *
+ * @return              the number of bytes, -1 if the head written by the
+ *                      peer is inconsistent (the channel is then broken)
+ */
+static long long shmem_available(struct shmem_channel * channel)
+{
+        unsigned long long available;
+
+        if (channel->broken)
+        {
+                return -1;
+        }
+        available = __atomic_load_n(&channel->in->head, __ATOMIC_SEQ_CST) -
+                    channel->tail;
+        if (available > channel->capacity)
+        {
+                channel->broken = 1;
+                return -1;
+        }
+
+        return available;
+}
+
+
+/**
+ *  \brief Reading of the available bytes of the ring read.
+ *
+ * @param channel       the channel
+ * @param buffer        received bytes
+ * @param size          size of the buffer
+ * @param available     bytes available (see shmem_available())
+ * @return              the number of bytes read
+ */
+static size_t shmem_ring_read(struct shmem_channel * channel,
+                              unsigned char * buffer, size_t size,
+                              unsigned long long available)
+{
+        size_t offset = channel->tail & (channel->capacity - 1);
+        size_t first;
+
+        if (size > available)
+        {
+                size = available;
+        }
+        first = channel->capacity - offset;
+        if (first > size)
+        {
+                first = size;
+        }
+        memcpy(buffer, channel->in_data + offset, first);
+        memcpy(buffer + first, channel->in_data, size - first);
+        channel->tail += size;
+        __atomic_store_n(&channel->in->tail, channel->tail, __ATOMIC_RELEASE);
+
+        return size;
+}
+
+
+/**
+ *  \brief Writing of the bytes that fit in the ring written.
+ *
+ * @param channel       the channel
+ * @param iov           parts of the bytes to write
+ * @param iovcnt        number of parts
+ * @param skip          bytes of the parts already written
+ * @return              the number of bytes written, -1 if the tail written
+ *                      by the peer is inconsistent (the channel is then
+ *                      broken)
+ */
+static ssize_t shmem_ring_write(struct shmem_channel * channel,
+                                const struct iovec * iov, int iovcnt, size_t skip)
+{
+        unsigned long long head = channel->head;
+        unsigned long long used = head - __atomic_load_n(&channel->out->tail,
+                                                         __ATOMIC_ACQUIRE);
+        size_t             space, done = 0;
+        int                i;
+
+        /*
+         *      Queue au-delà de la tête ou anneau plus que plein : le pair
+         *      ment sur sa position.
+         */
+        if (channel->broken || (used > channel->capacity))
+        {
+                channel->broken = 1;
+                return -1;
+        }
+        space = channel->capacity - used;
+
+        for (i = 0 ; (i < iovcnt) && (done < space) ; i++)
+        {
+                const unsigned char * base = iov[i].iov_base;
+                size_t                length = iov[i].iov_len;
+                size_t                offset, first;
+
+                if (skip >= length)
+                {
+                        skip -= length;
+                        continue;
+                }
+                base += skip;
+                length -= skip;
+                skip = 0;
+                if (length > space - done)
+                {
+                        length = space - done;
+                }
+
+                offset = (head + done) & (channel->capacity - 1);
+                first = channel->capacity - offset;
+                if (first > length)
+                {
+                        first = length;
+                }
+                memcpy(channel->out_data + offset, base, first);
+                memcpy(channel->out_data, base + first, length - first);
+                done += length;
+        }
+        if (done > 0)
+        {
+                channel->head = head + done;
+                __atomic_store_n(&channel->out->head, channel->head, __ATOMIC_SEQ_CST);
+        }
+
+        return done;
+}
+
+
+/**
+ *  \brief Shared memory upgrade, client side.
+ *
+ *         This function creates a segment, offers it to the server and
+ *         waits for its answer. It should be called on a blocking socket
+ *         right after the connection (or the capabilities negotiation, see
+ *         CAPABILITY_SHMEM), when no packet is expected from the server.
+ *         The connection stays on the socket if the server refuses.
+ *
+ * @param fd            connection to the server (same host)
+ * @param capacity      size of each ring (0 for SHMEM_RING_SIZE), rounded
+ *                      up to a power of two
+ * @return              the status of the upgrade
+ * @retval SUCCESS              connection upgraded
+ * @retval -ERR_BAD_PARAMETER   invalid socket or capacity
+ * @retval -ERR_SHARED_MEMORY   segment creation failed or server refusal
+ * @retval -ERR_CONNECTION_LOST connection lost
+ */
+int shmem_connect(int fd, int capacity)
+{
+        unsigned char          packet[PACKET_HEADER_SIZE + SHMEM_TOKEN_SIZE +
+                                      SHMEM_NAME_SIZE];
+        unsigned char          offer[SHMEM_TOKEN_SIZE + SHMEM_NAME_SIZE];
+        struct shmem_segment * segment;
+        unsigned long long     ring = SHMEM_MIN_RING;
+        size_t                 size;
+        int                    shm, length;
+
+        if ((fd < 0) || (fd >= SHMEM_MAX_CONNECTIONS) || shmem_channel(fd) ||
+            (capacity < 0) || (capacity > (1 << 30)))
+        {
+                return -ERR_BAD_PARAMETER;
+        }
+        if (capacity == 0)
+        {
+                capacity = SHMEM_RING_SIZE;
+        }
+        while (ring < (unsigned long long) capacity)
+        {
+                ring <<= 1;
+        }
+        size = SHMEM_DATA + 2 * ring;
+
+        if (getrandom(offer, SHMEM_TOKEN_SIZE, 0) != SHMEM_TOKEN_SIZE)
+        {
+                return -ERR_SHARED_MEMORY;
+        }
+        shm = memfd_create("cybercomms", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (shm < 0)
+        {
+                return -ERR_SHARED_MEMORY;
+        }
+        if ((ftruncate(shm, size) < 0) || (fcntl(shm, F_ADD_SEALS, SHMEM_SEALS) < 0))
+        {
+                close(shm);
+                return -ERR_SHARED_MEMORY;
+        }
+        segment = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, shm, 0);
+        if (segment == MAP_FAILED)
+        {
+                close(shm);
+                return -ERR_SHARED_MEMORY;
+        }
+        segment->capacity = ring;
+        memcpy(segment->token, offer, SHMEM_TOKEN_SIZE);
+        segment->magic = SHMEM_MAGIC;
+        length = SHMEM_TOKEN_SIZE +
+                 snprintf((char *) offer + SHMEM_TOKEN_SIZE, SHMEM_NAME_SIZE,
+                          "/proc/%d/fd/%d", getpid(), shm);
+
+        /*
+         *      Offre puis réponse, encore par la socket. Le descripteur doit
+         *      rester ouvert jusqu'à la réponse : le serveur l'ouvre par son
+         *      chemin dans /proc s'il accepte.
+         */
+        packet_create(PACKET_SHM, offer, length, packet);
+        if (packet_send(fd, packet) == 0)
+        {
+                length = -ERR_CONNECTION_LOST;
+        }
+        else if (packet_read(fd, packet, sizeof(packet)) == 0)
+        {
+                length = -ERR_CONNECTION_LOST;
+        }
+        else if (packet_type(packet) != PACKET_MSG_ACK)
+        {
+                length = -ERR_SHARED_MEMORY;
+        }
+        close(shm);
+        if (length < 0)
+        {
+                munmap(segment, size);
+                return length;
+        }
+
+        shmem_register(fd, segment, size, ring, 0);
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Shared memory segment opening, server side.
+ *
+ *         The segment must be a memfd of the peer sealed to its size, and
+ *         hold the token of the offer. When the connection gives the
+ *         credentials of the peer, the segment must belong to it.
+ *
+ * @param fd            connection of the client
+ * @param name          /proc path of the segment
+ * @param owner         process of the path
+ * @param token         token of the offer
+ * @param size          returned size of the mapping
+ * @param capacity      returned size of each ring, read once
+ * @return              the mapped segment or NULL if it cannot be used
+ */
+static struct shmem_segment * shmem_open(int fd, const char * name, int owner,
+                                         const unsigned char * token,
+                                         size_t * size,
+                                         unsigned long long * capacity)
+{
+        struct shmem_segment * segment = MAP_FAILED;
+        struct stat            status;
+        pid_t                  pid;
+        uid_t                  uid;
+        int                    known, shm;
+
+        known = (socket_peer_credentials(fd, &pid, &uid, NULL) == SUCCESS);
+        if (known && (pid != owner))
+        {
+                return NULL;
+        }
+        shm = open(name, O_RDWR | O_CLOEXEC);
+        if (shm < 0)
+        {
+                return NULL;
+        }
+
+        /*
+         *      Sans scellés, le client pourrait réduire le segment et le
+         *      serveur recevrait SIGBUS en le lisant.
+         */
+        if ((fstat(shm, &status) == 0) && ((size_t) status.st_size > SHMEM_DATA) &&
+            ((fcntl(shm, F_GET_SEALS) & SHMEM_SEALS) == SHMEM_SEALS) &&
+            (! known || (status.st_uid == uid)))
+        {
+                segment = mmap(NULL, status.st_size, PROT_READ | PROT_WRITE,
+                               MAP_SHARED, shm, 0);
+        }
+        close(shm);
+        if (segment == MAP_FAILED)
+        {
+                return NULL;
+        }
+
+        /*
+         *      Le client peut encore écrire dans le segment : la capacité
+         *      est lue une seule fois, et seule cette copie est vérifiée
+         *      puis utilisée.
+         */
+        *size = status.st_size;
+        *capacity = __atomic_load_n(&segment->capacity, __ATOMIC_ACQUIRE);
+        if ((__atomic_load_n(&segment->magic, __ATOMIC_ACQUIRE) != SHMEM_MAGIC) ||
+            (memcmp(segment->token, token, SHMEM_TOKEN_SIZE) != 0) ||
+            (*capacity < SHMEM_MIN_RING) || (*capacity & (*capacity - 1)) ||
+            (*size < SHMEM_DATA + 2 * *capacity))
+        {
+                munmap(segment, *size);
+                return NULL;
+        }
+
+        return segment;
+}
+
+
+/**
+ *  \brief Shared memory upgrade, server side.
+ *
+ *         This function maps the segment offered by a PACKET_SHM packet and
+ *         answers with an ACK, or with a NACK if the segment cannot be used
+ *         (another host, another user, wrong token...): the connection
+ *         then stays on the socket. A server using a dispatch table
+ *         registers shmem_dispatch() instead.
+ *
+ * @param fd            connection of the client
+ * @param packet        the PACKET_SHM packet
+ * @param size          size of the packet
+ * @return              the status of the upgrade
+ * @retval SUCCESS              connection upgraded
+ * @retval -ERR_BAD_PROTOCOL    invalid offer
+ * @retval -ERR_SHARED_MEMORY   unusable segment
+ * @retval -ERR_CONNECTION_LOST connection lost
+ */
+int shmem_accept(int fd, const unsigned char * packet, int size)
+{
+        char                   name[SHMEM_NAME_SIZE];
+        char                   path[SHMEM_NAME_SIZE];
+        const unsigned char  * token = packet + PACKET_HEADER_SIZE;
+        struct shmem_segment * segment;
+        unsigned long long     capacity;
+        size_t                 mapping;
+        int                    length = size - PACKET_HEADER_SIZE - SHMEM_TOKEN_SIZE;
+        int                    owner, number;
+
+        if ((length <= 0) || (length >= SHMEM_NAME_SIZE) ||
+            (packet_type(packet) != PACKET_SHM))
+        {
+                message_send(fd, PACKET_MSG_NACK, ERR_BAD_PROTOCOL);
+                return -ERR_BAD_PROTOCOL;
+        }
+        memcpy(name, token + SHMEM_TOKEN_SIZE, length);
+        name[length] = '\0';
+
+        /*
+         *      Seul un chemin /proc/<pid>/fd/<n> exact est ouvert.
+         */
+        if ((sscanf(name, "/proc/%d/fd/%d", &owner, &number) != 2) ||
+            (snprintf(path, sizeof(path), "/proc/%d/fd/%d", owner, number) != length) ||
+            (strcmp(path, name) != 0) ||
+            (fd >= SHMEM_MAX_CONNECTIONS) || shmem_channel(fd))
+        {
+                message_send(fd, PACKET_MSG_NACK, ERR_BAD_PROTOCOL);
+                return -ERR_BAD_PROTOCOL;
+        }
+
+        segment = shmem_open(fd, name, owner, token, &mapping, &capacity);
+        if (! segment)
+        {
+                message_send(fd, PACKET_MSG_NACK, ERR_SHARED_MEMORY);
+                return -ERR_SHARED_MEMORY;
+        }
+
+        /*
+         *      L'acquittement est le dernier octet envoyé par la socket.
+         */
+        if (message_send(fd, PACKET_MSG_ACK, 0) == 0)
+        {
+                munmap(segment, mapping);
+                return -ERR_CONNECTION_LOST;
+        }
+        shmem_register(fd, segment, mapping, capacity, 1);
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Shared memory offer handler of a dispatch table.
+ *
+ *         A server accepting the upgrades of its connections registers
+ *         this function for PACKET_SHM, with the DISPATCH_IGNORE policy
+ *         (see dispatch_register()): without it, dispatch_packet() refuses
+ *         the offers. The offer is answered by shmem_accept(); a segment
+ *         that cannot be used is not an error, the connection then stays
+ *         on the socket.
+ *
+ * @param fd            connection of the client
+ * @param packet        the PACKET_SHM packet
+ * @param size          size of the packet
+ * @param data          unused
+ * @return              the status of the upgrade (see shmem_accept())
+ */
+int shmem_dispatch(int fd, const unsigned char * packet, int size, void * data)
+{
+        int status = shmem_accept(fd, packet, size);
+
+        (void) data;
+
+        return (status == -ERR_SHARED_MEMORY) ? SUCCESS : status;
+}
+
+
+/**
+ *  \brief Shared memory release.
+ *
+ *         This function tells the peer that nothing more will be written
+ *         and unmaps the segment. It must be called before the socket is
+ *         closed, when no other thread uses it. It does nothing if the
+ *         connection is not upgraded.
+ *
+ * @param fd            upgraded connection
+ */
+void shmem_close(int fd)
+{
+        struct shmem_channel * channel = shmem_channel(fd);
+
+        if (! channel)
+        {
+                return;
+        }
+        __atomic_store_n(&channels[fd], NULL, __ATOMIC_RELEASE);
+        __atomic_store_n(&channel->out->closed, 1, __ATOMIC_SEQ_CST);
+        shmem_bell(fd, channel->out);
+        munmap(channel->segment, channel->size);
+        free(channel);
+}
+
+
+/**
+ *  \brief Shared memory upgrade information.
+ *
+ * @param fd            connection socket
+ * @return              1 if the connection is upgraded, 0 otherwise
+ */
+int shmem_active(int fd)
+{
+        return shmem_channel(fd) != NULL;
+}
+
+
+/**
+ *  \brief recv() of a connection, upgraded or not.
+ *
+ *         An upgraded connection returns the available bytes of its ring,
+ *         and follows the blocking mode of the socket (or MSG_DONTWAIT)
+ *         when it is empty. MSG_WAITALL is ignored: all the callers of the
+ *         library loop on short reads. A blocking read checks the ring for
+ *         a while (SHMEM_SPIN) before sleeping. A peer that writes an
+ *         inconsistent position in the segment breaks the connection
+ *         (EPROTO).
+ *
+ * @param fd            connection socket
+ * @param buffer        received bytes
+ * @param size          size of the buffer
+ * @param flags         recv() flags
+ * @return              the number of received bytes, 0 at the end of the
+ *                      connection, -1 on error (errno is set)
+ */
+ssize_t shmem_recv(int fd, void * buffer, size_t size, int flags)
+{
+        struct shmem_channel * channel = shmem_channel(fd);
+        int                    nonblocking = -1;
+        int                    spun = 0;
+
+        if (! channel)
+        {
+                return recv(fd, buffer, size, flags);
+        }
+        if (size == 0)
+        {
+                return 0;
+        }
+
+        for (;;)
+        {
+                struct pollfd wait;
+                long long     available = shmem_available(channel);
+                int           status;
+
+                if (available < 0)
+                {
+                        errno = EPROTO;
+                        return -1;
+                }
+                if (available > 0)
+                {
+                        return shmem_ring_read(channel, buffer, size, available);
+                }
+                if (__atomic_load_n(&channel->in->closed, __ATOMIC_SEQ_CST) &&
+                    (shmem_available(channel) == 0))
+                {
+                        return 0;
+                }
+                if (nonblocking < 0)
+                {
+                        nonblocking = shmem_nonblocking(fd, flags);
+                }
+                if (! nonblocking && ! spun)
+                {
+                        int i;
+
+                        for (i = 0 ; (i < SHMEM_SPIN) && (shmem_available(channel) == 0) ; i++)
+                        {
+                                sched_yield();
+                        }
+                        spun = 1;
+                        continue;
+                }
+
+                /*
+                 *      Les coups de sonnette déjà reçus sont lus avant de
+                 *      s'annoncer endormi : ceux qui suivent réveilleront
+                 *      la socket.
+                 */
+                status = shmem_drain(fd);
+                if (status <= 0)
+                {
+                        return status;
+                }
+                __atomic_store_n(&channel->in->waiting, 1, __ATOMIC_SEQ_CST);
+                if (shmem_available(channel) != 0)
+                {
+                        continue;
+                }
+                if (nonblocking)
+                {
+                        errno = EAGAIN;
+                        return -1;
+                }
+                wait.fd = fd;
+                wait.events = POLLIN;
+                if ((poll(&wait, 1, -1) < 0) && (errno != EINTR))
+                {
+                        return -1;
+                }
+        }
+}
+
+
+/**
+ *  \brief writev() of a connection, upgraded or not.
+ *
+ *         An upgraded connection writes the bytes in its ring, and follows
+ *         the blocking mode of the socket when the ring is full: a
+ *         non-blocking write returns the bytes written (or EAGAIN), a
+ *         blocking one waits for the reader to make room. A peer that
+ *         writes an inconsistent position in the segment breaks the
+ *         connection (EPROTO).
+ *
+ * @param fd            connection socket
+ * @param iov           parts of the bytes to send
+ * @param iovcnt        number of parts
+ * @return              the number of bytes sent, -1 on error (errno is set)
+ */
+ssize_t shmem_writev(int fd, const struct iovec * iov, int iovcnt)
+{
+        struct shmem_channel * channel = shmem_channel(fd);
+        size_t                 total = 0, written = 0;
+        int                    i;
+
+        if (! channel)
+        {
+                return writev(fd, iov, iovcnt);
+        }
+        for (i = 0 ; i < iovcnt ; i++)
+        {
+                total += iov[i].iov_len;
+        }
+
+        for (;;)
+        {
+                struct timespec pause = {0, SHMEM_WRITER_PAUSE};
+                struct pollfd   peer;
+                ssize_t         nb_write;
+
+                if (__atomic_load_n(&channel->in->closed, __ATOMIC_SEQ_CST))
+                {
+                        errno = EPIPE;
+                        return -1;
+                }
+                nb_write = shmem_ring_write(channel, iov, iovcnt, written);
+                if (nb_write < 0)
+                {
+                        errno = EPROTO;
+                        return -1;
+                }
+                written += nb_write;
+                shmem_bell(fd, channel->out);
+                if (written == total)
+                {
+                        return written;
+                }
+                if (shmem_nonblocking(fd, 0))
+                {
+                        if (written > 0)
+                        {
+                                return written;
+                        }
+                        errno = EAGAIN;
+                        return -1;
+                }
+
+                /*
+                 *      Anneau plein : le lecteur est occupé, on lui laisse
+                 *      la place en surveillant la fin de la connexion.
+                 */
+                peer.fd = fd;
+                peer.events = POLLRDHUP;
+                if ((poll(&peer, 1, 0) > 0) &&
+                    (peer.revents & (POLLRDHUP | POLLHUP | POLLERR)))
+                {
+                        errno = EPIPE;
+                        return -1;
+                }
+                nanosleep(&pause, NULL);
+        }
+}
+
+
+/**
+ *  \brief send() of a connection, upgraded or not.
+ *
+ * @param fd            connection socket
+ * @param buffer        bytes to send
+ * @param size          number of bytes
+ * @param flags         send() flags (MSG_DONTWAIT is not supported on
+ *                      an upgraded connection)
+ * @return              the number of bytes sent, -1 on error (errno is set)
+ */
+ssize_t shmem_send(int fd, const void * buffer, size_t size, int flags)
+{
+        struct iovec part;
+
+        if (! shmem_channel(fd))
+        {
+                return send(fd, buffer, size, flags);
+        }
+        part.iov_base = (void *) buffer;
+        part.iov_len = size;
+
+        return shmem_writev(fd, &part, 1);
+}
+
+
+/**
+ *  \brief sendmsg() of a connection, upgraded or not.
+ *
+ * @param fd            connection socket
+ * @param message       message to send (only its data are used on an
+ *                      upgraded connection)
+ * @param flags         sendmsg() flags
+ * @return              the number of bytes sent, -1 on error (errno is set)
+ */
+ssize_t shmem_sendmsg(int fd, const struct msghdr * message, int flags)
+{
+        if (! shmem_channel(fd))
+        {
+                return sendmsg(fd, message, flags);
+        }
+
+        return shmem_writev(fd, message->msg_iov, message->msg_iovlen);
+}
@@ -0,0 +1,79 @@
+/**
+ *  \file    shmem.h
+ *  \brief   Shared memory transport.
+ *
+ *           Project: project independant file.
+ *
+ *           This is the header file of shmem.c and contains all the
+ *           constants and functions declarations needed to carry the
+ *           packets of a same-host connection through shared memory.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#ifndef SHMEM_H
+#define SHMEM_H
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+
+/**
+ *  \defgroup shmem Shared memory transport constants
+ *
+ *  \details
+ *  A connection between two processes of the same host can be upgraded to
+ *  shared memory: the client creates a segment holding one ring per
+ *  direction, seals its size, and sends its /proc path and a random token
+ *  in a PACKET_SHM packet; the server maps it if it is sealed, holds the
+ *  token and belongs to the peer (when the socket gives its credentials),
+ *  and answers with an ACK (a NACK if it cannot), which is the last byte
+ *  sent through the socket. From then on, the same packets are written in
+ *  the rings, without any system call while both sides are busy. Servers
+ *  opt in: they call shmem_accept() themselves, or register
+ *  shmem_dispatch() for PACKET_SHM in their dispatch table, which refuses
+ *  the offers otherwise.
+ *
+ *  The socket stays open: it detects the end of the connection and it is
+ *  the doorbell of the rings. A reader that finds its ring empty notes it
+ *  in the segment and waits for the socket to be readable; the writer then
+ *  sends it one byte. Event loops thus watch the socket as before.
+ *
+ *  The upgrade is transparent for the packet functions (packet_read(),
+ *  packet_send(), packet_decoder_read(), outqueue_flush(), event_send()...):
+ *  they reach the socket through shmem_recv(), shmem_send(), shmem_sendmsg()
+ *  and shmem_writev(), which use the rings of an upgraded socket.
+ *  shmem_close() must be called before the socket is closed.
+ *  @{
+ */
+
+/*! Default size of each ring of a segment. */
+#define SHMEM_RING_SIZE         (1024 * 1024)
+
+/*! Number of file descriptors that can be upgraded. */
+#define SHMEM_MAX_CONNECTIONS   4096
+
+/*! Number of checks of an empty ring before sleeping (blocking reads). */
+#define SHMEM_SPIN              64
+
+/** @} */
+
+
+/** @cond DUPLICATE_DOCUMENTATION */
+int shmem_connect(int fd, int capacity);
+int shmem_accept(int fd, const unsigned char * packet, int size);
+int shmem_dispatch(int fd, const unsigned char * packet, int size, void * data);
+void shmem_close(int fd);
+int shmem_active(int fd);
+ssize_t shmem_recv(int fd, void * buffer, size_t size, int flags);
+ssize_t shmem_send(int fd, const void * buffer, size_t size, int flags);
+ssize_t shmem_sendmsg(int fd, const struct msghdr * message, int flags);
+ssize_t shmem_writev(int fd, const struct iovec * iov, int iovcnt);
+/** @endcond */
+
+
+#endif /* SHMEM_H */
@@ -0,0 +1,684 @@
+/**
+ *  \file    snapshots.c
+ *  \brief   Versioned state snapshots.
+ *
+ *           Project: project independant file.
+ *
+ *           This file contains a versioned records store used to answer
+ *           CMD_DUMP_STATE requests with deltas: the server keeps a single
+ *           state in which each record remembers the version of its last
+ *           change, and the version acknowledged by a client is its
+ *           baseline. Only the records changed since this baseline are
+ *           sent, or the full state when the baseline is unknown.
+ *
+ *           Records are indexed by key in a hash table and chained in the
+ *           order of their changes, so that building a delta only visits
+ *           the changed records. The same structure holds the replica of
+ *           the state on the client side.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "errors.h"
+#include "packets.h"
+#include "fragments.h"
+#include "compress.h"
+#include "outqueue.h"
+#include "snapshots.h"
+#include "tags.h"
+#include "xmem.h"
+
+
+/*! Initial size of the hash table (a power of 2). */
+#define SNAPSHOT_BUCKETS        64
+
+
+/**
+ *  \brief Function encoding a 32 bits number in little-endian order.
+ *
+ * @param buffer        destination
+ * @param value         number to encode
+ */
+static void put_u32(unsigned char * buffer, unsigned int value)
+{
+        buffer[0] = (value & 0xFF);
+        buffer[1] = ((value >> 8) & 0xFF);
+        buffer[2] = ((value >> 16) & 0xFF);
+        buffer[3] = ((value >> 24) & 0xFF);
+}
+
+
+/**
+ *  \brief Function decoding a 32 bits little-endian number.
+ *
+ * @param buffer        encoded number
+ * @return              the number
+ */
+static unsigned int get_u32(const unsigned char * buffer)
+{
+        return buffer[0] | (buffer[1] << 8) | (buffer[2] << 16)
+               | ((unsigned int) buffer[3] << 24);
+}
+
+
+/**
+ *  \brief Function returning the hash bucket of a key.
+ *
+ * @param snapshot      the state
+ * @param key           record key
+ * @return              the index of the bucket
+ */
+static int bucket_of(const struct snapshot * snapshot, unsigned int key)
+{
+        return (key * 2654435761U) & (snapshot->nb_buckets - 1);
+}
+
+
+/**
+ *  \brief Function looking for a record (deleted or not).
+ *
+ * @param snapshot      the state
+ * @param key           record key
+ * @return              the record or NULL
+ */
+static struct snapshot_record * record_find(const struct snapshot * snapshot,
+                                            unsigned int key)
+{
+        struct snapshot_record * record;
+
+        if (! snapshot->buckets)
+        {
+                return NULL;
+        }
+        record = snapshot->buckets[bucket_of(snapshot, key)];
+        while (record && (record->key != key))
+        {
+                record = record->next;
+        }
+
+        return record;
+}
+
+
+/**
+ *  \brief Function enlarging the hash table.
+ *
+ * @param snapshot      the state
+ */
+static void buckets_grow(struct snapshot * snapshot)
+{
+        struct snapshot_record * record;
+        int                      size = snapshot->nb_buckets
+                                        ? snapshot->nb_buckets * 2
+                                        : SNAPSHOT_BUCKETS;
+
+        FREE(snapshot->buckets);
+        snapshot->buckets = xmalloc(size * sizeof(struct snapshot_record *));
+        memset(snapshot->buckets, 0, size * sizeof(struct snapshot_record *));
+        snapshot->nb_buckets = size;
+        for (record = snapshot->oldest ; record ; record = record->newer)
+        {
+                int bucket = bucket_of(snapshot, record->key);
+
+                record->next = snapshot->buckets[bucket];
+                snapshot->buckets[bucket] = record;
+        }
+}
+
+
+/**
+ *  \brief Function moving a record at the end of the changes list and
+ *         giving it a new version.
+ *
+ * @param snapshot      the state
+ * @param record        the changed record
+ */
+static void record_touch(struct snapshot * snapshot, struct snapshot_record * record)
+{
+        if (record->older)
+        {
+                record->older->newer = record->newer;
+        }
+        else if (snapshot->oldest == record)
+        {
+                snapshot->oldest = record->newer;
+        }
+        if (record->newer)
+        {
+                record->newer->older = record->older;
+        }
+        else if (snapshot->newest == record)
+        {
+                snapshot->newest = record->older;
+        }
+
+        record->older = snapshot->newest;
+        record->newer = NULL;
+        if (snapshot->newest)
+        {
+                snapshot->newest->newer = record;
+        }
+        else
+        {
+                snapshot->oldest = record;
+        }
+        snapshot->newest = record;
+        record->version = ++snapshot->version;
+}
+
+
+/**
+ *  \brief Function removing a record from the state.
+ *
+ * @param snapshot      the state
+ * @param record        the record to remove
+ */
+static void record_remove(struct snapshot * snapshot, struct snapshot_record * record)
+{
+        struct snapshot_record ** link = &snapshot->buckets[bucket_of(snapshot, record->key)];
+
+        while (*link != record)
+        {
+                link = &(*link)->next;
+        }
+        *link = record->next;
+
+        if (record->older)
+        {
+                record->older->newer = record->newer;
+        }
+        else
+        {
+                snapshot->oldest = record->newer;
+        }
+        if (record->newer)
+        {
+                record->newer->older = record->older;
+        }
+        else
+        {
+                snapshot->newest = record->older;
+        }
+        snapshot->nb_records--;
+        free(record->data);
+        free(record);
+}
+
+
+/**
+ *  \brief State initialisation function.
+ *
+ * @param snapshot      the state to initialise
+ */
+void snapshot_init(struct snapshot * snapshot)
+{
+        memset(snapshot, 0, sizeof(struct snapshot));
+}
+
+
+/**
+ *  \brief State release function.
+ *
+ * @param snapshot      the state to release
+ */
+void snapshot_free(struct snapshot * snapshot)
+{
+        while (snapshot->oldest)
+        {
+                struct snapshot_record * record = snapshot->oldest;
+
+                snapshot->oldest = record->newer;
+                free(record->data);
+                free(record);
+        }
+        FREE(snapshot->buckets);
+        snapshot_init(snapshot);
+}
+
+
+/**
+ *  \brief Record setting function.
+ *
+ *         The record is created or replaced. Setting a record to the data
+ *         it already holds does not change the version of the state, so
+ *         that it is not sent again.
+ *
+ * @param snapshot      the state
+ * @param key           record key
+ * @param data          record data
+ * @param size          size of the data
+ * @return              the status of the operation
+ * @retval SUCCESS              record set
+ * @retval -ERR_OUT_OF_RANGE    size larger than SNAPSHOT_MAX_RECORD
+ */
+int snapshot_set(struct snapshot * snapshot, unsigned int key,
+                 const unsigned char * data, int size)
+{
+        struct snapshot_record * record;
+
+        if ((size < 0) || (size > SNAPSHOT_MAX_RECORD))
+        {
+                return -ERR_OUT_OF_RANGE;
+        }
+
+        record = record_find(snapshot, key);
+        if (record && ! record->deleted && (record->size == size) &&
+            ((size == 0) || (memcmp(record->data, data, size) == 0)))
+        {
+                return SUCCESS;
+        }
+        if (! record)
+        {
+                int bucket;
+
+                if (snapshot->nb_records >= snapshot->nb_buckets)
+                {
+                        buckets_grow(snapshot);
+                }
+                record = xmalloc(sizeof(struct snapshot_record));
+                memset(record, 0, sizeof(struct snapshot_record));
+                record->key = key;
+                bucket = bucket_of(snapshot, key);
+                record->next = snapshot->buckets[bucket];
+                snapshot->buckets[bucket] = record;
+                snapshot->nb_records++;
+        }
+
+        if (record->size != size)
+        {
+                free(record->data);
+                record->data = (size > 0) ? xmalloc(size) : NULL;
+        }
+        if (size > 0)
+        {
+                memcpy(record->data, data, size);
+        }
+        record->size = size;
+        record->deleted = 0;
+        record_touch(snapshot, record);
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Record deletion function.
+ *
+ *         The record is kept as deleted until snapshot_prune(), so that
+ *         its deletion is sent in the deltas.
+ *
+ * @param snapshot      the state
+ * @param key           record key
+ * @return              the status of the operation
+ * @retval SUCCESS              record deleted
+ * @retval -ERR_NOT_FOUND       no such record
+ */
+int snapshot_delete(struct snapshot * snapshot, unsigned int key)
+{
+        struct snapshot_record * record = record_find(snapshot, key);
+
+        if (! record || record->deleted)
+        {
+                return -ERR_NOT_FOUND;
+        }
+        FREE(record->data);
+        record->size = 0;
+        record->deleted = 1;
+        record_touch(snapshot, record);
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Record information function.
+ *
+ * @param snapshot      the state
+ * @param key           record key
+ * @return              the record or NULL if it does not exist
+ */
+const struct snapshot_record * snapshot_get(const struct snapshot * snapshot,
+                                            unsigned int key)
+{
+        struct snapshot_record * record = record_find(snapshot, key);
+
+        return (record && ! record->deleted) ? record : NULL;
+}
+
+
+/**
+ *  \brief Deleted records pruning function.
+ *
+ *         The records deleted up to the given version are forgotten.
+ *         Deltas can then only be built from this version on: older
+ *         clients get a full state. The server typically prunes up to
+ *         the oldest version acknowledged by its clients.
+ *
+ * @param snapshot      the state
+ * @param version       version up to which deletions are forgotten
+ */
+void snapshot_prune(struct snapshot * snapshot, unsigned int version)
+{
+        struct snapshot_record * record = snapshot->oldest;
+
+        if (version > snapshot->version)
+        {
+                version = snapshot->version;
+        }
+        while (record && (record->version <= version))
+        {
+                struct snapshot_record * newer = record->newer;
+
+                if (record->deleted)
+                {
+                        record_remove(snapshot, record);
+                }
+                record = newer;
+        }
+        if (version > snapshot->pruned)
+        {
+                snapshot->pruned = version;
+        }
+}
+
+
+/**
+ *  \brief Snapshot encoding function.
+ *
+ *         This function builds the answer to a CMD_DUMP_STATE request:
+ *         the records changed since the given version, or the full state
+ *         if the version is 0, older than the pruned version or unknown.
+ *
+ * @param snapshot      the state
+ * @param since         version held by the client
+ * @param size          returned size of the answer
+ * @return              the answer (to be freed by the caller)
+ */
+unsigned char * snapshot_encode(const struct snapshot * snapshot,
+                                unsigned int since, size_t * size)
+{
+        struct snapshot_record * first;
+        struct snapshot_record * record;
+        unsigned char          * buffer;
+        size_t                   length = SNAPSHOT_HEADER_SIZE;
+        int                      full = (since == 0) || (since < snapshot->pruned)
+                                        || (since > snapshot->version);
+
+        /*
+         *      Les enregistrements sont chaînés par version : un delta ne
+         *      parcourt que les enregistrements modifiés.
+         */
+        if (full)
+        {
+                since = 0;
+                first = snapshot->oldest;
+        }
+        else
+        {
+                first = snapshot->newest;
+                while (first && first->older && (first->older->version > since))
+                {
+                        first = first->older;
+                }
+                if (first && (first->version <= since))
+                {
+                        first = NULL;
+                }
+        }
+
+        for (record = first ; record ; record = record->newer)
+        {
+                if (! (full && record->deleted))
+                {
+                        length += SNAPSHOT_RECORD_HEADER + record->size;
+                }
+        }
+
+        buffer = xmalloc(length);
+        buffer[0] = full ? SNAPSHOT_FULL : 0;
+        put_u32(&buffer[1], since);
+        put_u32(&buffer[5], snapshot->version);
+        *size = SNAPSHOT_HEADER_SIZE;
+        for (record = first ; record ; record = record->newer)
+        {
+                int record_size = record->deleted ? SNAPSHOT_DELETED : record->size;
+
+                if (full && record->deleted)
+                {
+                        continue;
+                }
+                put_u32(&buffer[*size], record->key);
+                buffer[*size + 4] = (record_size & 0xFF);
+                buffer[*size + 5] = ((record_size >> 8) & 0xFF);
+                *size += SNAPSHOT_RECORD_HEADER;
+                if (record->size > 0)
+                {
+                        memcpy(&buffer[*size], record->data, record->size);
+                        *size += record->size;
+                }
+        }
+
+        return buffer;
+}
+
+
+/**
+ *  \brief Snapshot application function.
+ *
+ *         This function updates a replica of the state with an answer to
+ *         a CMD_DUMP_STATE request. A delta must be based on the version
+ *         of the replica: otherwise, a full state should be requested
+ *         (with the version 0).
+ *
+ * @param snapshot      the replica
+ * @param data          the answer (data of the packet)
+ * @param size          size of the answer
+ * @return              the status of the operation
+ * @retval SUCCESS              replica updated
+ * @retval -ERR_BAD_PROTOCOL    malformed answer (replica unchanged)
+ * @retval -ERR_DATA_INVALID    delta based on another version (replica
+ *                              unchanged)
+ */
+int snapshot_apply(struct snapshot * snapshot, const unsigned char * data,
+                   size_t size)
+{
+        size_t       offset;
+        unsigned int version;
+
+        if (size < SNAPSHOT_HEADER_SIZE)
+        {
+                return -ERR_BAD_PROTOCOL;
+        }
+        if (! (data[0] & SNAPSHOT_FULL) && (get_u32(&data[1]) != snapshot->version))
+        {
+                return -ERR_DATA_INVALID;
+        }
+
+        /*
+         *      Vérification complète avant de modifier la réplique.
+         */
+        for (offset = SNAPSHOT_HEADER_SIZE ; offset < size ; )
+        {
+                int record_size;
+
+                if (size - offset < SNAPSHOT_RECORD_HEADER)
+                {
+                        return -ERR_BAD_PROTOCOL;
+                }
+                record_size = data[offset + 4] | (data[offset + 5] << 8);
+                offset += SNAPSHOT_RECORD_HEADER;
+                if (record_size != SNAPSHOT_DELETED)
+                {
+                        if (size - offset < (size_t) record_size)
+                        {
+                                return -ERR_BAD_PROTOCOL;
+                        }
+                        offset += record_size;
+                }
+        }
+
+        version = get_u32(&data[5]);
+        if (data[0] & SNAPSHOT_FULL)
+        {
+                snapshot_free(snapshot);
+        }
+        for (offset = SNAPSHOT_HEADER_SIZE ; offset < size ; )
+        {
+                unsigned int key = get_u32(&data[offset]);
+                int          record_size = data[offset + 4] | (data[offset + 5] << 8);
+
+                offset += SNAPSHOT_RECORD_HEADER;
+                if (record_size == SNAPSHOT_DELETED)
+                {
+                        struct snapshot_record * record = record_find(snapshot, key);
+
+                        if (record)
+                        {
+                                record_remove(snapshot, record);
+                        }
+                }
+                else
+                {
+                        snapshot_set(snapshot, key, &data[offset], record_size);
+                        offset += record_size;
+                }
+        }
+        snapshot->version = version;
+        snapshot->pruned = version;
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Snapshot request function (client side).
+ *
+ *         This function sends a CMD_DUMP_STATE request with the version
+ *         of the replica: the server answers with the changes since this
+ *         version.
+ *
+ * @param socket_fd     the socket's file descriptor
+ * @param snapshot      the replica
+ * @return              the status of the operation
+ * @retval SUCCESS              request sent
+ * @retval -ERR_CONNECTION_LOST connection lost
+ */
+int snapshot_request(int socket_fd, const struct snapshot * snapshot)
+{
+        unsigned char version[4];
+        struct iovec  iov;
+
+        put_u32(version, snapshot->version);
+        iov.iov_base = version;
+        iov.iov_len = sizeof(version);
+        if (packet_sendv(socket_fd, CMD_DUMP_STATE, &iov, 1)
+            != (int) (PACKET_HEADER_SIZE + sizeof(version)))
+        {
+                return -ERR_CONNECTION_LOST;
+        }
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Requested version information function (server side).
+ *
+ * @param packet        a CMD_DUMP_STATE request
+ * @return              the version held by the client (0 for a full state)
+ */
+unsigned int snapshot_requested(const unsigned char * packet)
+{
+        if (packet_data_len(packet) < PACKET_TAG_SIZE + 4)
+        {
+                return 0;
+        }
+
+        return get_u32(&packet[PACKET_HEADER_SIZE]);
+}
+
+
+/**
+ *  \brief Snapshot sending function (server side).
+ *
+ *         This function answers a CMD_DUMP_STATE request. An answer larger
+ *         than MAX_DATA_SIZE is sent as fragments, which requires the
+ *         client to have announced CAPABILITY_FRAGMENTS. With a
+ *         compressor, the answer is compressed (see compress_send()),
+ *         which requires CAPABILITY_COMPRESSION as well.
+ *
+ * @param socket_fd     the socket's file descriptor
+ * @param snapshot      the state
+ * @param since         version held by the client (see
+ *                      snapshot_requested())
+ * @param compressor    compression state of the connection (NULL to send
+ *                      the answer uncompressed)
+ * @return              the status of the operation
+ * @retval SUCCESS              answer sent
+ * @retval -ERR_CONNECTION_LOST connection lost
+ */
+int snapshot_send(int socket_fd, const struct snapshot * snapshot,
+                  unsigned int since, struct compressor * compressor)
+{
+        size_t          size;
+        unsigned char * answer = snapshot_encode(snapshot, since, &size);
+        int             status;
+
+        if (compressor)
+        {
+                status = compress_send(socket_fd, compressor, CMD_DUMP_STATE,
+                                       answer, size);
+        }
+        else
+        {
+                status = fragment_send_large(socket_fd, CMD_DUMP_STATE,
+                                             answer, size);
+        }
+        free(answer);
+
+        return status;
+}
+
+
+/**
+ *  \brief Snapshot queuing function (server side).
+ *
+ *         This function answers a CMD_DUMP_STATE request through the
+ *         outgoing queue of the connection: the answer is sent in the bulk
+ *         lane, so that the control and real-time packets queued meanwhile
+ *         are not delayed by a large state (see outqueue_push_large()).
+ *         The answer is compressed if the queue has a compressor (see
+ *         outqueue_compress()).
+ *
+ * @param queue         the outgoing queue of the connection
+ * @param snapshot      the state
+ * @param since         version held by the client (see
+ *                      snapshot_requested())
+ * @param flags         packet flags (OUTQUEUE_FLUSH)
+ * @return              the number of bytes still pending or a negative
+ *                      value in case of error
+ * @retval -ERR_FIFO_FULL       the queue is full (see outqueue_limits())
+ * @retval -ERR_CONNECTION_LOST the queue was flushed and the connection is
+ *                              lost, or the queue was full and shut the
+ *                              connection down
+ */
+int snapshot_queue(struct outqueue * queue, const struct snapshot * snapshot,
+                   unsigned int since, int flags)
+{
+        size_t          size;
+        unsigned char * answer = snapshot_encode(snapshot, since, &size);
+        int             status = outqueue_push_large(queue, CMD_DUMP_STATE,
+                                                     answer, size, flags);
+
+        free(answer);
+
+        return status;
+}
@@ -0,0 +1,113 @@
+/**
+ *  \file    snapshots.h
+ *  \brief   Versioned state snapshots.
+ *
+ *           Project: project independant file.
+ *
+ *           This is the header file of snapshots.c and contains all the
+ *           constants, structures and functions declarations needed to
+ *           send a state as deltas between versions (CMD_DUMP_STATE).
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#ifndef SNAPSHOTS_H
+#define SNAPSHOTS_H
+
+#include <stddef.h>
+
+#include "outqueue.h"
+
+/**
+ *  \defgroup snapshots State snapshots constants and structures
+ *
+ *  \details
+ *  A state is a set of records identified by a 32 bits key. Each change
+ *  increments the version of the state, and each record remembers the
+ *  version of its last change. A client asks for the state with a
+ *  CMD_DUMP_STATE packet whose data is the version it holds (4 bytes,
+ *  little-endian, none or 0 for a full state); the server answers with the
+ *  records changed since this version. The answer data is:
+ *  - <tt>1 byte</tt>  flags (SNAPSHOT_FULL for a full state)
+ *  - <tt>4 bytes</tt> version on which the delta is based
+ *  - <tt>4 bytes</tt> version of the state after the delta
+ *  - for each record: <tt>4 bytes</tt> key, <tt>2 bytes</tt> size
+ *    (SNAPSHOT_DELETED for a deleted record) and the record data.
+ *
+ *  All numbers are little-endian. An answer larger than MAX_DATA_SIZE is
+ *  sent as fragments (see fragments.h). Deleted records are kept until
+ *  snapshot_prune(): a client older than the pruned version gets a full
+ *  state.
+ *  @{
+ */
+
+/*! Snapshot flag: the answer is a full state, not a delta. */
+#define SNAPSHOT_FULL           0x01
+
+/*! Size of the snapshot answer header. */
+#define SNAPSHOT_HEADER_SIZE    9
+
+/*! Size of the header of a record in a snapshot answer. */
+#define SNAPSHOT_RECORD_HEADER  6
+
+/*! Record size marking a deleted record in a snapshot answer. */
+#define SNAPSHOT_DELETED        0xFFFF
+
+/*! Maximum size of a record. */
+#define SNAPSHOT_MAX_RECORD     0xFFFE
+
+/*! State record. */
+struct snapshot_record {
+        unsigned int             key;      /*!< Record identifier.            */
+        unsigned int             version;  /*!< Version of the last change.   */
+        int                      deleted;  /*!< Deleted record (tombstone).   */
+        int                      size;     /*!< Size of the data.             */
+        unsigned char          * data;     /*!< Record data.                  */
+        struct snapshot_record * next;     /*!< Hash bucket link.             */
+        struct snapshot_record * older;    /*!< Previous change.              */
+        struct snapshot_record * newer;    /*!< Next change.                  */
+};
+
+/*! Versioned state, on the server side as well as on the client side. It
+ *  must be initialised with snapshot_init().
+ */
+struct snapshot {
+        unsigned int              version;     /*!< Current version.          */
+        unsigned int              pruned;      /*!< Oldest delta base.        */
+        int                       nb_records;  /*!< Number of records.        */
+        int                       nb_buckets;  /*!< Size of the hash table.   */
+        struct snapshot_record ** buckets;     /*!< Records by key.           */
+        struct snapshot_record  * oldest;      /*!< Least recently changed.   */
+        struct snapshot_record  * newest;      /*!< Most recently changed.    */
+};
+
+/** @} */
+
+
+/** @cond DUPLICATE_DOCUMENTATION */
+void snapshot_init(struct snapshot * snapshot);
+void snapshot_free(struct snapshot * snapshot);
+int snapshot_set(struct snapshot * snapshot, unsigned int key,
+                 const unsigned char * data, int size);
+int snapshot_delete(struct snapshot * snapshot, unsigned int key);
+const struct snapshot_record * snapshot_get(const struct snapshot * snapshot,
+                                            unsigned int key);
+void snapshot_prune(struct snapshot * snapshot, unsigned int version);
+unsigned char * snapshot_encode(const struct snapshot * snapshot,
+                                unsigned int since, size_t * size);
+int snapshot_apply(struct snapshot * snapshot, const unsigned char * data,
+                   size_t size);
+int snapshot_request(int socket_fd, const struct snapshot * snapshot);
+unsigned int snapshot_requested(const unsigned char * packet);
+int snapshot_send(int socket_fd, const struct snapshot * snapshot,
+                  unsigned int since, struct compressor * compressor);
+int snapshot_queue(struct outqueue * queue, const struct snapshot * snapshot,
+                   unsigned int since, int flags);
+/** @endcond */
+
+
+#endif /* SNAPSHOTS_H */
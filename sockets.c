@@ -8,7 +8,8 @@
  *           functions. It allows for socket creation, server socket
  *           creation and installation, server connections, accepting
  *           incomming transmission and waiting for incomming data on
- *           a socket.
+ *           a socket. The sockets are TCP ones (IPv4 or IPv6) or, for the
+ *           local endpoints ("unix:/path"), Unix domain stream sockets.
  *
  *  \author  Thomas Nemeth
  *
@@ -17,88 +18,103 @@
  */
 
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <errno.h>
 #include <signal.h>
 #include <netdb.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <string.h>
 #include <strings.h>
 #include <arpa/inet.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <time.h>
 
 #include "errors.h"
+#include "resolver.h"
 #include "sockets.h"
 
 
-#ifdef SunOS
+
+
 /**
- * \brief IP address conversion.
+ *  \brief Socket address of the peer or of the local end of a socket.
  *
- *        This function convert the given IP address into a structure usable by
- *        the C library functions.
+ *         IPv4 addresses mapped in IPv6 (on a dual-stack server socket) are
+ *         given back as IPv4 addresses.
  *
- * @param padr          IP address
- * @param ia            returned structure built from the IP address
- * @return              the status of the converstion
- * @retval      1       success
- * @retval      0       failure
+ * @param fd            socket to analyse
+ * @param remote        1 for the peer address, 0 for the local one
+ * @param address       returned address
+ * @param len_addr      returned length of the address
+ * @return              the status of the operation
+ * @retval SUCCESS              address found
+ * @retval -ERR_NOT_FOUND       could not get the address
  */
-static int inet_aton_local(char *padr, struct in_addr *ia)
+static int socket_address(int fd, int remote, struct sockaddr_storage *address,
+                          socklen_t *len_addr)
 {
-        int lna, net;
+        struct sockaddr_in6 *ip6 = (struct sockaddr_in6 *) address;
+        int                  status;
 
-        lna = inet_addr(padr); /* Extract the sub-net number */
-        if (lna == -1)
+        *len_addr = sizeof(struct sockaddr_storage);
+        status = remote
+                 ? getpeername(fd, (struct sockaddr *) address, len_addr)
+                 : getsockname(fd, (struct sockaddr *) address, len_addr);
+        if (status != 0)
         {
-                return 0;
+                return -ERR_NOT_FOUND;
         }
-
-        net = inet_network(padr); /* Extact the network number */
-        if (net == -1)
+        if ((address->ss_family == AF_INET6) &&
+            IN6_IS_ADDR_V4MAPPED(&ip6->sin6_addr))
         {
-                return 0;
-        }
+                struct sockaddr_in ip4;
 
-        *ia = inet_makeaddr(net, lna);
-
-        return 1;
+                memset(&ip4, 0, sizeof(ip4));
+                ip4.sin_family = AF_INET;
+                ip4.sin_port = ip6->sin6_port;
+                memcpy(&ip4.sin_addr, &ip6->sin6_addr.s6_addr[12], 4);
+                memcpy(address, &ip4, sizeof(ip4));
+                *len_addr = sizeof(ip4);
+        }
+        return SUCCESS;
 }
-#endif
 
 
 /**
- *  \brief Open a socket.
- *
- *         This function opens a socket of the TCP stream type. A server
- *         (listening) socket must specify its port different from 0.
+ *  \brief Socket creation and configuration.
  *
+ * @param family        AF_INET, AF_INET6 or AF_UNIX
  * @param port          TCP port (0 if not a server)
- * @param ip_address    IP address
- * @param ptr_address   returned structure built from the IP address
- * @return              the file descriptor of the opened socket or a negative
- *                      value in case of error.
+ * @param options       SOCKET_REUSE_PORT or 0 (ignored for AF_UNIX)
+ * @return              the file descriptor of the socket or a negative
+ *                      value in case of error
  * @retval -ERR_CREATE_SOCKET           could not create the socket
  * @retval -ERR_CONFIGURE_SOCKET        could not configure the socket
- * @retval -ERR_UNKNOWN_ADDRESS         could not find host (machine/IP address)
- * @retval -ERR_BIND_SOCKET             could not bind the socket to the address
  */
-int socket_open(int port, char *ip_address, struct sockaddr_in *ptr_address)
+static int socket_create(int family, int port, int options)
 {
-        int                 sock_fd;
-        unsigned int        len_addr = sizeof(struct sockaddr_in);
-        unsigned int        len_ling = sizeof(struct linger);
-        struct sockaddr_in  address;
-        struct linger       ling;
+        int           sock_fd;
+        unsigned int  len_ling = sizeof(struct linger);
+        struct linger ling;
 
         /*
          *      Socket creation
          */
-        sock_fd = socket(AF_INET, SOCK_STREAM, 0);
+        sock_fd = socket(family, SOCK_STREAM, 0);
         if (sock_fd == -1)
         {
                 return -ERR_CREATE_SOCKET;
@@ -107,7 +123,7 @@ int socket_open(int port, char *ip_address, struct sockaddr_in *ptr_address)
         /*
          *      Options setting
          */
-        if (port != 0)
+        if ((port != 0) && (family != AF_UNIX))
         {
                 int opt = 1;
                 if (setsockopt(sock_fd,
@@ -116,55 +132,159 @@ int socket_open(int port, char *ip_address, struct sockaddr_in *ptr_address)
                                &opt,
                                sizeof(int)) == -1)
                 {
+                        close(sock_fd);
+                        return -ERR_CONFIGURE_SOCKET;
+                }
+        }
+#ifdef SO_REUSEPORT
+        if ((options & SOCKET_REUSE_PORT) && (family != AF_UNIX))
+        {
+                int opt = 1;
+                if (setsockopt(sock_fd,
+                               SOL_SOCKET,
+                               SO_REUSEPORT,
+                               &opt,
+                               sizeof(int)) == -1)
+                {
+                        close(sock_fd);
                         return -ERR_CONFIGURE_SOCKET;
                 }
         }
+#else
+        if ((options & SOCKET_REUSE_PORT) && (family != AF_UNIX))
+        {
+                close(sock_fd);
+                return -ERR_CONFIGURE_SOCKET;
+        }
+#endif
+        if (family == AF_INET6)
+        {
+                /* Double pile : accepte aussi les clients IPv4. */
+                int opt = 0;
+                setsockopt(sock_fd, IPPROTO_IPV6, IPV6_V6ONLY, &opt, sizeof(int));
+        }
         ling.l_onoff = 0;
         ling.l_linger = 0;
         if (setsockopt(sock_fd, SOL_SOCKET, SO_LINGER, &ling, len_ling) == -1)
         {
+                close(sock_fd);
                 return -ERR_CONFIGURE_SOCKET;
         }
 
+        return sock_fd;
+}
+
+
+/**
+ *  \brief Removal of the file of a dead local server.
+ *
+ *         The file of a local endpoint outlives its server. It is removed
+ *         when nobody accepts connections on it anymore, so that a new
+ *         server can bind it.
+ *
+ * @param local         address of the local endpoint
+ * @param length        length of the address
+ */
+static void socket_local_stale(const struct sockaddr_un *local, socklen_t length)
+{
+        struct stat status;
+        int         probe;
+
+        if ((local->sun_path[0] == '\0') ||
+            (stat(local->sun_path, &status) != 0) || ! S_ISSOCK(status.st_mode))
+        {
+                return;
+        }
+        probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (probe < 0)
+        {
+                return;
+        }
+        if ((connect(probe, (const struct sockaddr *) local, length) == -1) &&
+            (errno == ECONNREFUSED))
+        {
+                unlink(local->sun_path);
+        }
+        close(probe);
+}
+
+
+/**
+ *  \brief Socket creation and binding.
+ *
+ *         Without IP address, the socket is bound to all the IPv6 and IPv4
+ *         addresses (dual-stack socket), or to all the IPv4 addresses when
+ *         IPv6 is not available. A host name is resolved with the resolver
+ *         cache, and its first address is used. A local endpoint (see
+ *         RESOLVER_UNIX_PREFIX) gives a Unix domain socket, the port being
+ *         ignored.
+ *
+ * @param port          TCP port (0 if not a server)
+ * @param ip_address    IP address, host name or local endpoint
+ * @param ptr_address   returned structure built from the IP address
+ * @param options       SOCKET_REUSE_PORT or 0
+ * @return              the file descriptor of the socket or a negative
+ *                      value in case of error
+ * @retval -ERR_CREATE_SOCKET           could not create the socket
+ * @retval -ERR_CONFIGURE_SOCKET        could not configure the socket
+ * @retval -ERR_UNKNOWN_ADDRESS         could not find host (machine/IP address)
+ * @retval -ERR_BIND_SOCKET             could not bind the socket to the address
+ */
+static int socket_bind(int port, char *ip_address,
+                       struct sockaddr_storage *ptr_address, int options)
+{
+        struct resolver_address address;
+        socklen_t               len_addr;
+        int                     sock_fd;
+
         /*
          *      Address binding preparation
          */
         memset(&address, 0, sizeof(address));
-        address.sin_family = AF_INET;
         if (ip_address)
         {
-                struct in_addr ia;
-
-#ifdef SunOS
-                if (inet_aton_local(ip_address, &ia))
-#else
-                if (inet_aton(ip_address, &ia))
-#endif
+                if (resolver_lookup(ip_address, port, AF_UNSPEC, &address, 1) < 0)
                 {
-                        address.sin_addr = ia;
+                        return -ERR_UNKNOWN_ADDRESS;
                 }
-                else
+                sock_fd = socket_create(address.address.ss_family, port, options);
+        }
+        else
+        {
+                struct sockaddr_in6 *any6 = (struct sockaddr_in6 *) &address.address;
+
+                any6->sin6_family = AF_INET6;
+                any6->sin6_addr = in6addr_any;
+                any6->sin6_port = htons(port);
+                address.length = sizeof(struct sockaddr_in6);
+                sock_fd = socket_create(AF_INET6, port, options);
+                if (sock_fd == -ERR_CREATE_SOCKET)
                 {
-                        struct hostent *h;
+                        struct sockaddr_in *any4 = (struct sockaddr_in *) &address.address;
 
-                        h = gethostbyname(ip_address);
-                        if (!h)
-                        {
-                                return -ERR_UNKNOWN_ADDRESS;
-                        }
-                        memcpy(&address.sin_addr.s_addr, h->h_addr, h->h_length);
+                        /* Pas d'IPv6 sur ce système */
+                        memset(&address, 0, sizeof(address));
+                        any4->sin_family = AF_INET;
+                        any4->sin_addr.s_addr = htonl(INADDR_ANY);
+                        any4->sin_port = htons(port);
+                        address.length = sizeof(struct sockaddr_in);
+                        sock_fd = socket_create(AF_INET, port, options);
                 }
         }
-        else
+        if (sock_fd < 0)
         {
-                address.sin_addr.s_addr = htonl(INADDR_ANY);
+                return sock_fd;
         }
-        address.sin_port = htons(port);
 
         /*
          *      Binding of the socket to the address
          */
-        if (bind(sock_fd, (struct sockaddr *)&address, len_addr) == -1)
+        if (address.address.ss_family == AF_UNIX)
+        {
+                socket_local_stale((struct sockaddr_un *) &address.address,
+                                   address.length);
+        }
+        if (bind(sock_fd, (struct sockaddr *)&address.address, address.length) == -1)
         {
                 close(sock_fd);
                 return -ERR_BIND_SOCKET;
@@ -175,21 +295,189 @@ int socket_open(int port, char *ip_address, struct sockaddr_in *ptr_address)
          */
         if (ptr_address != NULL)
         {
-                getsockname(sock_fd, (struct sockaddr*)ptr_address,
-                            (socklen_t *)&len_addr);
+                len_addr = sizeof(struct sockaddr_storage);
+                getsockname(sock_fd, (struct sockaddr*)ptr_address, &len_addr);
+        }
+
+        return sock_fd;
+}
+
+
+/**
+ *  \brief Open a socket.
+ *
+ *         This function opens a socket of the TCP stream type. A server
+ *         (listening) socket must specify its port different from 0. The
+ *         IP address may be an IPv4 or IPv6 address or a host name. A
+ *         local endpoint ("unix:/path") opens a Unix domain stream socket
+ *         bound to the path.
+ *
+ * @param port          TCP port (0 if not a server)
+ * @param ip_address    IP address or local endpoint
+ * @param ptr_address   returned structure built from the IP address
+ * @return              the file descriptor of the opened socket or a negative
+ *                      value in case of error.
+ * @retval -ERR_CREATE_SOCKET           could not create the socket
+ * @retval -ERR_CONFIGURE_SOCKET        could not configure the socket
+ * @retval -ERR_UNKNOWN_ADDRESS         could not find host (machine/IP address)
+ * @retval -ERR_BIND_SOCKET             could not bind the socket to the address
+ */
+int socket_open(int port, char *ip_address, struct sockaddr_storage *ptr_address)
+{
+        return socket_bind(port, ip_address, ptr_address, 0);
+}
+
+
+/**
+ *  \brief Current date in milliseconds, unaffected by the clock changes.
+ */
+static long long socket_now(void)
+{
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (long long) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+
+/**
+ *  \brief Non-blocking connection start.
+ *
+ *         This function creates a non-blocking socket and starts its
+ *         connection to the given address. The connection is established
+ *         when the socket becomes writable, its result is then given by
+ *         socket_connect_status(). The connection to a local endpoint
+ *         whose backlog is full fails at once.
+ *
+ * @param address       address of the server
+ * @param length        length of the address
+ * @return              the file descriptor of the socket or a negative
+ *                      value in case of error
+ * @retval -ERR_CREATE_SOCKET           could not create the socket
+ * @retval -ERR_CONFIGURE_SOCKET        could not configure the socket
+ * @retval -ERR_CONNECT_SERVER          the connection failed at once
+ */
+int socket_connect_start(const struct sockaddr *address, socklen_t length)
+{
+        int sock_fd = socket_create(address->sa_family, 0, 0);
+
+        if (sock_fd < 0)
+        {
+                return sock_fd;
+        }
+        if (socket_nonblocking(sock_fd) != SUCCESS)
+        {
+                close(sock_fd);
+                return -ERR_CONFIGURE_SOCKET;
+        }
+        if ((connect(sock_fd, address, length) == -1) && (errno != EINPROGRESS))
+        {
+                close(sock_fd);
+                return -ERR_CONNECT_SERVER;
         }
 
         return sock_fd;
 }
 
 
+/**
+ *  \brief Non-blocking connection result.
+ *
+ * @param fd            socket given by socket_connect_start(), writable
+ * @return              the result of the connection
+ * @retval SUCCESS                      socket connected
+ * @retval -ERR_CONNECT_SERVER          the connection failed
+ */
+int socket_connect_status(int fd)
+{
+        int       error = 0;
+        socklen_t len = sizeof(error);
+
+        if ((getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) == -1) ||
+            (error != 0))
+        {
+                return -ERR_CONNECT_SERVER;
+        }
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Blocking connection to a local endpoint.
+ *
+ *         A non-blocking connection to a Unix domain socket does not wait
+ *         for room in the backlog of the server: this one blocks, until
+ *         the deadline (SO_SNDTIMEO).
+ *
+ * @param address       address of the local endpoint
+ * @param deadline      deadline (socket_now()), 0 for no deadline
+ * @return              the file descriptor of the socket or a negative
+ *                      value in case of error
+ * @retval -ERR_CREATE_SOCKET           could not create the socket
+ * @retval -ERR_CONFIGURE_SOCKET        could not configure the socket
+ * @retval -ERR_CONNECT_SERVER          the connection failed
+ * @retval -ERR_TIMEOUT                 the deadline elapsed
+ */
+static int socket_connect_local(const struct resolver_address *address,
+                                long long deadline)
+{
+        struct timeval wait = {0, 0};
+        int            sock_fd = socket_create(AF_UNIX, 0, 0);
+        int            status = -ERR_CONNECT_SERVER;
+
+        if (sock_fd < 0)
+        {
+                return sock_fd;
+        }
+        if (deadline)
+        {
+                long long left = deadline - socket_now();
+
+                if (left <= 0)
+                {
+                        close(sock_fd);
+                        return -ERR_TIMEOUT;
+                }
+                wait.tv_sec = left / 1000;
+                wait.tv_usec = (left % 1000) * 1000;
+        }
+        if (setsockopt(sock_fd, SOL_SOCKET, SO_SNDTIMEO, &wait, sizeof(wait)) == -1)
+        {
+                close(sock_fd);
+                return -ERR_CONFIGURE_SOCKET;
+        }
+
+        while (connect(sock_fd, (const struct sockaddr *) &address->address,
+                       address->length) == -1)
+        {
+                if (errno == EINTR)
+                {
+                        continue;
+                }
+                if ((errno == EAGAIN) || (errno == EINPROGRESS))
+                {
+                        status = -ERR_TIMEOUT;
+                }
+                close(sock_fd);
+                return status;
+        }
+
+        /* Le délai ne doit pas s'appliquer aux envois. */
+        wait.tv_sec = 0;
+        wait.tv_usec = 0;
+        setsockopt(sock_fd, SOL_SOCKET, SO_SNDTIMEO, &wait, sizeof(wait));
+
+        return sock_fd;
+}
+
+
 /**
  *  \brief Connect to a server.
  *
  *         This function opens a socket of the stream type and tries to
- *         connect a server.
+ *         connect a server, without time limit. See connect_server_timeout().
  *
- * @param machine       IP address or hostname of the server
+ * @param machine       IP address, hostname or local endpoint of the server
  * @param port          TCP port to connect to on the server
  * @return              the file descriptor of the opened socket or a negative
  *                      value in case of error
@@ -197,15 +485,48 @@ int socket_open(int port, char *ip_address, struct sockaddr_in *ptr_address)
  * @retval -ERR_SERVER_INFO             could not find server information
  * @retval -ERR_CREATE_SOCKET           could not create the socket
  * @retval -ERR_CONFIGURE_SOCKET        could not configure the socket
- * @retval -ERR_UNKNOWN_ADDRESS         could not find address (host)
- * @retval -ERR_BIND_SOCKET             could not bind the socket
  * @retval -ERR_CONNECT_SERVER          could not connect to the given server
  */
 int connect_server(const char *machine, int port)
 {
-        struct hostent     * server_ent;
-        struct sockaddr_in   server_addr, client_addr;
-        int                  sock_fd;
+        return connect_server_timeout(machine, port, 0);
+}
+
+
+/**
+ *  \brief Connect to a server with a deadline.
+ *
+ *         This function opens a socket of the stream type and tries to
+ *         connect a server before the deadline. The name of the server is
+ *         resolved through the resolver cache, a local endpoint ("unix:/path"
+ *         or "unix:@name") is connected without any lookup. Its addresses are tried
+ *         Happy Eyeballs style (RFC 8305): families interleaved, a new
+ *         attempt started every CONNECT_ATTEMPT_DELAY milliseconds (or as
+ *         soon as one fails) while the previous ones go on, and the first
+ *         connected socket is kept. The returned socket is in blocking
+ *         mode. An event loop should use connector_start() instead.
+ *
+ * @param machine       IP address, hostname or local endpoint of the server
+ * @param port          TCP port to connect to on the server
+ * @param timeout       deadline in milliseconds (0 for no deadline)
+ * @return              the file descriptor of the opened socket or a negative
+ *                      value in case of error
+ * @retval -ERR_BAD_PARAMETER           remote host no given in parameter
+ * @retval -ERR_SERVER_INFO             could not find server information
+ * @retval -ERR_CREATE_SOCKET           could not create the socket
+ * @retval -ERR_CONFIGURE_SOCKET        could not configure the socket
+ * @retval -ERR_CONNECT_SERVER          could not connect to the given server
+ * @retval -ERR_TIMEOUT                 the deadline elapsed
+ */
+int connect_server_timeout(const char *machine, int port, int timeout)
+{
+        struct resolver_address addresses[RESOLVER_MAX_ADDRESSES];
+        struct pollfd           attempts[RESOLVER_MAX_ADDRESSES];
+        int                     nb_addresses, nb_started = 0, nb_attempts = 0;
+        int                     status = -ERR_CONNECT_SERVER;
+        int                     sock_fd = -1;
+        long long               deadline, next_start, now;
+        int                     i, wait;
 
         /*
          *      Look for the host where the server is
@@ -214,36 +535,101 @@ int connect_server(const char *machine, int port)
         {
                 return -ERR_BAD_PARAMETER;
         }
-        server_ent = gethostbyname(machine);
-        if (server_ent == NULL)
+        nb_addresses = resolver_lookup(machine, port, AF_UNSPEC,
+                                       addresses, RESOLVER_MAX_ADDRESSES);
+        if (nb_addresses <= 0)
         {
                 return -ERR_SERVER_INFO;
         }
-
-        /*
-         *      Communication socket creation -- indifferent port
-         */
-        sock_fd = socket_open(0, NULL, (struct sockaddr_in *)&client_addr);
-        if (sock_fd < 0)
+        now = socket_now();
+        deadline = timeout > 0 ? now + timeout : 0;
+        if (addresses[0].address.ss_family == AF_UNIX)
         {
-                return sock_fd;
+                return socket_connect_local(&addresses[0], deadline);
         }
+        resolver_interleave(addresses, nb_addresses);
 
-        /*
-         *      Server address preparation
-         */
-        server_addr.sin_family = AF_INET;
-        server_addr.sin_port = htons(port);
-        memcpy(&server_addr.sin_addr.s_addr,
-               server_ent->h_addr, server_ent->h_length);
+        next_start = now;
+        while (sock_fd < 0)
+        {
+                /*
+                 *      Next attempt, when the previous one is late or failed
+                 */
+                now = socket_now();
+                if ((nb_started < nb_addresses) &&
+                    ((now >= next_start) || (nb_attempts == 0)))
+                {
+                        int fd = socket_connect_start(
+                                (struct sockaddr *) &addresses[nb_started].address,
+                                addresses[nb_started].length);
 
-        /*
-         *      Connecting to the server
-         */
-        if (connect(sock_fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1)
+                        nb_started++;
+                        if (fd < 0)
+                        {
+                                status = fd;
+                                continue;
+                        }
+                        attempts[nb_attempts].fd = fd;
+                        attempts[nb_attempts].events = POLLOUT;
+                        attempts[nb_attempts].revents = 0;
+                        nb_attempts++;
+                        next_start = now + CONNECT_ATTEMPT_DELAY;
+                }
+                if (nb_attempts == 0)
+                {
+                        break;
+                }
+                if (deadline && (now >= deadline))
+                {
+                        status = -ERR_TIMEOUT;
+                        break;
+                }
+
+                /*
+                 *      Waiting for the next attempt or the deadline
+                 */
+                wait = -1;
+                if (nb_started < nb_addresses)
+                {
+                        wait = (int) (next_start - now);
+                }
+                if (deadline && ((wait < 0) || (deadline - now < wait)))
+                {
+                        wait = (int) (deadline - now);
+                }
+                if ((poll(attempts, nb_attempts, wait) < 0) && (errno != EINTR))
+                {
+                        break;
+                }
+
+                for (i = 0 ; (i < nb_attempts) && (sock_fd < 0) ; i++)
+                {
+                        if (! attempts[i].revents)
+                        {
+                                continue;
+                        }
+                        if (socket_connect_status(attempts[i].fd) == SUCCESS)
+                        {
+                                sock_fd = attempts[i].fd;
+                                attempts[i] = attempts[--nb_attempts];
+                                break;
+                        }
+                        /* Échec : la tentative suivante part tout de suite. */
+                        close(attempts[i].fd);
+                        attempts[i--] = attempts[--nb_attempts];
+                        next_start = 0;
+                }
+        }
+
+        for (i = 0 ; i < nb_attempts ; i++)
         {
-                return -ERR_CONNECT_SERVER;
+                close(attempts[i].fd);
         }
+        if (sock_fd < 0)
+        {
+                return status;
+        }
+        fcntl(sock_fd, F_SETFL, fcntl(sock_fd, F_GETFL, 0) & ~O_NONBLOCK);
 
         return sock_fd;
 }
@@ -254,11 +640,44 @@ int connect_server(const char *machine, int port)
  *
  *         This function installs a server on a listening socket in order
  *         to wait for incomming clients connections. It returns the file
- *         descriptor of the opened listening socket.
+ *         descriptor of the opened listening socket. A local endpoint
+ *         ("unix:/path") listens on a Unix domain socket: its file is
+ *         replaced if its server is dead, and is not removed when the
+ *         socket is closed.
+ *
+ * @param port          the TCP port on which to listen
+ * @param ip_address    the IP address (or local endpoint) to bind to
+ * @param ptr_address   returned information about the socket
+ * @return              the file descriptor index of the socket, a negative
+ *                      value in case of error
+ * @retval -ERR_CREATE_SOCKET           could not create the socket
+ * @retval -ERR_CONFIGURE_SOCKET        could not configure the socket
+ * @retval -ERR_UNKNOWN_ADDRESS         could not find address (host)
+ * @retval -ERR_BIND_SOCKET             could not bind the socket
+ * @retval -ERR_SERVER_LISTEN           could not configure the listening
+ */
+int install_server(int port, char *ip_address,
+                   struct sockaddr_storage *ptr_address)
+{
+        return socket_listen(port, ip_address, ptr_address, SOCKET_BACKLOG, 0);
+}
+
+
+/**
+ *  \brief Configurable server installation function.
+ *
+ *         This function installs a server like install_server() with the
+ *         given backlog (maximum number of connections waiting to be
+ *         accepted). With SOCKET_REUSE_PORT, many sockets can listen on
+ *         the same port, the kernel spreading the incomming connections
+ *         among them (not for a local endpoint, where the option is
+ *         ignored).
  *
  * @param port          the TCP port on which to listen
- * @param ip_address    the IP address to bind to
+ * @param ip_address    the IP address (or local endpoint) to bind to
  * @param ptr_address   returned information about the socket
+ * @param backlog       the backlog of the socket (0 for SOCKET_BACKLOG)
+ * @param options       SOCKET_REUSE_PORT or 0
  * @return              the file descriptor index of the socket, a negative
  *                      value in case of error
  * @retval -ERR_CREATE_SOCKET           could not create the socket
@@ -267,9 +686,10 @@ int connect_server(const char *machine, int port)
  * @retval -ERR_BIND_SOCKET             could not bind the socket
  * @retval -ERR_SERVER_LISTEN           could not configure the listening
  */
-int install_server(int port, char *ip_address, struct sockaddr_in *ptr_address)
+int socket_listen(int port, char *ip_address,
+                  struct sockaddr_storage *ptr_address, int backlog, int options)
 {
-        int sock_fd = socket_open(port, ip_address, ptr_address);
+        int sock_fd = socket_bind(port, ip_address, ptr_address, options);
 
         if (sock_fd < 0)
         {
@@ -279,8 +699,9 @@ int install_server(int port, char *ip_address, struct sockaddr_in *ptr_address)
         /*
          *      Service opening declaration
          */
-        if (listen(sock_fd, 10) == -1)
+        if (listen(sock_fd, backlog > 0 ? backlog : SOCKET_BACKLOG) == -1)
         {
+                close(sock_fd);
                 return -ERR_SERVER_LISTEN;
         }
 
@@ -310,15 +731,17 @@ int wait_timeout(int fd, int timeout)
 
         if (timeout > 0)
         {
-                int            result;
-                fd_set         read_set;
-                struct timeval tv;
+                int           result;
+                struct pollfd pfd;
 
-                FD_ZERO(&read_set);
-                FD_SET(fd, &read_set);
-                tv.tv_sec = timeout;
-                tv.tv_usec = 0;
-                result = select(fd + 1, &read_set, NULL, NULL, &tv);
+                /*
+                 *      poll() plutôt que select() : pas de limite
+                 *      FD_SETSIZE sur la valeur du descripteur.
+                 */
+                pfd.fd = fd;
+                pfd.events = POLLIN;
+                pfd.revents = 0;
+                result = poll(&pfd, 1, timeout * 1000);
                 if (result == 0)
                 {
                         return -ERR_TIMEOUT;
@@ -351,10 +774,10 @@ int wait_timeout(int fd, int timeout)
  */
 int accept_connection(int socket_server, int timeout)
 {
-        int                delay;
-        int                sock_fd;
-        int                len_address = sizeof(struct sockaddr_in);
-        struct sockaddr_in address;
+        int                     delay;
+        int                     sock_fd;
+        socklen_t               len_address = sizeof(struct sockaddr_storage);
+        struct sockaddr_storage address;
 
         delay = wait_timeout(socket_server, timeout);
         if (delay < 0)
@@ -367,7 +790,7 @@ int accept_connection(int socket_server, int timeout)
          */
         sock_fd = accept(socket_server,
                         (struct sockaddr *)&address,
-                        (socklen_t *) &len_address);
+                        &len_address);
 
         /*
          *      Got SIGPIPE
@@ -398,12 +821,68 @@ int accept_connection(int socket_server, int timeout)
 }
 
 
+/**
+ *  \brief Non-blocking mode setting function.
+ *
+ *         This function puts a socket in non-blocking mode, as needed by
+ *         the event loop.
+ *
+ * @param fd                    socket to configure
+ * @return                      the status of the operation
+ * @retval SUCCESS                      socket configured
+ * @retval -ERR_CONFIGURE_SOCKET        could not configure the socket
+ */
+int socket_nonblocking(int fd)
+{
+        int flags = fcntl(fd, F_GETFL, 0);
+
+        if ((flags == -1) || (fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1))
+        {
+                return -ERR_CONFIGURE_SOCKET;
+        }
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Unsent data limit setting function.
+ *
+ *         This function limits the data waiting in the socket buffer to be
+ *         sent (TCP_NOTSENT_LOWAT): a non-blocking socket is not writable
+ *         while more data is waiting. The packets queued afterwards, such
+ *         as the control messages of an outgoing queue sending a large
+ *         payload (see outqueue.h), then wait for this data at most instead
+ *         of the whole socket buffer.
+ *
+ * @param fd                    TCP socket to configure
+ * @param size                  maximum unsent data size in bytes
+ * @return                      the status of the operation
+ * @retval SUCCESS                      socket configured
+ * @retval -ERR_CONFIGURE_SOCKET        could not configure the socket (not
+ *                                      a TCP socket)
+ */
+int socket_unsent_limit(int fd, int size)
+{
+        if (setsockopt(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT,
+                       &size, sizeof(size)) == -1)
+        {
+                return -ERR_CONFIGURE_SOCKET;
+        }
+
+        return SUCCESS;
+}
+
+
 /**
  *  \brief Socket remote hostname function.
  *
  *        This function gets the remote hostname of the given socket. A NULL
  *        value for a char * parameter makes this parameter information not
- *        returned.
+ *        returned. This function never waits for the DNS: the name comes
+ *        from the resolver cache, and while it is not known (its lookup is
+ *        then queued for the resolver threads) the numeric IP address is
+ *        returned instead. The peer of a local endpoint is "localhost".
  *
  * @param fd                    socket to analyse
  * @param name                  hostname of the remote machine
@@ -414,40 +893,87 @@ int accept_connection(int socket_server, int timeout)
  */
 int socket_remote_host(int fd, char * name, int len)
 {
-        struct sockaddr_in info;
-#ifdef OpenBSD
-        int                infolen;
-#else
-        socklen_t          infolen;
-#endif
+        struct sockaddr_storage info;
+        socklen_t               infolen;
 
-        infolen = sizeof(info);
-        if (getpeername(fd, (struct sockaddr *) &info, &infolen) != 0)
+        if (socket_address(fd, 1, &info, &infolen) != SUCCESS)
         {
                 return -ERR_NOT_FOUND;
         }
+        if (name && (info.ss_family == AF_UNIX))
+        {
+                return snprintf(name, len, "localhost") < len
+                       ? SUCCESS
+                       : -ERR_NOT_FOUND;
+        }
         if (name)
         {
-                struct hostent * machine = gethostbyaddr((char *)&info.sin_addr,
-                                                         sizeof(info.sin_addr),
-                                                         info.sin_family);
-                if (machine == NULL)
+                if ((resolver_reverse_cached((struct sockaddr *) &info, infolen,
+                                             name, len) != SUCCESS) &&
+                    (getnameinfo((struct sockaddr *) &info, infolen, name, len,
+                                 NULL, 0, NI_NUMERICHOST) != 0))
                 {
                         return -ERR_NOT_FOUND;
                 }
-
-                strncpy(name, machine->h_name, len);
         }
         return SUCCESS;
 }
 
 
+/**
+ *  \brief Endpoint of a local connection.
+ *
+ *         The client end of a local connection has no name: the endpoint
+ *         is then the name of the server end.
+ *
+ * @param fd            socket to analyse
+ * @param info          address of the peer
+ * @param infolen       length of the address
+ * @param endpoint      returned endpoint
+ * @param len           maximum length of the endpoint
+ * @return              the status of the operation
+ * @retval SUCCESS              endpoint found
+ * @retval -ERR_NOT_FOUND       unnamed socket or endpoint too long
+ */
+static int socket_local_endpoint(int fd, struct sockaddr_storage * info,
+                                 socklen_t infolen, char * endpoint, int len)
+{
+        struct sockaddr_un * local = (struct sockaddr_un *) info;
+        int                  path = offsetof(struct sockaddr_un, sun_path);
+        int                  written;
+
+        if ((infolen <= (socklen_t) path) &&
+            (socket_address(fd, 0, info, &infolen) != SUCCESS))
+        {
+                return -ERR_NOT_FOUND;
+        }
+        if (infolen <= (socklen_t) path)
+        {
+                return -ERR_NOT_FOUND;
+        }
+        if (local->sun_path[0] == '\0')
+        {
+                /* Espace abstrait : le nom n'est pas terminé par '\0'. */
+                written = snprintf(endpoint, len, "%s@%.*s", RESOLVER_UNIX_PREFIX,
+                                   (int) infolen - path - 1, &local->sun_path[1]);
+        }
+        else
+        {
+                written = snprintf(endpoint, len, "%s%s", RESOLVER_UNIX_PREFIX,
+                                   local->sun_path);
+        }
+
+        return (written >= 0) && (written < len) ? SUCCESS : -ERR_NOT_FOUND;
+}
+
+
 /**
  *  \brief Socket remote IP address function.
  *
- *        This function gets the remote IP address of the given socket. A NULL
- *        value for a char * parameter makes this parameter information not
- *        returned.
+ *        This function gets the remote IP address (IPv4 or IPv6) of the
+ *        given socket. A NULL value for a char * parameter makes this
+ *        parameter information not returned. A local endpoint connection
+ *        gives its endpoint ("unix:/path"), on both sides.
  *
  * @param fd                    socket to analyse
  * @param addr                  IP address of the remote machine
@@ -458,30 +984,51 @@ int socket_remote_host(int fd, char * name, int len)
  */
 int socket_remote_ip(int fd, char * addr, int len)
 {
-        struct sockaddr_in info;
-#ifdef OpenBSD
-        int                infolen;
-#else
-        socklen_t          infolen;
-#endif
+        struct sockaddr_storage info;
+        socklen_t               infolen;
 
-        infolen = sizeof(info);
-        if (getpeername(fd, (struct sockaddr *) &info, &infolen) != 0)
+        if (socket_address(fd, 1, &info, &infolen) != SUCCESS)
         {
                 return -ERR_NOT_FOUND;
         }
+        if (addr && (info.ss_family == AF_UNIX))
+        {
+                return socket_local_endpoint(fd, &info, infolen, addr, len);
+        }
         if (addr)
         {
-                strncpy(addr, inet_ntoa(info.sin_addr), len);
+                if (getnameinfo((struct sockaddr *) &info, infolen, addr, len,
+                                NULL, 0, NI_NUMERICHOST) != 0)
+                {
+                        return -ERR_NOT_FOUND;
+                }
         }
         return SUCCESS;
 }
 
 
+/**
+ *  \brief Port of a socket address.
+ */
+static int socket_port(const struct sockaddr_storage * info)
+{
+        if (info->ss_family == AF_UNIX)
+        {
+                return 0;
+        }
+        if (info->ss_family == AF_INET6)
+        {
+                return ntohs(((const struct sockaddr_in6 *) info)->sin6_port);
+        }
+        return ntohs(((const struct sockaddr_in *) info)->sin_port);
+}
+
+
 /**
  *  \brief Socket remote port information function.
  *
- *        This function returns the remote port ofthe given socket.
+ *        This function returns the remote port ofthe given socket (0 for
+ *        a local endpoint).
  *
  * @param fd                    socket to analyse
  * @return                      the remote port of the socket or -ERR_NOT_FOUND
@@ -489,26 +1036,22 @@ int socket_remote_ip(int fd, char * addr, int len)
  */
 int socket_remote_port(int fd)
 {
-        struct sockaddr_in info;
-#ifdef OpenBSD
-        int                infolen;
-#else
-        socklen_t          infolen;
-#endif
+        struct sockaddr_storage info;
+        socklen_t               infolen;
 
-        infolen = sizeof(info);
-        if (getpeername(fd, (struct sockaddr *) &info, &infolen) != 0)
+        if (socket_address(fd, 1, &info, &infolen) != SUCCESS)
         {
                 return -ERR_NOT_FOUND;
         }
-        return ntohs(info.sin_port);
+        return socket_port(&info);
 }
 
 
 /**
  *  \brief Socket local port information function.
  *
- *        This function returns the local port of the given socket.
+ *        This function returns the local port of the given socket (0 for
+ *        a local endpoint).
  *
  * @param fd                    socket to analyse
  * @return                      the local port of the socket or -ERR_NOT_FOUND
@@ -516,17 +1059,69 @@ int socket_remote_port(int fd)
  */
 int socket_local_port(int fd)
 {
-        struct sockaddr_in info;
-#ifdef OpenBSD
-        int                infolen;
-#else
-        socklen_t          infolen;
-#endif
+        struct sockaddr_storage info;
+        socklen_t               infolen;
 
-        infolen = sizeof(info);
-        if (getsockname(fd, (struct sockaddr *) &info, &infolen) != 0)
+        if (socket_address(fd, 0, &info, &infolen) != SUCCESS)
         {
                 return -ERR_NOT_FOUND;
         }
-        return ntohs(info.sin_port);
+        return socket_port(&info);
+}
+
+
+/**
+ *  \brief Socket peer credentials function.
+ *
+ *        This function gets the process, user and group of the peer of a
+ *        local endpoint connection, as given by the kernel (SO_PEERCRED)
+ *        when the connection was made: they can be trusted without any
+ *        lookup. A NULL pointer makes its information not returned.
+ *
+ * @param fd                    socket to analyse
+ * @param pid                   process of the peer
+ * @param uid                   user of the peer
+ * @param gid                   group of the peer
+ * @return                      the status of the operation
+ * @retval SUCCESS              credentials found
+ * @retval -ERR_NOT_FOUND       not a local endpoint connection, or no
+ *                              credentials on this system
+ */
+int socket_peer_credentials(int fd, pid_t * pid, uid_t * uid, gid_t * gid)
+{
+#ifdef SO_PEERCRED
+        struct sockaddr_storage info;
+        struct ucred            credentials;
+        socklen_t               length;
+
+        if ((socket_address(fd, 0, &info, &length) != SUCCESS) ||
+            (info.ss_family != AF_UNIX))
+        {
+                return -ERR_NOT_FOUND;
+        }
+        length = sizeof(credentials);
+        if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) != 0)
+        {
+                return -ERR_NOT_FOUND;
+        }
+        if (pid)
+        {
+                *pid = credentials.pid;
+        }
+        if (uid)
+        {
+                *uid = credentials.uid;
+        }
+        if (gid)
+        {
+                *gid = credentials.gid;
+        }
+        return SUCCESS;
+#else
+        (void) fd;
+        (void) pid;
+        (void) uid;
+        (void) gid;
+        return -ERR_NOT_FOUND;
+#endif
 }
@@ -17,18 +17,40 @@
 #ifndef SOCKETS_H
 #define SOCKETS_H
 
+#include <sys/types.h>
+#include <sys/socket.h>
 #include <netinet/in.h>
 
+/*! Default backlog of the listening sockets. */
+#define SOCKET_BACKLOG          10
+
+/*! socket_listen() option: many sockets may listen on the same port. */
+#define SOCKET_REUSE_PORT       0x01
+
+/*! Delay before the next address is tried by a connection attempt, in
+ *  milliseconds (Happy Eyeballs "connection attempt delay").
+ */
+#define CONNECT_ATTEMPT_DELAY   250
+
 /** @cond DUPLICATE_DOCUMENTATION */
-int socket_open(int port, char *ip_address, struct sockaddr_in *ptr_address);
+int socket_open(int port, char *ip_address, struct sockaddr_storage *ptr_address);
 int connect_server(const char *machine, int port);
-int install_server(int port, char *ip_address, struct sockaddr_in *ptr_address);
+int connect_server_timeout(const char *machine, int port, int timeout);
+int socket_connect_start(const struct sockaddr *address, socklen_t length);
+int socket_connect_status(int fd);
+int install_server(int port, char *ip_address,
+                   struct sockaddr_storage *ptr_address);
+int socket_listen(int port, char *ip_address,
+                  struct sockaddr_storage *ptr_address, int backlog, int options);
 int wait_timeout(int fd, int timeout);
 int accept_connection(int socket_server, int timeout);
+int socket_nonblocking(int fd);
+int socket_unsent_limit(int fd, int size);
 int socket_remote_host(int fd, char * name, int len);
 int socket_remote_ip(int fd, char * addr, int len);
 int socket_remote_port(int fd);
 int socket_local_port(int fd);
+int socket_peer_credentials(int fd, pid_t * pid, uid_t * uid, gid_t * gid);
 /** @endcond */
 
 
@@ -53,6 +53,18 @@
  *  \hline
  *  Error message      & Error        & 0xFF &      & X    & X \\
  *  \hline
+ *  Capabilities       & Negotiation  & 0x0E & X    & X    & X \\
+ *  \hline
+ *  Fragment           & Large payload & 0xF0 & X    & X    & X \\
+ *  \hline
+ *  Compressed         & Compressed packet & 0xF1 & X  & X    & X \\
+ *  \hline
+ *  Request            & Identified request & 0xF2 & X  &      & X \\
+ *  \hline
+ *  Response           & Identified answer & 0xF3 &    & X    & X \\
+ *  \hline
+ *  Shared memory      & Upgrade offer & 0xF4 & X    &      & X \\
+ *  \hline
  *  \end{tabular}
  *  \endlatexonly
  *
@@ -69,6 +81,13 @@
 #define CMD_DUMP_STATE      0x07
 #define CMD_SET_SELECTION   0x08
 #define CMD_DISCONNECT      0x0D
+#define CMD_CAPABILITIES    0x0E  /*!< Capabilities negotiation.            */
+
+#define PACKET_FRAGMENT     0xF0  /*!< Fragment of a large payload.         */
+#define PACKET_COMPRESSED   0xF1  /*!< Packet with compressed data.         */
+#define PACKET_REQUEST      0xF2  /*!< Request with an identifier.          */
+#define PACKET_RESPONSE     0xF3  /*!< Response to an identified request.   */
+#define PACKET_SHM          0xF4  /*!< Shared memory upgrade offer.         */
 
 #define PACKET_MSG_ACK      0xFA  /*!< Acknowledge message from server.     */
 #define PACKET_MSG_NACK     0xFB  /*!< Acknowledge message from server.     */
@@ -0,0 +1,1158 @@
+/**
+ *  \file    cyberschema.c
+ *  \brief   Payload schema compiler.
+ *
+ *           Project: cybercomms (Cyberspace communication library).
+ *
+ *           This program turns a payload schema into a C header (see
+ *           schema.h): offsets and sizes of the fields, structures,
+ *           accessors reading the fields in place, exact-size encoders and,
+ *           for C++, view classes with constexpr offsets and sizes.
+ *
+ *           A schema is a list of messages:
+ *
+ *           \code
+ *           # Comment lines before a message document it.
+ *           [packed] message NAME [TAG] {
+ *                   TYPE NAME;              # comment of the field
+ *                   TYPE NAME[COUNT];
+ *                   TYPE NAME[];            # last field only
+ *           }
+ *           \endcode
+ *
+ *           The types are u8, i8, u16, i16, u32, i32, u64, i64, f32, f64
+ *           and char (the char arrays are strings padded with '\\0', or
+ *           filling the array). The TAG is a tags.h name or a number: the
+ *           messages with a TAG get a packer writing the whole packet.
+ *
+ *           Usage: cyberschema SCHEMA [HEADER]
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+
+
+/*! Maximum length of a name or of a comment. */
+#define NAME_SIZE       128
+
+/*! Maximum number of fields of a message. */
+#define MAX_FIELDS      64
+
+/*! Maximum number of messages of a schema. */
+#define MAX_MESSAGES    128
+
+/*! Largest fixed part of a message (the data of a packet). */
+#define MAX_SIZE        65534
+
+
+/*! Field type. */
+struct type {
+        const char * name;       /*!< Schema name.                     */
+        const char * ctype;      /*!< C type.                          */
+        const char * access;     /*!< schema_get_/schema_put_ suffix.  */
+        int          size;       /*!< Size in bytes.                   */
+};
+
+/*! Known types. */
+static const struct type types[] = {
+        {"u8",   "uint8_t",  "u8",  1},
+        {"i8",   "int8_t",   "u8",  1},
+        {"char", "char",     "u8",  1},
+        {"u16",  "uint16_t", "u16", 2},
+        {"i16",  "int16_t",  "u16", 2},
+        {"u32",  "uint32_t", "u32", 4},
+        {"i32",  "int32_t",  "u32", 4},
+        {"u64",  "uint64_t", "u64", 8},
+        {"i64",  "int64_t",  "u64", 8},
+        {"f32",  "float",    "f32", 4},
+        {"f64",  "double",   "f64", 8},
+        {NULL,   NULL,       NULL,  0}
+};
+
+/*! Message field. */
+struct field {
+        char                name[NAME_SIZE];     /*!< Field name.          */
+        char                comment[NAME_SIZE];  /*!< Documentation.       */
+        const struct type * type;                /*!< Type.                */
+        int                 count;               /*!< Elements (1: scalar,
+                                                      0: tail).            */
+        int                 array;               /*!< Declared as array.   */
+        int                 offset;              /*!< Offset in the data.  */
+};
+
+/*! Message. */
+struct message {
+        char         name[NAME_SIZE];     /*!< Message name.               */
+        char         upper[NAME_SIZE];    /*!< Name of its macros.         */
+        char         tag[NAME_SIZE];      /*!< TAG ("" if none).           */
+        char         comment[NAME_SIZE * 4]; /*!< Documentation.           */
+        int          packed;              /*!< No alignment of the fields. */
+        int          align;               /*!< Alignment of the message.   */
+        int          size;                /*!< Size of the fixed part.     */
+        int          nb_fields;           /*!< Number of fields.           */
+        struct field fields[MAX_FIELDS];  /*!< Fields.                     */
+        struct field * tail;              /*!< Last field of any length.   */
+};
+
+/*! Schema reader. */
+struct reader {
+        const char * file;                /*!< Schema file name.           */
+        FILE       * input;               /*!< Schema file.                */
+        int          line;                /*!< Current line.               */
+        char         token[NAME_SIZE];    /*!< Current token.              */
+        char         comment[NAME_SIZE * 4]; /*!< Comments before it.      */
+        int          same_line;           /*!< Comment on the line of the
+                                               previous token.             */
+        int          previous_line;       /*!< Line of the previous token. */
+};
+
+/*! Names of the fields reserved for the generated functions. */
+static const char * reserved[] = {
+        "check", "validate", "encode", "decode", "pack", "packet_size",
+        "data", "byte_size", "alignment", "tag_value", NULL
+};
+
+/*! Output file name (removed on error). */
+static const char * output_name = NULL;
+
+
+/**
+ *  \brief Error report: prints the message and exits.
+ */
+static void fail(const struct reader * reader, const char * format, ...)
+{
+        va_list arguments;
+
+        fprintf(stderr, "%s:%d: error: ", reader->file, reader->line);
+        va_start(arguments, format);
+        vfprintf(stderr, format, arguments);
+        va_end(arguments);
+        fprintf(stderr, "\n");
+        if (output_name)
+        {
+                remove(output_name);
+        }
+        exit(1);
+}
+
+
+/**
+ *  \brief Comment reading: appends it to the comments of the next token.
+ */
+static void read_comment(struct reader * reader)
+{
+        char   text[NAME_SIZE * 4];
+        size_t length = 0;
+        int    c = fgetc(reader->input);
+
+        while ((c == ' ') || (c == '\t') || (c == '#'))
+        {
+                c = fgetc(reader->input);
+        }
+        while ((c != EOF) && (c != '\n'))
+        {
+                if (length < sizeof(text) - 1)
+                {
+                        text[length++] = c;
+                }
+                c = fgetc(reader->input);
+        }
+        while ((length > 0) && isspace((unsigned char) text[length - 1]))
+        {
+                length--;
+        }
+        text[length] = '\0';
+
+        /* Commentaire en fin de ligne : il documente le jeton précédent. */
+        reader->same_line = (reader->line == reader->previous_line);
+        if (reader->same_line)
+        {
+                reader->comment[0] = '\0';
+        }
+        if (length > 0)
+        {
+                size_t used = strlen(reader->comment);
+
+                snprintf(reader->comment + used, sizeof(reader->comment) - used,
+                         "%s%s", used ? " " : "", text);
+        }
+        if (c == '\n')
+        {
+                reader->line++;
+        }
+}
+
+
+/**
+ *  \brief Next token: name, number or punctuation.
+ *
+ * @return              0 at the end of the file, 1 otherwise
+ */
+static int next_token(struct reader * reader)
+{
+        size_t length = 0;
+        int    empty = 0;
+        int    c;
+
+        for (;;)
+        {
+                c = fgetc(reader->input);
+                if (c == '\n')
+                {
+                        /* Ligne vide : les commentaires précédents sont isolés. */
+                        if (empty)
+                        {
+                                reader->comment[0] = '\0';
+                        }
+                        reader->line++;
+                        empty = 1;
+                }
+                else if (c == '#')
+                {
+                        read_comment(reader);
+                        empty = 1;
+                }
+                else if ((c == EOF) || ! isspace(c))
+                {
+                        break;
+                }
+        }
+        if (c == EOF)
+        {
+                reader->token[0] = '\0';
+                return 0;
+        }
+
+        if (isalnum(c) || (c == '_'))
+        {
+                while ((c != EOF) && (isalnum(c) || (c == '_')))
+                {
+                        if (length == sizeof(reader->token) - 1)
+                        {
+                                fail(reader, "name too long");
+                        }
+                        reader->token[length++] = c;
+                        c = fgetc(reader->input);
+                }
+                ungetc(c, reader->input);
+        }
+        else if (strchr("{}[];", c))
+        {
+                reader->token[length++] = c;
+        }
+        else
+        {
+                fail(reader, "unexpected character '%c'", c);
+        }
+        reader->token[length] = '\0';
+        reader->previous_line = reader->line;
+
+        return 1;
+}
+
+
+/**
+ *  \brief Token check.
+ */
+static void expect(struct reader * reader, const char * token)
+{
+        if (! next_token(reader) || (strcmp(reader->token, token) != 0))
+        {
+                fail(reader, "'%s' expected instead of '%s'", token, reader->token);
+        }
+}
+
+
+/**
+ *  \brief C identifier check.
+ */
+static int is_name(const char * token)
+{
+        if (! isalpha((unsigned char) token[0]) && (token[0] != '_'))
+        {
+                return 0;
+        }
+        for ( ; *token ; token++)
+        {
+                if (! isalnum((unsigned char) *token) && (*token != '_'))
+                {
+                        return 0;
+                }
+        }
+        return 1;
+}
+
+
+/**
+ *  \brief Number conversion (decimal or hexadecimal).
+ *
+ * @return              the number, -1 if the token is not a number
+ */
+static long to_number(const char * token)
+{
+        char * end;
+        long   value;
+
+        if (! isdigit((unsigned char) token[0]))
+        {
+                return -1;
+        }
+        value = strtol(token, &end, 0);
+        return (*end == '\0') ? value : -1;
+}
+
+
+/**
+ *  \brief Field reading, after its type.
+ */
+static void read_field(struct reader * reader, struct message * message,
+                       const struct type * type)
+{
+        struct field * field;
+        int            i;
+
+        if (message->tail)
+        {
+                fail(reader, "field after '%s[]', which must be the last one",
+                     message->tail->name);
+        }
+        if (message->nb_fields == MAX_FIELDS)
+        {
+                fail(reader, "too many fields in '%s'", message->name);
+        }
+        field = &message->fields[message->nb_fields++];
+        memset(field, 0, sizeof(struct field));
+        field->type = type;
+        field->count = 1;
+
+        if (! next_token(reader) || ! is_name(reader->token))
+        {
+                fail(reader, "field name expected instead of '%s'", reader->token);
+        }
+        for (i = 0 ; reserved[i] ; i++)
+        {
+                if (strcmp(reader->token, reserved[i]) == 0)
+                {
+                        fail(reader, "'%s' is a reserved field name", reader->token);
+                }
+        }
+        if ((strncmp(reader->token, "set_", 4) == 0) ||
+            (strncmp(reader->token, "pad_", 4) == 0))
+        {
+                fail(reader, "field names cannot start with '%.4s'", reader->token);
+        }
+        for (i = 0 ; i < message->nb_fields - 1 ; i++)
+        {
+                if (strcmp(message->fields[i].name, reader->token) == 0)
+                {
+                        fail(reader, "duplicate field '%s'", reader->token);
+                }
+        }
+        strcpy(field->name, reader->token);
+
+        next_token(reader);
+        if (strcmp(reader->token, "[") == 0)
+        {
+                field->array = 1;
+                next_token(reader);
+                if (strcmp(reader->token, "]") == 0)
+                {
+                        field->count = 0;
+                        message->tail = field;
+                }
+                else
+                {
+                        long count = to_number(reader->token);
+
+                        if ((count <= 0) || (count > MAX_SIZE))
+                        {
+                                fail(reader, "invalid array size '%s'", reader->token);
+                        }
+                        field->count = count;
+                        expect(reader, "]");
+                }
+                next_token(reader);
+        }
+        if (strcmp(reader->token, ";") != 0)
+        {
+                fail(reader, "';' expected instead of '%s'", reader->token);
+        }
+
+        /* Le commentaire de fin de ligne documente le champ. */
+        reader->comment[0] = '\0';
+        reader->same_line = 0;
+}
+
+
+/**
+ *  \brief Layout of a message: offsets, alignment and size.
+ */
+static void layout(struct reader * reader, struct message * message)
+{
+        int offset = 0;
+        int i;
+
+        message->align = 1;
+        for (i = 0 ; i < message->nb_fields ; i++)
+        {
+                struct field * field = &message->fields[i];
+                int            align = message->packed ? 1 : field->type->size;
+
+                if (align > message->align)
+                {
+                        message->align = align;
+                }
+                if (field->count == 0)
+                {
+                        continue;
+                }
+                offset = (offset + align - 1) / align * align;
+                field->offset = offset;
+                offset += field->type->size * field->count;
+                if (offset > MAX_SIZE)
+                {
+                        fail(reader, "message '%s' larger than %d bytes",
+                             message->name, MAX_SIZE);
+                }
+        }
+
+        /*
+         *      Taille arrondie à l'alignement : les éléments de la fin
+         *      sont alignés eux aussi.
+         */
+        message->size = (offset + message->align - 1) / message->align * message->align;
+        if (message->tail)
+        {
+                message->tail->offset = message->size;
+        }
+}
+
+
+/**
+ *  \brief Schema reading.
+ *
+ * @return              the number of messages
+ */
+static int read_schema(struct reader * reader, struct message * messages)
+{
+        int nb_messages = 0;
+
+        while (next_token(reader))
+        {
+                struct message * message;
+                int              i;
+
+                if (nb_messages == MAX_MESSAGES)
+                {
+                        fail(reader, "too many messages");
+                }
+                message = &messages[nb_messages++];
+                memset(message, 0, sizeof(struct message));
+                strcpy(message->comment, reader->comment);
+                reader->comment[0] = '\0';
+
+                if (strcmp(reader->token, "packed") == 0)
+                {
+                        message->packed = 1;
+                        next_token(reader);
+                }
+                if (strcmp(reader->token, "message") != 0)
+                {
+                        fail(reader, "'message' expected instead of '%s'", reader->token);
+                }
+                if (! next_token(reader) || ! is_name(reader->token))
+                {
+                        fail(reader, "message name expected instead of '%s'",
+                             reader->token);
+                }
+                for (i = 0 ; i < nb_messages - 1 ; i++)
+                {
+                        if (strcmp(messages[i].name, reader->token) == 0)
+                        {
+                                fail(reader, "duplicate message '%s'", reader->token);
+                        }
+                }
+                strcpy(message->name, reader->token);
+                for (i = 0 ; message->name[i] ; i++)
+                {
+                        message->upper[i] = toupper((unsigned char) message->name[i]);
+                }
+
+                next_token(reader);
+                if (strcmp(reader->token, "{") != 0)
+                {
+                        if (! is_name(reader->token) && (to_number(reader->token) < 0))
+                        {
+                                fail(reader, "TAG expected instead of '%s'", reader->token);
+                        }
+                        strcpy(message->tag, reader->token);
+                        expect(reader, "{");
+                }
+                reader->comment[0] = '\0';
+
+                for (;;)
+                {
+                        const struct type * type;
+
+                        if (! next_token(reader))
+                        {
+                                fail(reader, "'}' expected at the end of the file");
+                        }
+                        if (strcmp(reader->token, "}") == 0)
+                        {
+                                break;
+                        }
+                        for (type = types ; type->name ; type++)
+                        {
+                                if (strcmp(type->name, reader->token) == 0)
+                                {
+                                        break;
+                                }
+                        }
+                        if (! type->name)
+                        {
+                                fail(reader, "unknown type '%s'", reader->token);
+                        }
+                        read_field(reader, message, type);
+
+                        /* Le commentaire éventuel suit sur la même ligne. */
+                        {
+                                int c = fgetc(reader->input);
+
+                                while ((c == ' ') || (c == '\t'))
+                                {
+                                        c = fgetc(reader->input);
+                                }
+                                if (c == '#')
+                                {
+                                        read_comment(reader);
+                                        strcpy(message->fields[message->nb_fields - 1].comment,
+                                               reader->comment);
+                                        reader->comment[0] = '\0';
+                                }
+                                else
+                                {
+                                        ungetc(c, reader->input);
+                                }
+                        }
+                }
+                if ((message->nb_fields == 0) ||
+                    ((message->nb_fields == 1) && message->tail))
+                {
+                        fail(reader, "message '%s' without fixed field", message->name);
+                }
+                layout(reader, message);
+                reader->comment[0] = '\0';
+        }
+
+        return nb_messages;
+}
+
+
+/**
+ *  \brief Upper case name of a field, for the macros.
+ */
+static const char * upper(const char * name)
+{
+        static char result[NAME_SIZE];
+        int         i;
+
+        for (i = 0 ; name[i] ; i++)
+        {
+                result[i] = toupper((unsigned char) name[i]);
+        }
+        result[i] = '\0';
+        return result;
+}
+
+
+/**
+ *  \brief Size of a number of elements, without the product for bytes.
+ */
+static const char * scaled(const char * count, int size)
+{
+        static char result[NAME_SIZE];
+
+        if (size == 1)
+        {
+                return count;
+        }
+        snprintf(result, sizeof(result), "%s * %d", count, size);
+        return result;
+}
+
+
+/**
+ *  \brief Byte array field (u8, i8 or char): given as a pointer.
+ */
+static int is_bytes(const struct field * field)
+{
+        return field->array && (field->type->size == 1);
+}
+
+
+/**
+ *  \brief Constants and structure of a message.
+ */
+static void write_layout(FILE * out, const struct message * message)
+{
+        const char * m = message->upper;
+        int          padding = 0;
+        int          offset = 0;
+        int          i;
+
+        fprintf(out, "/**\n *  \\defgroup schema_%s %s message\n",
+                message->name, message->name);
+        if (message->comment[0])
+        {
+                fprintf(out, " *\n *  \\details\n *  %s\n", message->comment);
+        }
+        fprintf(out, " *  @{\n */\n\n");
+
+        if (message->tag[0])
+        {
+                fprintf(out, "/*! TAG of the %s packets. */\n", message->name);
+                fprintf(out, "#define %s_TAG %s\n\n", m, message->tag);
+        }
+        for (i = 0 ; i < message->nb_fields ; i++)
+        {
+                const struct field * field = &message->fields[i];
+
+                fprintf(out, "/*! Offset of the %s field. */\n", field->name);
+                fprintf(out, "#define %s_%s_OFFSET %d\n", m, upper(field->name),
+                        field->offset);
+                if (field->count > 1)
+                {
+                        fprintf(out, "/*! Number of elements of the %s field. */\n",
+                                field->name);
+                        fprintf(out, "#define %s_%s_COUNT %d\n", m, upper(field->name),
+                                field->count);
+                }
+        }
+        fprintf(out, "\n/*! Size of the %s data%s. */\n", message->name,
+                message->tail ? " (without its last field)" : "");
+        fprintf(out, "#define %s_SIZE %d\n\n", m, message->size);
+        fprintf(out, "/*! Alignment of the %s data. */\n", message->name);
+        fprintf(out, "#define %s_ALIGN %d\n\n", m, message->align);
+        if (message->tail)
+        {
+                fprintf(out, "/*! Size of an element of the %s field. */\n",
+                        message->tail->name);
+                fprintf(out, "#define %s_%s_ELEMENT %d\n\n", m,
+                        upper(message->tail->name), message->tail->type->size);
+                fprintf(out, "/*! Maximum number of elements of the %s field. */\n",
+                        message->tail->name);
+                if (message->tail->type->size == 1)
+                {
+                        fprintf(out, "#define %s_MAX_COUNT (MAX_DATA_SIZE - %s_SIZE)\n\n",
+                                m, m);
+                }
+                else
+                {
+                        fprintf(out, "#define %s_MAX_COUNT ((MAX_DATA_SIZE - %s_SIZE) / %d)\n\n",
+                                m, m, message->tail->type->size);
+                }
+        }
+        else if (message->tag[0])
+        {
+                fprintf(out, "/*! Size of a %s packet, header included. */\n",
+                        message->name);
+                fprintf(out, "#define %s_PACKET_SIZE (PACKET_HEADER_SIZE + %s_SIZE)\n\n",
+                        m, m);
+        }
+
+        /*
+         *      Structure : bourrage explicite, pour la même disposition
+         *      que les données sur toutes les architectures.
+         */
+        fprintf(out, "/*! %s data (host copy%s). */\n", message->name,
+                message->tail ? ", without its last field" : "");
+        fprintf(out, "struct %s {\n", message->name);
+        for (i = 0 ; i < message->nb_fields ; i++)
+        {
+                const struct field * field = &message->fields[i];
+
+                if (field->count == 0)
+                {
+                        continue;
+                }
+                if (field->offset > offset)
+                {
+                        fprintf(out, "        unsigned char pad_%d[%d];\n", padding++,
+                                field->offset - offset);
+                }
+                if (field->array)
+                {
+                        fprintf(out, "        %s %s[%d];", field->type->ctype, field->name,
+                                field->count);
+                }
+                else
+                {
+                        fprintf(out, "        %s %s;", field->type->ctype, field->name);
+                }
+                fprintf(out, " /*!< %s */\n", field->comment[0] ? field->comment : field->name);
+                offset = field->offset + field->type->size * field->count;
+        }
+        if (message->size > offset)
+        {
+                fprintf(out, "        unsigned char pad_%d[%d];\n", padding,
+                        message->size - offset);
+        }
+        fprintf(out, "} __attribute__((packed, aligned(%d)));\n\n", message->align);
+
+        fprintf(out, "/** @} */\n\n");
+        fprintf(out, "/** @cond DUPLICATE_DOCUMENTATION */\n");
+        fprintf(out, "SCHEMA_ASSERT(sizeof(struct %s) == %s_SIZE, \"%s size\");\n",
+                message->name, m, message->name);
+        for (i = 0 ; i < message->nb_fields ; i++)
+        {
+                const struct field * field = &message->fields[i];
+
+                if (field->count == 0)
+                {
+                        continue;
+                }
+                fprintf(out, "SCHEMA_ASSERT(offsetof(struct %s, %s) == %s_%s_OFFSET, "
+                        "\"%s.%s offset\");\n", message->name, field->name, m,
+                        upper(field->name), message->name, field->name);
+        }
+        fprintf(out, "\n");
+}
+
+
+/**
+ *  \brief Accessors of a field.
+ */
+static void write_accessors(FILE * out, const struct message * message,
+                            const struct field * field)
+{
+        const char * n = message->name;
+        const char * f = field->name;
+        const char * t = field->type->ctype;
+        const char * a = field->type->access;
+        char         where[NAME_SIZE * 3];
+        const char * m = message->upper;
+
+        snprintf(where, sizeof(where), "data + %s_%s_OFFSET", m, upper(f));
+
+        if (is_bytes(field))
+        {
+                const char * pointer = (field->type->name[0] == 'c') ? "char" : t;
+
+                fprintf(out, "static inline const %s * %s_%s(const unsigned char * data)\n"
+                        "{\n        return (const %s *) (%s);\n}\n\n",
+                        pointer, n, f, pointer, where);
+                if ((field->type->name[0] == 'c') && (field->count > 0))
+                {
+                        /* Une chaîne qui remplit le champ n'a pas de '\0'. */
+                        fprintf(out, "static inline size_t %s_%s_length(const unsigned char * data)\n"
+                                "{\n        const char * %s = (const char *) (%s);\n"
+                                "        const char * end = (const char *) memchr(%s, '\\0', %d);\n\n"
+                                "        return end ? (size_t) (end - %s) : %d;\n}\n\n",
+                                n, f, f, where, f, field->count, f, field->count);
+                }
+                if (field->count > 0)
+                {
+                        fprintf(out, "static inline void %s_set_%s(unsigned char * data, "
+                                "const %s * value)\n{\n", n, f, pointer);
+                        if (field->type->name[0] == 'c')
+                        {
+                                fprintf(out, "        strncpy((char *) (%s), value, %d);\n",
+                                        where, field->count);
+                        }
+                        else
+                        {
+                                fprintf(out, "        memcpy(%s, value, %d);\n", where,
+                                        field->count);
+                        }
+                        fprintf(out, "}\n\n");
+                }
+                return;
+        }
+
+        if (field->array && (field->count > 0))
+        {
+                /* Hors bornes : 0 en lecture, rien n'est écrit. */
+                fprintf(out, "static inline %s %s_%s(const unsigned char * data, int i)\n"
+                        "{\n        if ((i < 0) || (i >= %d))\n        {\n"
+                        "                return 0;\n        }\n"
+                        "        return (%s) schema_get_%s(%s + i * %d);\n}\n\n",
+                        t, n, f, field->count, t, a, where, field->type->size);
+                fprintf(out, "static inline void %s_set_%s(unsigned char * data, int i, "
+                        "%s value)\n{\n        if ((i < 0) || (i >= %d))\n        {\n"
+                        "                return;\n        }\n"
+                        "        schema_put_%s(%s + i * %d, value);\n}\n\n",
+                        n, f, t, field->count, a, where, field->type->size);
+                return;
+        }
+        if (field->array)
+        {
+                fprintf(out, "static inline %s %s_%s(const unsigned char * data, int i)\n"
+                        "{\n        return (%s) schema_get_%s(%s + i * %d);\n}\n\n",
+                        t, n, f, t, a, where, field->type->size);
+                fprintf(out, "static inline void %s_set_%s(unsigned char * data, int i, "
+                        "%s value)\n{\n        schema_put_%s(%s + i * %d, value);\n}\n\n",
+                        n, f, t, a, where, field->type->size);
+                return;
+        }
+
+        fprintf(out, "static inline %s %s_%s(const unsigned char * data)\n"
+                "{\n        return (%s) schema_get_%s(%s);\n}\n\n",
+                t, n, f, t, a, where);
+        fprintf(out, "static inline void %s_set_%s(unsigned char * data, %s value)\n"
+                "{\n        schema_put_%s(%s, value);\n}\n\n",
+                n, f, t, a, where);
+}
+
+
+/**
+ *  \brief Functions of a message: check, accessors, encoder, decoder and
+ *         packer.
+ */
+static void write_functions(FILE * out, const struct message * message)
+{
+        const char * n = message->name;
+        const char * m = message->upper;
+        int          i;
+
+        /* Contrôle de la taille reçue. */
+        if (message->tail && (message->tail->type->size == 1))
+        {
+                fprintf(out, "static inline int %s_check(const unsigned char * data, "
+                        "int size)\n{\n", n);
+                fprintf(out, "        (void) data;\n"
+                        "        return (size < %s_SIZE) ? -ERR_BAD_PROTOCOL : size - %s_SIZE;\n"
+                        "}\n\n", m, m);
+        }
+        else if (message->tail)
+        {
+                fprintf(out, "static inline int %s_check(const unsigned char * data, "
+                        "int size)\n{\n", n);
+                fprintf(out, "        (void) data;\n"
+                        "        if ((size < %s_SIZE) || ((size - %s_SIZE) %% %d))\n"
+                        "        {\n                return -ERR_BAD_PROTOCOL;\n        }\n"
+                        "        return (size - %s_SIZE) / %d;\n}\n\n",
+                        m, m, message->tail->type->size, m, message->tail->type->size);
+        }
+        else
+        {
+                fprintf(out, "static inline int %s_check(const unsigned char * data, "
+                        "int size)\n{\n", n);
+                fprintf(out, "        (void) data;\n"
+                        "        return (size < %s_SIZE) ? -ERR_BAD_PROTOCOL : SUCCESS;\n"
+                        "}\n\n", m);
+        }
+
+        for (i = 0 ; i < message->nb_fields ; i++)
+        {
+                write_accessors(out, message, &message->fields[i]);
+        }
+
+        /* Encodeur : les champs fixes et le bourrage à zéro. */
+        fprintf(out, "static inline void %s_encode(const struct %s * value, "
+                "unsigned char * data)\n{\n", n, n);
+        if (message->size > 0)
+        {
+                fprintf(out, "        memset(data, 0, %s_SIZE);\n", m);
+        }
+        for (i = 0 ; i < message->nb_fields ; i++)
+        {
+                const struct field * field = &message->fields[i];
+
+                if (field->count == 0)
+                {
+                        continue;
+                }
+                if (is_bytes(field))
+                {
+                        fprintf(out, "        memcpy(data + %s_%s_OFFSET, value->%s, %d);\n",
+                                m, upper(field->name), field->name, field->count);
+                }
+                else if (field->array)
+                {
+                        fprintf(out, "        {\n                int i;\n\n"
+                                "                for (i = 0 ; i < %d ; i++)\n"
+                                "                {\n                        "
+                                "%s_set_%s(data, i, value->%s[i]);\n"
+                                "                }\n        }\n",
+                                field->count, n, field->name, field->name);
+                }
+                else
+                {
+                        fprintf(out, "        %s_set_%s(data, value->%s);\n", n,
+                                field->name, field->name);
+                }
+        }
+        fprintf(out, "}\n\n");
+
+        /* Décodeur : copie des champs fixes. */
+        fprintf(out, "static inline void %s_decode(const unsigned char * data, "
+                "struct %s * value)\n{\n", n, n);
+        fprintf(out, "        memset(value, 0, sizeof(struct %s));\n", n);
+        for (i = 0 ; i < message->nb_fields ; i++)
+        {
+                const struct field * field = &message->fields[i];
+
+                if (field->count == 0)
+                {
+                        continue;
+                }
+                if (is_bytes(field))
+                {
+                        fprintf(out, "        memcpy(value->%s, data + %s_%s_OFFSET, %d);\n",
+                                field->name, m, upper(field->name), field->count);
+                }
+                else if (field->array)
+                {
+                        fprintf(out, "        {\n                int i;\n\n"
+                                "                for (i = 0 ; i < %d ; i++)\n"
+                                "                {\n                        "
+                                "value->%s[i] = %s_%s(data, i);\n"
+                                "                }\n        }\n",
+                                field->count, field->name, n, field->name);
+                }
+                else
+                {
+                        fprintf(out, "        value->%s = %s_%s(data);\n", field->name,
+                                n, field->name);
+                }
+        }
+        fprintf(out, "}\n\n");
+
+        if (! message->tag[0])
+        {
+                return;
+        }
+
+        /* Paquet complet, à la taille exacte. */
+        if (message->tail)
+        {
+                const struct field * tail = message->tail;
+                const char         * element = is_bytes(tail)
+                                               ? ((tail->type->name[0] == 'c')
+                                                  ? "char"
+                                                  : tail->type->ctype)
+                                               : tail->type->ctype;
+
+                fprintf(out, "static inline int %s_packet_size(int count)\n{\n"
+                        "        return PACKET_HEADER_SIZE + %s_SIZE + %s;\n}\n\n",
+                        n, m, scaled("count", tail->type->size));
+                fprintf(out, "static inline int %s_pack(const struct %s * value, "
+                        "const %s * %s, int count, unsigned char * packet)\n{\n",
+                        n, n, element, tail->name);
+                fprintf(out, "        unsigned char * data = packet + PACKET_HEADER_SIZE;\n");
+                if (! is_bytes(tail))
+                {
+                        fprintf(out, "        int             i;\n");
+                }
+                fprintf(out, "\n"
+                        "        if ((count < 0) || (count > %s_MAX_COUNT))\n"
+                        "        {\n                return -ERR_BAD_PARAMETER;\n        }\n"
+                        "        schema_put_u16(packet, %s_SIZE + %s + PACKET_TAG_SIZE);\n"
+                        "        packet[PACKET_LEN_SIZE] = %s_TAG;\n"
+                        "        %s_encode(value, data);\n",
+                        m, m, scaled("count", tail->type->size), m, n);
+                if (is_bytes(tail))
+                {
+                        fprintf(out, "        memcpy(data + %s_SIZE, %s, count);\n", m,
+                                tail->name);
+                }
+                else
+                {
+                        fprintf(out, "        for (i = 0 ; i < count ; i++)\n"
+                                "        {\n                schema_put_%s(data + %s_SIZE + i * %d, "
+                                "%s[i]);\n        }\n",
+                                tail->type->access, m, tail->type->size, tail->name);
+                }
+                fprintf(out, "        return %s_packet_size(count);\n}\n\n", n);
+        }
+        else
+        {
+                fprintf(out, "static inline int %s_pack(const struct %s * value, "
+                        "unsigned char * packet)\n{\n", n, n);
+                fprintf(out, "        schema_put_u16(packet, %s_SIZE + PACKET_TAG_SIZE);\n"
+                        "        packet[PACKET_LEN_SIZE] = %s_TAG;\n"
+                        "        %s_encode(value, packet + PACKET_HEADER_SIZE);\n"
+                        "        return %s_PACKET_SIZE;\n}\n\n", m, m, n, m);
+        }
+}
+
+
+/**
+ *  \brief C++ view of a message: constexpr layout and accessors.
+ */
+static void write_view(FILE * out, const struct message * message)
+{
+        const char * n = message->name;
+        const char * m = message->upper;
+        int          i;
+
+        fprintf(out, "struct %s_view {\n", n);
+        fprintf(out, "        static constexpr std::size_t byte_size = %s_SIZE;\n", m);
+        fprintf(out, "        static constexpr std::size_t alignment = %s_ALIGN;\n", m);
+        if (message->tag[0])
+        {
+                fprintf(out, "        static constexpr int tag_value = %s_TAG;\n", m);
+        }
+        for (i = 0 ; i < message->nb_fields ; i++)
+        {
+                const struct field * field = &message->fields[i];
+
+                fprintf(out, "        static constexpr std::size_t %s_offset = %s_%s_OFFSET;\n",
+                        field->name, m, upper(field->name));
+                if (field->count > 1)
+                {
+                        fprintf(out, "        static constexpr std::size_t %s_count = %d;\n",
+                                field->name, field->count);
+                }
+        }
+        fprintf(out, "\n        const unsigned char * data;\n\n");
+        fprintf(out, "        constexpr explicit %s_view(const unsigned char * data) "
+                ": data(data) {}\n", n);
+        fprintf(out, "        int validate(int size) const { return %s_check(data, size); }\n", n);
+        for (i = 0 ; i < message->nb_fields ; i++)
+        {
+                const struct field * field = &message->fields[i];
+                const char         * t = field->type->ctype;
+
+                if (is_bytes(field))
+                {
+                        const char * pointer = (field->type->name[0] == 'c') ? "char" : t;
+
+                        fprintf(out, "        const %s * %s() const { return %s_%s(data); }\n",
+                                pointer, field->name, n, field->name);
+                        if ((field->type->name[0] == 'c') && (field->count > 0))
+                        {
+                                fprintf(out, "        std::size_t %s_length() const "
+                                        "{ return %s_%s_length(data); }\n",
+                                        field->name, n, field->name);
+                        }
+                }
+                else if (field->array)
+                {
+                        fprintf(out, "        %s %s(int i) const { return %s_%s(data, i); }\n",
+                                t, field->name, n, field->name);
+                }
+                else
+                {
+                        fprintf(out, "        %s %s() const { return %s_%s(data); }\n",
+                                t, field->name, n, field->name);
+                }
+        }
+        fprintf(out, "};\n\n");
+}
+
+
+/**
+ *  \brief Header writing.
+ */
+static void write_header(FILE * out, const char * schema, const char * guard,
+                         const struct message * messages, int nb_messages)
+{
+        int i;
+
+        fprintf(out, "/*\n *  Generated by cyberschema from %s: do not edit.\n */\n\n",
+                schema);
+        fprintf(out, "#ifndef %s\n#define %s\n\n", guard, guard);
+        fprintf(out, "#include <stddef.h>\n#include <stdint.h>\n#include <string.h>\n\n");
+        fprintf(out, "#include \"errors.h\"\n#include \"packets.h\"\n"
+                "#include \"schema.h\"\n#include \"tags.h\"\n\n");
+        fprintf(out, "#ifndef SCHEMA_ASSERT\n#ifdef __cplusplus\n"
+                "#define SCHEMA_ASSERT static_assert\n#else\n"
+                "#define SCHEMA_ASSERT _Static_assert\n#endif\n#endif\n\n");
+
+        for (i = 0 ; i < nb_messages ; i++)
+        {
+                write_layout(out, &messages[i]);
+                write_functions(out, &messages[i]);
+                fprintf(out, "/** @endcond */\n\n\n");
+        }
+
+        fprintf(out, "#ifdef __cplusplus\n#include <cstddef>\n#include <cstdint>\n\n"
+                "/** @cond DUPLICATE_DOCUMENTATION */\nnamespace cyberschema {\n\n");
+        for (i = 0 ; i < nb_messages ; i++)
+        {
+                write_view(out, &messages[i]);
+        }
+        fprintf(out, "} /* namespace cyberschema */\n/** @endcond */\n#endif\n\n");
+        fprintf(out, "#endif /* %s */\n", guard);
+}
+
+
+int main(int argc, char ** argv)
+{
+        static struct message messages[MAX_MESSAGES];
+        struct reader         reader;
+        char                  guard[NAME_SIZE];
+        const char          * base;
+        FILE                * out = stdout;
+        int                   nb_messages;
+        int                   i, length;
+
+        if ((argc < 2) || (argc > 3))
+        {
+                fprintf(stderr, "usage: %s SCHEMA [HEADER]\n", argv[0]);
+                return 2;
+        }
+        memset(&reader, 0, sizeof(reader));
+        reader.file = argv[1];
+        reader.line = 1;
+        reader.input = fopen(argv[1], "r");
+        if (! reader.input)
+        {
+                perror(argv[1]);
+                return 1;
+        }
+
+        /* Garde : nom du fichier de schéma, sans répertoire ni extension. */
+        base = strrchr(argv[1], '/');
+        base = base ? base + 1 : argv[1];
+        for (length = 0 ; base[length] && (base[length] != '.') &&
+                          (length < NAME_SIZE - 12) ; length++)
+        {
+                guard[length] = isalnum((unsigned char) base[length])
+                                ? toupper((unsigned char) base[length])
+                                : '_';
+        }
+        strcpy(guard + length, "_SCHEMA_H");
+
+        nb_messages = read_schema(&reader, messages);
+        fclose(reader.input);
+
+        if (argc == 3)
+        {
+                output_name = argv[2];
+                out = fopen(output_name, "w");
+                if (! out)
+                {
+                        perror(output_name);
+                        return 1;
+                }
+        }
+        write_header(out, base, guard, messages, nb_messages);
+        i = ferror(out);
+        if ((out != stdout) && (fclose(out) != 0))
+        {
+                i = 1;
+        }
+        if (i)
+        {
+                fprintf(stderr, "%s: write error\n", argc == 3 ? argv[2] : "stdout");
+                if (output_name)
+                {
+                        remove(output_name);
+                }
+                return 1;
+        }
+
+        return 0;
+}
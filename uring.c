@@ -0,0 +1,466 @@
+/**
+ *  \file    uring.c
+ *  \brief   io_uring access.
+ *
+ *           Project: project independant file.
+ *
+ *           This file contains the minimal functions needed to use a Linux
+ *           io_uring instance through the raw system calls: creation and
+ *           mapping of the rings, submission and completion queues
+ *           handling, and provided receive buffers.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "errors.h"
+#include "uring.h"
+
+
+/**
+ *  \brief io_uring_setup() system call.
+ */
+static int sys_setup(unsigned int entries, struct io_uring_params * params)
+{
+        return syscall(__NR_io_uring_setup, entries, params);
+}
+
+
+/**
+ *  \brief io_uring_enter() system call.
+ */
+static int sys_enter(int fd, unsigned int to_submit, unsigned int min_complete,
+                     unsigned int flags, void * arg, size_t size)
+{
+        return syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                       flags, arg, size);
+}
+
+
+/**
+ *  \brief io_uring_register() system call.
+ */
+static int sys_register(int fd, unsigned int opcode, void * arg,
+                        unsigned int nb_args)
+{
+        return syscall(__NR_io_uring_register, fd, opcode, arg, nb_args);
+}
+
+
+/**
+ *  \brief io_uring instance creation function.
+ *
+ * @param ring          the instance to initialise
+ * @param entries       size of the submission queue
+ * @return              the status of the creation
+ * @retval SUCCESS                      instance created
+ * @retval -ERR_OPEN_DEVICE             io_uring is not available
+ * @retval -ERR_CONFIG_DEVICE           io_uring is too old (no EXT_ARG)
+ * @retval -ERR_NO_MEMORY               the rings cannot be mapped
+ */
+int uring_init(struct uring * ring, unsigned int entries)
+{
+        struct io_uring_params params;
+        unsigned char        * sq;
+        unsigned char        * cq;
+
+        memset(ring, 0, sizeof(struct uring));
+        memset(&params, 0, sizeof(params));
+        ring->fd = sys_setup(entries, &params);
+        if (ring->fd < 0)
+        {
+                return -ERR_OPEN_DEVICE;
+        }
+        ring->features = params.features;
+        if (! (params.features & IORING_FEAT_EXT_ARG))
+        {
+                close(ring->fd);
+                return -ERR_CONFIG_DEVICE;
+        }
+
+        ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+        ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+                if (ring->cq_size > ring->sq_size)
+                {
+                        ring->sq_size = ring->cq_size;
+                }
+                ring->cq_size = ring->sq_size;
+        }
+        ring->sq_ring = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, ring->fd,
+                             IORING_OFF_SQ_RING);
+        if (ring->sq_ring == MAP_FAILED)
+        {
+                close(ring->fd);
+                return -ERR_NO_MEMORY;
+        }
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+                ring->cq_ring = ring->sq_ring;
+        }
+        else
+        {
+                ring->cq_ring = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE,
+                                     MAP_SHARED | MAP_POPULATE, ring->fd,
+                                     IORING_OFF_CQ_RING);
+                if (ring->cq_ring == MAP_FAILED)
+                {
+                        munmap(ring->sq_ring, ring->sq_size);
+                        close(ring->fd);
+                        return -ERR_NO_MEMORY;
+                }
+        }
+        ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+        ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+        if (ring->sqes == MAP_FAILED)
+        {
+                if (ring->cq_ring != ring->sq_ring)
+                {
+                        munmap(ring->cq_ring, ring->cq_size);
+                }
+                munmap(ring->sq_ring, ring->sq_size);
+                close(ring->fd);
+                return -ERR_NO_MEMORY;
+        }
+
+        sq = ring->sq_ring;
+        ring->sq_head = (unsigned int *) (sq + params.sq_off.head);
+        ring->sq_tail = (unsigned int *) (sq + params.sq_off.tail);
+        ring->sq_mask = *(unsigned int *) (sq + params.sq_off.ring_mask);
+        ring->sq_array = (unsigned int *) (sq + params.sq_off.array);
+        ring->sq_pending = *ring->sq_tail;
+
+        cq = ring->cq_ring;
+        ring->cq_head = (unsigned int *) (cq + params.cq_off.head);
+        ring->cq_tail = (unsigned int *) (cq + params.cq_off.tail);
+        ring->cq_mask = *(unsigned int *) (cq + params.cq_off.ring_mask);
+        ring->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief io_uring instance destruction function.
+ *
+ * @param ring          the instance to destroy
+ */
+void uring_exit(struct uring * ring)
+{
+        munmap(ring->sqes, ring->sqes_size);
+        if (ring->cq_ring != ring->sq_ring)
+        {
+                munmap(ring->cq_ring, ring->cq_size);
+        }
+        munmap(ring->sq_ring, ring->sq_size);
+        close(ring->fd);
+}
+
+
+/**
+ *  \brief Function returning a free submission queue entry.
+ *
+ *         If the submission queue is full, the pending entries are
+ *         submitted first. The returned entry is cleared.
+ *
+ * @param ring          the instance
+ * @return              the entry or NULL if none can be obtained
+ */
+struct io_uring_sqe * uring_get_sqe(struct uring * ring)
+{
+        unsigned int          head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        struct io_uring_sqe * sqe;
+        unsigned int          index;
+
+        if (ring->sq_pending - head > ring->sq_mask)
+        {
+                if (uring_submit(ring) < 0)
+                {
+                        return NULL;
+                }
+                head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+                if (ring->sq_pending - head > ring->sq_mask)
+                {
+                        return NULL;
+                }
+        }
+
+        index = ring->sq_pending & ring->sq_mask;
+        sqe = &ring->sqes[index];
+        memset(sqe, 0, sizeof(struct io_uring_sqe));
+        ring->sq_array[index] = index;
+        ring->sq_pending++;
+
+        return sqe;
+}
+
+
+/**
+ *  \brief Function returning the number of free submission queue entries.
+ *
+ *         It allows a chain of linked entries to be checked before it is
+ *         built, so that it is not split by an automatic submission.
+ *
+ * @param ring          the instance
+ * @return              the number of entries uring_get_sqe() can return
+ *                      without submitting
+ */
+int uring_space(struct uring * ring)
+{
+        unsigned int head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+
+        return ring->sq_mask + 1 - (ring->sq_pending - head);
+}
+
+
+/**
+ *  \brief Function publishing the new submission queue entries.
+ *
+ * @param ring          the instance
+ * @return              the number of entries to submit
+ */
+static unsigned int sq_flush(struct uring * ring)
+{
+        __atomic_store_n(ring->sq_tail, ring->sq_pending, __ATOMIC_RELEASE);
+
+        return ring->sq_pending - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+}
+
+
+/**
+ *  \brief Function submitting the pending entries without waiting.
+ *
+ * @param ring          the instance
+ * @return              the number of submitted entries or -ERR_CONNECTION
+ */
+int uring_submit(struct uring * ring)
+{
+        unsigned int count = sq_flush(ring);
+        int          result;
+
+        if (count == 0)
+        {
+                return 0;
+        }
+        do
+        {
+                result = sys_enter(ring->fd, count, 0, 0, NULL, 0);
+        } while ((result < 0) && (errno == EINTR));
+
+        return (result < 0) ? -ERR_CONNECTION : result;
+}
+
+
+/**
+ *  \brief Function submitting the pending entries and waiting for a
+ *         completion.
+ *
+ * @param ring          the instance
+ * @param timeout       timeout in milliseconds (-1 means no timeout)
+ * @return              the status of the wait
+ * @retval SUCCESS              at least one completion may be available
+ * @retval -ERR_TIMEOUT         timeout elapsed
+ * @retval -ERR_CONNECTION      the wait failed
+ */
+int uring_wait(struct uring * ring, int timeout)
+{
+        struct io_uring_getevents_arg arg;
+        struct __kernel_timespec      ts;
+        unsigned int                  count = sq_flush(ring);
+        int                           result;
+
+        if (uring_peek(ring))
+        {
+                return (uring_submit(ring) < 0) ? -ERR_CONNECTION : SUCCESS;
+        }
+
+        memset(&arg, 0, sizeof(arg));
+        if (timeout >= 0)
+        {
+                ts.tv_sec = timeout / 1000;
+                ts.tv_nsec = (timeout % 1000) * 1000000L;
+                arg.ts = (unsigned long) &ts;
+        }
+        result = sys_enter(ring->fd, count, 1,
+                           IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                           &arg, sizeof(arg));
+        if (result < 0)
+        {
+                if (errno == ETIME)
+                {
+                        return -ERR_TIMEOUT;
+                }
+                if ((errno == EINTR) || (errno == EBUSY))
+                {
+                        return SUCCESS;
+                }
+                return -ERR_CONNECTION;
+        }
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Function returning the next completion, if any.
+ *
+ *         The completion must be released with uring_advance().
+ *
+ * @param ring          the instance
+ * @return              the completion or NULL
+ */
+struct io_uring_cqe * uring_peek(struct uring * ring)
+{
+        unsigned int head = *ring->cq_head;
+
+        if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+        {
+                return NULL;
+        }
+
+        return &ring->cqes[head & ring->cq_mask];
+}
+
+
+/**
+ *  \brief Function releasing the completion returned by uring_peek().
+ *
+ * @param ring          the instance
+ */
+void uring_advance(struct uring * ring)
+{
+        __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+
+/**
+ *  \brief Provided receive buffers creation function.
+ *
+ *         The buffers are registered as a buffer ring of the given group:
+ *         receive operations submitted with IOSQE_BUFFER_SELECT and this
+ *         group get their data in one of them.
+ *
+ * @param ring          the instance
+ * @param buffers       the buffers to initialise
+ * @param group         buffer group identifier
+ * @param count         number of buffers (a power of 2)
+ * @param size          size of each buffer
+ * @return              the status of the creation
+ * @retval SUCCESS                      buffers registered
+ * @retval -ERR_NO_MEMORY               cannot allocate the buffers
+ * @retval -ERR_CONFIG_DEVICE           the kernel refused the buffers
+ */
+int uring_buffers_init(struct uring * ring, struct uring_buffers * buffers,
+                       int group, int count, int size)
+{
+        struct io_uring_buf_reg reg;
+        size_t                  ring_size = count * sizeof(struct io_uring_buf);
+        int                     i;
+
+        memset(buffers, 0, sizeof(struct uring_buffers));
+        buffers->ring = mmap(NULL, ring_size, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (buffers->ring == MAP_FAILED)
+        {
+                return -ERR_NO_MEMORY;
+        }
+        buffers->memory = malloc((size_t) count * size);
+        if (! buffers->memory)
+        {
+                munmap(buffers->ring, ring_size);
+                return -ERR_NO_MEMORY;
+        }
+        buffers->count = count;
+        buffers->size = size;
+        buffers->group = group;
+
+        memset(&reg, 0, sizeof(reg));
+        reg.ring_addr = (unsigned long) buffers->ring;
+        reg.ring_entries = count;
+        reg.bgid = group;
+        if (sys_register(ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+        {
+                free(buffers->memory);
+                munmap(buffers->ring, ring_size);
+                memset(buffers, 0, sizeof(struct uring_buffers));
+                return -ERR_CONFIG_DEVICE;
+        }
+
+        for (i = 0 ; i < count ; i++)
+        {
+                uring_buffer_recycle(buffers, i);
+        }
+
+        return SUCCESS;
+}
+
+
+/**
+ *  \brief Provided receive buffers destruction function.
+ *
+ * @param ring          the instance
+ * @param buffers       the buffers to destroy
+ */
+void uring_buffers_free(struct uring * ring, struct uring_buffers * buffers)
+{
+        struct io_uring_buf_reg reg;
+
+        if (! buffers->memory)
+        {
+                return;
+        }
+        memset(&reg, 0, sizeof(reg));
+        reg.bgid = buffers->group;
+        sys_register(ring->fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+        free(buffers->memory);
+        munmap(buffers->ring, buffers->count * sizeof(struct io_uring_buf));
+        memset(buffers, 0, sizeof(struct uring_buffers));
+}
+
+
+/**
+ *  \brief Function returning the data area of a provided buffer.
+ *
+ * @param buffers       the buffers
+ * @param id            buffer identifier (from the completion flags)
+ * @return              the data area of the buffer
+ */
+unsigned char * uring_buffer(struct uring_buffers * buffers, int id)
+{
+        return &buffers->memory[(size_t) id * buffers->size];
+}
+
+
+/**
+ *  \brief Function giving a provided buffer back to the kernel.
+ *
+ * @param buffers       the buffers
+ * @param id            buffer identifier
+ */
+void uring_buffer_recycle(struct uring_buffers * buffers, int id)
+{
+        struct io_uring_buf * buf;
+
+        buf = &buffers->ring->bufs[buffers->tail & (buffers->count - 1)];
+        buf->addr = (unsigned long) uring_buffer(buffers, id);
+        buf->len = buffers->size;
+        buf->bid = id;
+        buffers->tail++;
+        __atomic_store_n(&buffers->ring->tail, buffers->tail, __ATOMIC_RELEASE);
+}
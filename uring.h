@@ -0,0 +1,82 @@
+/**
+ *  \file    uring.h
+ *  \brief   io_uring access.
+ *
+ *           Project: project independant file.
+ *
+ *           This is the header file of uring.c and contains the structures
+ *           and functions declarations giving access to a Linux io_uring
+ *           instance without any external library.
+ *
+ *  \author  Thomas Nemeth
+ *
+ *  \version 1.0.0
+ *  \date    Fri, Oct 16 2026
+ */
+
+
+#ifndef URING_H
+#define URING_H
+
+#include <stddef.h>
+#include <linux/io_uring.h>
+
+/**
+ *  \defgroup uring io_uring structures
+ *  @{
+ */
+
+/*! Mapped io_uring instance. */
+struct uring {
+        int                   fd;          /*!< io_uring file descriptor.    */
+        unsigned int          features;    /*!< IORING_FEAT_* flags.         */
+        unsigned int        * sq_head;     /*!< Submission queue head.       */
+        unsigned int        * sq_tail;     /*!< Submission queue tail.       */
+        unsigned int          sq_mask;     /*!< Submission queue mask.       */
+        unsigned int        * sq_array;    /*!< Submission queue indexes.    */
+        unsigned int          sq_pending;  /*!< Local (unpublished) tail.    */
+        struct io_uring_sqe * sqes;        /*!< Submission queue entries.    */
+        unsigned int        * cq_head;     /*!< Completion queue head.       */
+        unsigned int        * cq_tail;     /*!< Completion queue tail.       */
+        unsigned int          cq_mask;     /*!< Completion queue mask.       */
+        struct io_uring_cqe * cqes;        /*!< Completion queue entries.    */
+        void                * sq_ring;     /*!< Mapped submission ring.      */
+        size_t                sq_size;     /*!< Size of the submission ring. */
+        void                * cq_ring;     /*!< Mapped completion ring.      */
+        size_t                cq_size;     /*!< Size of the completion ring. */
+        size_t                sqes_size;   /*!< Size of the entries array.   */
+};
+
+/*! Receive buffers provided to an io_uring instance: the kernel picks a
+ *  free buffer for each completed receive.
+ */
+struct uring_buffers {
+        struct io_uring_buf_ring * ring;    /*!< Shared buffers ring.        */
+        unsigned char            * memory;  /*!< Buffers storage.            */
+        int                        count;   /*!< Number of buffers.          */
+        int                        size;    /*!< Size of each buffer.        */
+        int                        group;   /*!< Buffer group identifier.    */
+        unsigned short             tail;    /*!< Local ring tail.            */
+};
+
+/** @} */
+
+
+/** @cond DUPLICATE_DOCUMENTATION */
+int uring_init(struct uring * ring, unsigned int entries);
+void uring_exit(struct uring * ring);
+struct io_uring_sqe * uring_get_sqe(struct uring * ring);
+int uring_space(struct uring * ring);
+int uring_submit(struct uring * ring);
+int uring_wait(struct uring * ring, int timeout);
+struct io_uring_cqe * uring_peek(struct uring * ring);
+void uring_advance(struct uring * ring);
+int uring_buffers_init(struct uring * ring, struct uring_buffers * buffers,
+                       int group, int count, int size);
+void uring_buffers_free(struct uring * ring, struct uring_buffers * buffers);
+unsigned char * uring_buffer(struct uring_buffers * buffers, int id);
+void uring_buffer_recycle(struct uring_buffers * buffers, int id);
+/** @endcond */
+
+
+#endif /* URING_H */
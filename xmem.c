@@ -9,6 +9,12 @@
  *           function are not always needed: they are just provided for
  *           convenience.
  *
+ *           It also contains a pool of reference-counted packet buffers:
+ *           buffers are taken from and given back to per-thread free lists
+ *           of three size classes, so that steady-state traffic does not
+ *           allocate memory at all. The pool statistics are counted per
+ *           thread as well, and added by xbuf_stats().
+ *
  *  \author  Thomas Nemeth
  *
  *  \version 1.0.0
@@ -20,6 +26,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <pthread.h>
 
 #include "xmem.h"
 
@@ -70,3 +77,244 @@ char * xstrdup(const char * string)
 
         return ret;
 }
+
+
+/**
+ *  \addtogroup xbuf
+ *  @{
+ */
+
+/*! Capacity of each size class. */
+static const size_t xbuf_sizes[XBUF_CLASSES] = {
+        XBUF_SMALL_SIZE, XBUF_MEDIUM_SIZE, XBUF_LARGE_SIZE
+};
+
+/*! Free buffers of the current thread, for each size class. */
+static __thread struct xbuf * xbuf_free[XBUF_CLASSES];
+
+/*! Number of free buffers of the current thread, for each size class. */
+static __thread int xbuf_nb_free[XBUF_CLASSES];
+
+/*! Pool counters of a thread. A buffer released by another thread than
+ *  the one that allocated it is counted by both: only the sum of the
+ *  outstanding counts of all the threads is meaningful.
+ */
+struct xbuf_counters {
+        unsigned long          allocations;  /*!< xbuf_alloc() calls.       */
+        unsigned long          hits;         /*!< Served by a free list.    */
+        long                   outstanding;  /*!< Allocated - released.     */
+        long long              bytes;        /*!< Capacity balance.         */
+        struct xbuf_counters * next;         /*!< Next thread.              */
+};
+
+/*! Single-writer counter update (the counters of the current thread). */
+#define XBUF_COUNT(counter, value) \
+        __atomic_store_n(&(counter), (counter) + (value), __ATOMIC_RELAXED)
+
+/*! Counters of all the threads. They are never released, so that the
+ *  counts of the finished threads remain.
+ */
+static struct xbuf_counters * xbuf_blocks = NULL;
+
+/*! Counters list lock (registration only). */
+static pthread_mutex_t xbuf_blocks_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*! Counters of the current thread. */
+static __thread struct xbuf_counters * xbuf_block = NULL;
+
+/*! Largest capacity of the outstanding buffers seen by xbuf_stats(). */
+static size_t xbuf_peak = 0;
+
+/** @} */
+
+
+/**
+ *  \brief Counters of the current thread, created on the first call.
+ */
+static struct xbuf_counters * xbuf_thread_counters(void)
+{
+        struct xbuf_counters * block = xbuf_block;
+
+        if (block)
+        {
+                return block;
+        }
+        block = xmalloc(sizeof(struct xbuf_counters));
+        memset(block, 0, sizeof(struct xbuf_counters));
+
+        pthread_mutex_lock(&xbuf_blocks_lock);
+        block->next = xbuf_blocks;
+        __atomic_store_n(&xbuf_blocks, block, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&xbuf_blocks_lock);
+
+        xbuf_block = block;
+        return block;
+}
+
+
+/**
+ *  \brief Function allocating a packet buffer.
+ *
+ *         The buffer is taken from the free list of the current thread for
+ *         the smallest fitting size class, or allocated if the list is
+ *         empty. It is returned with one reference and a used size of 0.
+ *
+ * @param size          minimum capacity of the buffer
+ * @return              a pointer to the buffer (the program exits if the
+ *                      memory cannot be allocated)
+ */
+struct xbuf * xbuf_alloc(size_t size)
+{
+        struct xbuf_counters * counters = xbuf_thread_counters();
+        struct xbuf          * buffer = NULL;
+        size_t                 capacity = size;
+        int                    klass;
+
+        for (klass = 0 ; klass < XBUF_CLASSES ; klass++)
+        {
+                if (size <= xbuf_sizes[klass])
+                {
+                        capacity = xbuf_sizes[klass];
+                        break;
+                }
+        }
+
+        if ((klass < XBUF_CLASSES) && xbuf_free[klass])
+        {
+                buffer = xbuf_free[klass];
+                xbuf_free[klass] = buffer->next;
+                xbuf_nb_free[klass]--;
+                XBUF_COUNT(counters->hits, 1);
+        }
+        else
+        {
+                buffer = xmalloc(sizeof(struct xbuf) + capacity);
+                buffer->klass = (klass < XBUF_CLASSES) ? klass : -1;
+                buffer->capacity = capacity;
+        }
+        buffer->refcount = 1;
+        buffer->size = 0;
+        buffer->next = NULL;
+
+        XBUF_COUNT(counters->allocations, 1);
+        XBUF_COUNT(counters->outstanding, 1);
+        XBUF_COUNT(counters->bytes, capacity);
+
+        return buffer;
+}
+
+
+/**
+ *  \brief Function adding a reference to a packet buffer.
+ *
+ * @param buffer        the buffer
+ * @return              the buffer
+ */
+struct xbuf * xbuf_ref(struct xbuf * buffer)
+{
+        __atomic_fetch_add(&buffer->refcount, 1, __ATOMIC_RELAXED);
+
+        return buffer;
+}
+
+
+/**
+ *  \brief Function releasing a reference to a packet buffer.
+ *
+ *         When the last reference is released, the buffer goes to the free
+ *         list of the current thread (or is freed if the list is full or
+ *         if the buffer is larger than the size classes).
+ *
+ * @param buffer        the buffer (may be NULL)
+ */
+void xbuf_unref(struct xbuf * buffer)
+{
+        struct xbuf_counters * counters;
+        int                    klass;
+
+        if (! buffer ||
+            (__atomic_sub_fetch(&buffer->refcount, 1, __ATOMIC_ACQ_REL) != 0))
+        {
+                return;
+        }
+
+        counters = xbuf_thread_counters();
+        XBUF_COUNT(counters->outstanding, -1);
+        XBUF_COUNT(counters->bytes, - (long long) buffer->capacity);
+
+        klass = buffer->klass;
+        if ((klass >= 0) && (xbuf_nb_free[klass] < XBUF_CACHE_SIZE))
+        {
+                buffer->next = xbuf_free[klass];
+                xbuf_free[klass] = buffer;
+                xbuf_nb_free[klass]++;
+        }
+        else
+        {
+                free(buffer);
+        }
+}
+
+
+/**
+ *  \brief Function freeing the cached buffers of the current thread.
+ *
+ *         It should be called by threads using the pool before they exit.
+ */
+void xbuf_trim(void)
+{
+        int klass;
+
+        for (klass = 0 ; klass < XBUF_CLASSES ; klass++)
+        {
+                while (xbuf_free[klass])
+                {
+                        struct xbuf * buffer = xbuf_free[klass];
+
+                        xbuf_free[klass] = buffer->next;
+                        free(buffer);
+                }
+                xbuf_nb_free[klass] = 0;
+        }
+}
+
+
+/**
+ *  \brief Function returning the pool statistics.
+ *
+ *         This function adds the counters of all the threads. It takes no
+ *         lock: the counts of statistics taken during the traffic may be
+ *         off by the updates made while they are taken. The hit rate is
+ *         given by hits / allocations.
+ *
+ * @param stats         returned statistics
+ */
+void xbuf_stats(struct xbuf_stats * stats)
+{
+        struct xbuf_counters * block;
+        long long              bytes = 0;
+        size_t                 peak;
+
+        memset(stats, 0, sizeof(struct xbuf_stats));
+        for (block = __atomic_load_n(&xbuf_blocks, __ATOMIC_ACQUIRE) ;
+             block ; block = block->next)
+        {
+                stats->allocations += __atomic_load_n(&block->allocations, __ATOMIC_RELAXED);
+                stats->hits += __atomic_load_n(&block->hits, __ATOMIC_RELAXED);
+                stats->outstanding += __atomic_load_n(&block->outstanding, __ATOMIC_RELAXED);
+                bytes += __atomic_load_n(&block->bytes, __ATOMIC_RELAXED);
+        }
+        stats->bytes = (bytes > 0) ? bytes : 0;
+
+        /*
+         *      Suivre le maximum à chaque allocation demanderait un total
+         *      partagé : c'est le plus grand total vu par cette fonction.
+         */
+        peak = __atomic_load_n(&xbuf_peak, __ATOMIC_RELAXED);
+        while ((stats->bytes > peak) &&
+               ! __atomic_compare_exchange_n(&xbuf_peak, &peak, stats->bytes, 1,
+                                             __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+        }
+        stats->peak_bytes = (stats->bytes > peak) ? stats->bytes : peak;
+}
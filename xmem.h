@@ -17,6 +17,7 @@
 #ifndef XMEM_H
 #define XMEM_H
 
+#include <stddef.h>
 #include <string.h>
 #include <strings.h>
 
@@ -51,9 +52,59 @@
 /** @} */
 
 
+/**
+ *  \defgroup xbuf Packet buffers pool
+ *  @{
+ */
+
+/*! Capacity of the small buffers (ACK, NACK and error packets). */
+#define XBUF_SMALL_SIZE         64
+
+/*! Capacity of the medium buffers. */
+#define XBUF_MEDIUM_SIZE        2048
+
+/*! Capacity of the large buffers (a full packet, MAX_PACKET_SIZE). */
+#define XBUF_LARGE_SIZE         65537
+
+/*! Number of size classes. */
+#define XBUF_CLASSES            3
+
+/*! Maximum number of free buffers kept by each thread for each class. */
+#define XBUF_CACHE_SIZE         64
+
+/*! Reference-counted buffer. Buffers up to XBUF_LARGE_SIZE are recycled
+ *  through per-thread free lists; larger ones are allocated on demand.
+ */
+struct xbuf {
+        int             refcount;  /*!< Number of references.             */
+        int             klass;     /*!< Size class (-1 for unpooled).     */
+        size_t          capacity;  /*!< Usable size of the data area.     */
+        size_t          size;      /*!< Used size, managed by the user.   */
+        struct xbuf   * next;      /*!< Free list link.                   */
+        unsigned char   data[];    /*!< Data area.                        */
+};
+
+/*! Packet buffers pool statistics. */
+struct xbuf_stats {
+        unsigned long   allocations;  /*!< Number of xbuf_alloc() calls.        */
+        unsigned long   hits;         /*!< Allocations served by a free list.   */
+        long            outstanding;  /*!< Buffers currently allocated.         */
+        size_t          bytes;        /*!< Capacity of outstanding buffers.     */
+        size_t          peak_bytes;   /*!< Maximum value of bytes seen by
+                                           xbuf_stats().                       */
+};
+
+/** @} */
+
+
 /** @cond DUPLICATE_DOCUMENTATION */
 void * xmalloc(size_t size);
 char * xstrdup(const char *string);
+struct xbuf * xbuf_alloc(size_t size);
+struct xbuf * xbuf_ref(struct xbuf * buffer);
+void xbuf_unref(struct xbuf * buffer);
+void xbuf_trim(void);
+void xbuf_stats(struct xbuf_stats * stats);
 /** @endcond */
 
 